@@ -2,6 +2,8 @@
 
 #include <conf.h>
 #include <kernel.h>
+#include <com.h>
+#include <stdio.h>
 
 /*------------------------------------------------------------------------
  *  comcntl  -  control a serial line device by setting modes
@@ -9,6 +11,46 @@
  */
 int comcntl(struct devsw * pdev, int func, char * addr)
 {
+	STATWORD	ps;
+	struct comsoft	*pcom = &comtab[pdev->dvminor];
+	struct comstats	*pcs;
+	int		trig;
+
+	switch (func) {
+	case COMC_RXTRIG:
+		switch ((int) addr) {
+		case 1:		trig = UART_FCR_TRIGGER_1;	break;
+		case 4:		trig = UART_FCR_TRIGGER_4;	break;
+		case 8:		trig = UART_FCR_TRIGGER_8;	break;
+		case 14:	trig = UART_FCR_TRIGGER_14;	break;
+		default:	return SYSERR;
+		}
+		if (pcom->com_fcr == 0)		/* no FIFO */
+			return SYSERR;
+		lkdisable(ps, LK_DEV);
+		pcom->com_fcr = UART_FCR_ENABLE_FIFO | trig;
+		outb(pdev->dvcsr + UART_FCR, pcom->com_fcr);
+		restore(ps);
+		return OK;
+	case COMC_STATS:
+		pcs = (struct comstats *) addr;
+		lkdisable(ps, LK_DEV);
+		pcs->cs_ints = pcom->com_ints;
+		pcs->cs_rxbytes = pcom->com_rxbytes;
+		pcs->cs_overruns = pcom->com_overruns;
+		pcom->com_ints = pcom->com_rxbytes = pcom->com_overruns = 0;
+		restore(ps);
+		return OK;
+	case COMC_OSTART:
+		lkdisable(ps, LK_DEV);
+		if (comoin(pcom) > 0) {
+			outb(pdev->dvcsr + UART_IER, UART_IER_ALLI);
+			if (inb(pdev->dvcsr + UART_LSR) & UART_LSR_THRE)
+				comwstrt(pcom, pdev->dvcsr);
+		}
+		restore(ps);
+		return OK;
+	}
 	return SYSERR;
 }
 
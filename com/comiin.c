@@ -6,10 +6,11 @@
 #include <com.h>
 
 /*------------------------------------------------------------------------
- *  comiin  --  lower-half com device driver for input interrupts
+ *  comiin  --  lower-half com device driver for input interrupts: pass
+ *		n received bytes up, as one batch if the upper half is a tty
  *------------------------------------------------------------------------
  */
-INTPROC	comiin(struct comsoft * pcom, unsigned char ch)
+INTPROC	comiin(struct comsoft * pcom, unsigned char * buf, int n)
 {
     struct devsw	*pdev = pcom->com_pdev;
 
@@ -21,6 +22,9 @@ INTPROC	comiin(struct comsoft * pcom, unsigned char ch)
     if (pdev == 0)
 	return(OK);		/* no tty structure associated */
     
-    (pdev->dviint)(pdev, ch);
+    if (pdev->dviint == ttyiin)
+	return(ttyiinn(pdev, buf, n));
+    for (; n > 0 ; n--)
+	(pdev->dviint)(pdev, *buf++);
     return(OK);
 }
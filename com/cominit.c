@@ -30,7 +30,10 @@ int cominit(struct devsw * pdev)
     UART_OUT(csr+UART_DLM, 0);			/* 9600 baud */
     UART_OUT(csr+UART_LCR, UART_LCR_WLEN8);	/* 8N1 */
     
-    comprobe(csr);
+    pcom->com_txfifo = comprobe(csr);
+    pcom->com_fcr = (pcom->com_txfifo > 1) ?
+	(UART_FCR_ENABLE_FIFO | COMRXTRIG) : 0;
+    pcom->com_ints = pcom->com_rxbytes = pcom->com_overruns = 0;
 
     UART_OUT(csr+UART_MCR, 0);
     (void)inb(csr + UART_MSR);
@@ -48,19 +51,21 @@ int cominit(struct devsw * pdev)
 }
 
 /*-------------------------------------------------------------------------
- * comprobe - probe the com device
+ * comprobe - probe the com device; returns how many bytes its transmit
+ *	      FIFO holds (1 if it has none)
  *-------------------------------------------------------------------------
  */
 int comprobe(int csr)
 {
     char c1, c2;
+    int fifo = 1;
 
     c1 = inb(csr+UART_LCR);
     UART_OUT(csr+UART_LCR, c1 | UART_LCR_DLAB);
     UART_OUT(csr+UART_EFR, 0); 	/* EFR is the same as FCR */
     UART_OUT(csr+UART_LCR, c1);
     UART_OUT(csr+UART_FCR, UART_FCR_ENABLE_FIFO);
-    c2 = inb(UART_IIR) >> 6;
+    c2 = (inb(csr+UART_IIR) >> 6) & 3;
     
     switch (c2) {
     case 0:
@@ -73,7 +78,7 @@ int comprobe(int csr)
 	
     case 2:
 	/* kprintf("UART = 16550\n"); */
-	break;
+	break;			/* its FIFO is broken: not used	*/
 	
     case 3:
 	UART_OUT(csr+UART_LCR, c1 | UART_LCR_DLAB);
@@ -84,13 +89,19 @@ int comprobe(int csr)
 	    /* kprintf("UART = 16550A\n"); */
 	}
 	UART_OUT(csr+UART_LCR, c1);
+	fifo = COMFIFOSZ;
 	break;
     }
 
     UART_OUT(csr+UART_MCR, 0x00);
-    UART_OUT(csr+UART_FCR, (UART_FCR_CLEAR_RCVR | UART_FCR_CLEAR_XMIT));
+    if (fifo > 1) {			/* keep it on, the rx one too	*/
+	UART_OUT(csr+UART_FCR, (UART_FCR_ENABLE_FIFO | UART_FCR_CLEAR_RCVR |
+				UART_FCR_CLEAR_XMIT | COMRXTRIG));
+    } else {
+	UART_OUT(csr+UART_FCR, (UART_FCR_CLEAR_RCVR | UART_FCR_CLEAR_XMIT));
+    }
     (void)inb(csr+UART_RX);
-    return(OK);
+    return(fifo);
 }
 
 int comtest()
@@ -1,87 +1,121 @@
-/* comintr.c -- comintr */
+/* comintr.c -- comintr, comwstrt */
 
 #include <conf.h>
 #include <kernel.h>
 #include <tty.h>
 #include <com.h>
+#include <trace.h>
 #include <stdio.h>
 
 /*#define DEBUG*/
 /*------------------------------------------------------------------------
- *  comintr -- handle a serial line interrupt
+ *  comrx -- take every byte waiting in the receiver and hand them to the
+ *	     upper half a FIFO's worth at a time
+ *------------------------------------------------------------------------
+ */
+static void comrx(struct comsoft *pcom, int csr)
+{
+    unsigned char	buf[COMFIFOSZ];
+    unsigned char	lsr, b;
+    int			n = 0;
+
+    while ((lsr = inb(csr + UART_LSR)) & UART_LSR_DR) {
+	if (lsr & UART_LSR_OE)
+	    pcom->com_overruns++;
+	b = inb(csr + UART_RX);
+	pcom->com_rxbytes++;
+#ifdef DEBUG
+	kprintf("{RX=%x}", b);
+#endif
+	if (b == 0) {		/* XXX maybe a BREAK */
+	    if (n > 0)
+		comiin(pcom, buf, n);
+	    n = 0;
+	    /* handles the BREAK signal here */
+	    kprintf("\nSerial line BREAK detected.\n");
+	    monitor(csr);
+	    continue;
+	}
+	buf[n++] = b;
+	if (n == sizeof(buf)) {
+	    comiin(pcom, buf, n);
+	    n = 0;
+	}
+    }
+    if (n > 0)
+	comiin(pcom, buf, n);
+}
+
+/*------------------------------------------------------------------------
+ *  comintr -- handle a serial line interrupt: every cause pending on
+ *	       every line, until none is left
  *------------------------------------------------------------------------
  */
 int comintr()
 {
     STATWORD		ps;
+    struct comsoft	*pcom;
     unsigned char	iir, b;
     int			i, csr;
 
-    disable(ps);
+    lkdisable(ps, LK_DEV);
     
     for (i=0; i<Nserial; ++i) {
-	csr = comtab[i].com_pdev->dvcsr;
+	pcom = &comtab[i];
+	csr = pcom->com_pdev->dvcsr;
 	iir = inb(csr + UART_IIR);
 	if (iir & UART_IIR_NO_INT)
 	    continue;
-	break;
-    }
-
-    if (i == Nserial) {
-	restore(ps);
-	return(OK);
-    }
+	pcom->com_ints++;
+	TRACE(TRC_INTR, TE_INTR, pcom->com_pdev->dvivec, iir, 0, 0);
 
-    switch (iir & UART_IIR_IID) {
-    case UART_IIR_RLSI:
-	b = inb(csr + UART_LSR);
+	do {
+	    switch (iir & UART_IIR_IID) {
+	    case UART_IIR_RLSI:
+		b = inb(csr + UART_LSR);
 #ifdef DEBUG
-	kprintf("<LSR=%x>", b);
+		kprintf("<LSR=%x>", b);
 #endif
-	if (b & UART_LSR_BI) {
-	    (void) inb(csr + UART_RX);		/* discard it */
+		if (b & UART_LSR_OE)
+		    pcom->com_overruns++;
+		if (b & UART_LSR_BI) {
+		    (void) inb(csr + UART_RX);		/* discard it */
 
-	    if (!(b & UART_LSR_OE)) { 		/* XXX */
-		/* handles the BREAK signal here */
-		kprintf("\nSerial line BREAK detected\n");
-		monitor(csr);
-	    }
-	}
-	break;
+		    if (!(b & UART_LSR_OE)) { 		/* XXX */
+			/* handles the BREAK signal here */
+			kprintf("\nSerial line BREAK detected\n");
+			monitor(csr);
+		    }
+		}
+		break;
 	    
-    case UART_IIR_MSI:
-	b = inb(csr + UART_MSR);
+	    case UART_IIR_MSI:
+		b = inb(csr + UART_MSR);
 #ifdef DEBUG
-	kprintf("(MSR=%x)", b);
+		kprintf("(MSR=%x)", b);
 #endif
-	break;
+		break;
 	    
-    case UART_IIR_RDI:		/* received a char */
-	b = inb(csr + UART_RX);
-#ifdef DEBUG
-	kprintf("{RX=%x}", b);
-#endif
-	if (b == 0) {		/* XXX maybe a BREAK */
-	    /* handles the BREAK signal here */
-	    kprintf("\nSerial line BREAK detected.\n");
-	    monitor(csr);
-	}
-	else
-	    comiin(&comtab[i], b);
-	break;
+	    case UART_IIR_RDI:		/* received data, or the rx	*/
+		comrx(pcom, csr);	/* FIFO timed out below trigger	*/
+		break;
 	    
-    case UART_IIR_THRI:
-	b = inb(csr + UART_LSR);
+	    case UART_IIR_THRI:
+		b = inb(csr + UART_LSR);
 #ifdef DEBUG
-	kprintf("[LSR=%x]", b);
+		kprintf("[LSR=%x]", b);
 #endif
-	if (b & UART_LSR_THRE && comtab[i].com_count) {
-	    comwstrt(&comtab[i], csr);
-	}
-	break;
+		if (b & UART_LSR_OE)
+		    pcom->com_overruns++;
+		if (b & UART_LSR_THRE && pcom->com_count) {
+		    comwstrt(pcom, csr);
+		}
+		break;
 
-    default:
-	kprintf("comintr: unknown int: iir = 0x%x\n", iir);	
+	    default:
+		kprintf("comintr: unknown int: iir = 0x%x\n", iir);	
+	    }
+	} while (!((iir = inb(csr + UART_IIR)) & UART_IIR_NO_INT));
     }
     
     restore(ps);
@@ -89,23 +123,31 @@ int comintr()
 }
 
 /*-------------------------------------------------------------------------
- * comwstrt - 
+ * comwstrt - move as much of the output buffer as the transmitter takes
+ *	      (a 16550A takes 16 bytes once its FIFO is empty); when that
+ *	      empties the buffer, refill it from the tty above
  *-------------------------------------------------------------------------
  */
 int comwstrt(struct comsoft *pcom, int csr)
 {
+    int		n;
+
 #ifdef DEBUG
     kprintf("comwstrt: ct=%d, st=%d", pcom->com_count, pcom->com_start); 
 #endif
-    outb(csr+UART_TX, pcom->com_buf[pcom->com_start]);
-    pcom->com_count--;
-    pcom->com_start++;
+    for (n=0; n < pcom->com_txfifo && pcom->com_count > 0; n++) {
+	outb(csr+UART_TX, pcom->com_buf[pcom->com_start]);
+	pcom->com_count--;
+	if (++pcom->com_start >= COMBUFSZ)
+	    pcom->com_start = 0;
+    }
 	
+    if (n > 0 && pcom->com_count == 0)	/* refill from the tty	*/
+	comoin(pcom);
     if (pcom->com_count == 0)	/* disable tx ready interrupt */
 	outb(csr+UART_IER, UART_IER_MSI | UART_IER_RLSI | UART_IER_RDI);
 
-    if (pcom->com_start >= COMBUFSZ)
-	pcom->com_start = 0;
-    signal(pcom->com_osema);
+    if (n > 0)
+	isignaln(pcom->com_osema, n);
     return OK;
 }
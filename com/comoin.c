@@ -0,0 +1,34 @@
+/* comoin.c comoin */
+
+#include <conf.h>
+#include <kernel.h>
+#include <sem.h>
+#include <tty.h>
+#include <com.h>
+
+/*------------------------------------------------------------------------
+ *  comoin  --  lower-half com device driver for output: take as much of
+ *		the upper half's ready output as fits in the output buffer
+ *		(called with interrupts disabled); returns bytes queued
+ *------------------------------------------------------------------------
+ */
+INTPROC	comoin(struct comsoft * pcom)
+{
+    struct devsw	*pdev = pcom->com_pdev;
+    unsigned char	buf[COMBUFSZ / 2];
+    int			room, n, i, k;
+
+    if ((pdev = (struct devsw *)pdev->dvioblk) == 0)
+	return(0);		/* no tty device associated */
+    if (pdev->dvoint != ttyoin)
+	return(0);
+
+    room = scount(pcom->com_osema) / 2;	/* each may become \r\n	*/
+    if (room <= 0)
+	return(0);
+    n = ttyoin(pdev, buf, room);
+    for (i=0, k=0 ; i<n ; i++)
+	k += comqput(pcom, buf[i]);
+    semaph[pcom->com_osema].semcnt -= k;	/* stays >= 0	*/
+    return(k);
+}
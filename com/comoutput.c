@@ -1,8 +1,9 @@
-/* comoutput.c - computc, comwrite */
+/* comoutput.c - computc, comflush, comsputc, comwrite */
 
 #include <conf.h>
 #include <kernel.h>
 #include <proc.h>
+#include <sem.h>
 #include <tty.h>
 #include <com.h>
 #include <stdio.h>
@@ -20,9 +21,9 @@ unsigned char c;
     struct 	devsw	*pttydev;
     struct 	comsoft	*pcom = &comtab[pdev->dvminor];
     struct 	tty	*ptty=NULL;
-    int		pos, rv;
+    int		rv;
 
-    disable(ps);
+    lkdisable(ps, LK_DEV);
     
     if ((pttydev = (struct devsw *)pdev->dvioblk))
 	ptty = (struct tty *) pttydev->dvioblk;
@@ -35,21 +36,9 @@ unsigned char c;
     }
 
     wait(pcom->com_osema);
-    
-    pos = pcom->com_start + pcom->com_count;
-    if (c == '\n') {
+    if (c == '\n')
 	wait(pcom->com_osema);	/* need 2 for \r\n */
-	if (pos >= COMBUFSZ)
-	    pos -= COMBUFSZ;
-	pcom->com_buf[pos] = '\r';
-	pcom->com_count++;
-	++pos;
-    }
-    
-    if (pos >= COMBUFSZ)
-	pos -= COMBUFSZ;
-    pcom->com_buf[pos] = c;
-    pcom->com_count++;
+    comqput(pcom, c);
     
     outb(pdev->dvcsr+UART_IER, UART_IER_ALLI);	/* enable tx ready interrupt */
     rv = inb(pdev->dvcsr + UART_LSR);
@@ -112,20 +101,87 @@ int comsputc(struct devsw * pdev, unsigned char c)
 }
 
 
+/*------------------------------------------------------------------------
+ *  comqput - append c to the output buffer, which has room for it (and
+ *	      for the \r that goes before a \n); returns bytes added
+ *------------------------------------------------------------------------
+ */
+int comqput(struct comsoft * pcom, unsigned char c)
+{
+    int		pos, n = 0;
+
+    pos = pcom->com_start + pcom->com_count;
+    if (c == '\n') {
+	if (pos >= COMBUFSZ)
+	    pos -= COMBUFSZ;
+	pcom->com_buf[pos++] = '\r';
+	n++;
+    }
+    if (pos >= COMBUFSZ)
+	pos -= COMBUFSZ;
+    pcom->com_buf[pos] = c;
+    n++;
+    pcom->com_count += n;
+    return n;
+}
+
 /*------------------------------------------------------------------------
  *  comwrite - write to the PC physical monitor
+ *
+ *  The buffer is copied into com_buf a chunk at a time: as much as there
+ *  is room for, taken from com_osema in one step. Only when com_buf is
+ *  full does it wait(), as computc() does, for the transmit interrupt
+ *  to make room.
  *------------------------------------------------------------------------
  */
 int comwrite(struct devsw * pdev, char * buf, int count)
 {
+    STATWORD	ps;
+    struct 	devsw	*pttydev;
+    struct 	comsoft	*pcom = &comtab[pdev->dvminor];
+    struct 	tty	*ptty=NULL;
+    int		room, n;
+
     if (count < 0)
 	return SYSERR;
     
     if (count == 0)
 	return OK;
 
-    for (; count>0 ; count--)
-	computc(pdev, *buf++);
-    
+    lkdisable(ps, LK_DEV);
+
+    if ((pttydev = (struct devsw *)pdev->dvioblk))
+	ptty = (struct tty *) pttydev->dvioblk;
+
+    if (ptty && (ptty->tty_oflags & TOF_SYNC)) {
+	for (; count>0 ; count--)
+	    comsputc(pdev, *buf++);
+	restore(ps);
+	return OK;
+    }
+
+    while (count > 0) {
+	room = scount(pcom->com_osema);
+	if (room < (*buf == '\n' ? 2 : 1)) {	/* full */
+	    wait(pcom->com_osema);
+	    if (*buf == '\n')
+		wait(pcom->com_osema);
+	    comqput(pcom, *buf++);
+	    count--;
+	    room = scount(pcom->com_osema);
+	}
+
+	for (n=0 ; count > 0 ; count--, buf++) {
+	    if (room - n < (*buf == '\n' ? 2 : 1))
+		break;
+	    n += comqput(pcom, *buf);
+	}
+	semaph[pcom->com_osema].semcnt -= n;	/* stays >= 0	*/
+
+	outb(pdev->dvcsr+UART_IER, UART_IER_ALLI);	/* enable tx ready interrupt */
+	if (inb(pdev->dvcsr + UART_LSR) & UART_LSR_THRE)
+	    comwstrt(pcom, pdev->dvcsr);
+    }
+    restore(ps);
     return OK;
 }
@@ -0,0 +1,60 @@
+/* arp.h */
+
+#ifndef _ARP_H_
+#define _ARP_H_
+
+/* Address Resolution Protocol for IP over Ethernet (RFC 826) */
+
+#define	AR_HARDWARE	1		/* Ethernet			*/
+#define	AR_REQUEST	1		/* operations			*/
+#define	AR_REPLY	2
+
+struct	arp	{			/* fields in network order	*/
+	unsigned short	ar_hwtype;
+	unsigned short	ar_prtype;
+	unsigned char	ar_hwlen;
+	unsigned char	ar_prlen;
+	unsigned short	ar_op;
+	Eaddr	ar_sha;			/* sender hardware address	*/
+	unsigned char	ar_spa[IP_ALEN];/* sender IP address		*/
+	Eaddr	ar_tha;			/* target hardware address	*/
+	unsigned char	ar_tpa[IP_ALEN];/* target IP address		*/
+};
+#define	ARP_LEN		28		/* octets in an ARP packet	*/
+
+/* The cache. A packet for an address being resolved waits on its	*/
+/* entry, up to ARP_QLEN of them, oldest dropped first. netd resends	*/
+/* the request every ARP_RESEND ms and gives up after ARP_MAXTRY,	*/
+/* dropping the packets; it also forgets resolved entries after	*/
+/* ARP_TIMEOUT ms. A full cache reuses the least recently used entry.	*/
+
+#define	NARP		32		/* entries in the cache		*/
+#define	ARP_QLEN	4		/* packets held per entry	*/
+#define	ARP_RESEND	1000		/* ms between requests		*/
+#define	ARP_MAXTRY	4		/* requests before giving up	*/
+#define	ARP_TIMEOUT	300000		/* ms a resolved entry lives	*/
+
+#define	AS_FREE		0		/* entry states			*/
+#define	AS_PENDING	1
+#define	AS_RESOLVED	2
+
+struct	arpent	{
+	int	ae_state;
+	IPaddr	ae_pra;			/* IP address			*/
+	Eaddr	ae_hwa;			/* its hardware address		*/
+	int	ae_tries;		/* requests sent		*/
+	unsigned long	ae_expires;	/* ctr1000 to resend or forget	*/
+	unsigned long	ae_used;	/* ctr1000 of the last lookup	*/
+	struct	ep	*ae_queue[ARP_QLEN];	/* waiting, oldest first*/
+	int	ae_qlen;
+};
+
+extern	struct	arpent	arptab[];
+
+/* ANSI compliant function prototypes */
+
+int arp_in(struct ep *pep);
+int arpsend(struct ep *pep, int len);
+int arptimer();
+
+#endif
@@ -46,6 +46,7 @@ typedef struct _bs_map_t {
     int pid;                // process id using this bs
     int vpno;               // starting virtual page number
     int npages;             // number of pages in the store
+    int advice;             // access hint given with xmadvise()
     struct _bs_map_t * next; 
 } bs_map_t;
 
@@ -57,7 +58,7 @@ typedef struct {
     int isheap;         // is this bs used by heap?, if so can't be shared
     int npages;         // number of pages in the store
     bs_map_t * maps;    // where it is mapped
-    frame_t  * frames;  // the list of frames that maps this bs
+    frm_idx_t frames;   // the list of frames that maps this bs
 } bs_t;
 
 
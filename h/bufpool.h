@@ -20,6 +20,7 @@ struct	bpool	{			/* Description of a single pool	*/
 	int	bpmaxused;		/* max ever in use		*/
 	int	bptotal;		/* # buffers this pool		*/
 	char	*bpnext;		/* pointer to next free buffer	*/
+	char	*bpbase;		/* memory from getmem		*/
 	int	bpsem;			/* semaphore that counts buffers*/
 };					/*  currently in THIS pool	*/
 
@@ -32,6 +33,7 @@ extern  MARKER  bpmark;
 /* ANSI compliant function prototypes */
 
 int freebuf(void *buf);
+int freepool(int poolid);
 int *getbuf(int poolid);
 int mkpool(int bufsiz, int numbufs);
 int *nbgetbuf(int poolid);
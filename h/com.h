@@ -132,22 +132,44 @@
 #define UART_OUT(off,c)		outb(off,c);delay(10)
 
     
-#define	COMBUFSZ	32	/* serial device raw buffer size*/
+#define	COMBUFSZ	256	/* serial device raw buffer size*/
+#define	COMFIFOSZ	16	/* 16550A transmit FIFO size	*/
+#define	COMRXTRIG	UART_FCR_TRIGGER_8	/* rx FIFO interrupts	*/
+						/* at 8 bytes or idle	*/
 
 struct comsoft {
 	unsigned char	com_buf[COMBUFSZ];	/* raw output buffer	*/
-	unsigned char	com_start;		/* start of buffer	*/
-	unsigned char	com_count;		/* count in buffer	*/
+	int		com_start;		/* start of buffer	*/
+	int		com_count;		/* count in buffer	*/
 	int		com_osema;		/* output semaphore	*/
+	int		com_txfifo;		/* bytes the UART takes	*/
+						/* per tx interrupt	*/
+	unsigned char	com_fcr;		/* FIFO control, or 0	*/
+	unsigned long	com_ints;		/* interrupts taken	*/
+	unsigned long	com_rxbytes;		/* bytes received	*/
+	unsigned long	com_overruns;		/* times rx overran	*/
 	struct devsw	*com_pdev;		/* devsw pointer	*/
 };
 
+/* comcntl() functions */
+#define	COMC_RXTRIG	1	/* rx FIFO trigger: arg1 is 1, 4, 8 or 14	*/
+#define	COMC_STATS	2	/* copy counts to *arg1 and clear them	*/
+#define	COMC_OSTART	3	/* the tty above has output ready	*/
+
+struct comstats {
+	unsigned long	cs_ints;		/* interrupts taken	*/
+	unsigned long	cs_rxbytes;		/* bytes received	*/
+	unsigned long	cs_overruns;		/* times rx overran	*/
+};
+
 extern int	brtab[];	/* baud rate table		*/
 extern int	lstab[];	/* divisor count table		*/
 
 extern struct comsoft	comtab[];
 int comprobe(int);
 int comwstrt(struct comsoft *, int);
-int comiin(struct comsoft *, unsigned char);
+int comiin(struct comsoft *, unsigned char *, int);
+int comoin(struct comsoft *);
+int comqput(struct comsoft *, unsigned char);
 
 #endif
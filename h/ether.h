@@ -0,0 +1,40 @@
+/* ether.h - Ethernet frames and the packet buffers that hold them */
+
+#ifndef _ETHER_H_
+#define _ETHER_H_
+
+#define	EP_MINLEN	60		/* shortest frame on the wire	*/
+#define	EP_DLEN		1500		/* longest data field		*/
+#define	EP_HLEN		14		/* Ethernet header		*/
+#define	EP_ALEN		6		/* octets in a hardware address	*/
+#define	EP_MAXLEN	(EP_HLEN+EP_DLEN)
+typedef	unsigned char	Eaddr[EP_ALEN];
+#define	EP_BRC		"\377\377\377\377\377\377"	/* broadcast	*/
+
+#define	EPT_IP		0x0800		/* type: Internet Protocol	*/
+#define	EPT_ARP		0x0806		/* type: ARP			*/
+
+struct	eh	{			/* Ethernet header		*/
+	Eaddr	eh_dst;
+	Eaddr	eh_src;
+	unsigned short	eh_type;	/* host order inside the stack;	*/
+};					/* the driver swaps it		*/
+
+/* A packet buffer, from netpool. The driver receives the frame at	*/
+/* ep_eh and the IP header after it falls on a long boundary. The	*/
+/* buffer is passed by reference from the driver up to a socket's	*/
+/* queue, and from a writer down to the driver; whoever has it last	*/
+/* frees it.								*/
+
+struct	ep	{
+	IPaddr	ep_nexthop;		/* where ARP is to deliver it	*/
+	short	ep_len;			/* octets in the frame		*/
+	struct	eh	ep_eh;		/* the frame, from here on	*/
+	char	ep_data[EP_DLEN];
+};
+
+#define	ep_dst		ep_eh.eh_dst
+#define	ep_src		ep_eh.eh_src
+#define	ep_type		ep_eh.eh_type
+
+#endif
@@ -39,43 +39,45 @@
 //     FRM_PD - contains a page table directory
 //     FRM_PT - contains a page table
 //     FRM_BS - Part of a backing store  
+//     FRM_STK - Part of a demand-paged process stack (VSTACK)
 #define FRM_PD 0
 #define FRM_PT 1
 #define FRM_BS 2
+#define FRM_STK 3
 
 
-typedef struct _frame_t {
-    int frmid;  // The frame id (index) 
-    int status; // FRM_FREE - frame is not being used
-                // FRM_USED - frame is being used
-
-    int type;   // FRM_PD   - Being used for a page directory
-                // FRM_PT   - Being used for a page table
-                // FRM_BS   - Part of a backing store
-
-    int accessed; // Was the frame accessed or not since last
-                  // check?
+// Frames are linked into lists (the fifo, a backing store's frames)
+// by frame id rather than by pointer. FRM_NIL ends a list.
+typedef short frm_idx_t;
+#define FRM_NIL (-1)
 
-    int refcnt; // If the frame is used for a page table (FRM_PGT),
-                // refcnt is the number of mappings in the table. 
-                // When refcnt is 0 release the frame. 
-                //
-                // If the frame is used for FRM_BS, refcnt will be the
-                // number of times this frame is mapped by processes.
-                // When refcnt is 0 release the frame.
 
-    int age; // when the page is loaded, in ticks
-             // Used for page replacement policy AGING 
-                
-
-    struct _frame_t * fifo_next;
-        // The fifo that keeps up with the order in which frames were
-        // allocated. Oldest frames are at the head of the fifo.
+// The frame table is split in a hot and a cold part (see frame.c).
+// The hot part is a set of packed arrays indexed by frame id, the
+// fields every frame gets looked at for when scanning:
+//
+//   frm_status[]    - FRM_FREE or FRM_USED
+//   frm_type[]      - FRM_PD, FRM_PT, FRM_BS or FRM_STK
+//   frm_age[]       - age for page replacement policy AGING
+//   frm_accessed[]  - accessed since the ages were last updated?
+//   frm_refcnt[]    - FRM_PT: number of mappings in the table
+//                     FRM_BS: number of times processes map the frame
+//                     The frame is released when it drops to 0.
+//   frm_pincnt[]    - number of page table entries that lock this
+//                     frame with xmlock(). A frame with pincnt > 0
+//                     is never picked for eviction.
+//   frm_fifo_next[] - the fifo that keeps up with the order in which
+//                     frames were allocated. Oldest frames are at the
+//                     head of the fifo.
+//
+// frame_t is the cold part.
+typedef struct _frame_t {
+    int frmid;  // The frame id (index) 
 
-    // Following are only used if status == FRM_BS
+    // Following are only used if type == FRM_BS
     int    bsid;              // The backing store this frame maps to
     int    bspage;            // The page within the backing store
-    struct _frame_t * bs_next; // The list of all the frames for this bs
+    frm_idx_t bs_next;        // The list of all the frames for this bs
 
 } frame_t;
 
@@ -83,12 +85,39 @@ typedef struct _frame_t {
 int init_frmtab();
 int frm_decrefcnt(frame_t * frame);
 int frm_free(frame_t * frame);
+int frm_release(frame_t * frame);
+int _frm_cleanlists(void * bspointer);
 int frm_update_ages();
 frame_t * frm_alloc(); 
+frame_t * frm_getfree();
 frame_t * frm_find_bspage(int bsid, int bsoffset);
 
+
+// Paging statistics, see pgstat.c
+typedef struct {
+    int nfree;      // frames not in use
+    int npd;        // frames holding page directories
+    int npt;        // frames holding page tables
+    int nbs;        // frames holding backing store pages
+    int nstk;       // frames holding process stack pages
+    int npinned;    // frames pinned with xmlock()
+} pgstat_t;
+
+SYSCALL pgstat(pgstat_t * st);
+void pgdump();
+
 // Table with entries representing frame
+extern unsigned char  frm_status[];
+extern unsigned char  frm_type[];
+extern unsigned char  frm_age[];
+extern unsigned char  frm_accessed[];
+extern unsigned short frm_refcnt[];
+extern unsigned short frm_pincnt[];
+extern frm_idx_t      frm_fifo_next[];
 extern frame_t frm_tab[];
 
+// Number of frames with pincnt > 0
+extern int frm_npinned;
+
 
 #endif
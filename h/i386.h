@@ -3,7 +3,7 @@
 #define	NBPG		4096
 
 
-#define	NID		48
+#define	NID		64
 #define	NGD		 8
 
 #define	IRQBASE		32	/* base ivec for IRQ0			*/
@@ -92,6 +92,13 @@ struct tss {
 
 extern struct tss i386_tasks[];
 
+/* The Xinu and page fault TSSs of the running processor	*/
+#ifdef	SMP
+#define	cputss()	(cpu()->c_tss)
+#else
+#define	cputss()	i386_tasks
+#endif
+
 #define	sd_type		sd_perm
 
 /* System Descriptor Types */
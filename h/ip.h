@@ -0,0 +1,72 @@
+/* ip.h - IP_HLEN */
+
+#ifndef _IP_H_
+#define _IP_H_
+
+#define	IP_ALEN		4		/* octets in an IP address	*/
+typedef	unsigned long	IPaddr;		/* kept in network order	*/
+#define	IP_BCAST	0xffffffffUL	/* limited broadcast		*/
+
+#define	IPT_ICMP	1		/* protocol numbers		*/
+#define	IPT_UDP		17
+
+struct	ip	{			/* all fields in network order	*/
+	unsigned char	ip_verlen;	/* version & header length	*/
+	unsigned char	ip_tos;
+	unsigned short	ip_len;		/* octets, header included	*/
+	unsigned short	ip_id;
+	unsigned short	ip_fragoff;	/* flags & offset in 8 octets	*/
+	unsigned char	ip_ttl;
+	unsigned char	ip_proto;
+	unsigned short	ip_cksum;	/* of the header alone		*/
+	IPaddr	ip_src;
+	IPaddr	ip_dst;
+	unsigned char	ip_data[1];
+};
+
+#define	IP_VERSION	4
+#define	IP_MINHLEN	5		/* header length in longs	*/
+#define	IPMHLEN		20		/* and in octets		*/
+#define	IP_TTL		64
+#define	IP_HLEN(pip)	(((pip)->ip_verlen & 0xf) << 2)
+
+#define	IP_MF		0x2000		/* more fragments		*/
+#define	IP_DF		0x4000		/* don't fragment		*/
+#define	IP_FRAGOFF	0x1fff		/* offset, in 8-octet units	*/
+
+/* Reassembly. Fragments are copied into a buffer from the reassembly	*/
+/* pool at their offset, and a bitmap of 8-octet units says what has	*/
+/* come. The datagram is complete when the last fragment has said how	*/
+/* long it is and every unit up to there is in. A partial datagram is	*/
+/* dropped IP_FRAGTTL ms after its first fragment came.		*/
+
+#define	IP_MAXREASM	16384		/* largest datagram reassembled	*/
+#define	IP_NREASM	4		/* put together at once		*/
+#define	IP_FRAGTTL	3000		/* ms a partial one is kept	*/
+
+#define	IPF_FREE	0
+#define	IPF_BUSY	1
+
+struct	ipfq	{			/* a datagram being reassembled	*/
+	int	ipf_state;
+	IPaddr	ipf_src;		/* src, id and proto name it	*/
+	unsigned short	ipf_id;
+	unsigned char	ipf_proto;
+	struct	ep	*ipf_pep;	/* from the reassembly pool	*/
+	int	ipf_total;		/* data octets, -1 not yet known*/
+	int	ipf_end;		/* furthest octet seen so far	*/
+	int	ipf_units;		/* 8-octet units filled		*/
+	unsigned long	ipf_expires;	/* ctr1000 it is dropped at	*/
+	unsigned char	ipf_map[IP_MAXREASM / 64];	/* unit bitmap	*/
+};
+
+/* ANSI compliant function prototypes */
+
+struct	ep;				/* ether.h			*/
+
+int ip_in(struct ep *pep);
+int ipsend(IPaddr dst, int proto, struct ep *pep, int datalen);
+struct ep *ipreass(struct ep *pep);
+int ipftimer();
+
+#endif
@@ -1,4 +1,6 @@
-/* kernel.h - disable, enable, halt, restore, isodd, min, max */
+/* kernel.h - disable, lkdisable, lklock, lkrestore, enable, halt, restore,
+ *	      isodd, min, max
+ */
 
 #ifndef _KERNEL_H_
 #define _KERNEL_H_
@@ -51,6 +53,7 @@ typedef	char		Bool;		/* Boolean type			*/
 #define	INITRET		userret		/* processes return address	*/
 #define	INITREG		0		/* initial register contents	*/
 #define	QUANTUM		10		/* clock ticks until preemption	*/
+#define	NPRIO		256		/* priorities are 0 to NPRIO-1	*/
 
 
 
@@ -65,19 +68,19 @@ typedef	int	REG;		/* sizeof machine register		*/
 #define MAXLONG		0x7fffffff	
 #define MINLONG		0x80000000
 
-typedef short	STATWORD[1];	/* machine status for disable/restore	*/
+typedef short	STATWORD[2];	/* machine status for disable/restore	*/
 				/* by declaring it to be an array, the	*/
 				/* name provides an address so forgotten*/
 				/* &'s don't become a problem		*/
+				/* [0]: interrupt mask (with SMP, TRUE	*/
+				/* iff interrupts were already off),	*/
+				/* [1]: locks lkdisable() took		*/
 
 /* Miscellaneous utility inline functions */
 #define	isodd(x)	(01&(WORD)(x))
 #define	min(a,b)	( (a) < (b) ? (a) : (b) )
 #define	max(a,b)	( (a) > (b) ? (a) : (b) )
 
-extern	int	rdyhead, rdytail;
-extern	int	preempt;
-
 /* Include types and configuration information */
 
 #include <systypes.h>
@@ -86,6 +89,37 @@ extern	int	preempt;
 #include <conf.h>
 #endif
 
+/* Locks lkdisable() takes along with disable() when SMP is configured,	*/
+/* lowest first (see smp.c). Without SMP it is just disable().		*/
+
+#define	LK_DEV		0x001		/* tty and serial lines		*/
+#define	LK_NET		0x002		/* network stack		*/
+#define	LK_MEM		0x004		/* memlist, buffer pools, vheaps*/
+#define	LK_SEM		0x008		/* semaph			*/
+#define	LK_PROC		0x010		/* proctab, q, ready lists,	*/
+					/*   timers and the clock	*/
+#define	LK_BS		0x020		/* bs_tab and its maps		*/
+#define	LK_FRM		0x040		/* frm_tab and page tables	*/
+#define	LK_LOG		0x080		/* klog and trace rings		*/
+#define	LK_CONS		0x100		/* kprintf			*/
+#define	NLOCK		9
+
+/* lklock() and lkrestore() are lkdisable() and restore() for code that	*/
+/* always runs with interrupts disabled (interrupt handlers and what	*/
+/* they call); without SMP they do nothing.				*/
+
+#ifdef	SMP
+#include <mp.h>			/* rdyhead and rdytail are per cpu	*/
+#define	lklock(ps, locks)	lkdisable(ps, locks)
+#define	lkrestore(ps)		restore(ps)
+#else
+extern	int	rdyhead, rdytail;
+#define	lkdisable(ps, locks)	disable(ps)
+#define	lklock(ps, locks)	((void) (ps))
+#define	lkrestore(ps)		((void) (ps))
+#endif
+extern	int	preempt;
+
 /* ANSI compliant function prototypes */
 
 int blkcmp(void *p1, void *p2, int len);
@@ -94,6 +128,7 @@ int blkequ(void *p1, void *p2, int len);
 void clkinit();
 int dotrace(char *procname, int *argv, int argc);
 int initevec();
+void killstk(int pid);
 int kputc(int dev, unsigned char c);
 int main();
 int panic(char *msg);
@@ -140,20 +175,38 @@ SYSCALL scount(int sem);
 SYSCALL sdelete(int sem);
 SYSCALL	send(int pid, WORD msg);
 SYSCALL	sendf(int pid, int msg);
+SYSCALL	sendb(int pid, WORD msg);
+SYSCALL	sendt(int pid, WORD msg, int maxwait);
+SYSCALL	sendn(int pid, WORD *msgs, int n);
+SYSCALL	receiven(WORD *buf, int n);
+SYSCALL	recvnb();
+SYSCALL	msgqinit(int depth);
 SYSCALL	setdev(int pid, int dev1, int dev2);
 SYSCALL	setnok(int nok, int pid);
+SYSCALL	setschedclass(int class);
+SYSCALL	getschedclass();
+SYSCALL	setrate(int pid, int rate);
+SYSCALL	tktransfer(int pid);
 SYSCALL screate(int count);
+SYSCALL mcreate();
+SYSCALL mdelete(int mutex);
+SYSCALL mlock(int mutex);
+SYSCALL munlock(int mutex);
 SYSCALL signal(int sem);
 SYSCALL signaln(int sem, int count);
+int	isignaln(int sem, int count);
 SYSCALL	sleep(int n);
 SYSCALL	sleep10(int n);
 SYSCALL sleep100(int n);
 SYSCALL sleep1000(int n);
+SYSCALL	usleep(int n);
 SYSCALL sreset(int sem, int count);
 SYSCALL stacktrace(int pid);
 SYSCALL	suspend(int pid);
 SYSCALL	unsleep(int pid);
 SYSCALL	wait(int sem);
+SYSCALL	waitany(int *sems, int n);
+SYSCALL	waitall(int *sems, int n);
 
 int strtclk();
 int stopclk();
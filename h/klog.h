@@ -0,0 +1,31 @@
+/* klog.h - kernel log ring */
+
+#ifndef _KLOG_H_
+#define _KLOG_H_
+
+/* klog() formats a message into a ring in memory and returns; the	*/
+/* klogd process, which runs only when nothing else wants the CPU,	*/
+/* copies the ring out to the console. A message that does not fit	*/
+/* is dropped whole and counted. kprintf() still writes straight to	*/
+/* the console and is the one to use when the system is going down.	*/
+
+#define	KLOGSZ		8192		/* bytes in the ring		*/
+#define	KLOGMSG		160		/* longest message kept		*/
+#define	KLOGPRIO	1		/* priority of klogd		*/
+
+#define	KL_ERR		0		/* log levels			*/
+#define	KL_WARN		1
+#define	KL_INFO		2
+#define	KL_DEBUG	3
+
+extern	int	klevel;			/* highest level kept		*/
+extern	unsigned long	kldrops;	/* messages dropped, ring full	*/
+
+/* ANSI compliant function prototypes */
+
+int klog(int level, char *fmt, ...);
+int klflush();
+int klinit();
+PROCESS klogd();
+
+#endif
@@ -68,6 +68,8 @@
 
 #define _3C905_TXRING			16
 #define _3C905_RXRING			16
+#define _3C905_RXBATCH			4	/* rx descriptors refilled */
+						/* at a time		   */
 
 #define _3COM_VENDOR_ID			0x10b7
 #define _3COM_3C905_DEVICE_ID		0x9200
@@ -83,6 +85,8 @@ struct dev_3c905 {
 	unsigned long tx_begin;
 	unsigned long tx_end;
 	unsigned long rx_begin;		/* the end pointer are on the NIC */
+	unsigned long rx_fill;		/* next rx descriptor to refill	  */
+	int	      rx_empty;		/* rx descriptors with no buffer  */
 };
 
 struct eth_pd {
@@ -22,26 +22,23 @@
 
 #define MON_MAX_TRY	3
 
+#define MON_HZ		1000		/* clock interrupts per second,	*/
+					/* the rate clkinit() sets	*/
+
 #define	MON_NETBUFS	32		/* number of network buffers	*/
-					/* max network buffer length    */
-#define	MON_MAXNETBUF	EP_MAXLEN+sizeof(struct ehx)
 
 /* ARP related stuff */
 #define MON_ARP_TSIZE	3 
 extern struct   arpentry  mon_arptable[];
 
-/* network related stuff */
-struct	netinfo	{			/* info and parms. for network	*/
-	int	netpool;		/* network packet buffer pool	*/
-};
-extern  struct  netinfo mon_Net;
-
 extern int mon_boot_state, mon_boot_try;
 extern int mon_tftp_block, mon_tftp_bytes, mon_tftp_retx;
+extern int mon_tftp_blksize, mon_tftp_window;
 extern struct netif *mon_eth_pni; 	/* pointer to network interface */
 extern IPaddr mon_tftp_server;
 extern char mon_boot_fname[];
 extern int mon_clktime, mon_timeout;	/* for retx purpose */
+extern int mon_clkticks;		/* clock interrupts so far	*/
 
 int mon_cmd(char *);
 int mon_ethinit();
@@ -63,13 +60,17 @@ int mon_enq(int q, char *elt, int key);
 int mon_ethwstrt(struct ethdev *ped);
 int mon_udp_in(struct netif *pni, struct ep *pep);
 int enable();
-int mon_tftp_in(struct udp *pudp);
+int mon_tftp_in(struct udp *pudp, long sum);
 int mon_arpsend(struct arpentry *pae);
 int mon_ethdemux(struct ethdev *ped, u_short iobase);
 int mon_newq(int size);
 int mon_ethintr();
 int mon_ni_in(struct netif *pni, struct ep *pep, int len);
 int mon_tftp_ack(int block_no);
+int mon_tftp_timer();
+int mon_bufinit();
+char *mon_getbuf();
+int mon_freebuf(void *buf);
 int mon_pci_init(void);
 int mon_find_pci_device(int deviceID, int vendorID, int index);
 int mon_3c905_ethinit ();
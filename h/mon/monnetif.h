@@ -23,6 +23,5 @@ struct	netif {				/* info about one net interface	*/
 };
 
 extern struct netif	mon_nif[];
-extern	int mon_bufpool;
 
 #endif
@@ -18,6 +18,12 @@
 
 /* Declarations data conversion and checksum routines */
 extern unsigned short 	mon_cksum();    /* 1s comp of 16-bit 1s comp sum*/
+extern unsigned long	mon_cksum_add(void *buf, int len, unsigned long sum);
+					/* add to a partial sum	*/
+extern unsigned long	mon_cksum_copy(void *dst, void *src, int len,
+			    unsigned long sum);	/* the same, copying	*/
+extern unsigned long	mon_cksum_mmx(void *buf, int len, unsigned long sum);
+extern int		mon_hasmmx();	/* may mon_cksum_mmx be used	*/
 
 #if	BYTE_ORDER == LITTLE_ENDIAN
 #define hs2net(x) (unsigned) ((((x)>>8) &0xff) | (((x) & 0xff)<<8))
@@ -2,18 +2,29 @@
 #define _MONTFTP_H_
 
 /*
- * tftp.h -- ref: RFC-1350
+ * tftp.h -- ref: RFC-1350, options: RFC-2347, 2348 (blksize),
+ *	     7440 (windowsize)
  */
 #define TFTP_TRY	          5
 #define TFTP_BLOCK_SIZE		512		/* 512 octets	*/
 #define TFTP_DATA_HDR_SZ	4		/* 4 octets	*/
 #define TFTP_ACK_SZ		4		/* 4 octets	*/
 
+#define TFTP_BLKSIZE		1468	/* asked for: the most that fits */
+					/* in one Ethernet frame	*/
+#define TFTP_WINDOW		8	/* blocks per ACK asked for; the */
+					/* NIC has 16 receive buffers	*/
+#define TFTP_RTO		200	/* clock ticks without data	*/
+					/* before the last ACK is resent */
+
 #define TCTP_TYPE_RRQ		1
 #define TCTP_TYPE_WRQ		2
 #define TFTP_TYPE_DATA		3
 #define TFTP_TYPE_ACK		4
 #define TFTP_TYPE_ERROR		5
+#define TFTP_TYPE_OACK		6
+
+#define TFTP_EOPTION		8	/* error: options refused	*/
 
 #define TFTP_INIT_TID		69
 #define TFTP_MY_TID		62316
@@ -26,7 +37,7 @@ struct tftp_req {
 struct tftp_data {
     short type;
     short block;
-    char data[512];
+    char data[TFTP_BLKSIZE];
 };
 
 struct tftp_ack {
@@ -0,0 +1,37 @@
+#ifndef _MONVIRTIO_H_
+#define _MONVIRTIO_H_
+
+/* the registers and rings are the kernel driver's too (net/vionet.c) */
+#include <virtio.h>
+
+/*
+ * Each packet takes two descriptors, header then frame, so packet i
+ * always uses descriptors 2i and 2i+1 and the chain head says which.
+ */
+#define VIO_RXBUFS			16	/* receive buffers posted */
+#define VIO_RXBATCH			4	/* refilled at a time */
+#define VIO_TXBUFS			16	/* frames in flight */
+
+struct dev_vio {
+	int	      ifn;
+	unsigned long pcidev;
+	unsigned long iobase;
+	unsigned char irq;
+	Eaddr	      hwa;
+	struct virtq  rxq;
+	struct virtq  txq;
+	struct ep    *rxbuf[VIO_RXBUFS];	/* 0 for an empty slot */
+	int	      rx_fill;		/* next slot to refill */
+	int	      rx_empty;		/* slots with no buffer */
+	struct ep    *txbuf[VIO_TXBUFS];	/* 0 for a free slot */
+	int	      tx_free;		/* free tx slots */
+	int	      tx_next;		/* where to look for one */
+};
+
+extern struct dev_vio	mon_dev_vio;
+
+int mon_vio_ethinit();
+int mon_vio_ethintr();
+int mon_vio_ethwrite(struct ep *pep, int len);
+
+#endif
@@ -0,0 +1,173 @@
+/* mp.h - cpu, cpuget, CPUSEL, MP configuration, local APIC */
+
+#ifndef _MP_H_
+#define _MP_H_
+
+/* Intel MultiProcessor Specification 1.4 tables. The BIOS leaves a	*/
+/* floating pointer structure in the last KB of base memory or in the	*/
+/* BIOS ROM; it points at a configuration table that lists one entry	*/
+/* per processor, bus, I/O APIC and interrupt.				*/
+
+#define	NCPU		8		/* processors remembered	*/
+
+#define	MP_FPSIG	0x5f504d5f	/* "_MP_"			*/
+#define	MP_CTSIG	0x504d4350	/* "PCMP"			*/
+
+struct	mpfp	{			/* floating pointer structure	*/
+	unsigned long	fp_sig;		/* MP_FPSIG			*/
+	unsigned long	fp_cfg;		/* physical addr of config table*/
+	unsigned char	fp_len;		/* length in 16 byte units (1)	*/
+	unsigned char	fp_rev;		/* spec revision		*/
+	unsigned char	fp_sum;		/* all bytes add up to 0	*/
+	unsigned char	fp_type;	/* nonzero: a default config	*/
+	unsigned char	fp_feat[4];
+};
+
+struct	mpct	{			/* configuration table header	*/
+	unsigned long	ct_sig;		/* MP_CTSIG			*/
+	unsigned short	ct_len;		/* bytes, header included	*/
+	unsigned char	ct_rev;
+	unsigned char	ct_sum;		/* all ct_len bytes add up to 0	*/
+	char		ct_oem[8];
+	char		ct_prod[12];
+	unsigned long	ct_oemtab;
+	unsigned short	ct_oemlen;
+	unsigned short	ct_count;	/* entries that follow		*/
+	unsigned long	ct_lapic;	/* local APIC physical address	*/
+	unsigned short	ct_xlen;
+	unsigned char	ct_xsum;
+	unsigned char	ct_res;
+};
+
+#define	MP_CPU		0		/* entry types; a processor	*/
+					/* entry is 20 bytes, the rest 8*/
+#define	MP_CPUEN	0x01		/* processor entry flags	*/
+#define	MP_CPUBSP	0x02
+
+struct	mpcpu	{			/* processor entry		*/
+	unsigned char	cpu_type;	/* MP_CPU			*/
+	unsigned char	cpu_apicid;
+	unsigned char	cpu_apicver;
+	unsigned char	cpu_flags;	/* MP_CPUEN, MP_CPUBSP		*/
+	unsigned long	cpu_sig;
+	unsigned long	cpu_feat;
+	unsigned long	cpu_res[2];
+};
+
+/* Local APIC registers (byte offsets) and the bits Xinu uses		*/
+
+#define	LAPIC_ID	0x020		/* id in bits 24-31		*/
+#define	LAPIC_TPR	0x080		/* task priority		*/
+#define	LAPIC_EOI	0x0b0
+#define	LAPIC_SVR	0x0f0		/* spurious vector, enable	*/
+#define	LAPIC_ESR	0x280		/* error status			*/
+#define	LAPIC_ICRLO	0x300		/* interrupt command		*/
+#define	LAPIC_ICRHI	0x310		/*   destination in bits 24-31	*/
+#define	LAPIC_TIMER	0x320		/* local vector table entries	*/
+#define	LAPIC_LINT0	0x350
+#define	LAPIC_LINT1	0x360
+#define	LAPIC_ERROR	0x370
+#define	LAPIC_TICR	0x380		/* timer initial count		*/
+#define	LAPIC_TCCR	0x390		/* timer current count		*/
+#define	LAPIC_TDCR	0x3e0		/* timer divide configuration	*/
+
+#define	LAPIC_ENABLE	0x00100		/* SVR: software enable		*/
+#define	LAPIC_MASKED	0x10000		/* LVT: entry masked		*/
+#define	LAPIC_PERIODIC	0x20000		/* LVT: periodic timer		*/
+#define	LAPIC_NMI	0x00400		/* LVT: deliver as NMI		*/
+#define	LAPIC_EXTINT	0x00700		/* LVT: 8259 passes through	*/
+#define	LAPIC_DIV16	0x3		/* TDCR: bus clock / 16		*/
+
+#define	ICR_INIT	0x00500		/* delivery modes		*/
+#define	ICR_STARTUP	0x00600
+#define	ICR_PENDING	0x01000		/* not yet accepted		*/
+#define	ICR_ASSERT	0x04000
+#define	ICR_LEVEL	0x08000
+#define	ICR_OTHERS	0xc0000		/* all processors but self	*/
+
+/* Vectors for the local APIC, above the 8259's 32-47. The spurious	*/
+/* vector must end in 1111 binary on P6 processors.			*/
+
+#define	IVEC_TIMER	48		/* local APIC timer (SMP)	*/
+#define	IVEC_FLUSH	49		/* IPI: TLB shootdown		*/
+#define	IVEC_REQ	50		/* IPI: see smpreqs()		*/
+#define	IVEC_SPUR	63
+
+extern	int	ncpu;			/* usable processors (>= 1)	*/
+extern	int	cpubsp;			/* index of the boot processor	*/
+extern	unsigned char	cpuapic[];	/* local APIC id per processor	*/
+extern	unsigned long	lapicaddr;	/* local APIC address, or 0	*/
+extern	volatile unsigned long	*lapic;	/* the same, once mapped (SMP)	*/
+
+#ifdef	SMP
+
+/* Per-processor state. Each processor's %fs selects a GDT data	*/
+/* segment based at its own struct cpu, so cpuget() reads a field	*/
+/* of the running processor's in one instruction, which a process	*/
+/* moving to another processor can't split. Everything else is	*/
+/* shared, under the locks lkdisable() takes (see smp.c).		*/
+
+struct	tss;
+
+struct	cpu	{
+	struct	cpu	*c_self;	/* this entry, for cpu()	*/
+	int	c_id;			/* index in cpus[] and cpuapic[]*/
+	int	c_currpid;		/* process running here		*/
+	int	c_rdyhead, c_rdytail;	/* this processor's ready list	*/
+	int	c_lkheld;		/* LK_ bits of the locks held	*/
+	int	c_lkdepth[NLOCK];	/* lkdisable()s of each held	*/
+	int	c_idlepid;		/* runs when nothing else can	*/
+	int	c_reap;			/* pid to free once switched	*/
+					/*   away from, or EMPTY	*/
+	unsigned long	c_psstart;	/* tsc when the current process	*/
+					/*   started (PROPORTIONALSHARE)*/
+	struct	tss	*c_tss;		/* Xinu and page fault TSSs	*/
+	volatile int	c_online;	/* scheduling processes		*/
+	volatile int	c_flush;	/* asked to drop its TLB	*/
+	int	c_kicked;		/* sent IVEC_REQ to look for work*/
+	unsigned long	c_nsteal;	/* processes taken from others	*/
+	unsigned long	c_nswitch;	/* context switches		*/
+};
+
+#define	CPUGD		7		/* GDT entry of the struct cpu;	*/
+#define	CPUSEL		(CPUGD << 3)	/*   each processor has its own	*/
+					/*   GDT (see smp.c)		*/
+
+#define	cpuget(f)	({ int _v;					\
+	asm volatile("movl %%fs:%c1,%0" : "=r" (_v)			\
+		: "i" (__builtin_offsetof(struct cpu, f))); _v; })
+#define	cpu()		((struct cpu *) cpuget(c_self))
+
+#define	currpid		cpuget(c_currpid)
+#define	rdyhead		cpuget(c_rdyhead)
+#define	rdytail		cpuget(c_rdytail)
+
+extern	struct	cpu	cpus[];
+extern	int	rdylists;		/* cpus[0]'s ready list; the	*/
+					/*   others follow it in q	*/
+
+#endif
+
+/* ANSI compliant function prototypes */
+
+int mpinit();
+int smpstart();
+void lapicinit(int bsp);
+#ifdef	SMP
+struct	pentry;
+void smpinit();
+void smpsteal();
+void smpkick();
+void smpreqs();
+void smpipi(int cpuid);
+void smpflush(void *pd);
+int smpidle(int pid);
+int smpquantum();
+void smpswitch(struct pentry *optr, struct pentry *nptr);
+void smpresume();
+void smpnew();
+void lkdisable(STATWORD ps, int locks);
+void lkunlock(int locks);
+#endif
+
+#endif
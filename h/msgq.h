@@ -0,0 +1,22 @@
+/* msgq.h - mqfull */
+
+#ifndef _MSGQ_H_
+#define _MSGQ_H_
+
+/* By default a process has a one message mailbox (pmsg) and send()	*/
+/* fails while it is full. After msgqinit(depth) its messages go in a	*/
+/* ring of depth messages instead and are received in the order they	*/
+/* were sent. phasmsg stays nonzero iff a message is waiting, so the	*/
+/* receive side waits the same way for both.				*/
+
+#define	mqfull(p)	((p)->pmq == NULL ? (p)->phasmsg != 0 :		\
+			 (p)->pmqcount == (p)->pmqsize)
+
+/* ANSI compliant function prototypes */
+
+void mqput(struct pentry *pptr, WORD msg);
+WORD mqget(struct pentry *pptr);
+WORD mqclear(struct pentry *pptr);
+void mqkill(int pid);
+
+#endif
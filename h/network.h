@@ -0,0 +1,76 @@
+/* network.h - hs2net, net2hs, hl2net, net2hl */
+
+#ifndef _NETWORK_H_
+#define _NETWORK_H_
+
+/* UDP/IP over one Ethernet interface. Frames are processed as they	*/
+/* come, in the driver's interrupt handler: ARP, IP with reassembly,	*/
+/* then UDP, which queues the datagram on its socket. Nothing there	*/
+/* waits: buffers come from netpool with nbgetbuf(), so no one ever	*/
+/* waits on the pool and freebuf() never reschedules, and a reader is	*/
+/* readied without rescheduling and netresched set; the handler	*/
+/* reschedules once it is done. The netd process resends ARP requests	*/
+/* and drops stale cache entries and partial datagrams.			*/
+
+#include <ip.h>
+#include <ether.h>
+#include <arp.h>
+#include <udp.h>
+
+#if	BYTE_ORDER == LITTLE_ENDIAN
+#define	hs2net(x)	((unsigned short)((((x)>>8) & 0xff) | (((x) & 0xff)<<8)))
+#define	net2hs(x)	hs2net(x)
+#define	hl2net(x)	((((x) & 0xff)<<24) | (((x)>>24) & 0xff) | \
+			 (((x) & 0xff0000)>>8) | (((x) & 0xff00)<<8))
+#define	net2hl(x)	hl2net(x)
+#else
+#define	hs2net(x)	(x)
+#define	net2hs(x)	(x)
+#define	hl2net(x)	(x)
+#define	net2hl(x)	(x)
+#endif
+
+/* static configuration: QEMU's user networking hands out these	*/
+#define	NET_IP		"10.0.2.15"
+#define	NET_MASK	"255.255.255.0"
+#define	NET_GATEWAY	"10.0.2.2"
+
+#define	NETBUFS		128		/* frames in netpool		*/
+#define	NETDPRIO	100		/* priority of netd		*/
+#define	NETDSTK		4096		/* and its stack		*/
+#define	NETDTICK	1		/* netd runs every 1/10 second	*/
+
+#define	NIS_DOWN	0		/* interface states		*/
+#define	NIS_UP		1
+
+struct	netif	{
+	int	ni_state;
+	IPaddr	ni_ip;			/* network order, all three	*/
+	IPaddr	ni_mask;
+	IPaddr	ni_gateway;
+	Eaddr	ni_hwa;
+	int	(*ni_write)(struct ep *, int);	/* frees the buffer	*/
+	int	ni_pool;		/* netpool			*/
+	int	ni_rpool;		/* reassembly buffers		*/
+	unsigned long	ni_ipackets;	/* frames in			*/
+	unsigned long	ni_idrops;	/* frames in and dropped	*/
+	unsigned long	ni_opackets;	/* frames out			*/
+	unsigned long	ni_odrops;	/* frames out and dropped	*/
+};
+
+extern	struct	netif	nif;
+extern	int	netresched;		/* a handler readied someone	*/
+
+/* the checksum routines are the monitor's (mon/moncksum.S) */
+extern	unsigned short	mon_cksum(void *buf, int len);
+extern	unsigned long	mon_cksum_add(void *buf, int len, unsigned long sum);
+
+/* ANSI compliant function prototypes */
+
+int netinit();
+PROCESS netd();
+int netin(struct ep *pep);
+struct ep *netgetbuf();
+IPaddr dot2ip(char *s);
+
+#endif
@@ -16,6 +16,37 @@
 #define VPNO2VA(vpno) ((unsigned int)(vpno)*NBPG)
 
 
+// Process stacks (VSTACK). Every process has its stack at the top of
+// its own address space, in the region mapped by the last page
+// directory entry. Pages are faulted in as the stack grows; anything
+// in the region below plimit is never mapped and acts as a guard.
+#define VSTK_PDE      (NENTRIES - 1)            /* pd entry for stacks  */
+#define VSTK_MINVPNO  (VSTK_PDE * NENTRIES)     /* first stack region pg*/
+#define VSTK_TOPVPNO  (VSTK_MINVPNO + NENTRIES - 1) /* topmost stack pg */
+#define VSTK_MAXPAGES (NENTRIES - 1)            /* keep >= 1 guard page */
+
+
+// Access hints for xmadvise(). A mapping starts out XM_NORMAL.
+#define XM_NORMAL     0     /* no special treatment                 */
+#define XM_SEQUENTIAL 1     /* read ahead, drop pages behind stream */
+#define XM_RANDOM     2     /* no read-ahead                        */
+#define XM_WILLNEED   3     /* prefault the range in the background */
+#define XM_DONTNEED   4     /* write back and release the range now */
+
+// Flags for xmmapf()
+#define XM_POPULATE   0x1   /* prefault the whole mapping up front  */
+
+// Number of pages read ahead on a fault in an XM_SEQUENTIAL mapping
+#define XM_RAHEAD     4
+
+// Most pages a process may have locked with xmlock() at once
+#define XM_MAXLOCK    (NFRAMES/4)
+
+// Bit in the p_avail field of a page table entry that is set while
+// the process has the page locked with xmlock()
+#define PG_LOCKED     0x1
+
+
 // Macros used to determine the memory eviction policy
 #define FIFO   3
 #define AGING  4
@@ -68,18 +99,45 @@ typedef struct {
 // gpt (global page tables) array to keep up with these page tables.
 extern pt_t * gpt[];
 
+// Page directory shared by processes without private mappings
+extern pd_t * kernpd;
+
+// With SMP one more global page table maps the 4MB that hold the
+// local and I/O APICs, uncached, through page directory entry apicpde
+extern pt_t * apicpt;
+extern int apicpde;
+
 // pd and pt functions
 int init_page_tables();
+int init_apic_pt(unsigned long addr);
 pd_t * pd_alloc();
 pt_t * pt_alloc();
 int pd_free(pd_t * pd);
+int pd_private(int pid);
 int pt_free(pt_t * pt);
+int p_free(pt_t * pt);
 int p_invalidate(int base);
+int p_load(int pid, bs_map_t * bsmptr, int vpno, int spec);
+int p_drop(int pid, int vpno);
+int p_locked(int pid, int vpno);
+int p_lock(int pid, int vpno);
+int p_unlock(int pid, int vpno);
+
+// demand-paged process stacks (see vstack.c)
+int init_pftask(pd_t * pd);
+unsigned long * vstk_alloc(pd_t * pd, int ssize, unsigned long * delta);
+int vstk_fault(int pid, int vpno);
+int vstk_free(int pid);
+int vstk_killcurr();
 
 
 /* Prototypes for required memory API calls */
 SYSCALL xmmap(int, bsd_t, int);
 SYSCALL xmunmap(int);
+SYSCALL xmmapf(int, bsd_t, int, int);
+SYSCALL xmadvise(int, int, int);
+SYSCALL xmlock(int, int);
+SYSCALL xmunlock(int, int);
 SYSCALL vcreate(int *, int, int, int, char *, int, long, ...);
 WORD*   vgetmem(unsigned int);
 SYSCALL vfreemem(struct mblock*, unsigned int);
@@ -71,4 +71,15 @@ __asm__ __volatile__("pushl %0 ; popfl": /* no output */ :"g" (x):"memory")
 #define PCI_COMMAND		    0x04
 #define PCI_BUSMASTER		    0x04
 
+/* ANSI compliant function prototypes */
+
+SYSCALL pci_init(void);
+SYSCALL find_pci_device(int deviceID, int vendorID, int index);
+SYSCALL pci_bios_read_config_byte(unsigned long dev, int where, unsigned char *value);
+SYSCALL pci_bios_read_config_word(unsigned long dev, int where, unsigned short *value);
+SYSCALL pci_bios_read_config_dword(unsigned long dev, int where, unsigned long *value);
+SYSCALL pci_bios_write_config_byte(unsigned long dev, int where, unsigned char value);
+SYSCALL pci_bios_write_config_word(unsigned long dev, int where, unsigned short value);
+SYSCALL pci_bios_write_config_dword(unsigned long dev, int where, unsigned long value);
+
 #endif /* _PCI_H */
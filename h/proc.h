@@ -30,15 +30,20 @@
 #define PRSUSP      '\006'      /* process is suspended     */
 #define PRWAIT      '\007'      /* process is on semaphore queue*/
 #define PRTRECV     '\010'      /* process is timing a receive  */
+#define PRDEAD      '\011'      /* killed, stack not yet freed  */
+                                /*   (SMP; see kill.c)          */
+#define PRWANY      '\012'      /* process is in waitany()      */
 
 /* process rescheduleing policy */
 
+#define PRIOSCHED               0
 #define RANDOMSCHED             1
 #define PROPORTIONALSHARE       2
 
 /* miscellaneous process definitions */
 
 #define PNMLEN      16      /* length of process "name" */
+#define NWANY       8       /* most semaphores in a waitany */
 
 #define NULLPROC    0       /* id of the null process; it   */
                     /*  is always eligible to run   */
@@ -68,11 +73,30 @@ struct  pentry  {
     int fildes[_NFILE];     /* file - device translation    */
     int ppagedev;           /* pageing dgram device     */
     int pwaitret;
+    unsigned pgen;          /* bumped each time create()    */
+                            /*   reuses this slot           */
 
 /* for process scheduling*/
         int     ppolicy;                /* process scheduling policy    */
-        int     ppi;                    /* priority value in psp        */
-        int     prate;                  /* rate value in psp            */
+        int     ppi;                    /* virtual time in psp          */
+        int     prate;                  /* rate value in psp, tickets   */
+                                        /*   in lottery                 */
+        int     pxferto;                /* tickets lent here if blocked */
+        int     pbprio;                 /* pprio without inheritance    */
+        int     pmutex;                 /* first mutex held, or EMPTY   */
+
+/* for message queues (see msgq.h) */
+        WORD    *pmq;                   /* ring of messages, or NULL if */
+                                        /*   pmsg is the only mailbox   */
+        int     pmqsize;                /* messages the ring holds      */
+        int     pmqhead;                /* index of the oldest one      */
+        int     pmqcount;               /* messages in the ring         */
+        int     pmqsem;                 /* senders wait here when full  */
+
+/* for waitany (see waitany.c) */
+        int     pwn;                    /* semaphores waited on         */
+        int     pwsem[NWANY];           /* the semaphores               */
+        int     pwlink[NWANY];          /* next waiter on pwsem[i]      */
 
 /* for demand paging */
         pd_t * pd;               /* pointer to page directory in memory */
@@ -81,12 +105,37 @@ struct  pentry  {
         int    hsize;            /* vheap size (in pages)        */
         struct mblock vmemlist;  /* vheap list                   */
         bs_map_t map[NBS];       /* A map for each backing store */
+        int    pnpinned;         /* pages locked with xmlock()   */
+
+#ifdef  SMP
+/* for running on several processors (see smp.c) */
+        int     pcpu;                   /* processor it last ran on     */
+        int     plkdepth[NLOCK];        /* c_lkdepth while switched out */
+        int     psmpreq;                /* PRQ_KILL/PRQ_SUSP from a     */
+                                        /*   processor not running it   */
+#endif
 };
 
+#define PRQ_KILL    1       /* psmpreq: kill it where it runs   */
+#define PRQ_SUSP    2       /*   suspend it there           */
+
 
 extern  struct  pentry proctab[];
 extern  int numproc;        /* currently active processes   */
 extern  int nextproc;       /* search point for free slot   */
+#ifdef  SMP
+#define setcurrpid(pid) (cpu()->c_currpid = (pid))
+#else
 extern  int currpid;        /* currently executing process  */
+#define setcurrpid(pid) (currpid = (pid))
+#endif
+extern  int schedclass;     /* PRIOSCHED, RANDOMSCHED, ...  */
+
+void schedinit();
+void schedadd(int pid);
+void schedremove(int pid);
+void schedstop(int pid);
+int schedpick();
+void schedkill(int pid);
 
 #endif
@@ -1,4 +1,4 @@
-/* q.h - firstid, firstkey, isempty, lastkey, nonempty */
+/* q.h - firstid, firstkey, isempty, isrdyhead, lastkey, nonempty */
 
 #ifndef _QUEUE_H_
 #define _QUEUE_H_
@@ -6,8 +6,12 @@
 /* q structure declarations, constants, and inline procedures		*/
 
 #ifndef	NQENT
+#ifdef	SMP
+#define	NQENT		NPROC + NSEM + NSEM + 2 + 2*NCPU /* sleep, ready*/
+#else
 #define	NQENT		NPROC + NSEM + NSEM + 4	/* for ready & sleep	*/
 #endif
+#endif
 
 struct	qent	{		/* one for each process plus two for	*/
 				/* each list				*/
@@ -27,6 +31,15 @@ extern	int	nextqueue;
 #define lastkey(tail)	(q[q[(tail)].qprev].qkey)
 #define firstid(list)	(q[(list)].qnext)
 
+/* the ready lists: with SMP one per processor, allocated together	*/
+
+#ifdef	SMP
+#define	isrdyhead(h)	((h) >= rdylists && (h) < rdylists + 2*NCPU &&	\
+			 (((h) - rdylists) & 1) == 0)
+#else
+#define	isrdyhead(h)	((h) == rdyhead)
+#endif
+
 /* gpq constants */
 
 #define	QF_WAIT		0	/* use semaphores to mutex		*/
@@ -42,5 +55,10 @@ int insertd(int pid, int head, int key);
 int insert(int proc, int head, int key);
 int getfirst(int head);
 int getlast(int tail);
+void rdyinit(int head);
+int rdyinsert(int pid, int head, int prio);
+void rdyremove(int item);
+int rdyheadof(int pid);
+int rdycount(int head);
 
 #endif
@@ -15,10 +15,31 @@ struct	sentry	{		/* semaphore table entry		*/
 	int	semcnt;		/* count for this semaphore		*/
 	int	sqhead;		/* q index of head of list		*/
 	int	sqtail;		/* q index of tail of list		*/
+	Bool	smutex;		/* TRUE iff created by mcreate		*/
+	int	sowner;		/* mutex holder, or BADPID		*/
+	int	snext;		/* next mutex held by sowner, or EMPTY	*/
+	int	sany;		/* first waitany() waiter, or EMPTY	*/
 };
 extern	struct	sentry	semaph[];
 extern	int	nextsem;
 
 #define	isbadsem(s)	(s<0 || s>=NSEM)
 
+/* A mutex is a semaphore with an owner (see mutex.c). Its waiters are	*/
+/* queued by priority and the owner runs at the highest priority of	*/
+/* any process waiting for a mutex it holds (priority inheritance).	*/
+/* The counting semaphore calls return SYSERR for a mutex id.	*/
+
+void mprio(int pid);
+void mkill(int pid);
+
+/* A process in waitany() is not on the queue of any of its		*/
+/* semaphores; it is on a list of its own per semaphore, linked	*/
+/* through pwlink (see waitany.c). It only waits while the count is	*/
+/* <= 0, and processes on the queue are started first.		*/
+
+void wanysignal(int sem, int resch);
+void wanydelete(int sem);
+void wanykill(int pid);
+
 #endif
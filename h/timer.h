@@ -0,0 +1,67 @@
+/* timer.h - tmarmed, TM_MS, TM_US */
+
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+/* Timers are kept in a hierarchical timing wheel keyed by tick. Level	*/
+/* 0 has one slot per tick for the next TM_L0SIZE ticks; each level	*/
+/* above covers TM_LNSIZE times the span of the one below and is	*/
+/* cascaded down a level when the one below wraps. Five levels cover	*/
+/* 2^32 ticks, more than the longest timeout.				*/
+
+/* With the periodic clock a wheel tick is a clock tick (ctr1000).	*/
+/* With TICKLESS the clock is one-shot and a tick is a microsecond	*/
+/* (ctrusec), so timeouts are not rounded up to whole milliseconds.	*/
+
+#ifdef	TICKLESS
+#define	TM_HZ		1000000		/* wheel ticks per second	*/
+#else
+#define	TM_HZ		1000
+#endif
+#define	TM_MS(ms)	((unsigned long)(ms) * (TM_HZ / 1000))
+#define	TM_US(us)	(((unsigned long)(us) + 1000000 / TM_HZ - 1) / \
+			 (1000000 / TM_HZ))
+
+#define	TM_L0BITS	8
+#define	TM_LNBITS	6
+#define	TM_L0SIZE	(1 << TM_L0BITS)
+#define	TM_LNSIZE	(1 << TM_LNBITS)
+#define	TM_NLEVELS	5		/* level 0 plus four above it	*/
+#define	TM_MAXTICKS	0x7fffffffUL	/* longest timeout tmset takes	*/
+
+struct	tmentry	{			/* one armed timer		*/
+	struct	tmentry	*tm_next;	/* next in slot, or NULL	*/
+	struct	tmentry	**tm_pprev;	/* link that points at this one;*/
+					/* NULL iff the timer is idle	*/
+	unsigned long	tm_expires;	/* wheel tick it fires at	*/
+	void	(*tm_func)(int);	/* called with interrupts off	*/
+	int	tm_arg;			/* argument passed to tm_func	*/
+};
+
+#define	tmarmed(t)	((t)->tm_pprev != NULL)
+
+/* ANSI compliant function prototypes */
+
+void tminit();
+void tmclear(struct tmentry *t);
+int tmset(struct tmentry *t, unsigned long ticks, void (*func)(int), int arg);
+int tmcancel(struct tmentry *t);
+int tmadvance();
+unsigned long tmnext();
+int tmsleep(int pid, unsigned long ticks);
+int tmunsleep(int pid);
+void clkperiodic();
+void clkspin(int ms);
+unsigned long clktsc();
+
+#ifdef	TICKLESS
+extern	unsigned long	ctrusec;	/* microseconds 0-INF (wraps)	*/
+extern	unsigned long	clkevents;	/* clock interrupts so far	*/
+
+void clkupdate();
+unsigned long clknow();
+void clkarm();
+void clkquantum();
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+/* trace.h - tracepoints and the trace ring */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+/* A tracepoint stores a fixed-size binary record (TSC, event, pid and	*/
+/* four arguments) in a ring that keeps the last NTRACE records. The	*/
+/* tracepoints are always compiled in; each costs one test of		*/
+/* tracemask while its category is off. tracedump() sends the ring	*/
+/* to the host, where tools/tracedec turns it into a timeline.		*/
+
+#define	NTRACE		2048		/* records kept (a power of 2)	*/
+
+/* categories, set with settrace() */
+#define	TRC_PAGE	0x0001		/* page faults			*/
+#define	TRC_FRAME	0x0002		/* frame allocation and freeing	*/
+#define	TRC_BS		0x0004		/* backing store reads, writes	*/
+#define	TRC_SCHED	0x0008		/* context switches		*/
+#define	TRC_SEM		0x0010		/* wait and signal		*/
+#define	TRC_INTR	0x0020		/* clock and serial interrupts	*/
+#define	TRC_ALL		0x003f
+
+/* events; the arguments recorded are given for each */
+#define	TE_PFINT	1		/* faulting address		*/
+#define	TE_FRMALLOC	2		/* frame id			*/
+#define	TE_FRMFREE	3		/* frame id, type, dirty	*/
+#define	TE_READBS	4		/* bs id, page			*/
+#define	TE_WRITEBS	5		/* bs id, page			*/
+#define	TE_RESCHED	6		/* old pid, new pid, old state	*/
+#define	TE_WAIT		7		/* sem, count before		*/
+#define	TE_SIGNAL	8		/* sem, count before		*/
+#define	TE_INTR		9		/* vector; IIR for a serial line */
+
+struct	trent	{			/* one trace record, 32 bytes	*/
+	unsigned long	tr_tsclo;	/* time stamp counter		*/
+	unsigned long	tr_tschi;
+	unsigned long	tr_seq;		/* records made before this one	*/
+	unsigned short	tr_event;	/* TE_*				*/
+	short		tr_pid;		/* currpid when it was made	*/
+	unsigned long	tr_arg[4];
+};
+
+/* tracedump() output: a header, then the records oldest first. On	*/
+/* the debug port (QEMU -debugcon file:trace.bin) it is the raw bytes;	*/
+/* on the console each is a line of hex words starting with "TR".	*/
+
+#define	TRD_DEBUGCON	0		/* binary to port 0xe9		*/
+#define	TRD_CONSOLE	1		/* hex text with kprintf()	*/
+
+#define	TR_DBGPORT	0xe9
+#define	TR_MAGIC	0x43525458	/* "XTRC"			*/
+
+struct	trhdr	{
+	unsigned long	th_magic;	/* TR_MAGIC			*/
+	unsigned long	th_size;	/* sizeof(struct trent)		*/
+	unsigned long	th_count;	/* records that follow		*/
+	unsigned long	th_khz;		/* TSC ticks per millisecond	*/
+};
+
+extern	int	tracemask;		/* categories being traced	*/
+extern	void	(*trintr)();		/* called by clkint if TRC_INTR	*/
+
+#define	TRACE(cat, ev, a0, a1, a2, a3)	do {				\
+	if (tracemask & (cat))						\
+		trace((ev), (long)(a0), (long)(a1), (long)(a2), (long)(a3)); \
+} while (0)
+
+/* ANSI compliant function prototypes */
+
+void trace(int event, long a0, long a1, long a2, long a3);
+int settrace(int mask);
+int tracedump(int how);
+
+#endif
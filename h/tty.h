@@ -41,6 +41,7 @@ struct tty {
 	unsigned char	 tty_oflags;	/* TOF_* below			*/
 	unsigned short	 tty_ostart;	/* index of first character	*/
 	unsigned short	 tty_ocount;	/* # characters in output buffer*/
+	unsigned short	 tty_oready;	/* # of those to be sent now	*/
 	unsigned char	 tty_out[OBLEN];
 	int		 tty_rows;
 	int		 tty_cols;
@@ -85,4 +86,9 @@ struct tty {
 
 extern struct tty	ttytab[];
 
+int	ttyiin();
+int	ttyiinn(struct devsw *pdev, unsigned char *buf, int n);
+int	ttyoin(struct devsw *pdev, unsigned char *buf, int n);
+int	ttyostart(struct tty *ptty, int all);
+
 #endif
@@ -0,0 +1,78 @@
+/* udp.h - UDP_DATA */
+
+#ifndef _UDP_H_
+#define _UDP_H_
+
+#include <timer.h>
+
+#define	U_HLEN		8		/* UDP header length		*/
+#define	U_MAXDATA	(EP_DLEN-IPMHLEN-U_HLEN)	/* longest write*/
+
+struct	udp	{			/* fields in network order	*/
+	unsigned short	u_src;		/* source port			*/
+	unsigned short	u_dst;		/* destination port		*/
+	unsigned short	u_len;		/* header and data octets	*/
+	unsigned short	u_cksum;	/* 0 if none			*/
+	char	u_data[1];
+};
+
+/* Each UDP device is a socket. open(UDPn, "a.b.c.d:port", lport)	*/
+/* binds it to local port lport (0 picks one) and, unless the remote	*/
+/* is NULL, connects it: then it only hears from there and writes go	*/
+/* there. read() waits for one datagram and copies it out; write()	*/
+/* sends one. Datagrams queue on the socket as the buffers they came	*/
+/* in, so UDPC_RECV can hand one over without a copy, and UDPC_SEND	*/
+/* sends a buffer from netgetbuf() filled in at UDP_DATA().		*/
+
+#define	UDP_QLEN	16		/* datagrams queued per socket	*/
+#define	UDP_PORT0	49152		/* ports picked for lport 0	*/
+#define	UDP_NPORT	16384
+
+#define	US_FREE		0		/* socket states		*/
+#define	US_OPEN		1
+
+struct	udpsock	{
+	int	us_state;
+	int	us_dnum;		/* the device			*/
+	unsigned short	us_lport;	/* host order			*/
+	unsigned short	us_rport;	/* host order, 0 if unconnected	*/
+	IPaddr	us_raddr;		/* 0 if unconnected		*/
+	int	us_rsem;		/* counts datagrams queued	*/
+	struct	ep	*us_q[UDP_QLEN];
+	int	us_qhead;
+	int	us_qlen;
+	int	us_timeout;		/* ms a read waits, 0 forever	*/
+	int	us_tmfired;		/* the read timer woke a reader	*/
+	struct	tmentry	us_tm;
+	unsigned long	us_drops;	/* datagrams lost, queue full	*/
+};
+
+/* control functions */
+
+#define	UDPC_REMOTE	1		/* connect to arg1 (an IPaddr),	*/
+					/* port arg2; 0 unconnects	*/
+#define	UDPC_TIMEOUT	2		/* reads wait arg1 ms at most	*/
+#define	UDPC_RECV	3		/* *(struct ep **)arg1 = the	*/
+					/* next datagram, *(char **)arg2*/
+					/* = its data; returns length	*/
+#define	UDPC_SEND	4		/* send arg1 (a struct ep *),	*/
+					/* arg2 octets at UDP_DATA()	*/
+#define	UDPC_DROPS	5		/* return us_drops		*/
+
+#define	UDP_DATA(pep)	((pep)->ep_data + IPMHLEN + U_HLEN)
+
+extern	struct	udpsock	udptab[];
+
+/* ANSI compliant function prototypes */
+
+int udpinit(struct devsw *devptr);
+int udpopen(struct devsw *devptr, char *remote, int lport);
+int udpclose(struct devsw *devptr);
+int udpread(struct devsw *devptr, char *buf, int len);
+int udpwrite(struct devsw *devptr, char *buf, int len);
+int udpcntl(struct devsw *devptr, int func, int arg1, int arg2);
+int udp_in(struct ep *pep);
+int udpsend(struct udpsock *pus, struct ep *pep, int len);
+int udpnextdg(struct udpsock *pus, struct ep **ppep, char **pdata);
+
+#endif
@@ -0,0 +1,38 @@
+/* vionet.h - the kernel's virtio-net driver */
+
+#ifndef _VIONET_H_
+#define _VIONET_H_
+
+#include <virtio.h>
+
+/* Packet i takes descriptors 2i (the virtio header) and 2i+1 (the	*/
+/* frame, in a netpool buffer), so the chain head says which it is.	*/
+
+#define	VIONRXBUFS	32		/* receive buffers posted	*/
+#define	VIONRXBATCH	8		/* refilled at a time		*/
+#define	VIONTXBUFS	32		/* frames in flight		*/
+
+struct	vionet	{
+	unsigned long	vn_pcidev;
+	unsigned long	vn_iobase;
+	unsigned char	vn_irq;
+	struct	virtq	vn_rxq;
+	struct	virtq	vn_txq;
+	struct	ep	*vn_rxbuf[VIONRXBUFS];	/* 0 for an empty slot	*/
+	int	vn_rxfill;		/* next slot to refill		*/
+	int	vn_rxempty;		/* slots with no buffer		*/
+	struct	ep	*vn_txbuf[VIONTXBUFS];	/* 0 for a free slot	*/
+	int	vn_txfree;
+	int	vn_txnext;		/* where to look for one	*/
+};
+
+extern	struct	vionet	vionet;
+
+/* ANSI compliant function prototypes */
+
+int vioinit();
+INTPROC vioint();
+int viointr();
+int viowrite(struct ep *pep, int len);
+
+#endif
@@ -0,0 +1,100 @@
+/* virtio.h - legacy virtio-net registers and split virtqueues */
+
+#ifndef _VIRTIO_H_
+#define _VIRTIO_H_
+
+/* virtio-net over PCI, through the legacy (0.9.5) I/O port interface	*/
+/*	- the transitional device QEMU gives with -device virtio-net-pci */
+
+#define VIO_VENDOR_ID			0x1af4
+#define VIO_NET_DEVICE_ID		0x1000	/* transitional virtio-net */
+
+#define VIO_PCI_IOBASE			0x10
+#define VIO_PCI_IRQ			0x3C
+
+/* legacy registers, from BAR 0 */
+#define VIO_OFF_HOSTFEAT		0x00	/* 32 */
+#define VIO_OFF_GUESTFEAT		0x04	/* 32 */
+#define VIO_OFF_QADDR			0x08	/* 32, page number */
+#define VIO_OFF_QSIZE			0x0C	/* 16 */
+#define VIO_OFF_QSEL			0x0E	/* 16 */
+#define VIO_OFF_QNOTIFY			0x10	/* 16 */
+#define VIO_OFF_STATUS			0x12	/* 8 */
+#define VIO_OFF_ISR			0x13	/* 8, cleared on read */
+#define VIO_OFF_MAC			0x14	/* device config, no MSI-X */
+
+#define VIO_STT_ACK			0x01	/* device status */
+#define VIO_STT_DRIVER			0x02
+#define VIO_STT_DRIVEROK		0x04
+#define VIO_STT_FAILED			0x80
+
+#define VIO_NET_F_MAC			(1 << 5)
+
+#define VIO_ISR_QUEUE			0x1
+
+#define VIO_RXQ				0	/* queue numbers */
+#define VIO_TXQ				1
+
+/* split virtqueue */
+#define VIO_QMAX			256	/* largest queue we take */
+#define VIO_ALIGN			4096	/* legacy used ring alignment */
+
+#define VRING_DESC_F_NEXT		1
+#define VRING_DESC_F_WRITE		2
+#define VRING_AVAIL_F_NO_INTERRUPT	1
+#define VRING_USED_F_NO_NOTIFY		1
+
+struct vring_desc {
+	unsigned long	addr;		/* 64 bits on the device's side */
+	unsigned long	addr_hi;
+	unsigned long	len;
+	unsigned short	flags;
+	unsigned short	next;
+};
+
+struct vring_avail {
+	unsigned short	flags;
+	unsigned short	idx;
+	unsigned short	ring[VIO_QMAX];
+};
+
+struct vring_used_elem {
+	unsigned long	id;		/* head of the descriptor chain */
+	unsigned long	len;		/* octets the device wrote */
+};
+
+struct vring_used {
+	unsigned short	flags;
+	unsigned short	idx;
+	struct vring_used_elem ring[VIO_QMAX];
+};
+
+/* the device works on the rings behind our back: VIO_WMB() keeps the	*/
+/* compiler from moving memory accesses across it, VIO_MB() also keeps	*/
+/* the CPU from doing a later load before an earlier store		*/
+#define VIO_WMB()	__asm__ __volatile__("" : : : "memory")
+#define VIO_MB()	__asm__ __volatile__("lock; addl $0,0(%%esp)" : : : "memory")
+
+/* legacy queue layout: descriptors, avail ring, used ring on a page */
+#define VIO_QBYTES(n)	((((16 * (n) + 6 + 2 * (n)) + VIO_ALIGN - 1) & \
+			  ~(VIO_ALIGN - 1)) + 6 + 8 * (n))
+
+struct virtq {
+	int		     size;	/* entries, as the device says */
+	struct vring_desc   *desc;
+	volatile struct vring_avail *avail;
+	volatile struct vring_used  *used;
+	unsigned short	     lastused;	/* next used entry to look at */
+};
+
+/* every frame goes with this header, in a descriptor of its own */
+struct vio_nethdr {
+	unsigned char	flags;
+	unsigned char	gso_type;
+	unsigned short	hdr_len;
+	unsigned short	gso_size;
+	unsigned short	csum_start;
+	unsigned short	csum_offset;
+};
+
+#endif
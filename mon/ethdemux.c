@@ -80,7 +80,7 @@ static int rcv_frame(struct ethdev *ped, u_short port, u_short len)
 {
     struct ep   *pep;
     
-    pep = (struct ep *)nbgetbuf(mon_bufpool);
+    pep = (struct ep *)mon_getbuf();
     if (pep == 0) {
 #ifdef PRINTERR
         kprintf("rcv_frame: ?? no buffer\n");
@@ -118,7 +118,7 @@ static int rcv_frame(struct ethdev *ped, u_short port, u_short len)
      * pass it to upper layer; may cause context switch
      */
     if (mon_nif[0].ni_state == NIS_DOWN)
-	freebuf(pep);
+	mon_freebuf(pep);
     else {
 	/*
 	 * may cause context switch
@@ -15,9 +15,11 @@
 #include <./mon/mon3com.h>
 #include <./mon/monintel.h>
 #include <./mon/monpci.h>
+#include <./mon/monvirtio.h>
 #include <stdio.h>
 
 struct ethdev    mon_eth[1];
+static int       mon_outqok;	/* mon_eth[0].ed_outq has been made */
 
 extern int mon_ethwrite(struct ep*, int);
 static int eep_probe(struct ethdev *ped, u_short iobase);
@@ -37,10 +39,18 @@ static int config_593(u_short iobase);
 int mon_ethinit()
 {
     struct ethdev *ped;
+    struct ep *pep;
     u_short iobase;
 
     ped = &mon_eth[0];
-    ped->ed_outq = mon_newq(16);
+    if (mon_outqok) {
+	/* a boot attempt failed: free what it left to send */
+	while ((pep = (struct ep *) mon_deq(ped->ed_outq)) != NULL)
+	    mon_freebuf(pep);
+    } else {
+	ped->ed_outq = mon_newq(16);
+	mon_outqok = TRUE;
+    }
     ped->ed_iobase = 0;		/* auto search */
 
     iobase = ped->ed_iobase;
@@ -58,6 +68,11 @@ int mon_ethinit()
 	    kprintf("ethinit: Found 3COM 3c905 card, configuring.\n");
 	    mon_3c905_ethinit();
 	    return OK;
+	} else if (mon_find_pci_device(VIO_NET_DEVICE_ID, VIO_VENDOR_ID, 0) == OK) {
+	    /* found a virtio-net device (QEMU/KVM) */
+	    kprintf("ethinit: Found virtio-net device, configuring.\n");
+	    if (mon_vio_ethinit() == OK)
+		return OK;
 	} else if (mon_find_pci_device(_INTEL_PRO100_DEVICE_ID, _INTEL_VENDOR_ID, 0) == OK) {
 	    /* found the Intel Pro/100 card */
 	    kprintf("ethinit: Intel Pro/100 S found -- can't configure\n");
@@ -28,7 +28,7 @@ int             len;
 #ifdef PRINTERRORS
         kprintf("eep_write: len(%d) > EP_MAXLEN(%d)\n", len, EP_MAXLEN);
 #endif
-        freebuf(pep);
+        mon_freebuf(pep);
         return SYSERR;
     }
 
@@ -45,7 +45,7 @@ int             len;
 
     if (mon_enq(ped->ed_outq, (char *) pep, 0) < 0) {
         kprintf("eep_write: qull full (len=%d)\n", mon_lenq(ped->ed_outq));
-        freebuf(pep);
+        mon_freebuf(pep);
     }
     
     disable(ps);
@@ -118,7 +118,7 @@ struct ethdev    *ped;
 	ped->ed_tx_chain_cnt = pep->ep_len;
 	ped->ed_tx_end = end;
 
-	freebuf(pep);
+	mon_freebuf(pep);
 
 #ifdef DEBUG
 	kprintf("eep_wstrt: chain=%d, chain_c=%d, st=%d, end=%d, avail=%d\n",
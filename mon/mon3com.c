@@ -13,12 +13,11 @@
 */
 
 /*#define DEBUG*/
-#define MAX_RCV			10		/* maximum packets per int */
-#define GETBUF			getbuf		/* non-blocking getbuf     */
 
 extern int mon_ethint_hi();
 
 int mon_3c905_ethwrite(struct ep*, int);
+static int mon_3c905_rxfill(struct dev_3c905 *dev);
 
 struct dev_3c905 mon_dev_eth;
 struct eth_pd* mon_eth_txring;
@@ -46,13 +45,40 @@ int ethcmdwait(struct dev_3c905 *dev, unsigned short cmd, unsigned short arg)
     return SYSERR;
 }
 
+/*
+ * mon_3c905_reclaim - stop the NIC and free the buffers an earlier
+ *		       mon_3c905_ethinit() left in the rings, so that a
+ *		       second boot attempt starts with all of them free
+ */
+static void mon_3c905_reclaim(dev)
+struct dev_3c905* dev;
+{
+    struct eth_pd* epd;
+    int i;
+
+    ethcmdwait(dev, _3C905_CMD_RXRESET, 0x7);	/* no more DMA */
+    ethcmdwait(dev, _3C905_CMD_TXRESET, 0x3);
+    for (i = 0; i < _3C905_RXRING; i++) {
+        epd = &mon_eth_rxring[i];
+        if (epd->buffer) {
+            mon_freebuf(epd->buffer - sizeof(struct ehx));
+            epd->buffer = 0;
+        }
+    }
+    while (dev->tx_begin != (dev->tx_end + 1) % _3C905_TXRING) {
+        epd = &mon_eth_txring[dev->tx_begin];
+        mon_freebuf(epd->buffer - sizeof(struct ehx));
+        dev->tx_begin = (dev->tx_begin + 1) % _3C905_TXRING;
+    }
+}
+
 int mon_3c905_ethinit () 
 {
     struct dev_3c905* dev;
     struct netif*     pni;
     struct ethdev*    ped;
     unsigned short    status;
-    unsigned char*    buf;
+    STATWORD          ps;
     int i;
 
     dev = &mon_dev_eth;
@@ -69,6 +95,13 @@ int mon_3c905_ethinit ()
     /* if mem address is below 1 MB */
     dev->membase &= ~2;
 
+    /* the rings are set up: this is another boot attempt */
+    if (mon_eth_rxring) {
+        disable(ps);
+        mon_3c905_reclaim(dev);
+        restore(ps);
+    }
+
     /* enable PCI bus master */
     mon_pci_bios_read_config_word(dev->pcidev, PCI_COMMAND, &status);
     status |= PCI_BUSMASTER;
@@ -98,16 +131,15 @@ int mon_3c905_ethinit ()
     mon_eth_rxring = (struct eth_pd*) (((unsigned long) rxring + 0xF) & ~0xF);
     for (i = 0; i < _3C905_RXRING; i++) {
         mon_eth_rxring[i].next   = &mon_eth_rxring[(i + 1) % _3C905_RXRING];
-        mon_eth_rxring[i].status = 0;
-        buf = (unsigned char*) GETBUF(mon_Net.netpool); 
-        if (buf == (unsigned char *)SYSERR || buf == (unsigned char *)0) {
-            kprintf("No buffer in ethinit()");
-            panic("could not allocate buffer for monitor");
-        }
-        mon_eth_rxring[i].buffer = (void*) buf + sizeof(struct ehx);
-        mon_eth_rxring[i].length = _3C905_FLG_LASTFRAG | EP_MAXLEN;
+        mon_eth_rxring[i].status = _3C905_FLG_UPCOMPLETE;	/* ours */
+        mon_eth_rxring[i].buffer = 0;
+    }
+    dev->rx_begin = dev->rx_fill = 0;
+    dev->rx_empty = _3C905_RXRING;
+    if (mon_3c905_rxfill(dev) != _3C905_RXRING) {
+        kprintf("No buffer in ethinit()");
+        panic("could not allocate buffer for monitor");
     }
-    dev->rx_begin = 0;
     bzero(mon_eth_txring, sizeof(struct eth_pd) * _3C905_TXRING);
     dev->tx_begin = 0;
     dev->tx_end   = _3C905_TXRING - 1;
@@ -145,7 +177,6 @@ int mon_3c905_ethinit ()
 int mon_3c905_ethintr() {
     STATWORD          ps;
     struct dev_3c905* dev;
-    struct eth_pd*    epd;
     unsigned long     intst, txst;
 
     disable(ps);
@@ -191,22 +222,12 @@ int mon_3c905_ethintr() {
             outb(dev->iobase + _3C905_OFF_TXSTATUS, 1);
         }
         if (dev->state & _3C905_STT_RECLAIM) {
-            while (1) {
-                epd = &mon_eth_rxring[dev->rx_begin];
-                if (epd->status == 0 || epd->buffer != 0) {
-                    dev->state &= ~_3C905_STT_RECLAIM;
-                    break;
-                }
-		epd->buffer = (void*) GETBUF(mon_Net.netpool);
-                if (epd->buffer == (void *)0 || epd->buffer == (void *)SYSERR) {
-                    epd->buffer = 0;
-                    break;
-                }
-                epd->status = 0;
-                epd->buffer = (void*) epd->buffer + sizeof(struct ehx);
-                epd->length = _3C905_FLG_LASTFRAG | EP_MAXLEN;
-                dev->rx_begin = (dev->rx_begin + 1) % _3C905_RXRING;
-            }
+            mon_3c905_rxfill(dev);	/* buffers may be back now */
+            if (dev->rx_empty == 0)
+                dev->state &= ~_3C905_STT_RECLAIM;
+            if (inl(dev->iobase + _3C905_OFF_UPPKTSTATUS) &
+                _3C905_FLG_UPSTALLED)
+                _3CCMD(dev, _3C905_CMD_UPUNSTALL, 0);
         }
     }
 #ifdef DEBUG
@@ -217,17 +238,23 @@ int mon_3c905_ethintr() {
     return(OK);
 }
 
+/*
+ * Receive ring: the NIC uploads each frame straight into the buffer of
+ * the next descriptor, and the buffer goes up to mon_ni_in() as it is.
+ * The descriptor then stays ours (upComplete left set, no buffer) until
+ * mon_3c905_rxfill() gives it a new one; that is done _3C905_RXBATCH
+ * descriptors at a time, or at once if the NIC has had to stall.
+ * rx_begin is the next descriptor to look at, rx_fill the next to fill.
+ */
 int mon_3c905_ethdemux (dev) 
 struct dev_3c905* dev;
 {
     struct eth_pd* epd;
     struct ep*     pep;
     unsigned long  status;
-    int len, nopackets;
-
-    nopackets = MAX_RCV;
+    int len, n;
 
-    while (nopackets--) {
+    for (n = _3C905_RXRING - dev->rx_empty; n > 0; n--) {
         epd = &mon_eth_rxring[dev->rx_begin];
         status = epd->status;
         
@@ -238,44 +265,56 @@ struct dev_3c905* dev;
 #ifdef DEBUG
             kprintf("ethdemux: packet error\n");
 #endif
-            epd->status = 0;
-            epd->length = _3C905_FLG_LASTFRAG | EP_MAXLEN;
+            mon_freebuf(epd->buffer - sizeof(struct ehx));
         } else {
-            if (epd->buffer) {
-                dev->state &= ~_3C905_STT_RECLAIM;
-                len = status & _3C905_MSK_PKTLENGTH;
-                pep = (struct ep*) (epd->buffer - sizeof(struct ehx));
-                pep->ep_ifn  = dev->ifn;
-                pep->ep_len  = len;
-                pep->ep_type = net2hs(pep->ep_type);
-#if 1
-                mon_ni_in(&mon_nif[dev->ifn], pep, len);
-#else
-                freebuf(pep);
-#endif
-            }
-
-            epd->buffer = (void*) GETBUF(mon_Net.netpool);
-            if (epd->buffer == (void *)SYSERR || epd->buffer == (void *)0) {
-#ifdef DEBUG
-                kprintf("ethdemux: no buffer\n");
-#endif
-                epd->buffer = NULL;
-                dev->state |= _3C905_STT_RECLAIM;
-                break;
-            }
-            epd->status = 0;
-            epd->buffer = (void*) epd->buffer + sizeof(struct ehx);
-            epd->length = _3C905_FLG_LASTFRAG | EP_MAXLEN;
+            len = status & _3C905_MSK_PKTLENGTH;
+            pep = (struct ep*) (epd->buffer - sizeof(struct ehx));
+            pep->ep_ifn  = dev->ifn;
+            pep->ep_len  = len;
+            pep->ep_type = net2hs(pep->ep_type);
+            mon_ni_in(&mon_nif[dev->ifn], pep, len);
         }
+        epd->buffer = 0;
+        dev->rx_empty++;
         dev->rx_begin = (dev->rx_begin + 1) % _3C905_RXRING;
     }
+
     status = inl(dev->iobase + _3C905_OFF_UPPKTSTATUS);
+    if (dev->rx_empty >= _3C905_RXBATCH || (status & _3C905_FLG_UPSTALLED)) {
+        mon_3c905_rxfill(dev);
+        if (dev->rx_empty > 0)
+            dev->state |= _3C905_STT_RECLAIM;	/* short of buffers */
+    }
     if (status & _3C905_FLG_UPSTALLED)
         _3CCMD(dev, _3C905_CMD_UPUNSTALL, 0);
     return(OK);
 }
 
+/*
+ * mon_3c905_rxfill - give buffers to the empty descriptors, in ring
+ *		      order, for as long as there are buffers; returns
+ *		      how many were filled
+ */
+static int mon_3c905_rxfill(dev)
+struct dev_3c905* dev;
+{
+    struct eth_pd* epd;
+    char*          buf;
+    int n;
+
+    for (n = 0; dev->rx_empty > 0; n++) {
+        if ((buf = mon_getbuf()) == 0)
+            break;
+        epd = &mon_eth_rxring[dev->rx_fill];
+        epd->buffer = (void*) buf + sizeof(struct ehx);
+        epd->length = _3C905_FLG_LASTFRAG | EP_MAXLEN;
+        epd->status = 0;		/* now the NIC's */
+        dev->rx_empty--;
+        dev->rx_fill = (dev->rx_fill + 1) % _3C905_RXRING;
+    }
+    return(n);
+}
+
 int mon_3c905_ethxintr(dev)
 struct dev_3c905* dev;
 {
@@ -306,7 +345,7 @@ struct dev_3c905* dev;
 
         epd->status = 0;
         pep = (struct ep*) (epd->buffer - sizeof(struct ehx));
-        freebuf(pep);
+        mon_freebuf(pep);
         dev->tx_begin = (dev->tx_begin + 1) % _3C905_TXRING;
     }
     return(OK);
@@ -342,7 +381,7 @@ int len;
 #ifdef DEBUG
         kprintf("ethwrite: buffer full: %d %d\n", dev->tx_end, dev->tx_begin);
 #endif
-        freebuf(pep);
+        mon_freebuf(pep);
         return SYSERR;
     }
 
@@ -15,15 +15,21 @@ struct  arpentry        *mon_arpfind(), *mon_arpalloc();
 struct	arpentry	mon_arptable[MON_ARP_TSIZE];
 
 /*------------------------------------------------------------------------
- * mon_arpinit  -  initialize data structures for ARP processing
+ * mon_arpinit  -  initialize data structures for ARP processing, freeing
+ *		   any packet an earlier boot attempt left waiting
  *------------------------------------------------------------------------
  */
 void mon_arpinit()
 {
     int	i;
 
-    for (i=0; i<MON_ARP_TSIZE; ++i)
+    for (i=0; i<MON_ARP_TSIZE; ++i) {
+	if (mon_arptable[i].ae_pep) {
+	    mon_freebuf(mon_arptable[i].ae_pep);
+	    mon_arptable[i].ae_pep = 0;
+	}
 	mon_arptable[i].ae_state = AS_FREE;
+    }
 }
 
 /*------------------------------------------------------------------------
@@ -42,7 +48,7 @@ int mon_arp_in(struct netif *pni, struct ep *pep)
     parp->ar_op = net2hs(parp->ar_op);
 
     if (parp->ar_hwtype != AR_HARDWARE || parp->ar_prtype != EPT_IP) {
-	freebuf(pep);
+	mon_freebuf(pep);
 	return OK;
     }
     
@@ -51,7 +57,7 @@ int mon_arp_in(struct netif *pni, struct ep *pep)
     }
     
     if (!mon_blkequ(TPA(parp), (char *)&pni->ni_ip, IP_ALEN)) {
-	freebuf(pep);
+	mon_freebuf(pep);
 	return OK;
     }
     
@@ -95,7 +101,7 @@ int mon_arp_in(struct netif *pni, struct ep *pep)
 	mon_nif[0].ni_write(pep, arplen);
 	/* mon_ethwrite(pep, arplen); */
     } else
-	freebuf(pep);
+	mon_freebuf(pep);
     return OK;
 }
 
@@ -154,8 +160,8 @@ int mon_arpsend(struct arpentry *pae)
     struct	arp	*parp;
     int		arplen;
 
-    pep = (struct ep *)getbuf(mon_bufpool);
-    if ((int)pep == SYSERR)
+    pep = (struct ep *)mon_getbuf();
+    if (pep == 0)
 	return SYSERR;
     
     blkcopy(pep->ep_dst, pni->ni_hwb.ha_addr, EP_ALEN);
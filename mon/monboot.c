@@ -14,6 +14,7 @@ int mon_boot_state;
 struct netif *mon_eth_pni = &mon_nif[0];	/* network interface */
 int mon_boot_try = 0;
 int mon_clktime = 0;		/* tick once per sec. for retx purpose */
+int mon_clkticks = 0;		/* every clock interrupt, for TFTP */
 int mon_timeout = 0;		/* when to send a retx; 0: stop	retx */
 int mon_first_req = 0;
 
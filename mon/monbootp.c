@@ -88,7 +88,7 @@ int mon_bootp_request(int secs)
     struct ip *pip;
     struct udp *pup;
 
-    pep = (struct ep *)getbuf(mon_bufpool);
+    pep = (struct ep *)mon_getbuf();
     if (pep == 0) {
 #ifdef PRINTERR
 	kprintf("bootp_request: !! no buffer\n");
@@ -0,0 +1,67 @@
+#include <./mon/monnetwork.h>
+#include <./mon/monitor.h>
+#include <stdio.h>
+
+/*
+ * The monitor's own network buffers, so that it needs none of the
+ * buffer pool routines in sys/: MON_NETBUFS frames on a free list that
+ * runs through the first word of each. The 3c905 receives straight into
+ * them and hands them up as they are; whoever ends up with one gives it
+ * back with mon_freebuf().
+ */
+#define MON_BUFSZ	((sizeof(struct ep) + 15) & ~15)
+
+static char	mon_bufs[MON_NETBUFS][MON_BUFSZ];
+static char	*mon_buffree;		/* first free buffer, or 0 */
+
+/*-------------------------------------------------------------------------
+ * mon_bufinit - put every buffer on the free list; only once, from
+ *		 mon_init(), since it forgets any buffer still held
+ *-------------------------------------------------------------------------
+ */
+int mon_bufinit()
+{
+    STATWORD ps;
+    int i;
+
+    disable(ps);
+    mon_buffree = 0;
+    for (i = 0; i < MON_NETBUFS; i++) {
+	*(char **)mon_bufs[i] = mon_buffree;
+	mon_buffree = mon_bufs[i];
+    }
+    restore(ps);
+    return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * mon_getbuf - take a buffer without waiting; 0 if there is none
+ *-------------------------------------------------------------------------
+ */
+char *mon_getbuf()
+{
+    STATWORD ps;
+    char *buf;
+
+    disable(ps);
+    if ((buf = mon_buffree) != 0) {
+	mon_buffree = *(char **)buf;
+    }
+    restore(ps);
+    return(buf);
+}
+
+/*-------------------------------------------------------------------------
+ * mon_freebuf - give a buffer back
+ *-------------------------------------------------------------------------
+ */
+int mon_freebuf(void *buf)
+{
+    STATWORD ps;
+
+    disable(ps);
+    *(char **)buf = mon_buffree;
+    mon_buffree = buf;
+    restore(ps);
+    return(OK);
+}
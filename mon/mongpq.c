@@ -3,6 +3,12 @@
 #include <stdio.h>
 
 /* generic priority queue processing functions */
+
+/*
+ * Same scheme as sys/gpq.c: a binary heap on (key, enq order), kept as
+ * a ring while every item has the same key (the ethernet output queue
+ * only ever uses key 0).
+ */
 struct	qinfo {
 	char	q_valid;
 	int	q_max;
@@ -11,12 +17,120 @@ struct	qinfo {
 	int	q_mutex;
 	int	*q_key;
 	char	**q_elt;
+	unsigned long	*q_seq;		/* enq order, for equal keys	*/
+	unsigned long	q_nextseq;
+	char	q_ring;			/* all keys equal, kept as ring	*/
+	int	q_head;			/* ring: index of the head	*/
 };
 
 #define	MAXNQ 	32	
 
 static	struct	qinfo mon_Q[MAXNQ];
 
+/*------------------------------------------------------------------------
+ * mon_qprec -- does item (k1,s1) come out before item (k2,s2)?
+ *------------------------------------------------------------------------
+ */
+static int mon_qprec(int k1, unsigned long s1, int k2, unsigned long s2)
+{
+    return k1 > k2 || (k1 == k2 && (long)(s1 - s2) < 0);
+}
+
+/*------------------------------------------------------------------------
+ * mon_qset -- store an item in slot i
+ *------------------------------------------------------------------------
+ */
+static void mon_qset(struct qinfo *qp, int i, char *elt, int key,
+		     unsigned long seq)
+{
+    qp->q_elt[i] = elt;
+    qp->q_key[i] = key;
+    qp->q_seq[i] = seq;
+}
+
+/*------------------------------------------------------------------------
+ * mon_qup -- move the item in slot i up the heap to where it belongs
+ *------------------------------------------------------------------------
+ */
+static void mon_qup(struct qinfo *qp, int i)
+{
+    char	*elt = qp->q_elt[i];
+    int	key = qp->q_key[i];
+    unsigned long	seq = qp->q_seq[i];
+    int	parent;
+
+    while (i > 0) {
+	parent = (i - 1) / 2;
+	if (!mon_qprec(key, seq, qp->q_key[parent], qp->q_seq[parent]))
+	    break;
+	mon_qset(qp, i, qp->q_elt[parent], qp->q_key[parent],
+		 qp->q_seq[parent]);
+	i = parent;
+    }
+    mon_qset(qp, i, elt, key, seq);
+}
+
+/*------------------------------------------------------------------------
+ * mon_qdown -- move the item in slot i down the heap to where it belongs
+ *------------------------------------------------------------------------
+ */
+static void mon_qdown(struct qinfo *qp, int i)
+{
+    char	*elt = qp->q_elt[i];
+    int	key = qp->q_key[i];
+    unsigned long	seq = qp->q_seq[i];
+    int	child;
+
+    while ((child = 2 * i + 1) < qp->q_count) {
+	if (child + 1 < qp->q_count &&
+	    mon_qprec(qp->q_key[child+1], qp->q_seq[child+1],
+		      qp->q_key[child], qp->q_seq[child]))
+	    child++;
+	if (!mon_qprec(qp->q_key[child], qp->q_seq[child], key, seq))
+	    break;
+	mon_qset(qp, i, qp->q_elt[child], qp->q_key[child],
+		 qp->q_seq[child]);
+	i = child;
+    }
+    mon_qset(qp, i, elt, key, seq);
+}
+
+/*------------------------------------------------------------------------
+ * mon_qreverse -- reverse slots lo through hi
+ *------------------------------------------------------------------------
+ */
+static void mon_qreverse(struct qinfo *qp, int lo, int hi)
+{
+    char	*elt;
+    int	key;
+    unsigned long	seq;
+
+    for ( ; lo < hi ; lo++, hi--) {
+	elt = qp->q_elt[lo];
+	key = qp->q_key[lo];
+	seq = qp->q_seq[lo];
+	mon_qset(qp, lo, qp->q_elt[hi], qp->q_key[hi], qp->q_seq[hi]);
+	mon_qset(qp, hi, elt, key, seq);
+    }
+}
+
+/*------------------------------------------------------------------------
+ * mon_qunring -- turn a ring into a heap: rotate its head to slot 0
+ *------------------------------------------------------------------------
+ */
+static void mon_qunring(struct qinfo *qp)
+{
+    int	h = qp->q_head;
+
+    if (h != 0) {
+	mon_qreverse(qp, 0, h - 1);
+	mon_qreverse(qp, h, qp->q_max - 1);
+	mon_qreverse(qp, 0, qp->q_max - 1);
+    }
+    qp->q_head = 0;
+    qp->q_ring = FALSE;
+}
+
 /*------------------------------------------------------------------------
  * mon_enq  --	insert an item at the tail of a list, based on priority
  *	Returns the number of slots available; -1, if full
@@ -29,7 +143,7 @@ int mon_enq(int q, char *elt, int key)
 {
     STATWORD	ps;
     struct	qinfo	*qp;
-    int	i, j, left;
+    int	i, left;
 
     if (q < 0 || q >= MAXNQ)
 	return -1;
@@ -40,24 +154,24 @@ int mon_enq(int q, char *elt, int key)
 
     disable(ps);
 
-    /* start at tail and move towards head, as long as key is greater */
-
     /* this shouldn't happen, but... */
     if (qp->q_count < 0)
 	qp->q_count = 0;
-    i = qp->q_count-1;
-
-    while(i >= 0 && key > qp->q_key[i])
-	--i;
-    /* i can be -1 (new head) -- it still works */
 
-    for (j = qp->q_count-1; j > i; --j) {
-	qp->q_key[j+1] = qp->q_key[j];
-	qp->q_elt[j+1] = qp->q_elt[j];
+    if (qp->q_ring &&
+	(qp->q_count == 0 || key == qp->q_key[qp->q_head])) {
+	i = qp->q_head + qp->q_count;	/* same key: ring tail	*/
+	if (i >= qp->q_max)
+	    i -= qp->q_max;
+	mon_qset(qp, i, elt, key, qp->q_nextseq++);
+	qp->q_count++;
+    } else {
+	if (qp->q_ring)
+	    mon_qunring(qp);
+	i = qp->q_count++;
+	mon_qset(qp, i, elt, key, qp->q_nextseq++);
+	mon_qup(qp, i);
     }
-    qp->q_key[i+1] = key;
-    qp->q_elt[i+1] = elt;
-    qp->q_count++;
     left = qp->q_max - qp->q_count;
 
     restore(ps);
@@ -87,13 +201,22 @@ char *mon_deq(int q)
 
     disable(ps);
 
-    elt = qp->q_elt[0];
-
-    for (i=1; i<qp->q_count; ++i) {
-	qp->q_elt[i-1] = qp->q_elt[i];
-	qp->q_key[i-1] = qp->q_key[i];
+    if (qp->q_ring) {
+	elt = qp->q_elt[qp->q_head];
+	if (++qp->q_head == qp->q_max)
+	    qp->q_head = 0;
+	qp->q_count--;
+    } else {
+	elt = qp->q_elt[0];
+	if (--qp->q_count > 0) {
+	    i = qp->q_count;
+	    mon_qset(qp, 0, qp->q_elt[i], qp->q_key[i], qp->q_seq[i]);
+	    mon_qdown(qp, 0);
+	} else {
+	    qp->q_ring = TRUE;		/* empty: a ring again	*/
+	    qp->q_head = 0;
+	}
     }
-    qp->q_count--;
     restore(ps);
     return(elt);
 }
@@ -118,9 +241,14 @@ int mon_newq(int size)
     qp->q_max = size;
     qp->q_count = 0;
     qp->q_seen = -1;
+    qp->q_nextseq = 0;
+    qp->q_ring = TRUE;
+    qp->q_head = 0;
     qp->q_elt = (char **) getmem(sizeof(char *) * size);
     qp->q_key = (int *) getmem(sizeof(int) * size);
-    if (qp->q_key == (int *) SYSERR || qp->q_elt == (char **) SYSERR)
+    qp->q_seq = (unsigned long *) getmem(sizeof(unsigned long) * size);
+    if (qp->q_key == (int *) SYSERR || qp->q_elt == (char **) SYSERR ||
+	qp->q_seq == (unsigned long *) SYSERR)
 	return -1;
     return i;
 }
@@ -168,7 +296,7 @@ char * mon_headq(int q)
         qp = &mon_Q[q];
 
         disable(ps);
-        elt = qp->q_elt[0];
+        elt = qp->q_elt[qp->q_ring ? qp->q_head : 0];
         restore(ps);
         return(elt);
 }
@@ -24,7 +24,7 @@ int mon_ip_in(struct netif *pni, struct ep *pep)
 #ifdef PRINTERR
 	kprintf("ip_in: !! bad version\n");
 #endif
-	freebuf(pep);
+	mon_freebuf(pep);
 	return(OK);
     }
     
@@ -32,7 +32,7 @@ int mon_ip_in(struct netif *pni, struct ep *pep)
 #ifdef PRINTERR
 	kprintf("mon_ip_in: class E IP??\n");
 #endif
-	freebuf(pep);
+	mon_freebuf(pep);
 	return(OK);
     }
     
@@ -40,7 +40,7 @@ int mon_ip_in(struct netif *pni, struct ep *pep)
 #ifdef PRINTERR
 	kprintf("ip_in: !! bad checksum\n");
 #endif
-	freebuf(pep);
+	mon_freebuf(pep);
 	return(OK);
     }
 
@@ -62,7 +62,7 @@ int mon_ip_in(struct netif *pni, struct ep *pep)
 #ifdef DEBUG
 	kprintf("mon_ip_in: Not UDP, proto tyep = %d\n", pip->ip_proto);
 #endif
-	freebuf(pep);
+	mon_freebuf(pep);
 	return(OK);
     }
     return(OK);
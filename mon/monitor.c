@@ -12,7 +12,6 @@
 #include <./mon/monnetwork.h>
 #include <./mon/monitor.h>
 #include <./mon/moni386.h>
-#include <bufpool.h>
 #include <stdio.h>
 
 #define MON_PROMPT	"monitor> "
@@ -20,8 +19,6 @@
 extern short girmask;
 extern int console_dev;
 
-struct  netinfo mon_Net;
-
 /*-------------------------------------------------------------------------
  * monitor -
  * NOTE: assume all interrupts disabled.
@@ -104,8 +101,10 @@ int mon_cmd(char *str)
 	
 	/*
 	 * init ethernet interface, ARP, nif[] structures, and interrupts
+	 * (the buffer free list is built once, by mon_init(); after a
+	 * failed attempt mon_ethinit() and mon_arpinit() hand back the
+	 * buffers the last one left in the rings and the ARP table)
 	 */
-	mon_Net.netpool = mkpool(MON_MAXNETBUF, MON_NETBUFS);
 	mon_ethinit();
 	mon_arpinit();
 	mon_netinit();
@@ -1,10 +1,8 @@
 #include <./mon/monnetwork.h>
 #include <./mon/moni386.h>
 #include <./mon/monitor.h>
-#include <bufpool.h>
 #include <stdio.h>
 
-int		mon_bufpool;
 struct	netif	mon_nif[1];
 IPaddr		mon_ip_maskall = -1;
 IPaddr		mon_ip_anyaddr = 0;
@@ -18,7 +16,7 @@ IPaddr		mon_ip_anyaddr = 0;
 int mon_init()
 {
     mon_initq();
-    mon_bufpool = mkpool(1530, 16);
+    mon_bufinit();
     return(OK);
 }
 
@@ -31,6 +29,7 @@ int mon_netinit()
     struct ethdev *ped = &mon_eth[0];
     extern short girmask;
     extern int   mon_clkint();	/* clock int. handler, for retx purpose */
+    extern void  clkperiodic();	/* undoes TICKLESS's one-shot mode */
     
     blkcopy(mon_nif[0].ni_hwa.ha_addr, ped->ed_paddr, EP_ALEN);
     blkcopy(mon_nif[0].ni_hwb.ha_addr, ped->ed_bcast, EP_ALEN);
@@ -44,6 +43,7 @@ int mon_netinit()
      * 3. call enable() to enable clock & ethernet interrupts.
      */
     set_evec(IRQBASE, (unsigned int) mon_clkint);
+    clkperiodic();
     girmask = (girmask & ~(1 << ped->ed_irq));
     enable();
     return(OK);
@@ -74,7 +74,7 @@ int		len;		/* length, in octets	*/
 	break;
 	
     default:
-	freebuf(pep);
+	mon_freebuf(pep);
 	return OK;
     }
     return(OK);
@@ -95,7 +95,7 @@ int		len;
     STATWORD	ps;
 
     if (pni->ni_state != NIS_UP) {
-	freebuf(pep);
+	mon_freebuf(pep);
 	return SYSERR;
     }
     
@@ -123,7 +123,7 @@ int		len;
 	}
 	else if (pae->ae_state == AS_PENDING) {
 	    if (pae->ae_pep)
-		freebuf(pae->ae_pep);
+		mon_freebuf(pae->ae_pep);
 	    pae->ae_pep = pep;
 	    mon_arpsend(pae);
 	    restore(ps);
@@ -7,14 +7,26 @@
 int mon_tftp_block;		/* tftp block count */
 int mon_tftp_bytes;		/* tftp byte count */
 int mon_tftp_retx;              /* TFTP ACK retx count */
+int mon_tftp_blksize;		/* block size agreed on */
+int mon_tftp_window;		/* blocks per ACK agreed on */
 short mon_tftp_server_port;
 IPaddr mon_tftp_server;
 char *mon_tftp_memloc;
 
+static int mon_tftp_opts = 1;	/* ask for options; 0 once refused */
+static int mon_tftp_inwin;	/* blocks taken since the last ACK */
+static int mon_tftp_reacked;	/* gap already re-ACKed, or -1 */
+static int mon_tftp_due;	/* tick to resend the ACK at, or 0 */
+static int mon_tftp_start;	/* tick the request went out at */
+
 #define CONTINUE	99
 
 int mon_tftp_ack(int block_no);
 int mon_netwrite(struct ep *pep, int len);
+static int mon_tftp_oack(char *p, int len);
+static int mon_tftp_sumok(struct udp *pudp, long sum);
+static int mon_tftp_opteq(char *s, char *name);
+static int mon_tftp_opt(struct tftp_req *req, int len, char *name, int val);
 
 /*
 #define PRINTERR
@@ -23,68 +35,202 @@ int mon_netwrite(struct ep *pep, int len);
 */
 
 /*-------------------------------------------------------------------------
- * mon_tftp_in - 
+ * mon_tftp_in - take a DATA, OACK or ERROR packet. Blocks are copied in
+ *		 as they arrive in order and ACKed once per window (RFC
+ *		 7440); a block out of order makes it ACK the last one it
+ *		 has, once, so the server sends the window again from there.
+ *		 sum is -1 if the UDP checksum has been checked (or there
+ *		 is none), else the partial sum of all before the data:
+ *		 the data is then added in as it is copied.
  *-------------------------------------------------------------------------
  */
-int mon_tftp_in(struct udp *pudp)
+int mon_tftp_in(struct udp *pudp, long sum)
 {
     struct tftp_data *rd;
-    int nbytes, diff;
+    int nbytes, diff, ms;
 
     mon_tftp_server_port = pudp->u_src;
     
     rd = (struct tftp_data *) pudp->u_data;
     rd->type = net2hs(rd->type);
+
+    if (rd->type == TFTP_TYPE_OACK) {	/* options follow the type */
+	if (mon_tftp_block != 1 || mon_tftp_bytes != 0)
+	    return (CONTINUE);		/* too late, data has come */
+	if (!mon_tftp_sumok(pudp, sum))
+	    return (CONTINUE);
+	if (mon_tftp_oack((char *)&rd->block, pudp->u_len - U_HLEN - 2)
+	    != OK) {
+	    mon_tftp_opts = 0;
+	    mon_tftp_due = 0;
+	    return SYSERR;
+	}
+	mon_tftp_ack(0);
+	mon_tftp_due = mon_clkticks + TFTP_RTO;
+	return (CONTINUE);
+    }
+
     rd->block = net2hs(rd->block);
+    nbytes = pudp->u_len - TFTP_DATA_HDR_SZ - U_HLEN;
 
     if (rd->type == TFTP_TYPE_ERROR) {
+	if (!mon_tftp_sumok(pudp, sum))
+	    return (CONTINUE);
 #ifdef PRINTERR
 	kprintf("TFTP: Received error (code = %d)\n", rd->block);
 #endif
+	if (rd->block == TFTP_EOPTION && mon_tftp_opts) {
+	    kprintf("TFTP: options refused, asking without them\n");
+	    mon_tftp_opts = 0;
+	}
+	mon_tftp_due = 0;
 	return SYSERR;
     }
-    
-    if (rd->block != mon_tftp_block) {
+
+    if (rd->type != TFTP_TYPE_DATA || nbytes < 0 ||
+	nbytes > mon_tftp_blksize)
+	return (CONTINUE);
+
+    diff = (short)(rd->block - mon_tftp_block);	/* blocks wrap at 64K */
+    if (diff != 0) {
+	if (!mon_tftp_sumok(pudp, sum))
+	    return (CONTINUE);
 #ifdef PRINTERR
 	kprintf("TFTP: expecting block %d, got %d\n", mon_tftp_block,
-		rd->block);
+		rd->block & 0xffff);
 #endif
-	diff = mon_tftp_block - rd->block;
-	if (diff == 1)
-		mon_tftp_ack(rd->block);	/* lost ACK? */
-	else if  (diff == -1)
-		mon_tftp_ack(mon_tftp_block); 	/* lost DATA? */
+	if (mon_tftp_reacked != mon_tftp_block) {
+	    mon_tftp_ack((mon_tftp_block - 1) & 0xffff);  /* lost DATA */
+	    mon_tftp_reacked = mon_tftp_block;		  /* or ACK */
+	    mon_tftp_inwin = 0;
+	}
 	return (CONTINUE);
     }
 
     /*
-     * copy to memory, then ACK
+     * copy to memory, checking the sum on the way if it is still to be
+     * done: a bad block is left to be overwritten, as if it was lost.
+     * Then ACK if it ends a window.
      */
-    nbytes = pudp->u_len - TFTP_DATA_HDR_SZ - U_HLEN;
-    blkcopy(mon_tftp_memloc, rd->data, nbytes);
+    if (sum < 0)
+	blkcopy(mon_tftp_memloc, rd->data, nbytes);
+    else if (mon_cksum_copy(mon_tftp_memloc, rd->data, nbytes, sum)
+	     != 0xffff) {
+#ifdef PRINTERR
+	kprintf("TFTP: !! UDP checksum error in block %d\n", mon_tftp_block);
+#endif
+	return (CONTINUE);
+    }
     mon_tftp_memloc += nbytes;
     mon_tftp_bytes += nbytes;
+    mon_tftp_reacked = -1;
+    mon_tftp_retx = 0;
 
-    /*
-     * ACK it
-     */
-    mon_tftp_ack(mon_tftp_block);
-
-    if ((mon_tftp_block % 2) == 0)
-	kprintf(".");
-
-    if (nbytes < TFTP_BLOCK_SIZE) {
-	kprintf("\ntotal = %d octets.\n", mon_tftp_bytes);
+    if (nbytes < mon_tftp_blksize) {
+	mon_tftp_ack(mon_tftp_block);
+	mon_tftp_due = 0;
+	ms = (mon_clkticks - mon_tftp_start) * (1000 / MON_HZ);
+	kprintf("\ntotal = %d octets in %d ms", mon_tftp_bytes, ms);
+	if (ms > 0)
+	    kprintf(" (%d KB/s)", mon_tftp_bytes / ms);
+	kprintf(", %d-octet blocks, window %d.\n", mon_tftp_blksize,
+		mon_tftp_window);
 	return OK;
     }
+
+    if (++mon_tftp_inwin >= mon_tftp_window) {
+	mon_tftp_ack(mon_tftp_block);
+	mon_tftp_inwin = 0;
+    }
+
+    if ((mon_tftp_bytes & 0x7fff) < nbytes)	/* each 32K */
+	kprintf(".");
     
-    mon_tftp_block++;
+    mon_tftp_block = (mon_tftp_block + 1) & 0xffff;
+    mon_tftp_due = mon_clkticks + TFTP_RTO;
 
     return (CONTINUE);
 }	
 
 /*-------------------------------------------------------------------------
- * mon_tftp_req - send a TFTP request
+ * mon_tftp_oack - take the options the server agreed to; SYSERR if it
+ *		   answered with values that were not asked for
+ *-------------------------------------------------------------------------
+ */
+static int mon_tftp_oack(char *p, int len)
+{
+    char *end = p + len, *name, *val;
+    int n;
+
+    while (p < end) {
+	name = p;
+	p += strlen(p) + 1;
+	if (p >= end)
+	    break;
+	val = p;
+	p += strlen(p) + 1;
+	n = atoi(val);
+	if (mon_tftp_opteq(name, "blksize")) {
+	    if (n < 8 || n > TFTP_BLKSIZE)
+		return SYSERR;
+	    mon_tftp_blksize = n;
+	} else if (mon_tftp_opteq(name, "windowsize")) {
+	    if (n < 1 || n > TFTP_WINDOW)
+		return SYSERR;
+	    mon_tftp_window = n;
+	}
+    }
+#ifdef VERBOSE
+    kprintf("TFTP: blksize %d, windowsize %d\n", mon_tftp_blksize,
+	    mon_tftp_window);
+#endif
+    return OK;
+}
+
+/*-------------------------------------------------------------------------
+ * mon_tftp_opteq - compare an option name, ignoring case
+ *-------------------------------------------------------------------------
+ */
+static int mon_tftp_opteq(char *s, char *name)
+{
+    for (; *name; s++, name++)
+	if ((*s | 0x20) != *name)
+	    return 0;
+    return *s == '\0';
+}
+
+/*-------------------------------------------------------------------------
+ * mon_tftp_timer - called on each clock interrupt (mon_clkint): once the
+ *		    transfer has started, resend the last ACK when no data
+ *		    has come for TFTP_RTO ticks
+ *-------------------------------------------------------------------------
+ */
+int mon_tftp_timer()
+{
+    if (mon_tftp_due == 0 || mon_clkticks - mon_tftp_due < 0)
+	return(OK);
+    if (mon_boot_state != TFTP_REQ_SENT) {
+	mon_tftp_due = 0;
+	return(OK);
+    }
+    if (mon_tftp_retx++ >= TFTP_TRY) {
+	kprintf("mon_tftp_timer: too many retransmissions\n");
+	mon_boot_state = BOOT_ERROR;
+	mon_tftp_due = 0;
+	return(OK);
+    }
+#ifdef PRINTERR
+    kprintf("mon_tftp_timer: RETX TFTP ACK=%d\n", mon_tftp_block-1);
+#endif
+    mon_tftp_ack((mon_tftp_block - 1) & 0xffff);
+    mon_tftp_inwin = 0;
+    mon_tftp_due = mon_clkticks + TFTP_RTO;
+    return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * mon_tftp_req - send a TFTP request, with blksize and windowsize
+ *		  options unless the server has refused them
  *-------------------------------------------------------------------------
  */
 int mon_tftp_req()
@@ -95,7 +241,7 @@ int mon_tftp_req()
     struct udp *pup;
     int len, slen;
 
-    pep = (struct ep *)getbuf(mon_bufpool);
+    pep = (struct ep *)mon_getbuf();
     if (pep == 0) {
 #ifdef PRINTERR
 	kprintf("tftp_req: !! no buffer\n");
@@ -114,6 +260,10 @@ int mon_tftp_req()
     strcpy(req.data, mon_boot_fname);
     strcpy(&req.data[slen + 1], "octet");
     len = sizeof(req.type) + slen + 1 + 5 + 1;
+    if (mon_tftp_opts) {
+	len = mon_tftp_opt(&req, len, "blksize", TFTP_BLKSIZE);
+	len = mon_tftp_opt(&req, len, "windowsize", TFTP_WINDOW);
+    }
 #ifdef DEBUG
     kprintf("mon_tftp_req: file name = [%s], len=%d, udp len=%d\n",
 	    mon_boot_fname, slen, len);
@@ -147,6 +297,12 @@ int mon_tftp_req()
 
     mon_tftp_memloc = (char *)BOOTPLOC;
     mon_tftp_block = mon_tftp_bytes = 0;
+    mon_tftp_blksize = TFTP_BLOCK_SIZE;	/* until an OACK says more */
+    mon_tftp_window = 1;
+    mon_tftp_inwin = 0;
+    mon_tftp_reacked = -1;
+    mon_tftp_due = 0;
+    mon_tftp_start = mon_clkticks;
 
     /* use ARP to get server's hardware address */
     /* (mon_nif[0].ni_write)(pep, EP_HLEN+net2hs(pip->ip_len)); */
@@ -154,6 +310,38 @@ int mon_tftp_req()
     return(OK);
 }
 
+/*-------------------------------------------------------------------------
+ * mon_tftp_opt - add an option and its value to a request of len octets
+ *-------------------------------------------------------------------------
+ */
+static int mon_tftp_opt(struct tftp_req *req, int len, char *name, int val)
+{
+    char *p = (char *)req + len;
+
+    strcpy(p, name);
+    p += strlen(name) + 1;
+    sprintf(p, "%d", val);
+    return len + strlen(name) + 1 + strlen(p) + 1;
+}
+
+/*-------------------------------------------------------------------------
+ * mon_tftp_sumok - finish the UDP checksum of a packet that is not
+ *		    copied out, if it was left to mon_tftp_in
+ *-------------------------------------------------------------------------
+ */
+static int mon_tftp_sumok(struct udp *pudp, long sum)
+{
+    if (sum < 0)
+	return 1;
+    sum = mon_cksum_add(pudp->u_data + TFTP_DATA_HDR_SZ,
+			pudp->u_len - U_HLEN - TFTP_DATA_HDR_SZ, sum);
+#ifdef PRINTERR
+    if (sum != 0xffff)
+	kprintf("TFTP: !! UDP checksum error\n");
+#endif
+    return (sum == 0xffff);
+}
+
 /*-------------------------------------------------------------------------
  * mon_tftp_ack - ACK a TFTP data packet
  *-------------------------------------------------------------------------
@@ -165,7 +353,7 @@ int mon_tftp_ack(int block_no)
     struct ip *pip;
     struct udp *pup;
 
-    pep = (struct ep *)getbuf(mon_bufpool);
+    pep = (struct ep *)mon_getbuf();
     if (pep == 0) {
 #ifdef PRINTERR
 	kprintf("tftp_ack: !! no buffer\n");
@@ -199,8 +387,6 @@ int mon_tftp_ack(int block_no)
     /* now set the ethernet info */
     pep->ep_nexthop = mon_tftp_server;
     pep->ep_eh.eh_type = EPT_IP;
-    
-    mon_timeout = mon_clktime + 2;    /* start retx timer */
 
     /* use ARP to get server's hardware address */
     /* return((mon_nif[0].ni_write)(pep, EP_HLEN+U_HLEN+IPMHLEN+TFTP_ACK_SZ)); */
@@ -15,24 +15,9 @@ int mon_timer()
 	    mon_boot_state = BOOTP_RETX;
 	    break;
 
-	case TFTP_REQ_SENT:
-	    if (mon_tftp_bytes == 0)
-	    	mon_boot_state = TFTP_RETX;
-	    else {
-		if (mon_tftp_retx < 5) {
-#ifdef PRINTERR
-		   kprintf("mon_timer: RETX TFTP ACK=%d\n", mon_tftp_block-1);
-#endif
-		   mon_tftp_ack(mon_tftp_block-1);
-		   mon_tftp_retx++;
-		}
-		else {
-		   kprintf("mon_timer: too many retransmissions\n");
-		   mon_boot_state = BOOT_ERROR;
-		   mon_timeout = 0;
-		}
-	    }
-	    break;
+	case TFTP_REQ_SENT:	/* no reply to the request; once the	*/
+	    mon_boot_state = TFTP_RETX;	/* transfer is under way	*/
+	    break;			/* mon_tftp_timer() takes over	*/
 	    
 	default:
 	    break;
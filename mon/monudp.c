@@ -8,6 +8,7 @@
 /*#define DEBUG*/
 
 u_short mon_udpcksum(struct ep *pep, int len);
+static unsigned long mon_udpsum(struct ep *pep, int ulen, int len);
 
 /*------------------------------------------------------------------------
  * mon_udp_in -  handle an inbound UDP datagram
@@ -17,14 +18,26 @@ int mon_udp_in(struct netif *pni, struct ep *pep)
 {
     struct	ip	*pip = (struct ip *)pep->ep_data;
     struct	udp	*pudp = (struct udp *)pip->ip_data;
-    int		ret;
+    int		ret, ulen;
+    long	sum = -1;		/* datagram checked, or no sum	*/
 
-    if (pudp->u_cksum && mon_udpcksum(pep, net2hs(pudp->u_len))) {
+    ulen = net2hs(pudp->u_len);
+    if (pudp->u_cksum) {
+	/*
+	 * TFTP data is checked as mon_tftp_in copies it out, so only
+	 * the headers are summed here
+	 */
+	if (pudp->u_dst == hs2net(TFTP_MY_TID) &&
+	    mon_boot_state == TFTP_REQ_SENT &&
+	    ulen >= U_HLEN + TFTP_DATA_HDR_SZ)
+	    sum = mon_udpsum(pep, ulen, U_HLEN + TFTP_DATA_HDR_SZ);
+	else if (mon_udpcksum(pep, ulen)) {
 #ifdef PRINTERR
-	kprintf("udp_in: !! UDP checksum error\n");
+	    kprintf("udp_in: !! UDP checksum error\n");
 #endif
-	freebuf(pep);
-	return SYSERR;			/* checksum error */
+	    mon_freebuf(pep);
+	    return SYSERR;		/* checksum error */
+	}
     }
 
     /*
@@ -63,7 +76,7 @@ int mon_udp_in(struct netif *pni, struct ep *pep)
 	if (mon_boot_state == TFTP_REQ_SENT) {
 	    mon_timeout = 0;        /* stop retx timer */
 	    
-	    ret = mon_tftp_in(pudp);
+	    ret = mon_tftp_in(pudp, sum);
 	    if (ret == OK)
 		mon_boot_state = BOOT_DONE;
 	    else if (ret == SYSERR) {
@@ -79,7 +92,7 @@ int mon_udp_in(struct netif *pni, struct ep *pep)
 	break;
     }
 
-    freebuf(pep);
+    mon_freebuf(pep);
     return OK;
 }
 
@@ -89,31 +102,20 @@ int mon_udp_in(struct netif *pni, struct ep *pep)
  */
 u_short mon_udpcksum(struct ep *pep, int len)
 {
-	struct	ip	*pip = (struct ip *)pep->ep_data;
-	struct	udp	*pudp = (struct udp *)pip->ip_data;
-	unsigned	short	*sptr;
-	unsigned	long ucksum;
-	int		i;
-
-	ucksum = 0;
-
-	sptr = (unsigned short *) &pip->ip_src;
-	/* 2*IP_ALEN octets = IP_ALEN shorts... */
-	/* they are in net order.		*/
-	for (i=0; i<IP_ALEN; ++i)
-		ucksum += *sptr++;
-	sptr = (unsigned short *)pudp;
-	ucksum += hs2net(IPT_UDP + len);
-	if (len % 2) {
-		((char *)pudp)[len] = 0;	/* pad */
-		len += 1;	/* for the following division */
-	}
-	len >>= 1;	/* convert to length in shorts */
+	return (u_short)(~mon_udpsum(pep, len, len) & 0xffff);
+}
 
-	for (i=0; i<len; ++i)
-		ucksum += *sptr++;
-	ucksum = (ucksum >> 16) + (ucksum & 0xffff);
-	ucksum += (ucksum >> 16);
+/*------------------------------------------------------------------------
+ *  mon_udpsum -  partial sum of the pseudo-header for a datagram of ulen
+ *		  octets and of the first len octets of it
+ *------------------------------------------------------------------------
+ */
+static unsigned long mon_udpsum(struct ep *pep, int ulen, int len)
+{
+	struct	ip	*pip = (struct ip *)pep->ep_data;
+	unsigned	long sum;
 
-	return (short)(~ucksum & 0xffff);
+	/* the addresses are in net order, the rest is made so */
+	sum = mon_cksum_add(&pip->ip_src, 2*IP_ALEN, hs2net(IPT_UDP + ulen));
+	return mon_cksum_add(pip->ip_data, len, sum);
 }
@@ -0,0 +1,375 @@
+#include <mon/moni386.h>
+#include <mon/monnetwork.h>
+#include <mon/mon3com.h>
+#include <mon/monpci.h>
+#include <mon/monvirtio.h>
+#include <mon/monitor.h>
+#include <stdio.h>
+
+/*#define DEBUG*/
+
+/*
+ * virtio-net, for booting under QEMU/KVM. The receive queue holds
+ * VIO_RXBUFS monitor buffers; frames are received straight into them and
+ * passed up as they are, as the 3c905 driver does. Emptied slots are
+ * refilled VIO_RXBATCH at a time with one notify for the lot. The
+ * transmit queue never interrupts: sent frames are reaped the next time
+ * a frame goes out or a receive interrupt comes in. While the receive
+ * queue is being drained its interrupt is off too, so a burst (a TFTP
+ * window) costs one interrupt, not one per frame.
+ */
+
+extern int mon_vioint();
+
+static int mon_vio_qinit(struct dev_vio *dev, struct virtq *vq, int qn,
+			 char *mem);
+static void mon_vio_kick(struct dev_vio *dev, struct virtq *vq, int qn);
+static int mon_vio_rxfill(struct dev_vio *dev);
+static int mon_vio_ethdemux(struct dev_vio *dev);
+static int mon_vio_txreap(struct dev_vio *dev);
+
+struct dev_vio mon_dev_vio;
+
+#define VIO_QSPAN	((VIO_QBYTES(VIO_QMAX) + VIO_ALIGN - 1) & ~(VIO_ALIGN - 1))
+
+static char		 mon_vio_qmem[2 * VIO_QSPAN + VIO_ALIGN];
+static struct vio_nethdr mon_vio_rxhdr[VIO_RXBUFS];
+static struct vio_nethdr mon_vio_txhdr[VIO_TXBUFS];	/* all zero */
+
+/*-------------------------------------------------------------------------
+ * mon_vio_ethinit - set up the virtio-net device mon_find_pci_device()
+ *		     found, with one receive and one transmit queue
+ *-------------------------------------------------------------------------
+ */
+int mon_vio_ethinit()
+{
+    struct dev_vio*   dev;
+    struct netif*     pni;
+    struct ethdev*    ped;
+    struct vring_desc *d;
+    unsigned short    status;
+    unsigned long     feat;
+    char*	      mem;
+    int i;
+
+    dev = &mon_dev_vio;
+    dev->pcidev = mon_dev_eth.pcidev;	/* mon_find_pci_device() puts */
+					/* it there */
+
+    /* read config information */
+    mon_pci_bios_read_config_dword(dev->pcidev, VIO_PCI_IOBASE, &dev->iobase);
+    mon_pci_bios_read_config_byte (dev->pcidev, VIO_PCI_IRQ,    &dev->irq);
+    if (! (dev->iobase & 1)) {
+	kprintf("virtio: no legacy I/O interface\n");
+	return SYSERR;
+    }
+    dev->iobase &= ~3;
+
+    /* enable PCI bus master */
+    mon_pci_bios_read_config_word(dev->pcidev, PCI_COMMAND, &status);
+    status |= PCI_BUSMASTER;
+    mon_pci_bios_write_config_word(dev->pcidev, PCI_COMMAND, status);
+
+    /* reset, then say we know it and have a driver for it; the	*/
+    /* reset also ends any DMA into buffers an earlier boot attempt	*/
+    /* left in the rings, which are freed below			*/
+    outb(dev->iobase + VIO_OFF_STATUS, 0);
+    outb(dev->iobase + VIO_OFF_STATUS, VIO_STT_ACK);
+    outb(dev->iobase + VIO_OFF_STATUS, VIO_STT_ACK | VIO_STT_DRIVER);
+
+    /* the MAC address is all we want; no offloads, no merged buffers */
+    feat = inl(dev->iobase + VIO_OFF_HOSTFEAT) & VIO_NET_F_MAC;
+    outl(dev->iobase + VIO_OFF_GUESTFEAT, feat);
+
+    mem = (char *) (((unsigned long) mon_vio_qmem + VIO_ALIGN - 1) &
+		    ~(VIO_ALIGN - 1));
+    if (mon_vio_qinit(dev, &dev->rxq, VIO_RXQ, mem) != OK ||
+	mon_vio_qinit(dev, &dev->txq, VIO_TXQ, mem + VIO_QSPAN) != OK) {
+	outb(dev->iobase + VIO_OFF_STATUS, VIO_STT_FAILED);
+	kprintf("virtio: queues too small or too large\n");
+	return SYSERR;
+    }
+
+    if (feat & VIO_NET_F_MAC) {
+	for (i = 0; i < EP_ALEN; i++)
+	    dev->hwa[i] = inb(dev->iobase + VIO_OFF_MAC + i);
+    } else {
+	/* a locally administered one */
+	dev->hwa[0] = 0x02;
+	for (i = 1; i < EP_ALEN; i++)
+	    dev->hwa[i] = i;
+    }
+
+    /* the header and frame descriptors of each slot stay paired */
+    for (i = 0; i < VIO_RXBUFS; i++) {
+	d = &dev->rxq.desc[2 * i];
+	d->addr  = (unsigned long) &mon_vio_rxhdr[i];
+	d->len   = sizeof(struct vio_nethdr);
+	d->flags = VRING_DESC_F_NEXT | VRING_DESC_F_WRITE;
+	d->next  = 2 * i + 1;
+	d[1].flags = VRING_DESC_F_WRITE;
+	if (dev->rxbuf[i])
+	    mon_freebuf(dev->rxbuf[i]);
+	dev->rxbuf[i] = 0;
+    }
+    for (i = 0; i < VIO_TXBUFS; i++) {
+	d = &dev->txq.desc[2 * i];
+	d->addr  = (unsigned long) &mon_vio_txhdr[i];
+	d->len   = sizeof(struct vio_nethdr);
+	d->flags = VRING_DESC_F_NEXT;
+	d->next  = 2 * i + 1;
+	if (dev->txbuf[i])
+	    mon_freebuf(dev->txbuf[i]);
+	dev->txbuf[i] = 0;
+    }
+    dev->txq.avail->flags = VRING_AVAIL_F_NO_INTERRUPT;
+    dev->tx_free = VIO_TXBUFS;
+    dev->tx_next = 0;
+    dev->rx_fill = 0;
+    dev->rx_empty = VIO_RXBUFS;
+
+    set_evec(dev->irq + IRQBASE, (unsigned) mon_vioint);
+    outb(dev->iobase + VIO_OFF_STATUS,
+	 VIO_STT_ACK | VIO_STT_DRIVER | VIO_STT_DRIVEROK);
+
+    if (mon_vio_rxfill(dev) != VIO_RXBUFS) {
+	kprintf("No buffer in ethinit()");
+	panic("could not allocate buffer for monitor");
+    }
+
+    /* set the OS structures */
+    dev->ifn = 0;
+    pni = &mon_nif[0];
+    pni->ni_write = mon_vio_ethwrite;
+    ped = &mon_eth[0];
+    for (i = 0; i < EP_ALEN; i++) {
+	ped->ed_paddr[i] = dev->hwa[i];
+	ped->ed_bcast[i] = ~0;
+    }
+    ped->ed_irq = dev->irq;
+    return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * mon_vio_qinit - give the device queue qn, laid out at mem
+ *-------------------------------------------------------------------------
+ */
+static int mon_vio_qinit(struct dev_vio *dev, struct virtq *vq, int qn,
+			 char *mem)
+{
+    int n;
+
+    outw(dev->iobase + VIO_OFF_QSEL, qn);
+    n = inw(dev->iobase + VIO_OFF_QSIZE);
+    if (n < 2 * VIO_RXBUFS || n < 2 * VIO_TXBUFS || n > VIO_QMAX)
+	return SYSERR;
+
+    bzero(mem, VIO_QBYTES(n));
+    vq->size  = n;
+    vq->desc  = (struct vring_desc *) mem;
+    vq->avail = (struct vring_avail *) (mem + 16 * n);
+    vq->used  = (struct vring_used *) (mem + VIO_QBYTES(n) - 6 - 8 * n);
+    vq->lastused = 0;
+    outl(dev->iobase + VIO_OFF_QADDR, (unsigned long) mem / VIO_ALIGN);
+#ifdef DEBUG
+    kprintf("virtio: queue %d, %d entries at 0x%x\n", qn, n, mem);
+#endif
+    return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * mon_vio_kick - tell the device about new avail entries, unless it has
+ *		  said it will find them on its own
+ *-------------------------------------------------------------------------
+ */
+static void mon_vio_kick(struct dev_vio *dev, struct virtq *vq, int qn)
+{
+    VIO_MB();
+    if (! (vq->used->flags & VRING_USED_F_NO_NOTIFY))
+	outw(dev->iobase + VIO_OFF_QNOTIFY, qn);
+}
+
+/*-------------------------------------------------------------------------
+ * mon_vio_ethintr - handle a virtio-net interrupt
+ *-------------------------------------------------------------------------
+ */
+int mon_vio_ethintr()
+{
+    STATWORD        ps;
+    struct dev_vio* dev;
+
+    disable(ps);
+
+    dev = &mon_dev_vio;
+
+    /* reading the ISR acknowledges it; 0 means not ours */
+    if (! (inb(dev->iobase + VIO_OFF_ISR) & VIO_ISR_QUEUE)) {
+	restore(ps);
+	return(OK);
+    }
+
+    /*
+     * Drain with the interrupt off, then turn it back on and look
+     * once more, for frames that came in before it was
+     */
+    do {
+	dev->rxq.avail->flags = VRING_AVAIL_F_NO_INTERRUPT;
+	mon_vio_ethdemux(dev);
+	mon_vio_txreap(dev);
+	dev->rxq.avail->flags = 0;
+	VIO_MB();
+    } while (dev->rxq.lastused != dev->rxq.used->idx);
+
+    restore(ps);
+    return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * mon_vio_ethdemux - pass up every frame in the receive used ring, then
+ *		      refill the slots if a batch of them is empty
+ *-------------------------------------------------------------------------
+ */
+static int mon_vio_ethdemux(struct dev_vio *dev)
+{
+    struct virtq*	    vq = &dev->rxq;
+    volatile struct vring_used_elem* ue;
+    struct ep*		    pep;
+    int i, len;
+
+    while (vq->lastused != vq->used->idx) {
+	VIO_WMB();
+	ue  = &vq->used->ring[vq->lastused & (vq->size - 1)];
+	i   = ue->id / 2;
+	len = ue->len - sizeof(struct vio_nethdr);
+	vq->lastused++;
+	if (i >= VIO_RXBUFS || (pep = dev->rxbuf[i]) == 0)
+	    continue;			/* not one we gave it */
+	dev->rxbuf[i] = 0;
+	dev->rx_empty++;
+
+	if (len < EP_HLEN || len > EP_MAXLEN) {
+#ifdef DEBUG
+	    kprintf("vio_ethdemux: bad length %d\n", len);
+#endif
+	    mon_freebuf(pep);
+	    continue;
+	}
+	pep->ep_ifn  = dev->ifn;
+	pep->ep_len  = len;
+	pep->ep_type = net2hs(pep->ep_type);
+	mon_ni_in(&mon_nif[dev->ifn], pep, len);
+    }
+
+    if (dev->rx_empty >= VIO_RXBATCH)
+	mon_vio_rxfill(dev);
+    return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * mon_vio_rxfill - give buffers to the empty receive slots for as long
+ *		    as there are buffers, with one notify; returns how
+ *		    many were filled
+ *-------------------------------------------------------------------------
+ */
+static int mon_vio_rxfill(struct dev_vio *dev)
+{
+    struct virtq*  vq = &dev->rxq;
+    struct ep*	   pep;
+    unsigned short idx;
+    int i, n;
+
+    idx = vq->avail->idx;
+    for (n = 0; dev->rx_empty > 0; n++) {
+	if ((pep = (struct ep *) mon_getbuf()) == 0)
+	    break;
+	for (i = dev->rx_fill; dev->rxbuf[i]; i = (i + 1) % VIO_RXBUFS)
+	    ;
+	dev->rxbuf[i] = pep;
+	vq->desc[2 * i + 1].addr = (unsigned long) &pep->ep_eh;
+	vq->desc[2 * i + 1].len  = EP_MAXLEN;
+	vq->avail->ring[idx++ & (vq->size - 1)] = 2 * i;
+	dev->rx_empty--;
+	dev->rx_fill = (i + 1) % VIO_RXBUFS;
+    }
+    if (n > 0) {
+	VIO_WMB();			/* entries before the index */
+	vq->avail->idx = idx;
+	mon_vio_kick(dev, vq, VIO_RXQ);
+    }
+    return(n);
+}
+
+/*-------------------------------------------------------------------------
+ * mon_vio_txreap - free the frames the device has sent
+ *-------------------------------------------------------------------------
+ */
+static int mon_vio_txreap(struct dev_vio *dev)
+{
+    struct virtq* vq = &dev->txq;
+    int i;
+
+    while (vq->lastused != vq->used->idx) {
+	VIO_WMB();
+	i = vq->used->ring[vq->lastused & (vq->size - 1)].id / 2;
+	vq->lastused++;
+	if (i < VIO_TXBUFS && dev->txbuf[i]) {
+	    mon_freebuf(dev->txbuf[i]);
+	    dev->txbuf[i] = 0;
+	    dev->tx_free++;
+	}
+    }
+    return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * mon_vio_ethwrite - queue a frame; the buffer is freed once it is sent
+ *-------------------------------------------------------------------------
+ */
+int mon_vio_ethwrite(struct ep *pep, int len)
+{
+    STATWORD        ps;
+    struct dev_vio* dev;
+    struct virtq*   vq;
+    int i;
+
+    if (pep == NULL || len > EP_MAXLEN)
+	return SYSERR;
+
+    dev = &mon_dev_vio;
+    vq  = &dev->txq;
+
+    /* update the packet */
+    blkcopy(pep->ep_src, dev->hwa, EP_ALEN);
+    pep->ep_len  = len;
+    pep->ep_type = hs2net(pep->ep_type);
+
+    disable(ps);
+
+    mon_vio_txreap(dev);
+    if (dev->rx_empty >= VIO_RXBATCH)	/* it may have freed some */
+	mon_vio_rxfill(dev);
+
+    if (dev->tx_free == 0) {
+	restore(ps);
+#ifdef DEBUG
+	kprintf("vio_ethwrite: queue full\n");
+#endif
+	mon_freebuf(pep);
+	return SYSERR;
+    }
+    for (i = dev->tx_next; dev->txbuf[i]; i = (i + 1) % VIO_TXBUFS)
+	;
+    dev->txbuf[i] = pep;
+    dev->tx_free--;
+    dev->tx_next = (i + 1) % VIO_TXBUFS;
+
+    vq->desc[2 * i + 1].addr = (unsigned long) &pep->ep_eh;
+    vq->desc[2 * i + 1].len  = len;
+    vq->avail->ring[vq->avail->idx & (vq->size - 1)] = 2 * i;
+    VIO_WMB();
+    vq->avail->idx++;
+    mon_vio_kick(dev, vq, VIO_TXQ);
+
+    restore(ps);
+    return OK;
+}
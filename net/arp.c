@@ -0,0 +1,225 @@
+/* arp.c - arp_in, arpsend, arptimer */
+
+#include <conf.h>
+#include <kernel.h>
+#include <bufpool.h>
+#include <network.h>
+#include <stdio.h>
+
+extern	unsigned long	ctr1000;
+
+/*
+ * The cache is only touched with interrupts disabled: arp_in() runs in
+ * the driver's interrupt handler, arpsend() in a process or a handler,
+ * arptimer() in netd.
+ */
+
+struct	arpent	arptab[NARP];
+
+/*------------------------------------------------------------------------
+ *  _arpfind  --  the entry for ip, or NULL
+ *------------------------------------------------------------------------
+ */
+LOCAL struct arpent *_arpfind(IPaddr ip)
+{
+	struct	arpent	*pae;
+
+	for (pae = &arptab[0] ; pae < &arptab[NARP] ; pae++)
+		if (pae->ae_state != AS_FREE && pae->ae_pra == ip)
+			return(pae);
+	return(NULL);
+}
+
+/*------------------------------------------------------------------------
+ *  _arpdrop  --  free an entry and the packets waiting on it
+ *------------------------------------------------------------------------
+ */
+LOCAL void _arpdrop(struct arpent *pae)
+{
+	int	i;
+
+	for (i=0 ; i<pae->ae_qlen ; i++) {
+		nif.ni_odrops++;
+		freebuf(pae->ae_queue[i]);
+	}
+	pae->ae_qlen = 0;
+	pae->ae_state = AS_FREE;
+}
+
+/*------------------------------------------------------------------------
+ *  _arpalloc  --  an entry for ip: a free one, or else the one least
+ *		   recently used
+ *------------------------------------------------------------------------
+ */
+LOCAL struct arpent *_arpalloc(IPaddr ip)
+{
+	struct	arpent	*pae, *victim = NULL;
+
+	for (pae = &arptab[0] ; pae < &arptab[NARP] ; pae++) {
+		if (pae->ae_state == AS_FREE) {
+			victim = pae;
+			break;
+		}
+		if (victim == NULL ||
+		    ctr1000 - pae->ae_used > ctr1000 - victim->ae_used)
+			victim = pae;
+	}
+	if (victim->ae_state != AS_FREE)
+		_arpdrop(victim);
+	victim->ae_pra = ip;
+	victim->ae_used = ctr1000;
+	victim->ae_tries = 0;
+	victim->ae_qlen = 0;
+	return(victim);
+}
+
+/*------------------------------------------------------------------------
+ *  _arprequest  --  broadcast a request for ip's hardware address
+ *------------------------------------------------------------------------
+ */
+LOCAL void _arprequest(IPaddr ip)
+{
+	struct	ep	*pep;
+	struct	arp	*parp;
+
+	if ((pep = netgetbuf()) == NULL)
+		return;			/* netd tries again		*/
+	blkcopy(pep->ep_dst, EP_BRC, EP_ALEN);
+	pep->ep_type = EPT_ARP;
+	parp = (struct arp *) pep->ep_data;
+	parp->ar_hwtype = hs2net(AR_HARDWARE);
+	parp->ar_prtype = hs2net(EPT_IP);
+	parp->ar_hwlen = EP_ALEN;
+	parp->ar_prlen = IP_ALEN;
+	parp->ar_op = hs2net(AR_REQUEST);
+	blkcopy(parp->ar_sha, nif.ni_hwa, EP_ALEN);
+	blkcopy(parp->ar_spa, &nif.ni_ip, IP_ALEN);
+	bzero(parp->ar_tha, EP_ALEN);
+	blkcopy(parp->ar_tpa, &ip, IP_ALEN);
+	(*nif.ni_write)(pep, EP_HLEN + ARP_LEN);
+}
+
+/*------------------------------------------------------------------------
+ *  arp_in  --  handle an ARP packet: learn the sender's address if it
+ *		is in the cache or is asking us, send what was waiting for
+ *		it, and answer a request for our address in the request's
+ *		own buffer
+ *------------------------------------------------------------------------
+ */
+int arp_in(struct ep *pep)
+{
+	STATWORD ps;
+	struct	arp	*parp = (struct arp *) pep->ep_data;
+	struct	arpent	*pae;
+	struct	ep	*qep;
+	IPaddr	spa, tpa;
+	int	i;
+
+	if (pep->ep_len < EP_HLEN + ARP_LEN ||
+	    net2hs(parp->ar_hwtype) != AR_HARDWARE ||
+	    net2hs(parp->ar_prtype) != EPT_IP ||
+	    parp->ar_hwlen != EP_ALEN || parp->ar_prlen != IP_ALEN) {
+		nif.ni_idrops++;
+		freebuf(pep);
+		return(SYSERR);
+	}
+	blkcopy(&spa, parp->ar_spa, IP_ALEN);
+	blkcopy(&tpa, parp->ar_tpa, IP_ALEN);
+
+	lkdisable(ps, LK_NET);
+	if ((pae = _arpfind(spa)) == NULL && tpa == nif.ni_ip)
+		pae = _arpalloc(spa);
+	if (pae != NULL) {
+		blkcopy(pae->ae_hwa, parp->ar_sha, EP_ALEN);
+		pae->ae_state = AS_RESOLVED;
+		pae->ae_expires = ctr1000 + ARP_TIMEOUT;
+		for (i=0 ; i<pae->ae_qlen ; i++) {
+			qep = pae->ae_queue[i];
+			blkcopy(qep->ep_dst, pae->ae_hwa, EP_ALEN);
+			(*nif.ni_write)(qep, qep->ep_len);
+		}
+		pae->ae_qlen = 0;
+	}
+	restore(ps);
+
+	if (tpa != nif.ni_ip || net2hs(parp->ar_op) != AR_REQUEST) {
+		freebuf(pep);
+		return(OK);
+	}
+	parp->ar_op = hs2net(AR_REPLY);
+	blkcopy(parp->ar_tha, parp->ar_sha, EP_ALEN);
+	blkcopy(parp->ar_tpa, parp->ar_spa, IP_ALEN);
+	blkcopy(parp->ar_sha, nif.ni_hwa, EP_ALEN);
+	blkcopy(parp->ar_spa, &nif.ni_ip, IP_ALEN);
+	blkcopy(pep->ep_dst, parp->ar_tha, EP_ALEN);
+	(*nif.ni_write)(pep, EP_HLEN + ARP_LEN);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  arpsend  --  send a frame of len octets to pep->ep_nexthop, or hold
+ *		 it until the address is resolved; takes the buffer
+ *------------------------------------------------------------------------
+ */
+int arpsend(struct ep *pep, int len)
+{
+	STATWORD ps;
+	struct	arpent	*pae;
+	int	i;
+
+	pep->ep_len = len;
+	lkdisable(ps, LK_NET);
+	pae = _arpfind(pep->ep_nexthop);
+	if (pae != NULL && pae->ae_state == AS_RESOLVED) {
+		pae->ae_used = ctr1000;
+		blkcopy(pep->ep_dst, pae->ae_hwa, EP_ALEN);
+		restore(ps);
+		return((*nif.ni_write)(pep, len));
+	}
+	if (pae == NULL) {
+		pae = _arpalloc(pep->ep_nexthop);
+		pae->ae_state = AS_PENDING;
+		pae->ae_tries = 1;
+		pae->ae_expires = ctr1000 + ARP_RESEND;
+		_arprequest(pae->ae_pra);
+	}
+	if (pae->ae_qlen == ARP_QLEN) {		/* drop the oldest	*/
+		nif.ni_odrops++;
+		freebuf(pae->ae_queue[0]);
+		for (i=1 ; i<ARP_QLEN ; i++)
+			pae->ae_queue[i-1] = pae->ae_queue[i];
+		pae->ae_qlen--;
+	}
+	pae->ae_queue[pae->ae_qlen++] = pep;
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  arptimer  --  resend the requests that are due, give up on those
+ *		  tried ARP_MAXTRY times and forget resolved entries that
+ *		  have timed out; called by netd
+ *------------------------------------------------------------------------
+ */
+int arptimer()
+{
+	STATWORD ps;
+	struct	arpent	*pae;
+
+	lkdisable(ps, LK_NET);
+	for (pae = &arptab[0] ; pae < &arptab[NARP] ; pae++) {
+		if (pae->ae_state == AS_FREE ||
+		    (long) (ctr1000 - pae->ae_expires) < 0)
+			continue;
+		if (pae->ae_state == AS_RESOLVED ||
+		    pae->ae_tries >= ARP_MAXTRY) {
+			_arpdrop(pae);
+			continue;
+		}
+		pae->ae_tries++;
+		pae->ae_expires = ctr1000 + ARP_RESEND;
+		_arprequest(pae->ae_pra);
+	}
+	restore(ps);
+	return(OK);
+}
@@ -0,0 +1,87 @@
+/* ip.c - ip_in, ipsend */
+
+#include <conf.h>
+#include <kernel.h>
+#include <bufpool.h>
+#include <network.h>
+#include <stdio.h>
+
+LOCAL	unsigned short	ipackid = 1;	/* id of the next datagram	*/
+
+/*------------------------------------------------------------------------
+ *  ip_in  --  check an IP datagram addressed to us, put it back together
+ *	       if it is a fragment, and pass it up; called by netin()
+ *------------------------------------------------------------------------
+ */
+int ip_in(struct ep *pep)
+{
+	struct	ip	*pip = (struct ip *) pep->ep_data;
+	int	hlen, len;
+
+	hlen = IP_HLEN(pip);
+	len = net2hs(pip->ip_len);
+	if ((pip->ip_verlen >> 4) != IP_VERSION || hlen < IPMHLEN ||
+	    len < hlen || len > pep->ep_len - EP_HLEN ||
+	    mon_cksum(pip, hlen) != 0)
+		goto drop;
+	if (pip->ip_dst != nif.ni_ip && pip->ip_dst != IP_BCAST &&
+	    pip->ip_dst != (nif.ni_ip | ~nif.ni_mask))
+		goto drop;
+
+	if (net2hs(pip->ip_fragoff) & (IP_MF | IP_FRAGOFF)) {
+		if ((pep = ipreass(pep)) == NULL)
+			return(OK);	/* kept, or dropped, by ipreass	*/
+		pip = (struct ip *) pep->ep_data;
+	}
+	switch (pip->ip_proto) {
+	case IPT_UDP:
+		return(udp_in(pep));
+	}
+drop:
+	nif.ni_idrops++;
+	freebuf(pep);
+	return(SYSERR);
+}
+
+/*------------------------------------------------------------------------
+ *  ipsend  --  send datalen octets of protocol proto, which the caller
+ *		has put after a minimal header, to dst; takes the buffer.
+ *		Datagrams are never fragmented on the way out.
+ *------------------------------------------------------------------------
+ */
+int ipsend(IPaddr dst, int proto, struct ep *pep, int datalen)
+{
+	STATWORD ps;
+	struct	ip	*pip = (struct ip *) pep->ep_data;
+	int	len = EP_HLEN + IPMHLEN + datalen;
+
+	if (IPMHLEN + datalen > EP_DLEN) {
+		nif.ni_odrops++;
+		freebuf(pep);
+		return(SYSERR);
+	}
+	pip->ip_verlen = (IP_VERSION << 4) | IP_MINHLEN;
+	pip->ip_tos = 0;
+	pip->ip_len = hs2net(IPMHLEN + datalen);
+	lkdisable(ps, LK_NET);
+	pip->ip_id = hs2net(ipackid);
+	ipackid++;
+	restore(ps);
+	pip->ip_fragoff = 0;
+	pip->ip_ttl = IP_TTL;
+	pip->ip_proto = proto;
+	pip->ip_cksum = 0;
+	pip->ip_src = nif.ni_ip;
+	pip->ip_dst = dst;
+	pip->ip_cksum = mon_cksum(pip, IPMHLEN);
+	pep->ep_type = EPT_IP;
+
+	if (dst == IP_BCAST || dst == (nif.ni_ip | ~nif.ni_mask)) {
+		blkcopy(pep->ep_dst, EP_BRC, EP_ALEN);
+		pep->ep_len = len;
+		return((*nif.ni_write)(pep, len));
+	}
+	pep->ep_nexthop = ((dst ^ nif.ni_ip) & nif.ni_mask) ?
+	    nif.ni_gateway : dst;
+	return(arpsend(pep, len));
+}
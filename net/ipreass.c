@@ -0,0 +1,148 @@
+/* ipreass.c - ipreass, ipftimer */
+
+#include <conf.h>
+#include <kernel.h>
+#include <bufpool.h>
+#include <network.h>
+#include <stdio.h>
+
+extern	unsigned long	ctr1000;
+
+LOCAL	struct	ipfq	ipfqtab[IP_NREASM];
+
+/*------------------------------------------------------------------------
+ *  _ipfdrop  --  give up on a partial datagram (interrupts disabled)
+ *------------------------------------------------------------------------
+ */
+LOCAL void _ipfdrop(struct ipfq *pfq)
+{
+	nif.ni_idrops++;
+	freebuf(pfq->ipf_pep);
+	pfq->ipf_state = IPF_FREE;
+}
+
+/*------------------------------------------------------------------------
+ *  _ipfnew  --  a slot and a reassembly buffer for the datagram pip is
+ *		 a fragment of, or NULL if there are none free
+ *------------------------------------------------------------------------
+ */
+LOCAL struct ipfq *_ipfnew(struct ip *pip)
+{
+	struct	ipfq	*pfq;
+	struct	ep	*pep;
+
+	for (pfq = &ipfqtab[0] ; pfq < &ipfqtab[IP_NREASM] ; pfq++)
+		if (pfq->ipf_state == IPF_FREE)
+			break;
+	if (pfq == &ipfqtab[IP_NREASM])
+		return(NULL);
+	pep = (struct ep *) nbgetbuf(nif.ni_rpool);
+	if (pep == NULL || pep == (struct ep *) SYSERR)
+		return(NULL);
+	pfq->ipf_state = IPF_BUSY;
+	pfq->ipf_src = pip->ip_src;
+	pfq->ipf_id = pip->ip_id;
+	pfq->ipf_proto = pip->ip_proto;
+	pfq->ipf_pep = pep;
+	pfq->ipf_total = -1;
+	pfq->ipf_end = 0;
+	pfq->ipf_units = 0;
+	pfq->ipf_expires = ctr1000 + IP_FRAGTTL;
+	bzero(pfq->ipf_map, sizeof(pfq->ipf_map));
+	blkcopy(pep->ep_data, pip, IPMHLEN);	/* options are not kept	*/
+	return(pfq);
+}
+
+/*------------------------------------------------------------------------
+ *  ipreass  --  copy a fragment into its datagram and free it; returns
+ *		 the datagram, in a reassembly buffer, once it is whole,
+ *		 NULL until then. Runs in the driver's interrupt handler.
+ *------------------------------------------------------------------------
+ */
+struct ep *ipreass(struct ep *pep)
+{
+	STATWORD ps;
+	struct	ip	*pip = (struct ip *) pep->ep_data;
+	struct	ipfq	*pfq;
+	struct	ep	*prep;
+	int	fragoff, off, len, unit, last;
+
+	fragoff = net2hs(pip->ip_fragoff);
+	off = (fragoff & IP_FRAGOFF) << 3;
+	len = net2hs(pip->ip_len) - IP_HLEN(pip);
+
+	lkdisable(ps, LK_NET);
+	for (pfq = &ipfqtab[0] ; pfq < &ipfqtab[IP_NREASM] ; pfq++)
+		if (pfq->ipf_state == IPF_BUSY &&
+		    pfq->ipf_src == pip->ip_src && pfq->ipf_id == pip->ip_id &&
+		    pfq->ipf_proto == pip->ip_proto)
+			break;
+	if (pfq == &ipfqtab[IP_NREASM] && (pfq = _ipfnew(pip)) == NULL) {
+		restore(ps);
+		nif.ni_idrops++;
+		freebuf(pep);
+		return(NULL);
+	}
+
+	/* too long, or a middle piece that is not whole units */
+	if (IPMHLEN + off + len > IP_MAXREASM ||
+	    ((fragoff & IP_MF) && (len & 7))) {
+		_ipfdrop(pfq);
+		restore(ps);
+		freebuf(pep);
+		return(NULL);
+	}
+	if (!(fragoff & IP_MF))
+		pfq->ipf_total = off + len;
+	if (off + len > pfq->ipf_end)
+		pfq->ipf_end = off + len;
+	if (pfq->ipf_total >= 0 && pfq->ipf_end > pfq->ipf_total) {
+		_ipfdrop(pfq);		/* pieces past the end		*/
+		restore(ps);
+		freebuf(pep);
+		return(NULL);
+	}
+
+	blkcopy(pfq->ipf_pep->ep_data + IPMHLEN + off,
+	    (char *) pip + IP_HLEN(pip), len);
+	last = (off + len + 7) >> 3;
+	for (unit = off >> 3 ; unit < last ; unit++)
+		if (!(pfq->ipf_map[unit >> 3] & (1 << (unit & 7)))) {
+			pfq->ipf_map[unit >> 3] |= 1 << (unit & 7);
+			pfq->ipf_units++;
+		}
+	freebuf(pep);
+
+	if (pfq->ipf_total < 0 || pfq->ipf_units < (pfq->ipf_total + 7) >> 3) {
+		restore(ps);
+		return(NULL);
+	}
+	prep = pfq->ipf_pep;
+	pip = (struct ip *) prep->ep_data;
+	pip->ip_verlen = (IP_VERSION << 4) | IP_MINHLEN;
+	pip->ip_len = hs2net(IPMHLEN + pfq->ipf_total);
+	pip->ip_fragoff = 0;
+	prep->ep_len = EP_HLEN + IPMHLEN + pfq->ipf_total;
+	pfq->ipf_state = IPF_FREE;
+	restore(ps);
+	return(prep);
+}
+
+/*------------------------------------------------------------------------
+ *  ipftimer  --  drop the partial datagrams that have waited too long;
+ *		  called by netd
+ *------------------------------------------------------------------------
+ */
+int ipftimer()
+{
+	STATWORD ps;
+	struct	ipfq	*pfq;
+
+	lkdisable(ps, LK_NET);
+	for (pfq = &ipfqtab[0] ; pfq < &ipfqtab[IP_NREASM] ; pfq++)
+		if (pfq->ipf_state == IPF_BUSY &&
+		    (long) (ctr1000 - pfq->ipf_expires) >= 0)
+			_ipfdrop(pfq);
+	restore(ps);
+	return(OK);
+}
@@ -0,0 +1,126 @@
+/* netinit.c - netinit, netd, netin, netgetbuf, dot2ip */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <sleep.h>
+#include <bufpool.h>
+#include <network.h>
+#include <vionet.h>
+#include <stdio.h>
+
+struct	netif	nif;
+int	netresched = FALSE;
+
+/*------------------------------------------------------------------------
+ *  netinit  --  make the buffer pools, bring the interface up with the
+ *		 static configuration and start netd; SYSERR if there is
+ *		 no interface
+ *------------------------------------------------------------------------
+ */
+int netinit()
+{
+	int	pid;
+
+	nif.ni_state = NIS_DOWN;
+	nif.ni_ip = dot2ip(NET_IP);
+	nif.ni_mask = dot2ip(NET_MASK);
+	nif.ni_gateway = dot2ip(NET_GATEWAY);
+	if ((nif.ni_pool = mkpool(sizeof(struct ep), NETBUFS)) == SYSERR)
+		goto nomem;
+	if ((nif.ni_rpool = mkpool(sizeof(struct ep) - EP_DLEN + IP_MAXREASM,
+	    IP_NREASM)) == SYSERR) {
+		freepool(nif.ni_pool);
+		goto nomem;
+	}
+	if (vioinit() != OK) {
+		freepool(nif.ni_rpool);		/* in reverse, see freepool()	*/
+		freepool(nif.ni_pool);
+		return(SYSERR);
+	}
+	if ((pid = create(netd, NETDSTK, NETDPRIO, "netd", 0, 0)) == SYSERR)
+		return(SYSERR);
+	numproc--;			/* a daemon; see klinit()	*/
+	nif.ni_state = NIS_UP;
+	resume(pid);
+	kprintf("net: %s on virtio-net, gateway %s\n", NET_IP, NET_GATEWAY);
+	return(OK);
+
+nomem:
+	kprintf("net: no memory for buffers\n");
+	return(SYSERR);
+}
+
+/*------------------------------------------------------------------------
+ *  netd  --  the stack's timers: ARP retries and expiry, and dropping
+ *	      partial datagrams
+ *------------------------------------------------------------------------
+ */
+PROCESS netd()
+{
+	for (;;) {
+		sleep10(NETDTICK);
+		arptimer();
+		ipftimer();
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  netin  --  pass a frame up by its type; called by the driver's
+ *	       interrupt handler, and takes the buffer
+ *------------------------------------------------------------------------
+ */
+int netin(struct ep *pep)
+{
+	nif.ni_ipackets++;
+	switch (pep->ep_type) {
+	case EPT_ARP:
+		return(arp_in(pep));
+	case EPT_IP:
+		return(ip_in(pep));
+	}
+	nif.ni_idrops++;
+	freebuf(pep);
+	return(SYSERR);
+}
+
+/*------------------------------------------------------------------------
+ *  netgetbuf  --  a packet buffer, or NULL if netpool is empty; never
+ *		   waits
+ *------------------------------------------------------------------------
+ */
+struct ep *netgetbuf()
+{
+	struct	ep	*pep;
+
+	pep = (struct ep *) nbgetbuf(nif.ni_pool);
+	if (pep == (struct ep *) SYSERR)
+		return(NULL);
+	return(pep);
+}
+
+/*------------------------------------------------------------------------
+ *  dot2ip  --  the address "a.b.c.d" (which may go on after a ':') in
+ *		network order, or 0 if it is not one
+ *------------------------------------------------------------------------
+ */
+IPaddr dot2ip(char *s)
+{
+	IPaddr	ip;
+	unsigned char	*p = (unsigned char *) &ip;
+	int	i, n;
+
+	for (i=0 ; i<IP_ALEN ; i++) {
+		if (*s < '0' || *s > '9')
+			return(0);
+		for (n=0 ; *s >= '0' && *s <= '9' ; s++)
+			if ((n = 10*n + *s - '0') > 255)
+				return(0);
+		p[i] = n;
+		if (i < IP_ALEN-1 && *s++ != '.')
+			return(0);
+	}
+	if (*s != '\0' && *s != ':')
+		return(0);
+	return(ip);
+}
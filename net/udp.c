@@ -0,0 +1,153 @@
+/* udp.c - udp_in, udpsend, udpnextdg */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sem.h>
+#include <bufpool.h>
+#include <network.h>
+#include <stdio.h>
+
+/*------------------------------------------------------------------------
+ *  _udpsum  --  sum of a datagram of len octets and its pseudo-header,
+ *		 folded but not complemented
+ *------------------------------------------------------------------------
+ */
+LOCAL unsigned long _udpsum(struct ip *pip, struct udp *pudp, int len)
+{
+	unsigned long	sum;
+
+	sum = mon_cksum_add(&pip->ip_src, 2 * IP_ALEN, hs2net(IPT_UDP + len));
+	return(mon_cksum_add(pudp, len, sum));
+}
+
+/*------------------------------------------------------------------------
+ *  _udptimeout  --  a read has waited long enough: wake the reader, who
+ *		     finds the queue empty (runs from the clock, with
+ *		     interrupts off)
+ *------------------------------------------------------------------------
+ */
+LOCAL void _udptimeout(int i)
+{
+	struct	udpsock	*pus = &udptab[i];
+
+	if (semaph[pus->us_rsem].semcnt < 0) {
+		pus->us_tmfired = TRUE;
+		isignaln(pus->us_rsem, 1);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  udp_in  --  queue a UDP datagram on the socket bound to its port;
+ *		runs in the driver's interrupt handler, so the reader is
+ *		readied without rescheduling
+ *------------------------------------------------------------------------
+ */
+int udp_in(struct ep *pep)
+{
+	struct	ip	*pip = (struct ip *) pep->ep_data;
+	struct	udp	*pudp = (struct udp *) ((char *) pip + IP_HLEN(pip));
+	struct	udpsock	*pus;
+	unsigned short	dport, sport;
+	int	len;
+
+	len = net2hs(pudp->u_len);
+	if (len < U_HLEN || len > net2hs(pip->ip_len) - IP_HLEN(pip) ||
+	    (pudp->u_cksum != 0 && _udpsum(pip, pudp, len) != 0xffff))
+		goto drop;
+
+	dport = net2hs(pudp->u_dst);
+	sport = net2hs(pudp->u_src);
+	for (pus = &udptab[0] ; pus < &udptab[Nudp] ; pus++)
+		if (pus->us_state == US_OPEN && pus->us_lport == dport &&
+		    (pus->us_raddr == 0 || (pus->us_raddr == pip->ip_src &&
+		    pus->us_rport == sport)))
+			break;
+	if (pus == &udptab[Nudp])
+		goto drop;
+	if (pus->us_qlen == UDP_QLEN) {
+		pus->us_drops++;
+		goto drop;
+	}
+	pus->us_q[(pus->us_qhead + pus->us_qlen++) % UDP_QLEN] = pep;
+	if (isignaln(pus->us_rsem, 1) > 0)
+		netresched = TRUE;
+	return(OK);
+drop:
+	nif.ni_idrops++;
+	freebuf(pep);
+	return(SYSERR);
+}
+
+/*------------------------------------------------------------------------
+ *  udpsend  --  send len octets the caller has put at UDP_DATA(pep) to
+ *		 the socket's remote; takes the buffer
+ *------------------------------------------------------------------------
+ */
+int udpsend(struct udpsock *pus, struct ep *pep, int len)
+{
+	struct	ip	*pip = (struct ip *) pep->ep_data;
+	struct	udp	*pudp = (struct udp *) (pep->ep_data + IPMHLEN);
+	unsigned short	sum;
+
+	if (len < 0 || len > U_MAXDATA || pus->us_raddr == 0) {
+		freebuf(pep);
+		return(SYSERR);
+	}
+	pudp->u_src = hs2net(pus->us_lport);
+	pudp->u_dst = hs2net(pus->us_rport);
+	pudp->u_len = hs2net(U_HLEN + len);
+	pudp->u_cksum = 0;
+	pip->ip_src = nif.ni_ip;		/* for the pseudo-header	*/
+	pip->ip_dst = pus->us_raddr;
+	sum = ~_udpsum(pip, pudp, U_HLEN + len);
+	pudp->u_cksum = sum ? sum : 0xffff;	/* 0 would mean none	*/
+	return(ipsend(pus->us_raddr, IPT_UDP, pep, U_HLEN + len));
+}
+
+/*------------------------------------------------------------------------
+ *  udpnextdg  --  wait for the next datagram on a socket, up to its
+ *		   timeout, and take it off the queue; sets *ppep to the
+ *		   buffer and *pdata to the data, and returns the length,
+ *		   TIMEOUT, or SYSERR if the socket is closed meanwhile
+ *------------------------------------------------------------------------
+ */
+int udpnextdg(struct udpsock *pus, struct ep **ppep, char **pdata)
+{
+	STATWORD ps;
+	struct	ep	*pep;
+	struct	ip	*pip;
+	struct	udp	*pudp;
+	int	fired;
+
+	lkdisable(ps, LK_NET);
+	if (pus->us_timeout > 0 && pus->us_qlen == 0)
+		tmset(&pus->us_tm, TM_MS(pus->us_timeout), _udptimeout,
+		    pus - &udptab[0]);
+	if (wait(pus->us_rsem) != OK || pus->us_state != US_OPEN) {
+		restore(ps);
+		return(SYSERR);
+	}
+	tmcancel(&pus->us_tm);
+	fired = pus->us_tmfired;
+	pus->us_tmfired = FALSE;
+	if (pus->us_qlen == 0) {
+		restore(ps);
+		return(TIMEOUT);
+	}
+	/* the timer woke us but a datagram came before we ran: its	*/
+	/* count is still on the semaphore, with no one waiting		*/
+	if (fired)
+		semaph[pus->us_rsem].semcnt--;
+	pep = pus->us_q[pus->us_qhead];
+	pus->us_qhead = (pus->us_qhead + 1) % UDP_QLEN;
+	pus->us_qlen--;
+	restore(ps);
+
+	pip = (struct ip *) pep->ep_data;
+	pudp = (struct udp *) ((char *) pip + IP_HLEN(pip));
+	*ppep = pep;
+	*pdata = pudp->u_data;
+	return(net2hs(pudp->u_len) - U_HLEN);
+}
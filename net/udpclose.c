@@ -0,0 +1,33 @@
+/* udpclose.c - udpclose */
+
+#include <conf.h>
+#include <kernel.h>
+#include <bufpool.h>
+#include <network.h>
+#include <stdio.h>
+
+/*------------------------------------------------------------------------
+ *  udpclose  --  close a UDP socket, dropping what is queued on it; a
+ *		  reader waiting on it gets SYSERR
+ *------------------------------------------------------------------------
+ */
+int udpclose(struct devsw *devptr)
+{
+	STATWORD ps;
+	struct	udpsock	*pus = (struct udpsock *) devptr->dvioblk;
+
+	lkdisable(ps, LK_NET);
+	if (pus->us_state != US_OPEN) {
+		restore(ps);
+		return(SYSERR);
+	}
+	pus->us_state = US_FREE;
+	tmcancel(&pus->us_tm);
+	for ( ; pus->us_qlen > 0 ; pus->us_qlen--) {
+		freebuf(pus->us_q[pus->us_qhead]);
+		pus->us_qhead = (pus->us_qhead + 1) % UDP_QLEN;
+	}
+	sdelete(pus->us_rsem);
+	restore(ps);
+	return(OK);
+}
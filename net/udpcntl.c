@@ -0,0 +1,43 @@
+/* udpcntl.c - udpcntl */
+
+#include <conf.h>
+#include <kernel.h>
+#include <network.h>
+#include <stdio.h>
+
+/*------------------------------------------------------------------------
+ *  udpcntl  --  control a UDP socket (see udp.h)
+ *------------------------------------------------------------------------
+ */
+int udpcntl(struct devsw *devptr, int func, int arg1, int arg2)
+{
+	STATWORD ps;
+	struct	udpsock	*pus = (struct udpsock *) devptr->dvioblk;
+
+	if (pus->us_state != US_OPEN)
+		return(SYSERR);
+	switch (func) {
+	case UDPC_REMOTE:
+		if (arg2 < 0 || arg2 > 0xffff || (arg1 == 0) != (arg2 == 0))
+			return(SYSERR);
+		lkdisable(ps, LK_NET);
+		pus->us_raddr = (IPaddr) arg1;
+		pus->us_rport = arg2;
+		restore(ps);
+		return(OK);
+	case UDPC_TIMEOUT:
+		if (arg1 < 0)
+			return(SYSERR);
+		pus->us_timeout = arg1;
+		return(OK);
+	case UDPC_RECV:
+		return(udpnextdg(pus, (struct ep **) arg1, (char **) arg2));
+	case UDPC_SEND:
+		if (udpsend(pus, (struct ep *) arg1, arg2) == SYSERR)
+			return(SYSERR);
+		return(arg2);
+	case UDPC_DROPS:
+		return((int) pus->us_drops);
+	}
+	return(SYSERR);
+}
@@ -0,0 +1,22 @@
+/* udpinit.c - udpinit */
+
+#include <conf.h>
+#include <kernel.h>
+#include <network.h>
+
+struct	udpsock	udptab[Nudp];
+
+/*------------------------------------------------------------------------
+ *  udpinit  --  initialize a UDP socket device
+ *------------------------------------------------------------------------
+ */
+int udpinit(struct devsw *devptr)
+{
+	struct	udpsock	*pus = &udptab[devptr->dvminor];
+
+	devptr->dvioblk = (char *) pus;
+	pus->us_state = US_FREE;
+	pus->us_dnum = devptr->dvnum;
+	tmclear(&pus->us_tm);
+	return(OK);
+}
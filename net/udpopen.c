@@ -0,0 +1,79 @@
+/* udpopen.c - udpopen */
+
+#include <conf.h>
+#include <kernel.h>
+#include <network.h>
+#include <stdio.h>
+
+LOCAL	int	udpnextport = 0;	/* where to look for a free one	*/
+
+/*------------------------------------------------------------------------
+ *  _udpinuse  --  is a socket bound to port (interrupts disabled)
+ *------------------------------------------------------------------------
+ */
+LOCAL int _udpinuse(int port)
+{
+	struct	udpsock	*pus;
+
+	for (pus = &udptab[0] ; pus < &udptab[Nudp] ; pus++)
+		if (pus->us_state == US_OPEN && pus->us_lport == port)
+			return(TRUE);
+	return(FALSE);
+}
+
+/*------------------------------------------------------------------------
+ *  udpopen  --  bind a UDP socket to local port lport, or to a free one
+ *		 if lport is 0, and connect it to remote, "a.b.c.d:port",
+ *		 unless that is NULL; returns the device
+ *------------------------------------------------------------------------
+ */
+int udpopen(struct devsw *devptr, char *remote, int lport)
+{
+	STATWORD ps;
+	struct	udpsock	*pus = (struct udpsock *) devptr->dvioblk;
+	IPaddr	raddr = 0;
+	int	rport = 0;
+	char	*p;
+	int	i;
+
+	if (nif.ni_state != NIS_UP || lport < 0 || lport > 0xffff)
+		return(SYSERR);
+	if (remote != NULL) {
+		for (p = remote ; *p != '\0' && *p != ':' ; p++)
+			;
+		if (*p != ':' || (raddr = dot2ip(remote)) == 0 ||
+		    (rport = atoi(p+1)) <= 0 || rport > 0xffff)
+			return(SYSERR);
+	}
+
+	lkdisable(ps, LK_NET);
+	if (pus->us_state != US_FREE) {
+		restore(ps);
+		return(SYSERR);
+	}
+	if (lport == 0) {
+		for (i=0 ; i<UDP_NPORT ; i++) {
+			lport = UDP_PORT0 + udpnextport;
+			udpnextport = (udpnextport + 1) % UDP_NPORT;
+			if (!_udpinuse(lport))
+				break;
+		}
+	} else if (_udpinuse(lport)) {
+		restore(ps);
+		return(SYSERR);
+	}
+	if ((pus->us_rsem = screate(0)) == SYSERR) {
+		restore(ps);
+		return(SYSERR);
+	}
+	pus->us_lport = lport;
+	pus->us_raddr = raddr;
+	pus->us_rport = rport;
+	pus->us_qhead = pus->us_qlen = 0;
+	pus->us_timeout = 0;
+	pus->us_tmfired = FALSE;
+	pus->us_drops = 0;
+	pus->us_state = US_OPEN;
+	restore(ps);
+	return(devptr->dvnum);
+}
@@ -0,0 +1,30 @@
+/* udpread.c - udpread */
+
+#include <conf.h>
+#include <kernel.h>
+#include <bufpool.h>
+#include <network.h>
+
+/*------------------------------------------------------------------------
+ *  udpread  --  wait for a datagram and copy up to len octets of it
+ *		 into buf; the rest of a longer one is lost. Returns the
+ *		 octets copied, or TIMEOUT.
+ *------------------------------------------------------------------------
+ */
+int udpread(struct devsw *devptr, char *buf, int len)
+{
+	struct	udpsock	*pus = (struct udpsock *) devptr->dvioblk;
+	struct	ep	*pep;
+	char	*data;
+	int	n;
+
+	if (pus->us_state != US_OPEN || len < 0)
+		return(SYSERR);
+	if ((n = udpnextdg(pus, &pep, &data)) < 0)
+		return(n);
+	if (n > len)
+		n = len;
+	blkcopy(buf, data, n);
+	freebuf(pep);
+	return(n);
+}
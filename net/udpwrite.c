@@ -0,0 +1,26 @@
+/* udpwrite.c - udpwrite */
+
+#include <conf.h>
+#include <kernel.h>
+#include <network.h>
+
+/*------------------------------------------------------------------------
+ *  udpwrite  --  send len octets from buf as one datagram to the
+ *		  socket's remote
+ *------------------------------------------------------------------------
+ */
+int udpwrite(struct devsw *devptr, char *buf, int len)
+{
+	struct	udpsock	*pus = (struct udpsock *) devptr->dvioblk;
+	struct	ep	*pep;
+
+	if (pus->us_state != US_OPEN || pus->us_raddr == 0 || len < 0 ||
+	    len > U_MAXDATA)
+		return(SYSERR);
+	if ((pep = netgetbuf()) == NULL)
+		return(SYSERR);
+	blkcopy(UDP_DATA(pep), buf, len);
+	if (udpsend(pus, pep, len) == SYSERR)
+		return(SYSERR);
+	return(len);
+}
@@ -0,0 +1,335 @@
+/* vionet.c - vioinit, viointr, viowrite */
+
+#include <conf.h>
+#include <kernel.h>
+#include <i386.h>
+#include <pci.h>
+#include <bufpool.h>
+#include <network.h>
+#include <vionet.h>
+#include <stdio.h>
+
+/*
+ * virtio-net for the kernel's stack, laid out as the monitor's driver
+ * is (mon/monvirtio.c) but on netpool buffers. Frames are received
+ * straight into the buffers and passed to netin() as they are, from the
+ * interrupt handler; emptied slots are refilled VIONRXBATCH at a time.
+ * The transmit queue never interrupts: sent frames are reaped when the
+ * next one goes out or a receive interrupt comes in. Kernel memory is
+ * mapped one to one, so a buffer's address is what the device is given.
+ */
+
+struct	vionet	vionet;
+
+#define	VIONQSPAN	((VIO_QBYTES(VIO_QMAX) + VIO_ALIGN - 1) & ~(VIO_ALIGN - 1))
+
+LOCAL	char	vionqmem[2 * VIONQSPAN + VIO_ALIGN];
+LOCAL	struct	vio_nethdr	vionrxhdr[VIONRXBUFS];
+LOCAL	struct	vio_nethdr	viontxhdr[VIONTXBUFS];	/* all zero	*/
+
+/*------------------------------------------------------------------------
+ *  _vioqinit  --  give the device queue qn, laid out at mem
+ *------------------------------------------------------------------------
+ */
+LOCAL int _vioqinit(struct vionet *vn, struct virtq *vq, int qn, char *mem)
+{
+	int	n;
+
+	outw(vn->vn_iobase + VIO_OFF_QSEL, qn);
+	n = inw(vn->vn_iobase + VIO_OFF_QSIZE);
+	if (n < 2 * VIONRXBUFS || n < 2 * VIONTXBUFS || n > VIO_QMAX)
+		return(SYSERR);
+
+	bzero(mem, VIO_QBYTES(n));
+	vq->size = n;
+	vq->desc = (struct vring_desc *) mem;
+	vq->avail = (struct vring_avail *) (mem + 16 * n);
+	vq->used = (struct vring_used *) (mem + VIO_QBYTES(n) - 6 - 8 * n);
+	vq->lastused = 0;
+	outl(vn->vn_iobase + VIO_OFF_QADDR, (unsigned long) mem / VIO_ALIGN);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  _viokick  --  tell the device about new avail entries, unless it has
+ *		  said it will find them on its own
+ *------------------------------------------------------------------------
+ */
+LOCAL void _viokick(struct vionet *vn, struct virtq *vq, int qn)
+{
+	VIO_MB();
+	if (!(vq->used->flags & VRING_USED_F_NO_NOTIFY))
+		outw(vn->vn_iobase + VIO_OFF_QNOTIFY, qn);
+}
+
+/*------------------------------------------------------------------------
+ *  _viorxfill  --  give buffers to the empty receive slots for as long
+ *		    as there are buffers, with one notify; returns how
+ *		    many were filled
+ *------------------------------------------------------------------------
+ */
+LOCAL int _viorxfill(struct vionet *vn)
+{
+	struct	virtq	*vq = &vn->vn_rxq;
+	struct	ep	*pep;
+	unsigned short	idx;
+	int	i, n;
+
+	idx = vq->avail->idx;
+	for (n=0 ; vn->vn_rxempty > 0 ; n++) {
+		if ((pep = netgetbuf()) == NULL)
+			break;
+		for (i = vn->vn_rxfill ; vn->vn_rxbuf[i] ; i = (i+1) % VIONRXBUFS)
+			;
+		vn->vn_rxbuf[i] = pep;
+		vq->desc[2*i + 1].addr = (unsigned long) &pep->ep_eh;
+		vq->desc[2*i + 1].len = EP_MAXLEN;
+		vq->avail->ring[idx++ & (vq->size - 1)] = 2 * i;
+		vn->vn_rxempty--;
+		vn->vn_rxfill = (i+1) % VIONRXBUFS;
+	}
+	if (n > 0) {
+		VIO_WMB();			/* entries before the index	*/
+		vq->avail->idx = idx;
+		_viokick(vn, vq, VIO_RXQ);
+	}
+	return(n);
+}
+
+/*------------------------------------------------------------------------
+ *  _viodemux  --  pass up every frame in the receive used ring, then
+ *		   refill the slots if a batch of them is empty
+ *------------------------------------------------------------------------
+ */
+LOCAL void _viodemux(struct vionet *vn)
+{
+	struct	virtq	*vq = &vn->vn_rxq;
+	volatile struct	vring_used_elem	*ue;
+	struct	ep	*pep;
+	int	i, len;
+
+	while (vq->lastused != vq->used->idx) {
+		VIO_WMB();
+		ue = &vq->used->ring[vq->lastused & (vq->size - 1)];
+		i = ue->id / 2;
+		len = ue->len - sizeof(struct vio_nethdr);
+		vq->lastused++;
+		if (i >= VIONRXBUFS || (pep = vn->vn_rxbuf[i]) == NULL)
+			continue;		/* not one we gave it	*/
+		vn->vn_rxbuf[i] = NULL;
+		vn->vn_rxempty++;
+
+		if (len < EP_HLEN || len > EP_MAXLEN) {
+			nif.ni_idrops++;
+			freebuf(pep);
+			continue;
+		}
+		pep->ep_len = len;
+		pep->ep_type = net2hs(pep->ep_type);
+		netin(pep);
+	}
+
+	if (vn->vn_rxempty >= VIONRXBATCH)
+		_viorxfill(vn);
+}
+
+/*------------------------------------------------------------------------
+ *  _viotxreap  --  free the frames the device has sent
+ *------------------------------------------------------------------------
+ */
+LOCAL void _viotxreap(struct vionet *vn)
+{
+	struct	virtq	*vq = &vn->vn_txq;
+	int	i;
+
+	while (vq->lastused != vq->used->idx) {
+		VIO_WMB();
+		i = vq->used->ring[vq->lastused & (vq->size - 1)].id / 2;
+		vq->lastused++;
+		if (i < VIONTXBUFS && vn->vn_txbuf[i]) {
+			freebuf(vn->vn_txbuf[i]);
+			vn->vn_txbuf[i] = NULL;
+			vn->vn_txfree++;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  vioinit  --  find the virtio-net device and set it up with one
+ *		 receive and one transmit queue
+ *------------------------------------------------------------------------
+ */
+int vioinit()
+{
+	struct	vionet	*vn = &vionet;
+	struct	vring_desc	*d;
+	unsigned short	status;
+	unsigned long	feat;
+	char	*mem;
+	int	dev, i;
+
+	if (pci_init() != OK ||
+	    (dev = find_pci_device(VIO_NET_DEVICE_ID, VIO_VENDOR_ID, 0)) ==
+	    SYSERR) {
+		kprintf("net: no virtio-net device\n");
+		return(SYSERR);
+	}
+	vn->vn_pcidev = dev;
+	pci_bios_read_config_dword(vn->vn_pcidev, VIO_PCI_IOBASE,
+	    &vn->vn_iobase);
+	pci_bios_read_config_byte(vn->vn_pcidev, VIO_PCI_IRQ, &vn->vn_irq);
+	if (!(vn->vn_iobase & 1)) {
+		kprintf("net: virtio-net has no legacy I/O interface\n");
+		return(SYSERR);
+	}
+	vn->vn_iobase &= ~3;
+
+	pci_bios_read_config_word(vn->vn_pcidev, PCI_COMMAND, &status);
+	pci_bios_write_config_word(vn->vn_pcidev, PCI_COMMAND,
+	    status | PCI_BUSMASTER);
+
+	/* reset, then say we know it and have a driver for it */
+	outb(vn->vn_iobase + VIO_OFF_STATUS, 0);
+	outb(vn->vn_iobase + VIO_OFF_STATUS, VIO_STT_ACK);
+	outb(vn->vn_iobase + VIO_OFF_STATUS, VIO_STT_ACK | VIO_STT_DRIVER);
+
+	/* the MAC address is all we want; no offloads, no merged buffers */
+	feat = inl(vn->vn_iobase + VIO_OFF_HOSTFEAT) & VIO_NET_F_MAC;
+	outl(vn->vn_iobase + VIO_OFF_GUESTFEAT, feat);
+
+	mem = (char *) (((unsigned long) vionqmem + VIO_ALIGN - 1) &
+	    ~(VIO_ALIGN - 1));
+	if (_vioqinit(vn, &vn->vn_rxq, VIO_RXQ, mem) != OK ||
+	    _vioqinit(vn, &vn->vn_txq, VIO_TXQ, mem + VIONQSPAN) != OK) {
+		outb(vn->vn_iobase + VIO_OFF_STATUS, VIO_STT_FAILED);
+		kprintf("net: virtio-net queues too small or too large\n");
+		return(SYSERR);
+	}
+
+	if (feat & VIO_NET_F_MAC)
+		for (i=0 ; i<EP_ALEN ; i++)
+			nif.ni_hwa[i] = inb(vn->vn_iobase + VIO_OFF_MAC + i);
+	else {					/* a locally administered one */
+		nif.ni_hwa[0] = 0x02;
+		for (i=1 ; i<EP_ALEN ; i++)
+			nif.ni_hwa[i] = i;
+	}
+
+	/* the header and frame descriptors of each slot stay paired */
+	for (i=0 ; i<VIONRXBUFS ; i++) {
+		d = &vn->vn_rxq.desc[2*i];
+		d->addr = (unsigned long) &vionrxhdr[i];
+		d->len = sizeof(struct vio_nethdr);
+		d->flags = VRING_DESC_F_NEXT | VRING_DESC_F_WRITE;
+		d->next = 2*i + 1;
+		d[1].flags = VRING_DESC_F_WRITE;
+		vn->vn_rxbuf[i] = NULL;
+	}
+	for (i=0 ; i<VIONTXBUFS ; i++) {
+		d = &vn->vn_txq.desc[2*i];
+		d->addr = (unsigned long) &viontxhdr[i];
+		d->len = sizeof(struct vio_nethdr);
+		d->flags = VRING_DESC_F_NEXT;
+		d->next = 2*i + 1;
+		vn->vn_txbuf[i] = NULL;
+	}
+	vn->vn_txq.avail->flags = VRING_AVAIL_F_NO_INTERRUPT;
+	vn->vn_txfree = VIONTXBUFS;
+	vn->vn_txnext = 0;
+	vn->vn_rxfill = 0;
+	vn->vn_rxempty = VIONRXBUFS;
+
+	set_evec(vn->vn_irq + IRQBASE, (u_long) vioint);
+	outb(vn->vn_iobase + VIO_OFF_STATUS,
+	    VIO_STT_ACK | VIO_STT_DRIVER | VIO_STT_DRIVEROK);
+	if (_viorxfill(vn) != VIONRXBUFS) {
+		kprintf("net: no buffers for virtio-net\n");
+		return(SYSERR);
+	}
+	nif.ni_write = viowrite;
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  viointr  --  handle a virtio-net interrupt; called by vioint
+ *------------------------------------------------------------------------
+ */
+int viointr()
+{
+	STATWORD ps;
+	struct	vionet	*vn = &vionet;
+
+	lkdisable(ps, LK_NET);
+
+	/* reading the ISR acknowledges it; 0 means not ours */
+	if (!(inb(vn->vn_iobase + VIO_OFF_ISR) & VIO_ISR_QUEUE)) {
+		restore(ps);
+		return(OK);
+	}
+
+	/* drain with the interrupt off, then turn it back on and look	*/
+	/* once more, for frames that came in before it was		*/
+	do {
+		vn->vn_rxq.avail->flags = VRING_AVAIL_F_NO_INTERRUPT;
+		_viodemux(vn);
+		_viotxreap(vn);
+		vn->vn_rxq.avail->flags = 0;
+		VIO_MB();
+	} while (vn->vn_rxq.lastused != vn->vn_rxq.used->idx);
+
+	/* the rings are consistent again: let whoever got a datagram run */
+	if (netresched) {
+		netresched = FALSE;
+		resched();
+	}
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  viowrite  --  queue a frame of len octets; the buffer is freed once
+ *		  it is sent, or now if it cannot be
+ *------------------------------------------------------------------------
+ */
+int viowrite(struct ep *pep, int len)
+{
+	STATWORD ps;
+	struct	vionet	*vn = &vionet;
+	struct	virtq	*vq = &vn->vn_txq;
+	int	i;
+
+	if (len > EP_MAXLEN) {
+		nif.ni_odrops++;
+		freebuf(pep);
+		return(SYSERR);
+	}
+	blkcopy(pep->ep_src, nif.ni_hwa, EP_ALEN);
+	pep->ep_len = len;
+	pep->ep_type = hs2net(pep->ep_type);
+
+	lkdisable(ps, LK_NET);
+	_viotxreap(vn);
+	if (vn->vn_rxempty >= VIONRXBATCH)	/* it may have freed some */
+		_viorxfill(vn);
+	if (vn->vn_txfree == 0) {
+		nif.ni_odrops++;
+		restore(ps);
+		freebuf(pep);
+		return(SYSERR);
+	}
+	for (i = vn->vn_txnext ; vn->vn_txbuf[i] ; i = (i+1) % VIONTXBUFS)
+		;
+	vn->vn_txbuf[i] = pep;
+	vn->vn_txfree--;
+	vn->vn_txnext = (i+1) % VIONTXBUFS;
+
+	vq->desc[2*i + 1].addr = (unsigned long) &pep->ep_eh;
+	vq->desc[2*i + 1].len = len;
+	vq->avail->ring[vq->avail->idx & (vq->size - 1)] = 2 * i;
+	VIO_WMB();
+	vq->avail->idx++;
+	_viokick(vn, vq, VIO_TXQ);
+	nif.ni_opackets++;
+	restore(ps);
+	return(OK);
+}
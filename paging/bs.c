@@ -56,7 +56,7 @@ int bs_alloc(bsd_t bsid, int npages) {
     bsptr->isheap = 0;
     bsptr->npages = npages;
     bsptr->maps   = NULL;
-    bsptr->frames = NULL;
+    bsptr->frames = FRM_NIL;
 
     return OK;
 }
@@ -108,7 +108,7 @@ int bs_free(bs_t * bsptr) {
     bsptr->status = BS_FREE;
     bsptr->isheap = 0;
     bsptr->npages = 256;
-    bsptr->frames = NULL;
+    bsptr->frames = FRM_NIL;
     bsptr->maps   = NULL;
 
 
@@ -3,6 +3,7 @@
 #include <conf.h>
 #include <kernel.h>
 #include <paging.h>
+#include <klog.h>
 #include <proc.h>
 #include <stdio.h>
 #include <bs.h>
@@ -60,7 +61,7 @@ int bs_cleanproc(int pid) {
     bs_map_t * curr;
 
 #if DUSTYDEBUG
-    kprintf("bs_cleanproc %d\n", pid);
+    klog(KL_DEBUG, "bs_cleanproc %d\n", pid);
 #endif
 
     // Iterate over the lists of maps for each backing store. Each 
@@ -124,37 +125,73 @@ int bs_cleanproc(int pid) {
 
 /*
  * bsm_frm_cleanup 
- *      - Given a mapping decrefcnt all frames that are 
- *        in this mapping
+ *      - Given a mapping remove the owning process's page table 
+ *        entries for it. Dirty pages are written back, frames no 
+ *        other process maps are released and so are page tables 
+ *        that end up empty.
+ *
+ * Note: Only the owner's page tables are walked. Going through
+ *       frm_decrefcnt() -> frm_free() instead would scan the page 
+ *       tables of every process (p_invalidate()) for each frame 
+ *       and clean the frame lists once per frame; here the lists
+ *       are cleaned once at the end.
  */
 int bsm_frm_cleanup(bs_map_t * bsmptr) {
-    bs_t * bsptr;
-    frame_t * prev;
-    frame_t * curr;
+    int vpno;
+    int last;
+    pd_t * pd;
+    pt_t * pt;
+    pt_t * pte;
+    frame_t * frame;
+    frame_t * ptframe;
 
 #if DUSTYDEBUG
-    kprintf("bsm_frm_cleanup for bsid:%d pid:%d vpno:%d npages:%d\n",
+    klog(KL_DEBUG, "bsm_frm_cleanup for bsid:%d pid:%d vpno:%d npages:%d\n",
             bsmptr->bsid, bsmptr->pid, bsmptr->vpno, bsmptr->npages);
 #endif
 
-    // Get a pointer to the bs_t structure for the backing store
-    bsptr = &bs_tab[bsmptr->bsid];
+    pd   = proctab[bsmptr->pid].pd;
+    last = bsmptr->vpno + bsmptr->npages;
+
+    for (vpno = bsmptr->vpno; vpno < last; vpno++) {
+
+        // No page table, skip to the first page of the next one
+        if (!pd[vpno / NENTRIES].pt_pres) {
+            vpno |= NENTRIES - 1;
+            continue;
+        }
+
+        pt  = (pt_t *)VPNO2VA(pd[vpno / NENTRIES].pt_base);
+        pte = &pt[vpno & (NENTRIES - 1)];
+        if (!pte->p_pres)
+            continue;
+
+        frame = PA2FP(VPNO2VA(pte->p_base));
+
+        if (pte->p_avail & PG_LOCKED)
+            p_unlock(bsmptr->pid, vpno);
 
-    // Go through the frames that this bs has and release the frame
-    // that corresponds to this virtual frame.
-    prev = NULL;
-    curr = bsptr->frames;
-    while (curr) {
+        // Other processes may still map the frame, but the dirty
+        // bit is only in this entry
+        if (pte->p_dirty)
+            write_bs((char *)FID2PA(frame->frmid), frame->bsid, frame->bspage);
 
-        // Does this frame match?
-        if (curr->bspage < bsmptr->npages)
-            frm_decrefcnt(curr);
+        p_free(pte);
 
-        // Move to next frame in list
-        prev = curr;
-        curr = curr->bs_next;
+        if (--frm_refcnt[frame->frmid] == 0)
+            frm_release(frame);
+
+        ptframe = PA2FP(pt);
+        if (--frm_refcnt[ptframe->frmid] == 0) {
+            frm_release(ptframe);
+            pd[vpno / NENTRIES].pt_pres = 0;
+        }
     }
 
+    // Take the released frames out of the fifo and bs lists
+    _frm_cleanlists(&bs_tab[bsmptr->bsid]);
+
+    return OK;
 }
 
 /*
@@ -253,16 +290,20 @@ int bs_add_mapping(bsd_t bsid, int pid, int vpno, int npages) {
     bs_map_t * bsmptr;
 
 #if DUSTYDEBUG
-    kprintf("bs_add_mapping(%d, %d, %d, %d) for proc %d\n", bsid, pid, vpno, npages, pid);
+    klog(KL_DEBUG, "bs_add_mapping(%d, %d, %d, %d) for proc %d\n", bsid, pid, vpno, npages, pid);
 #endif
 
+    // Page tables for the mapping go in a directory of pid's own
+    if (pd_private(pid) == SYSERR)
+        return SYSERR;
+
     // Get the pointer to the backing store.
     bsptr = &bs_tab[bsid];
 
     // Get memory for a new bs_map_t 
     bsmptr = (bs_map_t *) getmem(sizeof(bs_map_t));
     if (!bsmptr) {
-        kprintf("Error when calling getmem()!\n");
+        klog(KL_ERR, "Error when calling getmem()!\n");
         return SYSERR;
     }
 
@@ -271,6 +312,7 @@ int bs_add_mapping(bsd_t bsid, int pid, int vpno, int npages) {
     bsmptr->pid    = pid;
     bsmptr->vpno   = vpno;
     bsmptr->npages = npages;  
+    bsmptr->advice = XM_NORMAL;
 
     // Finally add the new mapping to the head of that maps list
     bsmptr->next   = bsptr->maps;
@@ -287,20 +329,20 @@ bs_map_t * bs_lookup_mapping(int pid, int vpno) {
     bs_map_t * bsmptr;
 
 #if DUSTYDEBUG
-    kprintf("bs_lookup_mapping(%d, %d) for proc %d..\t", pid, vpno, pid);
+    klog(KL_DEBUG, "bs_lookup_mapping(%d, %d) for proc %d..\t", pid, vpno, pid);
 #endif
 
     // Find the mapping using _bs_operate_on_mapping function
     rc = _bs_operate_on_mapping(pid, vpno, OP_FIND, &bsmptr);
     if (rc == SYSERR) {
-        kprintf("\nCould not find mapping!\n");
+        klog(KL_WARN, "\nCould not find mapping!\n");
         return NULL;
     }
 
 
 
 #if DUSTYDEBUG
-    kprintf("found bsid:%d pid:%d vpno:%d npages:%d\n",
+    klog(KL_DEBUG, "found bsid:%d pid:%d vpno:%d npages:%d\n",
     bsmptr->bsid,
     bsmptr->pid,
     bsmptr->vpno,
@@ -319,12 +361,12 @@ int bs_del_mapping(int pid, int vpno) {
     int rc;
 
 #if DUSTYDEBUG
-    kprintf("bs_del_mapping(%d, %d) for proc %d\n", pid, vpno, pid);
+    klog(KL_DEBUG, "bs_del_mapping(%d, %d) for proc %d\n", pid, vpno, pid);
 #endif
 
     rc = _bs_operate_on_mapping(pid, vpno, OP_DELETE, NULL);
     if (rc == SYSERR) {
-        kprintf("Could not delete mapping!\n");
+        klog(KL_ERR, "Could not delete mapping!\n");
         return SYSERR;
     }
 
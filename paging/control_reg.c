@@ -2,11 +2,10 @@
 		   write_cr0 write_cr3 write_cr4 enable_pagine */
 
 #include <conf.h>
+#include <i386.h>
 #include <kernel.h>
 #include <stdio.h>
 
-unsigned long tmp;
-
 
 /*-------------------------------------------------------------------------
  * read_cr0 - read CR0
@@ -19,12 +18,7 @@ unsigned long read_cr0(void) {
 
   disable(ps);
 
-  asm("pushl %eax");
-  asm("movl %cr0, %eax");
-  asm("movl %eax, tmp");
-  asm("popl %eax");
-
-  local_tmp = tmp;
+  asm volatile("movl %%cr0, %0" : "=r" (local_tmp));
 
   restore(ps);
 
@@ -43,12 +37,7 @@ unsigned long read_cr2(void) {
 
   disable(ps);
 
-  asm("pushl %eax");
-  asm("movl %cr2, %eax");
-  asm("movl %eax, tmp");
-  asm("popl %eax");
-
-  local_tmp = tmp;
+  asm volatile("movl %%cr2, %0" : "=r" (local_tmp));
 
   restore(ps);
 
@@ -68,12 +57,7 @@ unsigned long read_cr3(void) {
 
   disable(ps);
 
-  asm("pushl %eax");
-  asm("movl %cr3, %eax");
-  asm("movl %eax, tmp");
-  asm("popl %eax");
-
-  local_tmp = tmp;
+  asm volatile("movl %%cr3, %0" : "=r" (local_tmp));
 
   restore(ps);
 
@@ -93,12 +77,7 @@ unsigned long read_cr4(void) {
 
   disable(ps);
 
-  asm("pushl %eax");
-  asm("movl %cr4, %eax");
-  asm("movl %eax, tmp");
-  asm("popl %eax");
-
-  local_tmp = tmp;
+  asm volatile("movl %%cr4, %0" : "=r" (local_tmp));
 
   restore(ps);
 
@@ -117,12 +96,7 @@ void write_cr0(unsigned long n) {
 
   disable(ps);
 
-  tmp = n;
-  asm("pushl %eax");
-  asm("movl tmp, %eax");		/* mov (move) value at tmp into %eax register. 
-					   "l" signifies long (see docs on gas assembler)	*/
-  asm("movl %eax, %cr0");
-  asm("popl %eax");
+  asm volatile("movl %0, %%cr0" : : "r" (n) : "memory");
 
   restore(ps);
 
@@ -141,12 +115,7 @@ void write_cr3(unsigned long n) {
 
   disable(ps);
 
-  tmp = n;
-  asm("pushl %eax");
-  asm("movl tmp, %eax");                /* mov (move) value at tmp into %eax register.
-                                           "l" signifies long (see docs on gas assembler)       */
-  asm("movl %eax, %cr3");
-  asm("popl %eax");
+  asm volatile("movl %0, %%cr3" : : "r" (n) : "memory");
 
   restore(ps);
 
@@ -165,12 +134,7 @@ void write_cr4(unsigned long n) {
 
   disable(ps);
 
-  tmp = n;
-  asm("pushl %eax");
-  asm("movl tmp, %eax");                /* mov (move) value at tmp into %eax register.
-                                           "l" signifies long (see docs on gas assembler)       */
-  asm("movl %eax, %cr4");
-  asm("popl %eax");
+  asm volatile("movl %0, %%cr4" : : "r" (n) : "memory");
 
   restore(ps);
 
@@ -200,5 +164,12 @@ void set_PDBR(unsigned long n) {
   // This means we must left shift n by 12. 
 
   n = n << 12;
+
+#ifdef VSTACK
+  // The page fault task returns to the Xinu task with a task switch,
+  // which reloads CR3 from the Xinu TSS. Keep that copy current.
+  cputss()[0].ts_pdbr = n;
+#endif
+
   write_cr3(n); 
 }
@@ -3,75 +3,90 @@
 #include <kernel.h>
 #include <proc.h>
 #include <paging.h>
+#include <klog.h>
+#include <trace.h>
 #include <stdio.h>
 
 
 
 // When writing out a dirty page the only way to figure out which backing store
-// a dirty frame belongs to would be to traverse the page tables of every process 
-// looking for a frame location that corresponds to the frame we wish to write out. 
-// This is inefficient. To prevent this we use an inverted page table (maps frames 
-// to pages) named frm_tab that holds NFRAMES entries and each entry is a frame_t 
-// structure that contains the following data in each :
+// a dirty frame belongs to would be to traverse the page tables of every process
+// looking for a frame location that corresponds to the frame we wish to write out.
+// This is inefficient. To prevent this we use an inverted page table (maps frames
+// to pages) that holds NFRAMES entries, indexed by frame id.
 //
-//  int frmid;  // The frame id (index) 
-//  int status; // FRM_FREE - frame is not being used
-//              // FRM_USED - frame is being used
-//  int type;   // FRM_PD   - Being used for a page directory
-//              // FRM_PT   - Being used for a page table
-//              // FRM_BS   - Part of a backing store
-//  int accessed; // Was the frame accessed or not since last
-//                // check?
-//  int refcnt; // If the frame is used for a page table (FRM_PGT),
-//              // refcnt is the number of mappings in the table. 
-//              // When refcnt is 0 release the frame. 
-//              //
-//              // If the frame is used for FRM_BS, refcnt will be the
-//              // number of times this frame is mapped by processes.
-//              // When refcnt is 0 release the frame.
-//  int age; // when the page is loaded, in ticks
-//           // Used for page replacement policy AGING 
-//              
-//  struct _frame_t * fifo_next;
-//      // The fifo that keeps up with the order in which frames were
-//      // allocated. Oldest frames are at the head of the fifo.
-//  // Following are only used if status == FRM_BS
-//  int    bsid;              // The backing store this frame maps to
-//  int    bspage;            // The page within the backing store
-//  struct _frame_t * bs_next; // The list of all the frames for this bs
+// The table is split in two. The fields the replacement policies and
+// the frame searches go through for every frame are kept in packed
+// arrays (the "hot" part), so a scan only pulls in the bytes it looks
+// at:
 //
+//  frm_status[]   // FRM_FREE - frame is not being used
+//                 // FRM_USED - frame is being used
+//  frm_type[]     // FRM_PD   - Being used for a page directory
+//                 // FRM_PT   - Being used for a page table
+//                 // FRM_BS   - Part of a backing store
+//                 // FRM_STK  - Part of a process stack
+//  frm_age[]      // Used for page replacement policy AGING
+//  frm_accessed[] // Was the frame accessed or not since last check?
+//  frm_refcnt[]   // If the frame is used for a page table (FRM_PT),
+//                 // refcnt is the number of mappings in the table.
+//                 // If the frame is used for FRM_BS, refcnt will be the
+//                 // number of times this frame is mapped by processes.
+//                 // When refcnt is 0 release the frame.
+//  frm_pincnt[]   // Number of xmlock() pins, pinned frames are
+//                 // never evicted
+//  frm_fifo_next[]// The fifo that keeps up with the order in which
+//                 // frames were allocated. Oldest frames are at the
+//                 // head of the fifo.
+//
+// The rest lives in frm_tab[], an array of frame_t (the "cold" part):
+// which backing store page the frame holds and the link in that
+// backing store's list of frames. frame_t pointers into frm_tab[] are
+// still what is passed around to identify a frame.
 //
 // With this information we can easily find what bs and bspage the physical frame
 // maps to and write it to the appropriate location.
-//
-// Note: This table also holds some information useful in page replacement decisions
 
 
-// Table with entries reprensenting frame
+// Hot part of the frame table
+unsigned char  frm_status[NFRAMES];
+unsigned char  frm_type[NFRAMES];
+unsigned char  frm_age[NFRAMES];
+unsigned char  frm_accessed[NFRAMES];
+unsigned short frm_refcnt[NFRAMES];
+unsigned short frm_pincnt[NFRAMES];
+frm_idx_t      frm_fifo_next[NFRAMES];
+
+// Cold part of the frame table
 frame_t frm_tab[NFRAMES];
 
 // Used for FIFO frame replacement policy
-frame_t * frm_fifo_head;
+frm_idx_t frm_fifo_head;
+frm_idx_t frm_fifo_tail;
+
+// Number of frames pinned with xmlock()
+int frm_npinned = 0;
 
 frame_t * _frm_evict();
 frame_t * _frm_evict_fifo();
 frame_t * _frm_evict_aging();
+frame_t * _frm_findfree();
+frame_t * _frm_setup(frame_t * frame);
 
 
 /*
  * frm_decrefcnt - decrease the reference count of a frame
- *                 and free if it possible 
+ *                 and free if it possible
  */
 int frm_decrefcnt(frame_t * frame) {
+    int id = frame->frmid;
 
 #if DUSTYDEBUG
-    kprintf("frm_decrefcnt(): frm %d type %d - cnt %d -> %d\n", 
-            frame->frmid, frame->type, frame->refcnt, frame->refcnt - 1);
-#endif 
-
-    frame->refcnt--;
+    klog(KL_DEBUG, "frm_decrefcnt(): frm %d type %d - cnt %d -> %d\n",
+            id, frm_type[id], frm_refcnt[id], frm_refcnt[id] - 1);
+#endif
 
-    if (frame->refcnt == 0)
+    if (--frm_refcnt[id] == 0)
         frm_free(frame);
 
     return OK;
@@ -86,39 +101,40 @@ int frm_decrefcnt(frame_t * frame) {
  */
 int _frm_cleanlists(void * bspointer) {
     bs_t * bsptr;
-    frame_t * prev;
-    frame_t * curr;
+    frm_idx_t prev;
+    frm_idx_t curr;
 
     bsptr = (bs_t *) bspointer;
 
     // Go through fifo_list!
-    prev = NULL;
+    prev = FRM_NIL;
     curr = frm_fifo_head;
-    while (curr) {
-        if (curr->status == FRM_FREE) {
+    while (curr != FRM_NIL) {
+        if (frm_status[curr] == FRM_FREE) {
 
 #if DUSTYDEBUG
-            kprintf("_frm_cleanlists(): removing frm %d from fifo_next list\n", 
-                    curr->frmid);
-#endif 
+            klog(KL_DEBUG, "_frm_cleanlists(): removing frm %d from fifo_next list\n",
+                    curr);
+#endif
 
             // Remove the frame from the list. Act differently
             // depending on if the frame is the head of the list or
             // not
-            if (prev == NULL) {
-                frm_fifo_head = curr->fifo_next;
-                curr = frm_fifo_head;
-            } else {
-                prev->fifo_next = curr->fifo_next;
-                curr = prev->fifo_next;
-            }
+            if (prev == FRM_NIL)
+                frm_fifo_head = frm_fifo_next[curr];
+            else
+                frm_fifo_next[prev] = frm_fifo_next[curr];
+
+            if (frm_fifo_tail == curr)
+                frm_fifo_tail = prev;
 
+            curr = frm_fifo_next[curr];
             continue;
-        } 
+        }
 
         // Move to next frame in list
         prev = curr;
-        curr = curr->fifo_next;
+        curr = frm_fifo_next[curr];
     }
 
 
@@ -127,33 +143,31 @@ int _frm_cleanlists(void * bspointer) {
     if (bsptr == NULL)
         return OK;
 
-    prev = NULL;
+    prev = FRM_NIL;
     curr = bsptr->frames;
-    while (curr) {
-        if (curr->status == FRM_FREE) {
+    while (curr != FRM_NIL) {
+        if (frm_status[curr] == FRM_FREE) {
 
 #if DUSTYDEBUG
-            kprintf("_frm_cleanlists(): removing frm %d from bs_next list\n", 
-                    curr->frmid);
-#endif 
+            klog(KL_DEBUG, "_frm_cleanlists(): removing frm %d from bs_next list\n",
+                    curr);
+#endif
 
             // Remove the frame from the list. Act differently
             // depending on if the frame is the head of the list or
             // not
-            if (prev == NULL) {
-                bsptr->frames = curr->bs_next;
-                curr = bsptr->frames;
-            } else {
-                prev->bs_next = curr->bs_next;
-                curr = prev->bs_next;
-            }
+            if (prev == FRM_NIL)
+                bsptr->frames = frm_tab[curr].bs_next;
+            else
+                frm_tab[prev].bs_next = frm_tab[curr].bs_next;
 
+            curr = frm_tab[curr].bs_next;
             continue;
-        } 
+        }
 
         // Move to next frame in list
         prev = curr;
-        curr = curr->bs_next;
+        curr = frm_tab[curr].bs_next;
     }
 
 
@@ -161,79 +175,126 @@ int _frm_cleanlists(void * bspointer) {
 }
 
 /*
- * frm_free - free a frame 
+ * _frm_clear - Reset the table entry of a frame that is being freed.
+ *
+ * Note: Don't clean up bs_next and fifo_next as loops may still be
+ *       using them for now. They will be reset in _frm_setup()
  */
-int frm_free(frame_t * frame) {
+LOCAL void _frm_clear(int id) {
+
+    frm_status[id]   = FRM_FREE;
+    frm_type[id]     = FRM_FREE;
+    frm_refcnt[id]   = 0;
+    frm_age[id]      = 0;
+    frm_accessed[id] = 0;
+    frm_tab[id].bsid   = -1;
+    frm_tab[id].bspage = 0;
+
+    // Normally unlocked before it gets here, keep the count right
+    // if not.
+    if (frm_pincnt[id]) {
+        frm_pincnt[id] = 0;
+        frm_npinned--;
+    }
+}
 
-    bs_t * bsptr;
-    pt_t * pte;
-    int dirty;
+/*
+ * frm_release - Mark a frame free without searching every process's
+ *               page tables for entries that map it like frm_free()
+ *               does. Only for frames the caller knows are no longer
+ *               mapped, with any dirty data already written back.
+ *               The frame stays on the fifo and bs lists until the
+ *               caller runs _frm_cleanlists(), so a whole batch of
+ *               frames can be released with one pass over the lists.
+ */
+int frm_release(frame_t * frame) {
 
     if (!IS_VALID_FRMID(frame->frmid))
         return SYSERR;
 
 #if DUSTYDEBUG
-    kprintf("frm_free(): Freeing frame %d\n", frame->frmid);
-#endif 
+    klog(KL_DEBUG, "frm_release(): Releasing frame %d\n", frame->frmid);
+#endif
+
+    _frm_clear(frame->frmid);
+
+    return OK;
+}
+
+/*
+ * frm_free - free a frame
+ */
+int frm_free(frame_t * frame) {
+    int id;
+    int dirty;
+
+    id = frame->frmid;
+    if (!IS_VALID_FRMID(id))
+        return SYSERR;
+
+#if DUSTYDEBUG
+    klog(KL_DEBUG, "frm_free(): Freeing frame %d\n", id);
+#endif
 
     // Invalidate any page table entries for this frame
-    dirty = p_invalidate(FID2PA(frame->frmid));
+    dirty = p_invalidate(FID2PA(id));
+    TRACE(TRC_FRAME, TE_FRMFREE, id, frm_type[id], dirty, 0);
 
     // If this frame is mapped from a backing store
     // then write the data back to the backing store
-    if (frame->type == FRM_BS && dirty) {
+    if (frm_type[id] == FRM_BS && dirty) {
 
         // Make sure the bsid is valid
         if (!IS_VALID_BSID(frame->bsid))
             return SYSERR;
-        
-        write_bs(FID2PA(frame->frmid), frame->bsid, frame->bspage);
+
+        write_bs(FID2PA(id), frame->bsid, frame->bspage);
 
     }
 
     // Set the frame status as free and clean it up from any
     // lists it may be in.
-    frame->status = FRM_FREE;
+    frm_status[id] = FRM_FREE;
 
     // Clean this frame up from any lists it may be in
-    if (frame->type == FRM_BS)
+    if (frm_type[id] == FRM_BS)
         _frm_cleanlists(&bs_tab[frame->bsid]);
     else
         _frm_cleanlists(NULL);
 
-
     // Any other cleanup that needs to be done..
-    //
-    // Note: Don't clean up bs_next and fifo_next 
-    //       as loops may still be using them for now.
-    //       They will be set to null in frm_alloc()
-    frame->type   = FRM_FREE;
-    frame->refcnt = 0;
-    frame->age    = 0;
-    frame->bsid   = -1;
-    frame->bspage = 0;
-    frame->accessed = 0;
-
+    _frm_clear(id);
 
     return OK;
 }
 
 /*
- * _frm_evict - Find a frame to evict from memory
+ * _frm_findfree - Find a frame that is not being used
  */
-frame_t * _frm_evict() {
+frame_t * _frm_findfree() {
     int i;
-    frame_t * frame;
 
     // Iterate over the frames
     for (i=0; i < NFRAMES; i++) {
-        frame = &frm_tab[i];
 
         // Is this frame free, if so use it
-        if (frame->status == FRM_FREE)
-            return frame;
+        if (frm_status[i] == FRM_FREE)
+            return &frm_tab[i];
     }
 
+    return NULL;
+}
+
+/*
+ * _frm_evict - Find a frame to evict from memory
+ */
+frame_t * _frm_evict() {
+    frame_t * frame;
+
+    // Use a free frame if there is one
+    if ((frame = _frm_findfree()) != NULL)
+        return frame;
+
     if (grpolicy() == FIFO) {
         if ((frame = _frm_evict_fifo()) == NULL)
             return NULL;
@@ -243,7 +304,7 @@ frame_t * _frm_evict() {
     }
 
     if (debugTA)
-        kprintf("_frm_evict(): Evicting frame %d\n", frame->frmid);
+        klog(KL_INFO, "_frm_evict(): Evicting frame %d\n", frame->frmid);
 
     // Free the frame
     frm_free(frame);
@@ -255,76 +316,66 @@ frame_t * _frm_evict() {
  * _frm_evict_fifo - Evict using FIFO replacement policy
  */
 frame_t * _frm_evict_fifo() {
-    frame_t * prev;
-    frame_t * curr;
-    int found = 0;
+    frm_idx_t curr;
 
 #if DUSTYDEBUG
-        kprintf("_frm_evict_fifo(): Evicting frame\n");
-#endif 
+        klog(KL_DEBUG, "_frm_evict_fifo(): Evicting frame\n");
+#endif
 
     // we must force one page out of memory to free up space.
     //
-    // Release the frame closest to the head of the fifo that 
-    // isn't a page directory or page table
-    prev = NULL;
+    // Release the frame closest to the head of the fifo that
+    // isn't a page directory or page table, or pinned
     curr = frm_fifo_head;
-    while (curr) {
-        if (curr->type == FRM_BS) {
-            found = 1;
-            break;
-        }
-        prev = curr;
-        curr = curr->fifo_next;
+    while (curr != FRM_NIL) {
+        if (frm_type[curr] == FRM_BS && frm_pincnt[curr] == 0)
+            return &frm_tab[curr];
+        curr = frm_fifo_next[curr];
     }
 
     // If we didn't find anything then return null
-    if (!found)
-        return NULL;
-
-    // return the pointer to the free frame
-    return curr;
+    return NULL;
 }
 
 /*
  * _frm_evict_aging - Evict using AGING replacement policy
  *
  * Note: The way the algorithm works out the smallest value
- *       for age actually means it is the oldest so we will 
+ *       for age actually means it is the oldest so we will
  *       find a frame with the smallest value for age to evict.
+ *       Of frames with the same age the one closest to the head
+ *       of the fifo goes.
  */
 frame_t * _frm_evict_aging() {
-    frame_t * prev;
-    frame_t * curr;
-    frame_t * candidate;
-    frame_t framestruct;
+    frm_idx_t curr;
+    frm_idx_t candidate;
+    int minage;
 
 #if DUSTYDEBUG
-        kprintf("_frm_evict_aging(): Evicting frame\n");
-#endif 
+        klog(KL_DEBUG, "_frm_evict_aging(): Evicting frame\n");
+#endif
 
-    // Initially our candidate will be set to the fake frame
-    // with age 255;
-    candidate = &framestruct;
-    candidate->age = 255;
+    // Initially there is no candidate, anything younger than
+    // 255 will do
+    candidate = FRM_NIL;
+    minage    = 255;
 
-    // Find the frame with largest age.
-    prev = NULL;
+    // Find the frame with smallest age.
     curr = frm_fifo_head;
-    while (curr) {
-        if (curr->type == FRM_BS) {
-            if (curr->age < candidate->age)
-                candidate = curr;
+    while (curr != FRM_NIL) {
+        if (frm_type[curr] == FRM_BS && frm_pincnt[curr] == 0 &&
+            frm_age[curr] < minage) {
+            candidate = curr;
+            minage    = frm_age[curr];
         }
-        prev = curr;
-        curr = curr->fifo_next;
+        curr = frm_fifo_next[curr];
     }
 
     // Did we find a real candidate? If not.. error
-    if (candidate == &framestruct)
+    if (candidate == FRM_NIL)
         return NULL;
 
-    return candidate;
+    return &frm_tab[candidate];
 }
 
 /*
@@ -334,22 +385,25 @@ frame_t * _frm_evict_aging() {
 int init_frmtab() {
     int i;
 
-    // To start out the FIFO frame replacement policy 
+    // To start out the FIFO frame replacement policy
     // head pointer will be null;
-    frm_fifo_head = NULL;
+    frm_fifo_head = FRM_NIL;
+    frm_fifo_tail = FRM_NIL;
 
     // Initialize all of the information in the frame table
     for (i=0; i < NFRAMES; i++) {
-        frm_tab[i].frmid  = i;        // frame id/index
-        frm_tab[i].status = FRM_FREE; // Current status
-        frm_tab[i].type   = FRM_FREE; // Type
-        frm_tab[i].refcnt = 0;        // reference count
-        frm_tab[i].age    = 0;        // when page is loaded (in ticks)
-        frm_tab[i].bspage = 0;
-        frm_tab[i].bsid   = -1;
-        frm_tab[i].accessed  = 0;
-        frm_tab[i].fifo_next = NULL;
-        frm_tab[i].bs_next   = NULL;
+        frm_tab[i].frmid   = i;       // frame id/index
+        frm_tab[i].bspage  = 0;
+        frm_tab[i].bsid    = -1;
+        frm_tab[i].bs_next = FRM_NIL;
+
+        frm_status[i]    = FRM_FREE; // Current status
+        frm_type[i]      = FRM_FREE; // Type
+        frm_refcnt[i]    = 0;        // reference count
+        frm_age[i]       = 0;        // when page is loaded (in ticks)
+        frm_pincnt[i]    = 0;        // not pinned
+        frm_accessed[i]  = 0;
+        frm_fifo_next[i] = FRM_NIL;
     }
 
     return OK;
@@ -357,45 +411,68 @@ int init_frmtab() {
 
 /*
  * frm_alloc - get a free frame according page replacement policy.
- * 
+ *
  */
 frame_t * frm_alloc() {
-    int i;
     frame_t * frame;
-    frame_t * curr;
-
 
     frame = _frm_evict();
     if (frame == NULL) {
-        kprintf("frm_alloc(): failed to find/evict frame\n"); 
+        klog(KL_ERR, "frm_alloc(): failed to find/evict frame\n");
         return NULL;
     }
 
+    return _frm_setup(frame);
+}
+
+/*
+ * frm_getfree - like frm_alloc() but only hands out a frame that is
+ *               already free, it never evicts. Used for speculative
+ *               loads (read-ahead, prefault) that shouldn't push out
+ *               pages somebody is using.
+ */
+frame_t * frm_getfree() {
+    frame_t * frame;
+
+    frame = _frm_findfree();
+    if (frame == NULL)
+        return NULL;
+
+    return _frm_setup(frame);
+}
+
+/*
+ * _frm_setup - Initialize a newly handed out frame and add it
+ *              to the end of the fifo.
+ */
+frame_t * _frm_setup(frame_t * frame) {
+    int id = frame->frmid;
+
 #if DUSTYDEBUG
-    kprintf("Allocating frame \tid:%d \taddr:0x%08x\n", 
-            frame->frmid,
-            FID2PA(frame->frmid));
+    klog(KL_DEBUG, "Allocating frame \tid:%d \taddr:0x%08x\n",
+            id,
+            FID2PA(id));
 #endif
 
-    // Populate data in the frame_t table
-    frame->status    = FRM_USED; // Current status
-    frame->refcnt    = 0;        // should be updated by caller
-    frame->accessed  = 0;
-    frame->age       = 0;
-    frame->bsid      = -1;
-    frame->bspage    = 0;
-    frame->fifo_next = NULL;
-    frame->bs_next   = NULL;
-
-    // Add frame to end of fifo. 
-    if (frm_fifo_head == NULL) {
-        frm_fifo_head = frame;
-    } else {
-        curr = frm_fifo_head;
-        while (curr->fifo_next != NULL)
-            curr = curr->fifo_next;
-        curr->fifo_next = frame;
-    }
+    TRACE(TRC_FRAME, TE_FRMALLOC, id, 0, 0, 0);
+
+    // Populate data in the frame table
+    frm_status[id]    = FRM_USED; // Current status
+    frm_refcnt[id]    = 0;        // should be updated by caller
+    frm_accessed[id]  = 0;
+    frm_age[id]       = 0;
+    frm_pincnt[id]    = 0;
+    frm_fifo_next[id] = FRM_NIL;
+    frame->bsid       = -1;
+    frame->bspage     = 0;
+    frame->bs_next    = FRM_NIL;
+
+    // Add frame to end of fifo.
+    if (frm_fifo_head == FRM_NIL)
+        frm_fifo_head = id;
+    else
+        frm_fifo_next[frm_fifo_tail] = id;
+    frm_fifo_tail = id;
 
     return frame;
 
@@ -403,38 +480,31 @@ frame_t * frm_alloc() {
 
 
 /*
- * frm_find_bspage - Iterate over the frame table and determine 
- *                   if the backing store page (determined by bsid,
- *                   bsoffset) is already in physical memory. If so
- *                   return a pointer to the frame_t struct for that
- *                   frame
+ * frm_find_bspage - Determine if the backing store page (determined
+ *                   by bsid, bsoffset) is already in physical memory.
+ *                   If so return a pointer to the frame_t struct for
+ *                   that frame. Only the frames of that backing store
+ *                   (its bs_next list) are looked at.
  */
 frame_t * frm_find_bspage(int bsid, int bsoffset) {
-    int i;
-    frame_t * frame;
-
-    // Iterate over the frames
-    for (i=0; i < NFRAMES; i++) {
-
-        frame = &frm_tab[i];
+    frm_idx_t curr;
 
-        // Is this frame free, if so skip
-        if (frame->status == FRM_FREE)
-            continue;
+    // Iterate over the frames of the bs
+    for (curr = bs_tab[bsid].frames; curr != FRM_NIL; curr = frm_tab[curr].bs_next) {
 
-        // Is this a backing store page. If not skip
-        if (frame->type != FRM_BS)
+        // Skip frames freed but not yet off the list
+        if (frm_status[curr] == FRM_FREE)
             continue;
 
-        // Does the bsid/bsoffset match? If so.. bingo
-        if (frame->bsid == bsid && frame->bspage == bsoffset) {
+        // Does the bsoffset match? If so.. bingo
+        if (frm_tab[curr].bspage == bsoffset) {
 #if DUSTYDEBUG
-            kprintf("Frame %d for bs:%d bspage:%d already mapped\n", 
-                frame->frmid,
+            klog(KL_DEBUG, "Frame %d for bs:%d bspage:%d already mapped\n",
+                curr,
                 bsid,
                 bsoffset);
 #endif
-            return frame;
+            return &frm_tab[curr];
 
         }
 
@@ -455,8 +525,6 @@ int frm_update_ages() {
     struct pentry * pptr;
     pd_t * pd;
     pt_t * pt;
-    frame_t * frame;
-    frame_t * curr;
 
 
     for (proc=0; proc<NPROC; proc++) {
@@ -469,14 +537,14 @@ int frm_update_ages() {
         // Get the page dir for this process
         // and iterate over entries
         //
-        // Note: Must start at 4 because we don't 
-        // want to operate on entries from first 4 
+        // Note: Must start at 4 because we don't
+        // want to operate on entries from first 4
         // page tables.
-        pd = pptr->pd; 
+        pd = pptr->pd;
         for (i=4; i<NENTRIES; i++) {
 
-            // Is this page table present?
-            if (pd[i].pt_pres) {
+            // Is this page table present? (and not the APIC's)
+            if (pd[i].pt_pres && !pd[i].pt_avail) {
                 pt = VPNO2VA(pd[i].pt_base);
 
                 // Iterate over page table entries
@@ -485,8 +553,7 @@ int frm_update_ages() {
                     // Has it been accessed?
                     if (pt[j].p_pres && pt[j].p_acc) {
 
-                        frame = PA2FP(VPNO2VA(pt[j].p_base));
-                        frame->accessed = 1;
+                        frm_accessed[PA2FID(VPNO2VA(pt[j].p_base))] = 1;
                         pt[j].p_acc = 0; // reset accessed bit
 
                     }
@@ -500,42 +567,39 @@ int frm_update_ages() {
     }
 
     // Now that all the accessed bits are updated lets update
-    // the ages of the frames. We needed to do this separately because 
+    // the ages of the frames. We needed to do this separately because
     // otherwise if two pages map to a single frame the frames would
     // get updated twice everytime this was done. By updating the
     // accessed bit in the frame (doesn't matter if you update it
     // twice) first, then we ensure we only update the age once.
-    curr = frm_fifo_head;
-    while (curr) {
+    //
+    // Free frames have age 0 and aren't accessed so going over
+    // the whole array gives the same result as following the fifo.
+    for (i=0; i < NFRAMES; i++) {
 
-        x = curr->age;
+        x = frm_age[i];
 
         // All frames age get decreased by half
         // Keep in mind we evict pages with smallest
-        // age (decreasing age increases chance of 
+        // age (decreasing age increases chance of
         // page replacement).
-        curr->age = curr->age >> 1;
-
-        // If the page was accessed then we add 128 to the age
-        if (curr->accessed) {
-
-            curr->age += 128;
-            if (curr->age > 255)
-                curr->age = 255; //max out at 255
-
-            curr->accessed = 0; // reset access flag
+        //
+        // If the page was accessed then we add 128 to the age,
+        // which can't go over 255.
+        if (frm_accessed[i]) {
+            frm_age[i] = (x >> 1) + 128;
+            frm_accessed[i] = 0; // reset access flag
+        } else {
+            frm_age[i] = x >> 1;
         }
 
 #if DUSTYDEBUG
         // Print out message if age changed
-        if (x != curr->age)
-            kprintf("Updated age of frame %d from %d to %d %s\n",
-                    curr->frmid, x, curr->age,
-                    (curr->age > x) ? "(accessed)" : "");
+        if (x != frm_age[i])
+            klog(KL_DEBUG, "Updated age of frame %d from %d to %d %s\n",
+                    i, x, frm_age[i],
+                    (frm_age[i] > x) ? "(accessed)" : "");
 #endif
-
-        // Go to next frame in list
-        curr = curr->fifo_next;
     }
 
     return OK;
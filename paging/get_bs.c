@@ -48,7 +48,7 @@ int get_bs(bsd_t bsid, unsigned int npages) {
         return bsptr->npages;
 
     // backing store does not exist.. create it.
-    disable(ps);
+    lkdisable(ps, LK_BS|LK_FRM);
     if (bsptr->status == BS_FREE) {
         bs_alloc(bsid, npages); // Not checking ret code
         restore(ps);
@@ -5,6 +5,7 @@
 #include <proc.h>
 #include <paging.h>
 #include <frame.h>
+#include <control_reg.h>
 
 
 // The first four page tables represent pages of physical memory. This
@@ -12,6 +13,16 @@
 // process. 
 pt_t * gpt[4] = { 0, 0, 0, 0 };
 
+// Page directory of the null process. It maps nothing but the global
+// page tables, and every process shares it until it gets a mapping of
+// its own (see pd_private()). Switching between two processes that
+// both use it needs no CR3 reload.
+pd_t * kernpd = NULL;
+
+// Page table for the APICs (SMP, see init_apic_pt()), or NULL
+pt_t * apicpt = NULL;
+int apicpde = -1;
+
 
 // At system startup we will create 4 page tables that index
 // the first 4096 pages of memory (physical memory). 
@@ -66,6 +77,38 @@ int init_page_tables() {
 }
 
 
+/*
+ * init_apic_pt - Create the global page table that maps the 4MB of
+ *                physical address space holding addr (the local
+ *                APIC), one to one and uncached. The I/O APIC is in
+ *                the same 4MB on a PC. Call it before the first
+ *                pd_alloc() so every directory gets the mapping.
+ */
+int init_apic_pt(unsigned long addr) {
+    int j;
+    pt_t * pt;
+
+    if (addr < 4096 * NBPG)
+        return SYSERR;          /* inside the global page tables */
+
+    pt = pt_alloc();
+    if (pt == NULL)
+        return SYSERR;
+
+    apicpde = addr / (NENTRIES * NBPG);
+    for (j=0; j<NENTRIES; j++) {
+        pt[j].p_pres  = 1;
+        pt[j].p_write = 1;
+        pt[j].p_pwt   = 1;
+        pt[j].p_pcd   = 1;      /* device registers, never cache */
+        pt[j].p_base  = apicpde * NENTRIES + j;
+    }
+    apicpt = pt;
+
+    return OK;
+}
+
+
 /* 
  * pd_alloc - Create a new page table directory
  *
@@ -85,8 +128,8 @@ pd_t * pd_alloc() {
       return NULL;
     }
 
-    // fill out rest of frm_tab entry here
-    frame->type = FRM_PD;
+    // fill out rest of frame table entry here
+    frm_type[frame->frmid] = FRM_PD;
 
 
     // Get the address to the base of the physical memory frame that 
@@ -130,19 +173,67 @@ pd_t * pd_alloc() {
 
     }
 
+    // The APIC page table is global too; pt_avail marks an entry that
+    // is shared and must never be freed or searched
+    if (apicpt != NULL) {
+        pd[apicpde].pt_pres  = 1;
+        pd[apicpde].pt_write = 1;
+        pd[apicpde].pt_pcd   = 1;
+        pd[apicpde].pt_avail = 1;
+        pd[apicpde].pt_base  = VA2VPNO(apicpt);
+    }
+
     return pd;
 }
 
 /* 
- * pd_free - Free a page table directory
+ * pd_free - Free a page table directory and the page tables still
+ *           in it. The global page tables (first four entries, and
+ *           the APIC's with SMP) are shared and stay, and with VSTACK the stack page table is
+ *           left to vstk_free(). The process's mappings must already
+ *           be gone (bs_cleanproc()), so nothing else can refer to
+ *           these frames and there is no need for frm_free() to go
+ *           looking for them in other processes' page tables.
  */
 int pd_free(pd_t * pd) {
     int i;
 
-    for (i=0; i < NENTRIES; i++)
-        pt_free((pt_t *)&pd[i]);
+    for (i=4; i < NENTRIES; i++) {
+#ifdef VSTACK
+        if (i == VSTK_PDE)
+            continue;
+#endif
+        if (pd[i].pt_pres && !pd[i].pt_avail)
+            frm_release(PA2FP(VPNO2VA(pd[i].pt_base)));
+    }
+
+    frm_release(PA2FP(pd));
+
+    // Take the released frames out of the fifo
+    _frm_cleanlists(NULL);
+
+    return OK;
+}
+
 
-    frm_free(PA2FP(pd));
+/*
+ * pd_private - Give process pid a page directory of its own if it is
+ *              still using kernpd. Called before the first mapping
+ *              for pid is added.
+ */
+int pd_private(int pid) {
+    pd_t * pd;
+
+    if (proctab[pid].pd != kernpd)
+        return OK;
+
+    pd = pd_alloc();
+    if (pd == NULL)
+        return SYSERR;
+
+    proctab[pid].pd = pd;
+    if (pid == currpid)
+        set_PDBR(VA2VPNO(pd));
 
     return OK;
 }
@@ -164,8 +255,8 @@ pt_t * pt_alloc() {
     if (frame == NULL)
         return NULL;
 
-    // fill out rest of frm_tab entry here
-    frame->type = FRM_PT;
+    // fill out rest of frame table entry here
+    frm_type[frame->frmid] = FRM_PT;
 
 
     // Get the address to the base of the physical memory frame that 
@@ -236,6 +327,7 @@ int p_invalidate(int addr) {
     frame_t * frame;
     frame_t * ptframe;
     int dirty = 0; // Keeps up with whether the page is dirty
+    int cleared;   // Entries removed from this process's tables
 
     page = VA2VPNO(addr);
 
@@ -253,10 +345,11 @@ int p_invalidate(int addr) {
         // want to invalidate entries from first 4 
         // page tables.
         pd = pptr->pd; 
+        cleared = 0;
         for (i=4; i<NENTRIES; i++) {
 
-            // Is this page table present?
-            if (pd[i].pt_pres) {
+            // Is this page table present? (and not the APIC's)
+            if (pd[i].pt_pres && !pd[i].pt_avail) {
                 pt = VPNO2VA(pd[i].pt_base);
 
                 // Iterate over page table entries
@@ -274,6 +367,7 @@ int p_invalidate(int addr) {
                                 PA2FID(addr), dirty, proc, i, j);
 #endif
                         p_free(&pt[j]);
+                        cleared++;
 
                         // Since we are removing a page from the page 
                         // table we need to decrease the refcnt of the
@@ -283,7 +377,7 @@ int p_invalidate(int addr) {
 
                         // If the frame is now free then lets make the
                         // entry in the page directory as not present
-                        if (ptframe->status == FRM_FREE) {
+                        if (frm_status[ptframe->frmid] == FRM_FREE) {
 #if DUSTYDEBUG
                             kprintf("PT has been freed.. Invalidating entry in PD\n"); 
 #endif
@@ -299,7 +393,247 @@ int p_invalidate(int addr) {
 
         }
 
+#ifdef SMP
+        // Another processor may be running this process and still
+        // hold the entries in its TLB
+        if (cleared)
+            smpflush(pd);
+#endif
+
     }
 
     return dirty;
 }
+
+
+/*
+ * p_load - Make virtual page vpno of process pid present. vpno lies
+ *          in mapping bsmptr; if no frame holds that page of the
+ *          backing store yet it is read in. A speculative load (spec
+ *          set, used for read-ahead and prefaulting) only takes a
+ *          frame that is already free rather than evict one.
+ *
+ * Note: The caller is responsible for flushing the TLB if pid is
+ *       the current process.
+ */
+int p_load(int pid, bs_map_t * bsmptr, int vpno, int spec) {
+    pd_t * pd;
+    pt_t * pt;
+    int pd_offset;
+    int pt_offset;
+    int bsoffset;
+    bs_t * bsptr;
+    frame_t * frame;
+
+    pd = proctab[pid].pd;
+
+    // Page offset from the beginning of the bs 
+    bsoffset = vpno - bsmptr->vpno;
+    bsptr = &bs_tab[bsmptr->bsid];
+
+    pd_offset = vpno / NENTRIES;
+    pt_offset = vpno & (NENTRIES - 1);
+
+
+    // If the Page Table does not exist create it.
+    if (pd[pd_offset].pt_pres != 1) {
+
+        // Create a new page table and fill in its properties in
+        // the corresponding page directory entry
+        pt = pt_alloc();
+        if (pt == NULL) {
+            kprintf("Could not create page table!\n");
+            return SYSERR;
+        }
+
+        pd[pd_offset].pt_pres  = 1;   /* page table present?      */
+        pd[pd_offset].pt_write = 1;   /* page is writable?        */
+        pd[pd_offset].pt_user  = 0;   /* is user level protection? */
+        pd[pd_offset].pt_pwt   = 0;   /* write through caching for pt?*/
+        pd[pd_offset].pt_pcd   = 0;   /* cache disable for this pt?   */
+        pd[pd_offset].pt_acc   = 0;   /* page table was accessed? */
+        pd[pd_offset].pt_mbz   = 0;   /* must be zero         */
+        pd[pd_offset].pt_fmb   = 0;   /* four MB pages?       */
+        pd[pd_offset].pt_global= 0;   /* global (ignored)     */
+        pd[pd_offset].pt_avail = 0;   /* for programmer's use     */
+        pd[pd_offset].pt_base  = VA2VPNO(pt);  /* Page # where pt is located */
+
+    }
+
+    // Get the address of the page table
+    pt = VPNO2VA(pd[pd_offset].pt_base);
+
+    // Nothing to do if the page is already there
+    if (pt[pt_offset].p_pres)
+        return OK;
+
+    // Check to see if the page from the backing store is already in 
+    // physical memory (a frame). If not we will have to allocate a 
+    // new frame and bring the data in from disk (backing store).
+    frame = frm_find_bspage(bsptr->bsid, bsoffset);
+    if (frame == NULL) {
+
+        // Get a free frame
+        frame = spec ? frm_getfree() : frm_alloc();
+        if (frame == NULL) {
+            if (!spec)
+                kprintf("p_load(): could not get free frame!\n");
+            return SYSERR;
+        }
+
+        // Populate a little more information in the frame
+        frm_type[frame->frmid]   = FRM_BS;
+        frm_refcnt[frame->frmid] = 1;
+        frame->bsid   = bsptr->bsid;
+        frame->bspage = bsoffset;
+
+        // Add the frame to head of the frame list within the bs_t struct
+        frame->bs_next = bsptr->frames;
+        bsptr->frames = frame->frmid;
+
+        // Copy the page from the backing store into the frame
+        read_bs((void *)FID2PA(frame->frmid), bsmptr->bsid, bsoffset);
+
+    } else {
+        frm_refcnt[frame->frmid]++;
+    }
+
+    // Update the page table
+    pt[pt_offset].p_pres  = 1;
+    pt[pt_offset].p_write = 1;
+    pt[pt_offset].p_base  = FID2VPNO(frame->frmid);
+
+    // Increase the refcount in the page table's frame
+    frm_refcnt[PA2FID(pt)]++;
+
+    return OK;
+}
+
+
+/*
+ * p_drop - Remove process pid's mapping of virtual page vpno, writing
+ *          the page back to its backing store first if it is dirty.
+ *          The frame itself is released once nobody maps it.
+ *          Locked pages (see xmlock()) are left alone.
+ *
+ * Note: The caller is responsible for flushing the TLB if pid is
+ *       the current process.
+ */
+int p_drop(int pid, int vpno) {
+    pd_t * pd;
+    pt_t * pt;
+    int pd_offset;
+    int pt_offset;
+    frame_t * frame;
+    frame_t * ptframe;
+
+    pd = proctab[pid].pd;
+
+    pd_offset = vpno / NENTRIES;
+    pt_offset = vpno & (NENTRIES - 1);
+
+    if (!pd[pd_offset].pt_pres)
+        return OK;
+
+    pt = VPNO2VA(pd[pd_offset].pt_base);
+    if (!pt[pt_offset].p_pres)
+        return OK;
+
+    if (pt[pt_offset].p_avail & PG_LOCKED)
+        return SYSERR;
+
+    frame = PA2FP(VPNO2VA(pt[pt_offset].p_base));
+
+    // Write back now, the dirty bit goes away with the entry
+    if (pt[pt_offset].p_dirty && frm_type[frame->frmid] == FRM_BS)
+        write_bs((char *)FID2PA(frame->frmid), frame->bsid, frame->bspage);
+
+    p_free(&pt[pt_offset]);
+
+    // One less page in the page table. If the table is now
+    // empty it is freed, so mark it not present.
+    ptframe = PA2FP(pt);
+    frm_decrefcnt(ptframe);
+    if (frm_status[ptframe->frmid] == FRM_FREE)
+        pd[pd_offset].pt_pres = 0;
+
+    frm_decrefcnt(frame);
+
+    return OK;
+}
+
+
+/*
+ * _p_lookup - Get the page table entry for virtual page vpno of
+ *             process pid, or NULL if the page isn't present.
+ */
+LOCAL pt_t * _p_lookup(int pid, int vpno) {
+    pd_t * pd;
+    pt_t * pt;
+
+    pd = proctab[pid].pd;
+    if (!pd[vpno / NENTRIES].pt_pres)
+        return NULL;
+
+    pt = VPNO2VA(pd[vpno / NENTRIES].pt_base);
+    if (!pt[vpno & (NENTRIES - 1)].p_pres)
+        return NULL;
+
+    return &pt[vpno & (NENTRIES - 1)];
+}
+
+
+/*
+ * p_locked - Is page vpno of process pid locked?
+ */
+int p_locked(int pid, int vpno) {
+    pt_t * pte;
+
+    pte = _p_lookup(pid, vpno);
+    return (pte != NULL) && (pte->p_avail & PG_LOCKED);
+}
+
+
+/*
+ * p_lock - Lock (pin) present page vpno of process pid so its
+ *          frame can't be evicted. Locking a locked page does
+ *          nothing.
+ */
+int p_lock(int pid, int vpno) {
+    pt_t * pte;
+
+    pte = _p_lookup(pid, vpno);
+    if (pte == NULL)
+        return SYSERR;
+
+    if (pte->p_avail & PG_LOCKED)
+        return OK;
+
+    pte->p_avail |= PG_LOCKED;
+    proctab[pid].pnpinned++;
+
+    if (frm_pincnt[PA2FID(VPNO2VA(pte->p_base))]++ == 0)
+        frm_npinned++;
+
+    return OK;
+}
+
+
+/*
+ * p_unlock - Undo p_lock(). Pages that aren't locked are skipped.
+ */
+int p_unlock(int pid, int vpno) {
+    pt_t * pte;
+
+    pte = _p_lookup(pid, vpno);
+    if (pte == NULL || !(pte->p_avail & PG_LOCKED))
+        return OK;
+
+    pte->p_avail &= ~PG_LOCKED;
+    proctab[pid].pnpinned--;
+
+    if (--frm_pincnt[PA2FID(VPNO2VA(pte->p_base))] == 0)
+        frm_npinned--;
+
+    return OK;
+}
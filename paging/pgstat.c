@@ -0,0 +1,63 @@
+/* pgstat.c - pgstat, pgdump */
+
+#include <conf.h>
+#include <kernel.h>
+#include <stdio.h>
+#include <proc.h>
+#include <paging.h>
+
+
+/*
+ * pgstat - Fill in st with counts of how the frames are being used.
+ */
+SYSCALL pgstat(pgstat_t * st) {
+    STATWORD ps;
+    int i;
+
+    lkdisable(ps, LK_FRM);
+
+    st->nfree = st->npd = st->npt = st->nbs = st->nstk = 0;
+    st->npinned = frm_npinned;
+
+    for (i=0; i < NFRAMES; i++) {
+        if (frm_status[i] == FRM_FREE) {
+            st->nfree++;
+            continue;
+        }
+
+        switch (frm_type[i]) {
+            case FRM_PD:  st->npd++;  break;
+            case FRM_PT:  st->npt++;  break;
+            case FRM_BS:  st->nbs++;  break;
+            case FRM_STK: st->nstk++; break;
+        }
+    }
+
+    restore(ps);
+    return OK;
+}
+
+
+/*
+ * pgdump - Print the paging statistics, along with the number of
+ *          pages each process has locked.
+ */
+void pgdump() {
+    int pid;
+    pgstat_t st;
+    struct pentry * pptr;
+
+    pgstat(&st);
+
+    kprintf("frames: %d total, %d free, %d pd, %d pt, %d bs, %d stk\n",
+            NFRAMES, st.nfree, st.npd, st.npt, st.nbs, st.nstk);
+    kprintf("pinned: %d frames (limit %d pages per process)\n",
+            st.npinned, XM_MAXLOCK);
+
+    for (pid=0; pid < NPROC; pid++) {
+        pptr = &proctab[pid];
+        if (pptr->pstate != PRFREE && pptr->pnpinned > 0)
+            kprintf("\tpid %d (%s): %d pages locked\n",
+                    pid, pptr->pname, pptr->pnpinned);
+    }
+}
@@ -5,6 +5,7 @@
 #include <bufpool.h>
 #include <proc.h>
 #include <paging.h>
+#include <trace.h>
 
 /*
  * fetch page page from map bs_id and write beginning 
@@ -24,6 +25,7 @@ SYSCALL read_bs(char *dst, bsd_t bsid, int page) {
             phy_addr, dst, 
             *(char *)phy_addr);
 #endif 
+    TRACE(TRC_BS, TE_READBS, bsid, page, 0, 0);
 
     bcopy(phy_addr, (void*)dst, NBPG);
 }
@@ -8,7 +8,7 @@
  */
 int release_bs(bsd_t bsid) {
     STATWORD ps;
-    disable(ps);
+    lkdisable(ps, LK_BS|LK_FRM);
 #if DUSTYDEBUG
     kprintf("release_bs(%d)\n", bsid);
 #endif
@@ -34,7 +34,7 @@ SYSCALL vcreate(procaddr,ssize,hsize,priority,name,nargs,args)
     struct mblock * memblock;
 
     // Disable interrupts
-    disable(ps);
+    lkdisable(ps, LK_MEM|LK_PROC|LK_BS|LK_FRM);
 
     // Perform normal process stuff! 
     pid = create(procaddr, ssize, priority, name, nargs, args);
@@ -54,7 +54,7 @@ SYSCALL vcreate(procaddr,ssize,hsize,priority,name,nargs,args)
     bsptr->isheap = 1;
     bsptr->npages = hsize;
     bsptr->maps   = NULL;
-    bsptr->frames = NULL;
+    bsptr->frames = FRM_NIL;
 
 
     // Add a mapping between this process and this backing 
@@ -35,7 +35,7 @@ SYSCALL vfreemem(struct mblock* block, unsigned int size) {
     size = (unsigned)roundmb(size);
 
     // Disable interrupts
-    disable(ps);
+    lkdisable(ps, LK_MEM);
 
     // Iterate through the list until we get to the end or 
     // the next block (p) is greater than the block we are 
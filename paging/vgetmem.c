@@ -24,7 +24,7 @@ WORD *vgetmem(unsigned int nbytes) {
         return (WORD *)SYSERR;
 
     // Disable interrupts
-    disable(ps);
+    lkdisable(ps, LK_MEM);
 
     // Get pointer to proctab entry for this proc
     pptr = &proctab[currpid];
@@ -0,0 +1,252 @@
+/* vstack.c - init_pftask, vstk_alloc, vstk_fault, vstk_free, vstk_killcurr */
+
+#include <conf.h>
+#include <i386.h>
+#include <kernel.h>
+#include <stdio.h>
+#include <proc.h>
+#include <paging.h>
+
+#ifdef VSTACK
+
+// With VSTACK defined process stacks no longer come from getstk(). Each
+// process gets its stack at the top of its own address space (the 4MB
+// region mapped by page directory entry VSTK_PDE). create() populates
+// only the topmost page; the rest of the stack is faulted in as it grows
+// and is backed by zero-filled frames of type FRM_STK instead of by a
+// backing store. Pages below plimit are never mapped, so running off
+// the end of a stack faults instead of silently corrupting memory. That
+// replaces the STKCHK test resched() would otherwise make on every
+// context switch.
+//
+// A fault on the stack can't be serviced on that same stack (the
+// processor would have nowhere to push the exception frame). So with
+// VSTACK the page fault handler runs as a separate task entered through
+// a task gate. The GDT already reserves a TSS for this: i386_tasks[1],
+// "Task for Interrupt 14" (cputss()[1], the running processor's). It has its own stack and returns to the
+// Xinu task with iret (see pftask in pfintr.S).
+
+// Stack size (in words) of the page fault task and of the stack a
+// process that faulted fatally is killed on.
+#define PFTSTKSIZE 2048
+
+// With SMP every processor has its own page fault task (see smp.c),
+// so it gets its own pair of stacks as well.
+#ifdef SMP
+#define NPFT  NCPU
+#define PFT   cpuget(c_id)
+#else
+#define NPFT  1
+#define PFT   0
+#endif
+
+LOCAL WORD pftstk[NPFT][PFTSTKSIZE];
+LOCAL WORD reapstk[NPFT][PFTSTKSIZE];
+
+extern int pftask();
+extern int set_tgate(unsigned int xnum, unsigned int tsel);
+
+
+/*
+ * _vstk_map - Map a zero-filled frame at stack page vpno in page
+ *             directory pd. The stack page table must exist.
+ */
+LOCAL frame_t * _vstk_map(pd_t * pd, int vpno) {
+    pt_t * pt;
+    frame_t * frame;
+    int pt_offset;
+
+    frame = frm_alloc();
+    if (frame == NULL)
+        return NULL;
+
+    frm_type[frame->frmid]   = FRM_STK;
+    frm_refcnt[frame->frmid] = 1;
+    bzero((void *)FID2PA(frame->frmid), NBPG);
+
+    pt = VPNO2VA(pd[VSTK_PDE].pt_base);
+    pt_offset = vpno & (NENTRIES - 1);
+    pt[pt_offset].p_pres  = 1;
+    pt[pt_offset].p_write = 1;
+    pt[pt_offset].p_base  = FID2VPNO(frame->frmid);
+
+    // One more mapping in the stack page table
+    frm_refcnt[PA2FID(pt)]++;
+
+    return frame;
+}
+
+/*
+ * _vstk_reap - Entered (instead of returning to the faulting
+ *              instruction) when a process takes a page fault
+ *              that can't be serviced. Runs on reapstk.
+ */
+LOCAL void _vstk_reap() {
+    kill(currpid);
+    panic("could not kill faulting process");
+}
+
+/*
+ * init_pftask - Set up the page fault task and route vector 14
+ *               through a task gate to it. pd is the page directory
+ *               the task runs with (any directory will do, it only
+ *               touches global memory).
+ */
+int init_pftask(pd_t * pd) {
+    struct tss * tss;
+
+    tss = &cputss()[1];
+    tss->ts_pdbr = (unsigned int) pd;
+    tss->ts_eip  = (unsigned int) pftask;
+    tss->ts_esp  = (unsigned int) &pftstk[PFT][PFTSTKSIZE - 1];
+    tss->ts_ebp  = tss->ts_esp;
+    tss->ts_efl  = 0x2;  // reserved bit only, interrupts off
+    tss->ts_es   = 0x10; // kernel data segment (string ops use it)
+#ifdef SMP
+    tss->ts_fs   = CPUSEL; // for cpu() in pfint()
+#endif
+
+    // GDT entry 6 (selector 0x30) is the page fault task
+    set_tgate(14, 0x30);
+
+    return OK;
+}
+
+/*
+ * vstk_alloc - Set up the stack region of a new process with page
+ *              directory pd. Only the top page is populated.
+ *
+ * return:
+ *          error   - SYSERR
+ *          success - address of the topmost stack word, as seen by
+ *                    the caller. *delta is what must be added to
+ *                    addresses in that page to get the address the
+ *                    new process will see.
+ */
+unsigned long * vstk_alloc(pd_t * pd, int ssize, unsigned long * delta) {
+    pt_t * pt;
+    frame_t * frame;
+    unsigned long top;
+
+    if ((ssize + NBPG - 1)/NBPG > VSTK_MAXPAGES)
+        return (unsigned long *)SYSERR;
+
+    // Page table covering the stack region
+    pt = pt_alloc();
+    if (pt == NULL)
+        return (unsigned long *)SYSERR;
+
+    pd[VSTK_PDE].pt_pres  = 1;
+    pd[VSTK_PDE].pt_write = 1;
+    pd[VSTK_PDE].pt_base  = VA2VPNO(pt);
+
+    // The topmost page is needed right away for the initial frame
+    // that create() builds.
+    frame = _vstk_map(pd, VSTK_TOPVPNO);
+    if (frame == NULL) {
+        pd[VSTK_PDE].pt_pres = 0;
+        pt_free(pt);
+        return (unsigned long *)SYSERR;
+    }
+
+    top    = FID2PA(frame->frmid) + NBPG - sizeof(WORD);
+    *delta = (VPNO2VA(VSTK_TOPVPNO) + NBPG - sizeof(WORD)) - top;
+
+    return (unsigned long *)top;
+}
+
+/*
+ * vstk_fault - Service a page fault on page vpno of the stack
+ *              region of process pid.
+ */
+int vstk_fault(int pid, int vpno) {
+    struct pentry * pptr;
+    pd_t * pd;
+    pt_t * pt;
+    int lowvpno;
+
+    pptr = &proctab[pid];
+    pd   = pptr->pd;
+
+    // The null process keeps its physical stack
+    if (!pd[VSTK_PDE].pt_pres)
+        return SYSERR;
+
+    // Below the lowest stack page is the guard
+    lowvpno = VA2VPNO(pptr->plimit);
+    if (vpno < lowvpno) {
+        kprintf("Stack overflow pid=%d (%s), lim=0x%08x, fault at 0x%08x\n",
+                pid, pptr->pname,
+                (unsigned int) pptr->plimit,
+                VPNO2VA(vpno));
+        return SYSERR;
+    }
+
+    if (_vstk_map(pd, vpno) == NULL)
+        return SYSERR;
+
+    // Keep one page mapped below the deepest page touched so far. An
+    // interrupt arriving near the bottom of a page pushes its frame on
+    // this stack, and a fault while delivering it would be fatal.
+    pt = VPNO2VA(pd[VSTK_PDE].pt_base);
+    if ((vpno - 1 >= lowvpno) && !pt[(vpno - 1) & (NENTRIES - 1)].p_pres)
+        _vstk_map(pd, vpno - 1);
+
+    return OK;
+}
+
+/*
+ * vstk_free - Release the stack frames of process pid and the page
+ *             table that maps them.
+ *
+ * Note: Stack frames are only ever mapped by their owner so there
+ *       is no need to search other processes' page tables like
+ *       frm_free() does. The page table entries themselves are left
+ *       alone because pid may be the current process, still running
+ *       on this stack until it calls resched().
+ */
+int vstk_free(int pid) {
+    pd_t * pd;
+    pt_t * pt;
+    int i;
+
+    pd = proctab[pid].pd;
+    if (!pd[VSTK_PDE].pt_pres)
+        return OK;
+
+    pt = VPNO2VA(pd[VSTK_PDE].pt_base);
+    for (i=0; i < NENTRIES; i++) {
+        if (!pt[i].p_pres)
+            continue;
+
+        frm_release(PA2FP(VPNO2VA(pt[i].p_base)));
+    }
+
+    frm_release(PA2FP(pt));
+
+    // Take the freed frames out of the fifo
+    _frm_cleanlists(NULL);
+
+    return OK;
+}
+
+/*
+ * vstk_killcurr - Called from the page fault task when the fault
+ *                 can't be serviced. Rather than returning to the
+ *                 faulting instruction the Xinu task resumes in
+ *                 _vstk_reap() on a stack of its own (the process
+ *                 stack may be the thing that overflowed).
+ */
+int vstk_killcurr() {
+    struct tss * tss;
+
+    tss = &cputss()[0];
+    tss->ts_eip = (unsigned int) _vstk_reap;
+    tss->ts_esp = (unsigned int) &reapstk[PFT][PFTSTKSIZE - 1];
+    tss->ts_ebp = tss->ts_esp;
+    tss->ts_efl &= ~0x200; // interrupts stay off until resched()
+
+    return OK;
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include <mark.h>
 #include <bufpool.h>
 #include <paging.h>
+#include <trace.h>
 
 /*
  *
@@ -24,6 +25,7 @@ SYSCALL write_bs(char *src, bsd_t bsid, int page) {
             src, bsid, page, 
             src, phy_addr, *src);
 #endif 
+    TRACE(TRC_BS, TE_WRITEBS, bsid, page, 0, 0);
     bcopy((void*)src, phy_addr, NBPG);
 
 }
@@ -1,10 +1,11 @@
-/* xm.c = xmmap xmunmap */
+/* xm.c = xmmap xmmapf xmunmap xmadvise xmlock xmunlock */
 
 #include <conf.h>
 #include <kernel.h>
 #include <stdio.h>
 #include <proc.h>
 #include <paging.h>
+#include <control_reg.h>
 
 
 /*
@@ -16,13 +17,27 @@
  * This function does nothing more than create the mapping.
  */ 
 SYSCALL xmmap(int vpno, bsd_t bsid, int npages) {
+    return xmmapf(vpno, bsid, npages, 0);
+}
+
+
+/*
+ * xmmapf:
+ * xmmap with flags. With XM_POPULATE the pages of the mapping are
+ * brought in right away in one go, rather than one fault at a time.
+ * Populating only uses free frames, whatever doesn't fit is faulted
+ * in later as usual.
+ */ 
+SYSCALL xmmapf(int vpno, bsd_t bsid, int npages, int flags) {
     int rc;
+    int i;
     bs_t * bsptr;
+    bs_map_t * bsmptr;
     STATWORD ps;
 
 
 #if DUSTYDEBUG
-    kprintf("xmmap(%d, %d, %d) for proc %d\n", vpno, bsid, npages, currpid);
+    kprintf("xmmapf(%d, %d, %d, 0x%x) for proc %d\n", vpno, bsid, npages, flags, currpid);
 #endif
 
     /* sanity check ! */
@@ -35,9 +50,24 @@ SYSCALL xmmap(int vpno, bsd_t bsid, int npages) {
         return SYSERR;
     }
 
+#ifdef VSTACK
+    // The top of the address space is reserved for the stack
+    if (vpno + npages > VSTK_MINVPNO) {
+        kprintf("xmmap call error: overlaps stack region! \n");
+        return SYSERR;
+    }
+#endif
+
+    // With SMP the APICs are mapped in every address space
+    if (apicpt != NULL && vpno < (apicpde + 1) * NENTRIES &&
+        vpno + npages > apicpde * NENTRIES) {
+        kprintf("xmmap call error: overlaps APIC region! \n");
+        return SYSERR;
+    }
+
 
     // Disable interrupts
-    disable(ps);
+    lkdisable(ps, LK_MEM|LK_BS|LK_FRM);
 
     // Make sure the bs has been allocated
     bsptr = &bs_tab[bsid];
@@ -64,6 +94,15 @@ SYSCALL xmmap(int vpno, bsd_t bsid, int npages) {
         return SYSERR;
     }
 
+    // Prefault the whole mapping. Adding entries for pages that were
+    // not present needs no TLB flush, so no set_PDBR() here.
+    if (flags & XM_POPULATE) {
+        bsmptr = bsptr->maps; // bs_add_mapping() puts it at the head
+        for (i=0; i < npages; i++)
+            if (p_load(currpid, bsmptr, vpno + i, 1) == SYSERR)
+                break;
+    }
+
     restore(ps);
     return OK;
 }
@@ -90,7 +129,7 @@ SYSCALL xmunmap(int vpno) {
     }
 
     // Disable interrupts
-    disable(ps);
+    lkdisable(ps, LK_MEM|LK_BS|LK_FRM);
 
     // Get a pointer to the PCB for current proc
     pptr = &proctab[currpid];
@@ -125,3 +164,217 @@ SYSCALL xmunmap(int vpno) {
     return OK;
 }
 
+
+
+/*
+ * _xm_prefault:
+ * Process started by xmadvise(XM_WILLNEED) that brings in pages
+ * [vpno, vpno+npages) of process pid while pid gets on with its
+ * work. One page at a time with interrupts disabled, so a mapping
+ * that goes away in between is noticed. gen is pid's pgen when the
+ * advice was given: if pid exits and its slot is handed to a new
+ * process, the pages must not go into that one's address space.
+ */
+LOCAL void _xm_prefault(int pid, unsigned gen, int vpno, int npages) {
+    int i;
+    bs_map_t * bsmptr;
+    STATWORD ps;
+
+    for (i=0; i < npages; i++) {
+        lkdisable(ps, LK_BS|LK_FRM);
+
+        if (proctab[pid].pstate == PRFREE || proctab[pid].pgen != gen) {
+            restore(ps);
+            return;
+        }
+
+        bsmptr = bs_lookup_mapping(pid, vpno + i);
+        if ((bsmptr == NULL) ||
+            (p_load(pid, bsmptr, vpno + i, 1) == SYSERR)
+        ) {
+            restore(ps);
+            return;
+        }
+
+        restore(ps);
+    }
+}
+
+
+/*
+ * xmadvise:
+ * Tell the pager how pages [vpno, vpno+npages) will be used. The
+ * range must start inside a mapping created by xmmap() and is cut
+ * off at the end of that mapping.
+ *
+ *   XM_NORMAL, XM_SEQUENTIAL, XM_RANDOM - set the access pattern
+ *        for the whole mapping (see pfint()).
+ *   XM_WILLNEED - prefault the range in the background.
+ *   XM_DONTNEED - write back and release the range now. The pages
+ *        are faulted in again from the backing store if touched.
+ */
+SYSCALL xmadvise(int vpno, int npages, int hint) {
+    int i;
+    int pid;
+    struct pentry * pptr;
+    bs_map_t * bsmptr;
+    STATWORD ps;
+
+#if DUSTYDEBUG
+    kprintf("xmadvise(%d, %d, %d) for proc %d\n", vpno, npages, hint, currpid);
+#endif
+
+    if ((vpno < 4096)           ||
+        (npages < 1)            ||
+        (hint < XM_NORMAL)      ||
+        (hint > XM_DONTNEED)
+    ) {
+        kprintf("xmadvise call error: parameter error! \n");
+        return SYSERR;
+    }
+
+    // Disable interrupts
+    lkdisable(ps, LK_MEM|LK_PROC|LK_BS|LK_FRM);
+
+    pptr = &proctab[currpid];
+
+    bsmptr = bs_lookup_mapping(currpid, vpno);
+    if (bsmptr == NULL) {
+        kprintf("xmadvise(): could not find mapping!\n");
+        restore(ps);
+        return SYSERR;
+    }
+
+    if (vpno + npages > bsmptr->vpno + bsmptr->npages)
+        npages = bsmptr->vpno + bsmptr->npages - vpno;
+
+    switch (hint) {
+
+        case XM_NORMAL:
+        case XM_SEQUENTIAL:
+        case XM_RANDOM:
+            bsmptr->advice = hint;
+            break;
+
+        case XM_WILLNEED:
+            pid = create(_xm_prefault, 1024, pptr->pprio, "xmprefault", 
+                         4, currpid, pptr->pgen, vpno, npages);
+            if (pid == SYSERR) {
+                restore(ps);
+                return SYSERR;
+            }
+            resume(pid);
+            break;
+
+        case XM_DONTNEED:
+            for (i=0; i < npages; i++)
+                p_drop(currpid, vpno + i);
+
+            // Entries were removed, flush the TLB
+            set_PDBR(VA2VPNO(pptr->pd));
+            break;
+    }
+
+    restore(ps);
+    return OK;
+}
+
+
+
+/*
+ * xmlock:
+ * Lock pages [vpno, vpno+npages) of a mapping into memory. They are
+ * faulted in now and never picked for eviction until xmunlock() or
+ * until the mapping goes away. A process may have at most XM_MAXLOCK
+ * pages locked. If we run out of frames part way through, the pages
+ * locked so far stay locked.
+ */
+SYSCALL xmlock(int vpno, int npages) {
+    int i;
+    int nnew;
+    struct pentry * pptr;
+    bs_map_t * bsmptr;
+    STATWORD ps;
+
+#if DUSTYDEBUG
+    kprintf("xmlock(%d, %d) for proc %d\n", vpno, npages, currpid);
+#endif
+
+    if ((vpno < 4096) || (npages < 1)) {
+        kprintf("xmlock call error: parameter error! \n");
+        return SYSERR;
+    }
+
+    // Disable interrupts
+    lkdisable(ps, LK_BS|LK_FRM);
+
+    pptr = &proctab[currpid];
+
+    // The whole range has to be in one mapping
+    bsmptr = bs_lookup_mapping(currpid, vpno);
+    if ((bsmptr == NULL) ||
+        (vpno + npages > bsmptr->vpno + bsmptr->npages)
+    ) {
+        kprintf("xmlock(): range is not mapped!\n");
+        restore(ps);
+        return SYSERR;
+    }
+
+    // Pages already locked don't count against the limit again
+    nnew = npages;
+    for (i=0; i < npages; i++)
+        if (p_locked(currpid, vpno + i))
+            nnew--;
+
+    if (pptr->pnpinned + nnew > XM_MAXLOCK) {
+        kprintf("xmlock(): would exceed %d locked pages!\n", XM_MAXLOCK);
+        restore(ps);
+        return SYSERR;
+    }
+
+    for (i=0; i < npages; i++) {
+        if ((p_load(currpid, bsmptr, vpno + i, 0) == SYSERR) ||
+            (p_lock(currpid, vpno + i) == SYSERR)
+        ) {
+            kprintf("xmlock(): could not lock page %d!\n", vpno + i);
+            set_PDBR(VA2VPNO(pptr->pd));
+            restore(ps);
+            return SYSERR;
+        }
+    }
+
+    // Bringing the pages in may have evicted others of ours
+    set_PDBR(VA2VPNO(pptr->pd));
+
+    restore(ps);
+    return OK;
+}
+
+
+/*
+ * xmunlock:
+ * Unlock pages [vpno, vpno+npages) locked with xmlock(). Pages in
+ * the range that aren't locked are skipped.
+ */
+SYSCALL xmunlock(int vpno, int npages) {
+    int i;
+    STATWORD ps;
+
+#if DUSTYDEBUG
+    kprintf("xmunlock(%d, %d) for proc %d\n", vpno, npages, currpid);
+#endif
+
+    if ((vpno < 4096) || (npages < 1)) {
+        kprintf("xmunlock call error: parameter error! \n");
+        return SYSERR;
+    }
+
+    // Disable interrupts
+    lkdisable(ps, LK_BS|LK_FRM);
+
+    for (i=0; i < npages; i++)
+        p_unlock(currpid, vpno + i);
+
+    restore(ps);
+    return OK;
+}
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <proc.h>
 #include <q.h>
+#include <sem.h>
 
 /*------------------------------------------------------------------------
  * chprio  --  change the scheduling priority of a process
@@ -12,23 +13,23 @@
  */
 SYSCALL chprio(pid,newprio)
 	int	pid;
-	int	newprio;		/* newprio > 0			*/
+	int	newprio;		/* 0 < newprio < NPRIO		*/
 {
 	STATWORD ps;    
 	int	oldprio;
 	struct	pentry	*pptr;
 
-	disable(ps);
-	if (isbadpid(pid) || newprio<=0 ||
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (isbadpid(pid) || newprio<=0 || newprio>=NPRIO ||
 	    (pptr = &proctab[pid])->pstate == PRFREE) {
 		restore(ps);
 		return(SYSERR);
 	}
-	oldprio = pptr->pprio;
-	pptr->pprio = newprio;
+	oldprio = pptr->pbprio;
+	pptr->pbprio = newprio;
+	mprio(pid);			/* it may be inheriting more	*/
 	switch (pptr->pstate) {
 	case PRREADY:
-		insert( dequeue(pid), rdyhead, newprio);
 	case PRCURR:
 		resched();
 	default:
@@ -1,4 +1,4 @@
-/* clkinit.c - clkinit, updateleds, dog_timeout */
+/* clkinit.c - clkinit, clkperiodic, clkspin, clktsc, clkupdate, clknow, clkarm, clkquantum, clkevent, dog_timeout */
 
 #include <conf.h>
 #include <kernel.h>
@@ -6,12 +6,24 @@
 #include <i386.h>
 #include <stdio.h>
 #include <q.h>
+#include <timer.h>
+#include <proc.h>
+
+extern	void	(*smptick)();		/* set once APIC timers preempt	*/
 
 /* Intel 8254-2 clock chip constants */
 
 #define	CLOCKBASE	0x40		/* I/O base port of clock chip	*/
 #define	CLOCK0		CLOCKBASE
+#define	CLOCK2		(CLOCKBASE+2)
 #define	CLKCNTL		(CLOCKBASE+3)	/* chip CSW I/O port		*/
+#define	CLKGATE		0x61		/* bit 0 gates counter 2 (bit 1	*/
+					/*   would drive the speaker)	*/
+#define	CLKFREQ		1193182		/* counter input clock, Hz	*/
+#define	CLKMAXUS	50000		/* longest one-shot; counter 2	*/
+					/*   wraps every 54.9ms		*/
+#define	CLKINTV		1190		/* counts between interrupts	*/
+					/*   without TICKLESS		*/
     
 /* real-time clock variables and sleeping process queue pointers	*/
     
@@ -23,10 +35,7 @@ unsigned long clktime = 0;	/* current time in seconds since 1/1/70	*/
 int	clmutex;		/* mutual exclusion for time-of-day	*/
 int     defclk;			/* non-zero, then deferring clock count */
 int     clkdiff;		/* deferred clock ticks			*/
-int     slnempty;		/* FALSE if the sleep queue is empty	*/
-int     *sltop;			/* address of key part of top entry in	*/
-				/* the sleep queue if slnonempty==TRUE	*/
-int     clockq;			/* head of queue of sleeping processes  */
+int     slnempty;		/* number of armed timers, 0 if none	*/
 int	preempt;		/* preemption counter.	Current process */
 				/* is preempted when it reaches zero;	*/
 #ifdef	RTCLOCK
@@ -35,38 +44,284 @@ int	clkruns;		/* set TRUE iff clock exists by setclkr	*/
 #else
 int	clkruns = FALSE;	/* no clock configured; be sure sleep	*/
 #endif				/*   doesn't wait forever		*/
+void	(*clkoneshot)();	/* clkevent if TICKLESS, else NULL	*/
+#ifdef	TICKLESS
+unsigned long	ctrusec;	/* counts in microseconds 0-INF		*/
+unsigned long	clkevents;	/* one-shots that have fired		*/
+LOCAL	unsigned short	clklast;	/* counter 2 at the last update	*/
+LOCAL	unsigned long	clksub;		/* counter 2 counts into second	*/
+LOCAL	unsigned long	clkusbase;	/* ctrusec at start of second	*/
+LOCAL	unsigned long	clkmsbase;	/* ctr1000 at start of second	*/
+LOCAL	int		clkpending;	/* one-shot armed, not fired	*/
+LOCAL	unsigned long	clkdue;		/* ctrusec it fires at		*/
+LOCAL	unsigned long	preemptdue;	/* ctrusec current process is	*/
+					/*   preempted at		*/
+#endif
 
+#ifdef	TICKLESS
 /*
+ * With TICKLESS the clock doesn't interrupt every millisecond. Counter
+ * 0 is used in one-shot mode (mode 0, interrupt on terminal count) and
+ * programmed for the next thing that has to happen: the next timer on
+ * the wheel or the end of the current process's quantum, whichever
+ * comes first. The null process gets no quantum, so an idle system is
+ * only interrupted every CLKMAXUS to keep the time base.
+ *
+ * Time itself is kept by counter 2, which counts down freely at
+ * CLKFREQ. clkupdate() adds the counts since it last ran to ctrusec,
+ * ctr1000 and clktime, so they don't drift however often counter 0 is
+ * reprogrammed. It runs on every one-shot and on every call to
+ * resched(), so the three are current whenever a process is switched
+ * in or out, including on the way into and out of sleep. Code that
+ * spins on the time without rescheduling must use clknow() instead.
+ */
+
+/*------------------------------------------------------------------------
+ * _clkread2 -- latch and read counter 2
  *------------------------------------------------------------------------
- * clkinit - initialize the clock and sleep queue (called at startup)
+ */
+LOCAL unsigned short _clkread2()
+{
+	int	lo, hi;
+
+	outb(CLKCNTL, 0x80);		/* counter latch, counter 2	*/
+	lo = inb(CLOCK2) & 0xff;
+	hi = inb(CLOCK2) & 0xff;
+	return((hi << 8) | lo);
+}
+
+/*------------------------------------------------------------------------
+ * _muldiv -- a*b/c with a 64-bit intermediate; the result must fit
+ *------------------------------------------------------------------------
+ */
+LOCAL unsigned long _muldiv(unsigned long a, unsigned long b, unsigned long c)
+{
+	unsigned long	q, r;
+
+	asm("mull %3\n\tdivl %4"
+	    : "=a" (q), "=&d" (r) : "0" (a), "rm" (b), "rm" (c) : "cc");
+	return(q);
+}
+
+/*------------------------------------------------------------------------
+ * clkupdate -- fold the counts since the last update into the clock.
+ *		Interrupts off.
+ *------------------------------------------------------------------------
+ */
+void clkupdate()
+{
+	unsigned short	now;
+	unsigned long	us;
+
+	now = _clkread2();
+	clksub += (unsigned short)(clklast - now);
+	clklast = now;
+	while (clksub >= CLKFREQ) {
+		clksub -= CLKFREQ;
+		clkusbase += 1000000;
+		clkmsbase += 1000;
+		clktime++;
+	}
+	us = _muldiv(clksub, 1000000, CLKFREQ);
+	ctrusec = clkusbase + us;
+	ctr1000 = clkmsbase + us / 1000;
+}
+
+/*------------------------------------------------------------------------
+ * clknow -- current time in microseconds, without waiting for the
+ *	     next clock interrupt to bring ctrusec up to date
+ *------------------------------------------------------------------------
+ */
+unsigned long clknow()
+{
+	unsigned short	d;
+
+	d = clklast - _clkread2();
+	return(clkusbase + _muldiv(clksub + d, 1000000, CLKFREQ));
+}
+
+/*------------------------------------------------------------------------
+ * clkarm -- program counter 0 for the next deadline, unless the
+ *	     interrupt already pending comes no later. Interrupts off.
+ *------------------------------------------------------------------------
+ */
+void clkarm()
+{
+	unsigned long	now, due, t, count;
+
+	now = clknow();
+	due = now + CLKMAXUS;
+	if (currpid != NULLPROC && smptick == NULL &&
+	    (long)(preemptdue - due) < 0)
+		due = preemptdue;
+	if (slnempty && (long)((t = tmnext()) - due) < 0)
+		due = t;
+	if (clkpending && (long)(clkdue - due) <= 0)
+		return;
+
+	count = ((long)(due - now) > 0) ? _muldiv(due - now, CLKFREQ, 1000000) : 0;
+	if (count == 0)
+		count = 1;		/* 0 would mean 65536		*/
+	outb(CLKCNTL, 0x30);		/* counter 0, mode 0, binary	*/
+	outb(CLOCK0, count & 0xff);
+	outb(CLOCK0, count >> 8);
+	clkdue = due;
+	clkpending = TRUE;
+}
+
+/*------------------------------------------------------------------------
+ * clkquantum -- start a new quantum for the current process (resched)
+ *------------------------------------------------------------------------
+ */
+void clkquantum()
+{
+	preemptdue = clknow() + QUANTUM * 1000;
+	clkarm();
+}
+
+/*------------------------------------------------------------------------
+ * clkevent -- the one-shot fired: update the time, run the timers that
+ *	       are due and preempt the current process if its quantum is
+ *	       up (unless the APIC timers preempt, see smp.c). Called
+ *	       from clkint with interrupts disabled.
+ *------------------------------------------------------------------------
+ */
+void clkevent()
+{
+	STATWORD ps;
+	int	fired;
+
+	lklock(ps, LK_SEM|LK_PROC);
+	clkpending = FALSE;
+	clkevents++;
+	clkupdate();
+	fired = slnempty ? tmadvance() : 0;
+	if (smptick != NULL) {
+		if (fired > 0)
+			resched();
+	} else if (fired > 0 || (long)(ctrusec - preemptdue) >= 0) {
+		resched();
+		/* still running and nobody to switch to: new quantum	*/
+		if ((long)(ctrusec - preemptdue) >= 0)
+			preemptdue = ctrusec + QUANTUM * 1000;
+	}
+	clkarm();
+	lkrestore(ps);
+}
+#endif
+
+/*
+ *------------------------------------------------------------------------
+ * clkinit - initialize the clock and timing wheel (called at startup)
  *------------------------------------------------------------------------
  */
 void clkinit()
 {
-	unsigned short	intv;
 	int clkint();
 
 	set_evec(IRQBASE, (u_long)clkint);
 
-	/* clock rate is 1.190 Mhz; this is 10ms interrupt rate */
-	intv = 1190;
-
 	clkruns = 1;
-	clockq = newqueue();
+	tminit();			/* empty timing wheel		*/
 	preempt = QUANTUM;		/* initial time quantum		*/
 	clmutex = screate(1);
 
+#ifdef	TICKLESS
+	/* counter 2 runs free as the time base: rate generator mode,	*/
+	/* count 0 (65536), gated on with the speaker left off		*/
+	outb(CLKGATE, (inb(CLKGATE) & ~0x02) | 0x01);
+	outb(CLKCNTL, 0xb4);
+	outb(CLOCK2, 0);
+	outb(CLOCK2, 0);
+	clklast = _clkread2();
+	clksub = clkusbase = clkmsbase = 0;
+	ctrusec = ctr1000 = 0;
+	clkpending = FALSE;
+	clkoneshot = clkevent;
+	preemptdue = QUANTUM * 1000;
+	clkarm();			/* counter 0: one-shot		*/
+#else
+	clkperiodic();
+#endif
+}
+
+/*------------------------------------------------------------------------
+ * clkperiodic - put counter 0 in rate generator mode, interrupting
+ *		 every CLKINTV counts. The monitor calls it before it
+ *		 takes the clock, as TICKLESS leaves the counter in
+ *		 one-shot mode; if the monitor gives the clock back, the
+ *		 first clkevent() goes back to one-shots.
+ *------------------------------------------------------------------------
+ */
+void clkperiodic()
+{
 	/*  set to: timer 0, 16-bit counter, rate generator mode,
 		counter is binary */
 	outb(CLKCNTL, 0x34);
 	/* must write LSB first, then MSB */
-	outb(CLOCK0, (char)intv);
-	outb(CLOCK0, intv>>8);
-	outb(CLOCK0, intv>>8);
+	outb(CLOCK0, CLKINTV & 0xff);
+	outb(CLOCK0, CLKINTV >> 8);
+}
+
+/*------------------------------------------------------------------------
+ * clkspin - busy-wait ms milliseconds (at most 50) on counter 2,
+ *	     which doesn't interrupt, so this works with interrupts
+ *	     off. With TICKLESS it is the time base and is only read;
+ *	     otherwise it is free and is run once in mode 0 (interrupt
+ *	     on terminal count), its output showing in CLKGATE bit 5.
+ *------------------------------------------------------------------------
+ */
+void clkspin(int ms)
+{
+	STATWORD ps;
+#ifdef	TICKLESS
+	unsigned long	us;
+
+	lkdisable(ps, LK_PROC);
+	clkupdate();			/* so counter 2 can't wrap	*/
+	us = clknow();
+	while (clknow() - us < ms * 1000)
+		;
+	restore(ps);
+#else
+	unsigned long	count;
+	int	gate;
+
+	lkdisable(ps, LK_PROC);
+	count = CLKFREQ / 1000 * ms;
+	gate = inb(CLKGATE);
+	outb(CLKGATE, (gate & ~0x02) | 0x01);	/* gate on, speaker off	*/
+	outb(CLKCNTL, 0xb0);		/* counter 2, mode 0, binary	*/
+	outb(CLOCK2, count & 0xff);
+	outb(CLOCK2, count >> 8);
+	while ((inb(CLKGATE) & 0x20) == 0)
+		;
+	outb(CLKGATE, gate);
+	restore(ps);
+#endif
+}
+
+/*------------------------------------------------------------------------
+ * clktsc - count TSC ticks over a millisecond of clkspin()
+ *------------------------------------------------------------------------
+ */
+unsigned long clktsc()
+{
+	STATWORD ps;
+	unsigned long	lo, hi, t0;
+
+	lkdisable(ps, LK_PROC);
+	asm volatile ("rdtsc" : "=a" (t0), "=d" (hi));
+	clkspin(1);
+	asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+	restore(ps);
+	return(lo - t0);
 }
 #endif
 
 
+
+
 #ifdef notyet
 /*
  * dog_timeout -- called when the watchdog timer determines that
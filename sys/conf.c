@@ -67,5 +67,41 @@ ttyinit, ttyopen, ionull,
 ttyread, ttywrite, ioerr,
 ttygetc, ttyputc, ttycntl,
 0000000, 0000, 0000,
-ttyiin, ttyoin, NULLPTR, 3 }
+ttyiin, ttyoin, NULLPTR, 3 },
+
+/*  UDP0  is udp  */
+
+{ 6, "UDP0",
+udpinit, udpopen, udpclose,
+udpread, udpwrite, ioerr,
+ioerr, ioerr, udpcntl,
+0000000, 0000, 0000,
+ioerr, ioerr, NULLPTR, 0 },
+
+/*  UDP1  is udp  */
+
+{ 7, "UDP1",
+udpinit, udpopen, udpclose,
+udpread, udpwrite, ioerr,
+ioerr, ioerr, udpcntl,
+0000000, 0000, 0000,
+ioerr, ioerr, NULLPTR, 1 },
+
+/*  UDP2  is udp  */
+
+{ 8, "UDP2",
+udpinit, udpopen, udpclose,
+udpread, udpwrite, ioerr,
+ioerr, ioerr, udpcntl,
+0000000, 0000, 0000,
+ioerr, ioerr, NULLPTR, 2 },
+
+/*  UDP3  is udp  */
+
+{ 9, "UDP3",
+udpinit, udpopen, udpclose,
+udpread, udpwrite, ioerr,
+ioerr, ioerr, udpcntl,
+0000000, 0000, 0000,
+ioerr, ioerr, NULLPTR, 3 }
 	};
@@ -19,7 +19,7 @@ LOCAL int newpid();
 SYSCALL create(procaddr,ssize,priority,name,nargs,args)
     int *procaddr;      /* procedure address        */
     int ssize;          /* stack size in words      */
-    int priority;       /* process priority > 0     */
+    int priority;       /* 0 < priority < NPRIO     */
     char    *name;      /* name (for debugging)     */
     int nargs;          /* number of args that follow   */
     long    args;       /* arguments (treated like an   */
@@ -32,21 +32,49 @@ SYSCALL create(procaddr,ssize,priority,name,nargs,args)
     int     i;
     unsigned long   *a;       /* points to list of args   */
     unsigned long   *saddr;   /* stack address        */
+    unsigned long   stkdelta; /* saddr + stkdelta is where the */
+                              /*  new process sees saddr      */
     int     INITRET();
 
-    disable(ps);
+    lkdisable(ps, LK_MEM|LK_PROC|LK_BS|LK_FRM);
     if (ssize < MINSTK)
         ssize = MINSTK;
     ssize = (int) roundew(ssize);
-    if (((saddr = (unsigned long *)getstk(ssize)) ==
-        (unsigned long *)SYSERR ) ||
-        (pid=newpid()) == SYSERR || priority < 1 ) {
+    if ((pid=newpid()) == SYSERR || priority < 1 || priority >= NPRIO) {
+        restore(ps);
+        return(SYSERR);
+    }
+    pptr = &proctab[pid];
+
+#ifdef VSTACK
+    // Set up a new page directory for the process
+    pptr->pd = pd_alloc();
+    if (pptr->pd == NULL) {
+        kprintf("create(): could not create new page directory for proc\n");
+        restore(ps);
+        return SYSERR;
+    }
+
+    // The stack lives in the new process's own address space. We
+    // build the initial frame through the physical address of its
+    // top page.
+    saddr = vstk_alloc(pptr->pd, ssize, &stkdelta);
+#else
+    // Until it maps something the process shares the kernel's page
+    // directory (see pd_private())
+    pptr->pd = kernpd;
+    saddr = (unsigned long *)getstk(ssize);
+    stkdelta = 0;
+#endif
+    if (saddr == (unsigned long *)SYSERR) {
+#ifdef VSTACK
+        frm_free(PA2FP(pptr->pd));
+#endif
         restore(ps);
         return(SYSERR);
     }
 
     numproc++;
-    pptr = &proctab[pid];
 
     pptr->fildes[0] = 0;    /* stdin set to console */
     pptr->fildes[1] = 0;    /* stdout set to console */
@@ -56,21 +84,39 @@ SYSCALL create(procaddr,ssize,priority,name,nargs,args)
         pptr->fildes[i] = FDFREE;
 
     pptr->pstate = PRSUSP;
+    pptr->pgen++;
     for (i=0 ; i<PNMLEN && (int)(pptr->pname[i]=name[i])!=0 ; i++)
         ;
     pptr->pprio = priority;
-    pptr->pbase = (long) saddr;
+    pptr->pbprio = priority;
+    pptr->pmutex = EMPTY;
+    pptr->prate = priority;
+    pptr->ppi = 0;
+    pptr->pxferto = BADPID;
+    pptr->pbase = (long) saddr + stkdelta;
     pptr->pstklen = ssize;
     pptr->psem = 0;
     pptr->phasmsg = FALSE;
+    pptr->pmq = NULL;
+    pptr->pmqsem = EMPTY;
+    pptr->pwn = 0;
     pptr->plimit = pptr->pbase - ssize + sizeof (long); 
     pptr->pirmask[0] = 0;
+    pptr->pirmask[1] = 0;
     pptr->pnxtkin = BADPID;
+    pptr->pnpinned = 0;
+#ifdef SMP
+    pptr->pirmask[0] = 1;   /* interrupts stay off until smpnew() */
+    pptr->pcpu = 0;
+    for (i=0 ; i<NLOCK ; i++)
+        pptr->plkdepth[i] = 0;
+    pptr->psmpreq = 0;
+#endif
     pptr->pdevs[0] = pptr->pdevs[1] = pptr->ppagedev = BADDEV;
 
         /* Bottom of stack */
     *saddr = MAGIC;
-    savsp = (unsigned long)saddr;
+    savsp = (unsigned long)saddr + stkdelta;
 
     /* push arguments */
     pptr->pargs = nargs;
@@ -80,8 +126,11 @@ SYSCALL create(procaddr,ssize,priority,name,nargs,args)
     *--saddr = (long)INITRET;   /* push on return address   */
 
     *--saddr = pptr->paddr = (long)procaddr; /* where we "ret" to   */
+#ifdef SMP
+    *--saddr = (long)smpnew;    /* which smpnew() returns to    */
+#endif
     *--saddr = savsp;       /* fake frame ptr for procaddr  */
-    savsp = (unsigned long) saddr;
+    savsp = (unsigned long) saddr + stkdelta;
 
 /* this must match what ctxsw expects: flags, regs, old SP */
 /* emulate 386 "pushal" instruction */
@@ -95,15 +144,7 @@ SYSCALL create(procaddr,ssize,priority,name,nargs,args)
     *--saddr = savsp;   /* %ebp */
     *--saddr = 0;       /* %esi */
     *--saddr = 0;       /* %edi */
-    *pushsp = pptr->pesp = (unsigned long)saddr;
-
-
-    // Set up a new page directory for the process
-    pptr->pd = pd_alloc();
-    if (pptr->pd == NULL) {
-        kprintf("create(): could not create new page directory for proc\n");
-        return SYSERR;
-    }
+    *pushsp = pptr->pesp = (unsigned long)saddr + stkdelta;
 
     restore(ps);
 
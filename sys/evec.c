@@ -10,6 +10,7 @@
 #include <q.h>
 #include <io.h>
 #include <stdio.h>
+#include <icu.h>
 
 /*#define STKTRACE*/
 /*#define REGDUMP*/
@@ -27,6 +28,7 @@ extern struct segtr idtr;
 extern long	defevec[];
 extern int	userret();
 extern int init8259();
+extern int	intrif;
 extern int lidt();
 
 int initevec()
@@ -66,10 +68,35 @@ int set_evec(unsigned int xnum, u_long handler)
 		/* enable the interrupt in the global IR mask */
 		xnum -= 32;
 		girmask &= ~(1<<xnum);
+		/* with SMP restore() leaves the mask alone (see intr.S) */
+		if (intrif) {
+			outb(IMR, girmask);
+			outb(ICU2+1, girmask >> 8);
+		}
 	}
         return(OK);
 }
 
+/*------------------------------------------------------------------------
+ * set_tgate - route an exception vector through a task gate to the
+ *             task with TSS selector tsel
+ *------------------------------------------------------------------------
+ */
+int set_tgate(unsigned int xnum, unsigned int tsel)
+{
+	struct	idt	*pidt;
+
+	pidt = &idt[xnum];
+	pidt->igd_loffset = 0;
+	pidt->igd_segsel = tsel;	/* TSS descriptor */
+	pidt->igd_mbz = 0;
+	pidt->igd_type = IGDT_TASK;
+	pidt->igd_dpl = 0;
+	pidt->igd_present = 1;
+	pidt->igd_hoffset = 0;
+        return(OK);
+}
+
 char *inames[17] = {
 	"divided by zero",
 	"debug exception",
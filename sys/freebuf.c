@@ -23,7 +23,7 @@ int freebuf(void *p)
 	poolid = *(--buf);
 	if (poolid<0 || poolid>=nbpools)
 		return(SYSERR);
-	disable(ps);
+	lkdisable(ps, LK_MEM);
 	*buf = (int) bptab[poolid].bpnext;
 	bptab[poolid].bpnext = (char *) buf;
 	restore(ps);
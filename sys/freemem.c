@@ -18,7 +18,7 @@ SYSCALL freemem(struct mblock *block, unsigned size) {
         || ((unsigned)block)<((unsigned) &end))
         return(SYSERR);
     size = (unsigned)roundmb(size);
-    disable(ps);
+    lkdisable(ps, LK_MEM);
 
     // Iterate through the list until we get to the end or 
     // the next block (p) is greater than the block we are 
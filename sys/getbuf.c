@@ -25,7 +25,7 @@ int *getbuf(int poolid)
 	inuse = bptab[poolid].bptotal - scount(bptab[poolid].bpsem);
 	if (inuse > bptab[poolid].bpmaxused)
 		bptab[poolid].bpmaxused = inuse;
-	disable(ps);
+	lkdisable(ps, LK_MEM);
 	buf = (int *) bptab[poolid].bpnext;
 	bptab[poolid].bpnext = (char *) *buf;
 	restore(ps);
@@ -49,7 +49,7 @@ int *nbgetbuf(int poolid)
 #endif
 	if (poolid<0 || poolid>=nbpools)
 		return((int *) SYSERR);
-	disable(ps);
+	lkdisable(ps, LK_MEM);
 	if (scount(bptab[poolid].bpsem) <= 0) {
 		restore(ps);
 		return 0;
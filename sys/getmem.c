@@ -14,7 +14,7 @@ WORD *getmem(unsigned nbytes)
 	STATWORD ps;    
 	struct	mblock	*p, *q, *leftover;
 
-	disable(ps);
+	lkdisable(ps, LK_MEM);
 	if (nbytes==0 || memlist.mnext== (struct mblock *) NULL) {
 		restore(ps);
 		return( (WORD *)SYSERR);
@@ -14,7 +14,7 @@ SYSCALL getprio(int pid)
 	STATWORD ps;    
 	struct	pentry	*pptr;
 
-	disable(ps);
+	lkdisable(ps, LK_PROC);
 	if (isbadpid(pid) || (pptr = &proctab[pid])->pstate == PRFREE) {
 		restore(ps);
 		return(SYSERR);
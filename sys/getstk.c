@@ -16,7 +16,7 @@ WORD *getstk(unsigned int nbytes)
 	struct	mblock	*fits, *fitsq=NULL;
 	WORD	len;
 
-	disable(ps);
+	lkdisable(ps, LK_MEM);
 	if (nbytes == 0) {
 		restore(ps);
 		return( (WORD *)SYSERR );
@@ -2,6 +2,19 @@
 
 /* generic priority queue processing functions */
 
+/*
+ * Higher keys come out first, and items with equal keys come out in
+ * the order they went in. Each item gets a sequence number when it is
+ * enqueued to make that order total, and the items are kept in a
+ * binary heap on (key, sequence number).
+ *
+ * Most queues only ever hold one key. While every item in a queue has
+ * the same key it is kept as a ring instead, so enq and deq are a
+ * store and an index bump. The first enq with a different key lays
+ * the ring out as a heap (items of one key in sequence order already
+ * are one) and the queue goes back to being a ring when it empties.
+ */
+
 #include <conf.h>
 #include <kernel.h>
 #include <q.h>
@@ -16,6 +29,12 @@ struct	qinfo {
 	int	q_mutex;
 	int	*q_key;
 	char	**q_elt;
+	unsigned long	*q_seq;		/* enq order, for equal keys	*/
+	unsigned long	q_nextseq;
+	Bool	q_ring;			/* all keys equal, kept as ring	*/
+	int	q_head;			/* ring: index of the head	*/
+	int	q_seenkey;		/* last item seeq returned	*/
+	unsigned long	q_seenseq;
 };
 
 static	int	qinit = FALSE;
@@ -27,6 +46,110 @@ static	int	initq();
 
 static	struct	qinfo Q[MAXNQ];
 
+/*------------------------------------------------------------------------
+ *  _qprec  --  does item (k1,s1) come out before item (k2,s2)?
+ *------------------------------------------------------------------------
+ */
+static int _qprec(int k1, unsigned long s1, int k2, unsigned long s2)
+{
+	return k1 > k2 || (k1 == k2 && (long)(s1 - s2) < 0);
+}
+
+/*------------------------------------------------------------------------
+ *  _qset  --  store an item in slot i
+ *------------------------------------------------------------------------
+ */
+static void _qset(struct qinfo *qp, int i, char *elt, int key,
+		  unsigned long seq)
+{
+	qp->q_elt[i] = elt;
+	qp->q_key[i] = key;
+	qp->q_seq[i] = seq;
+}
+
+/*------------------------------------------------------------------------
+ *  _qup  --  move the item in slot i up the heap to where it belongs
+ *------------------------------------------------------------------------
+ */
+static void _qup(struct qinfo *qp, int i)
+{
+	char	*elt = qp->q_elt[i];
+	int	key = qp->q_key[i];
+	unsigned long	seq = qp->q_seq[i];
+	int	parent;
+
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		if (!_qprec(key, seq, qp->q_key[parent], qp->q_seq[parent]))
+			break;
+		_qset(qp, i, qp->q_elt[parent], qp->q_key[parent],
+		      qp->q_seq[parent]);
+		i = parent;
+	}
+	_qset(qp, i, elt, key, seq);
+}
+
+/*------------------------------------------------------------------------
+ *  _qdown  --  move the item in slot i down the heap to where it belongs
+ *------------------------------------------------------------------------
+ */
+static void _qdown(struct qinfo *qp, int i)
+{
+	char	*elt = qp->q_elt[i];
+	int	key = qp->q_key[i];
+	unsigned long	seq = qp->q_seq[i];
+	int	child;
+
+	while ((child = 2 * i + 1) < qp->q_count) {
+		if (child + 1 < qp->q_count &&
+		    _qprec(qp->q_key[child+1], qp->q_seq[child+1],
+			   qp->q_key[child], qp->q_seq[child]))
+			child++;
+		if (!_qprec(qp->q_key[child], qp->q_seq[child], key, seq))
+			break;
+		_qset(qp, i, qp->q_elt[child], qp->q_key[child],
+		      qp->q_seq[child]);
+		i = child;
+	}
+	_qset(qp, i, elt, key, seq);
+}
+
+/*------------------------------------------------------------------------
+ *  _qreverse  --  reverse slots lo through hi
+ *------------------------------------------------------------------------
+ */
+static void _qreverse(struct qinfo *qp, int lo, int hi)
+{
+	char	*elt;
+	int	key;
+	unsigned long	seq;
+
+	for ( ; lo < hi ; lo++, hi--) {
+		elt = qp->q_elt[lo];
+		key = qp->q_key[lo];
+		seq = qp->q_seq[lo];
+		_qset(qp, lo, qp->q_elt[hi], qp->q_key[hi], qp->q_seq[hi]);
+		_qset(qp, hi, elt, key, seq);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  _qunring  --  turn a ring into a heap: rotate its head to slot 0
+ *------------------------------------------------------------------------
+ */
+static void _qunring(struct qinfo *qp)
+{
+	int	h = qp->q_head;
+
+	if (h != 0) {
+		_qreverse(qp, 0, h - 1);
+		_qreverse(qp, h, qp->q_max - 1);
+		_qreverse(qp, 0, qp->q_max - 1);
+	}
+	qp->q_head = 0;
+	qp->q_ring = FALSE;
+}
+
 /*------------------------------------------------------------------------
  * enq  --	insert an item at the tail of a list, based on priority
  *	Returns the number of slots available; -1, if full
@@ -39,7 +162,7 @@ int enq(int q, void *elt, int key)
 {
 	STATWORD	ps;
 	struct	qinfo	*qp;
-	int	i, j, left;
+	int	i, left;
 
 	if (q < 0 || q >= MAXNQ)
 		return -1;
@@ -49,28 +172,28 @@ int enq(int q, void *elt, int key)
 	qp = &Q[q];
 
 	if (qp->q_type == QF_NOWAIT)
-		disable(ps);
+		lkdisable(ps, LK_MEM);
 	else
 		wait(qp->q_mutex);
 
-	/* start at tail and move towards head, as long as key is greater */
-
 	/* this shouldn't happen, but... */
 	if (qp->q_count < 0)
 		qp->q_count = 0;
-	i = qp->q_count-1;
 
-	while(i >= 0 && key > qp->q_key[i])
-		--i;
-	/* i can be -1 (new head) -- it still works */
-
-	for (j = qp->q_count-1; j > i; --j) {
-		qp->q_key[j+1] = qp->q_key[j];
-		qp->q_elt[j+1] = qp->q_elt[j];
+	if (qp->q_ring &&
+	    (qp->q_count == 0 || key == qp->q_key[qp->q_head])) {
+		i = qp->q_head + qp->q_count;	/* same key: ring tail	*/
+		if (i >= qp->q_max)
+			i -= qp->q_max;
+		_qset(qp, i, elt, key, qp->q_nextseq++);
+		qp->q_count++;
+	} else {
+		if (qp->q_ring)
+			_qunring(qp);
+		i = qp->q_count++;
+		_qset(qp, i, elt, key, qp->q_nextseq++);
+		_qup(qp, i);
 	}
-	qp->q_key[i+1] = key;
-	qp->q_elt[i+1] = elt;
-	qp->q_count++;
 	left = qp->q_max - qp->q_count;
 	if (qp->q_type == QF_NOWAIT)
 		restore(ps);
@@ -100,17 +223,26 @@ char *deq(int q)
 	qp = &Q[q];
 
 	if (qp->q_type == QF_NOWAIT)
-		disable(ps);
+		lkdisable(ps, LK_MEM);
 	else
 		wait(qp->q_mutex);
 
-	elt = qp->q_elt[0];
-
-	for (i=1; i<qp->q_count; ++i) {
-		qp->q_elt[i-1] = qp->q_elt[i];
-		qp->q_key[i-1] = qp->q_key[i];
+	if (qp->q_ring) {
+		elt = qp->q_elt[qp->q_head];
+		if (++qp->q_head == qp->q_max)
+			qp->q_head = 0;
+		qp->q_count--;
+	} else {
+		elt = qp->q_elt[0];
+		if (--qp->q_count > 0) {
+			i = qp->q_count;
+			_qset(qp, 0, qp->q_elt[i], qp->q_key[i], qp->q_seq[i]);
+			_qdown(qp, 0);
+		} else {
+			qp->q_ring = TRUE;	/* empty: a ring again	*/
+			qp->q_head = 0;
+		}
 	}
-	qp->q_count--;
 	if (qp->q_type == QF_NOWAIT)
 		restore(ps);
 	else
@@ -136,11 +268,11 @@ char *headq(int q)
 	qp = &Q[q];
 
 	if (qp->q_type == QF_NOWAIT)
-		disable(ps);
+		lkdisable(ps, LK_MEM);
 	else
 		wait(qp->q_mutex);
 
-	elt = qp->q_elt[0];
+	elt = qp->q_elt[qp->q_ring ? qp->q_head : 0];
 	if (qp->q_type == QF_NOWAIT)
 		restore(ps);
 	else
@@ -159,6 +291,7 @@ char *seeq(int q)
 	struct	qinfo	*qp;
 	STATWORD	ps;
 	char	*elt;
+	int	i, j;
 
 	if (q < 0 || q >= MAXNQ)
 		return NULL;
@@ -168,7 +301,7 @@ char *seeq(int q)
 	qp = &Q[q];
 
 	if (qp->q_type == QF_NOWAIT)
-		disable(ps);
+		lkdisable(ps, LK_MEM);
 	else
 		wait(qp->q_mutex);
 
@@ -182,7 +315,26 @@ char *seeq(int q)
 		return NULL;
 	}
 
-	elt = qp->q_elt[qp->q_seen];
+	if (qp->q_ring) {
+		i = qp->q_head + qp->q_seen;
+		if (i >= qp->q_max)
+			i -= qp->q_max;
+	} else if (qp->q_seen == 0)
+		i = 0;
+	else {
+		/* the heap isn't in order: look for the item that comes */
+		/* next after the last one returned			  */
+		i = -1;
+		for (j=0; j<qp->q_count; ++j)
+			if (_qprec(qp->q_seenkey, qp->q_seenseq,
+				   qp->q_key[j], qp->q_seq[j]) &&
+			    (i < 0 || _qprec(qp->q_key[j], qp->q_seq[j],
+					     qp->q_key[i], qp->q_seq[i])))
+				i = j;
+	}
+	qp->q_seenkey = qp->q_key[i];
+	qp->q_seenseq = qp->q_seq[i];
+	elt = qp->q_elt[i];
 	if (qp->q_type == QF_NOWAIT)
 		restore(ps);
 	else
@@ -216,11 +368,16 @@ int newq(int size, int mtype)
 	qp->q_max = size;
 	qp->q_count = 0;
 	qp->q_seen = -1;
+	qp->q_nextseq = 0;
+	qp->q_ring = TRUE;
+	qp->q_head = 0;
 	if (mtype != QF_NOWAIT)
 		qp->q_mutex = screate(1);
 	qp->q_elt = (char **) getmem(sizeof(char *) * size);
 	qp->q_key = (int *) getmem(sizeof(int) * size);
-	if (qp->q_key == (int *) SYSERR || qp->q_elt == (char **) SYSERR)
+	qp->q_seq = (unsigned long *) getmem(sizeof(unsigned long) * size);
+	if (qp->q_key == (int *) SYSERR || qp->q_elt == (char **) SYSERR ||
+	    qp->q_seq == (unsigned long *) SYSERR)
 		return -1;
 	return i;
 }
@@ -238,6 +395,7 @@ int freeq(int q)
 	/* free resources */
 	freemem((struct mblock*)qp->q_key, sizeof(int) * qp->q_max);
 	freemem((struct mblock*)qp->q_elt, sizeof (char *) * qp->q_max);
+	freemem((struct mblock*)qp->q_seq, sizeof (unsigned long) * qp->q_max);
 	if (qp->q_type != QF_NOWAIT)
 		sdelete(qp->q_mutex);
 	qp->q_valid = FALSE;
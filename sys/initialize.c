@@ -14,6 +14,9 @@
 #include <paging.h>
 #include <bs.h>
 #include <frame.h>
+#include <mp.h>
+#include <klog.h>
+#include <network.h>
 
 /*#define DETAIL */
 #define HOLESIZE    (600)   
@@ -42,10 +45,16 @@ struct  tty     tty[Ntty];      /* SLU buffers and mode control     */
 
 /* active system status */
 int numproc;        /* number of live user processes    */
+#ifndef SMP
 int currpid;        /* id of currently running process  */
+#endif
 int reboot = 0;     /* non-zero after first boot        */
 
+#ifdef SMP
+int rdylists;           /* ready lists, NCPU head/tail pairs in q */
+#else
 int rdyhead,rdytail;    /* head/tail of ready list (q indicies) */
+#endif
 char    vers[80];
 int console_dev;        /* the console device           */
 
@@ -115,7 +124,20 @@ nulluser()              /* babysit CPU when no one is home */
     
     kprintf("clock %sabled\n", clkruns == 1?"en":"dis");
 
+#ifdef SMP
+    if (ncpu > 1)
+        kprintf("%d of %d processors running\n", smpstart(), ncpu);
+#else
+    if (ncpu > 1)
+        kprintf("%d processors, Xinu runs on the boot processor only\n",
+            ncpu);
+#endif
+
     open(CONSOLE, console_dev, 0);
+    klinit();
+#ifdef Nudp
+    netinit();
+#endif
 
     /* create a process to execute the user's main program */
     userpid = create(main,INITSTK,INITPRIO,INITNAME,INITARGS);
@@ -191,6 +213,13 @@ sysinit()
     }
 
 
+    // Count the processors. With SMP each gets its struct cpu here,
+    // before anything reads currpid.
+    mpinit();
+#ifdef SMP
+    smpinit();
+#endif
+
     // The following should occur at system initialization:
 
 
@@ -252,8 +281,16 @@ sysinit()
     if (rc == SYSERR)
         return SYSERR;
 
-    // Create a page directory for the null process
-    pd = pd_alloc();
+    // With SMP the other processors need the local APIC, which every
+    // page directory must then map.
+#ifdef SMP
+    if (ncpu > 1 && init_apic_pt(lapicaddr) == SYSERR)
+        ncpu = 1;
+#endif
+
+    // Create a page directory for the null process. Processes share
+    // it until they map something (kernpd).
+    kernpd = pd = pd_alloc();
     if (pd == NULL)
         return SYSERR;
 
@@ -262,7 +299,13 @@ sysinit()
     set_PDBR(VA2VPNO(pd));
 
     // Install the page fault interrupt service routine.
+#ifdef VSTACK
+    // Faults are taken as a separate task so that a fault on a
+    // process stack can be serviced (see paging/vstack.c)
+    init_pftask(pd);
+#else
     set_evec(14, (unsigned long) pfintr);
+#endif
 
     // Enable paging (set bit 31 of CR0 register)
     enable_paging();
@@ -311,18 +354,31 @@ sysinit()
     pptr->paddr = (WORD) nulluser;
     pptr->pargs = 0;
     pptr->pprio = 0;
+    pptr->pbprio = 0;
+    pptr->pmutex = EMPTY;
+    pptr->pmq = NULL;
 
     pptr->pd = pd; // Set the pdbr for the null proc
 
 
-    currpid = NULLPROC;
+    setcurrpid(NULLPROC);
 
     for (i=0 ; i<NSEM ; i++) {  /* initialize semaphores */
         (sptr = &semaph[i])->sstate = SFREE;
+        sptr->smutex = FALSE;
+        sptr->sany = EMPTY;
         sptr->sqtail = 1 + (sptr->sqhead = newqueue());
     }
 
+#ifdef SMP
+    for (i=0 ; i<NCPU ; i++) {  /* a ready list per processor */
+        cpus[i].c_rdytail = 1 + (cpus[i].c_rdyhead = newqueue());
+        rdyinit(cpus[i].c_rdyhead);
+    }
+#else
     rdytail = 1 + (rdyhead=newqueue());/* initialize ready list */
+    rdyinit(rdyhead);
+#endif
 
 
     return(OK);
@@ -13,6 +13,9 @@ int insert(int proc, int head, int key)
 	int	next;			/* runs through list		*/
 	int	prev;
 
+	if (isrdyhead(head))		/* no need to walk these	*/
+		return( rdyinsert(proc, head, key) );
+
 	next = q[head].qnext;
 	while (q[next].qkey < key)	/* tail has maxint as key	*/
 		next = q[next].qnext;
@@ -1,4 +1,4 @@
-/* kill.c - kill */
+/* kill.c - kill, killstk */
 
 #include <conf.h>
 #include <kernel.h>
@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <bs.h>
 #include <frame.h>
+#include <msgq.h>
 
 /*------------------------------------------------------------------------
  * kill  --  kill a process and remove it from the system
@@ -21,11 +22,27 @@ SYSCALL kill(int pid)
     struct  pentry  *pptr;      /* points to proc. table for pid*/
     int dev;
 
-    disable(ps);
-    if (isbadpid(pid) || (pptr= &proctab[pid])->pstate==PRFREE) {
+    lkdisable(ps, LK_DEV|LK_NET|LK_MEM|LK_SEM|LK_PROC|LK_BS|LK_FRM);
+    if (isbadpid(pid) || (pptr= &proctab[pid])->pstate==PRFREE ||
+        pptr->pstate == PRDEAD) {
         restore(ps);
         return(SYSERR);
     }
+#ifdef SMP
+    if (smpidle(pid)) {
+        restore(ps);
+        return(SYSERR);
+    }
+    // Running on another processor: it must stop using its stack
+    // first, so that processor kills it (see smpreqs)
+    if (pptr->pstate == PRCURR && pid != currpid) {
+        pptr->psmpreq |= PRQ_KILL;
+        smpipi(pptr->pcpu);
+        restore(ps);
+        return(OK);
+    }
+    pptr->psmpreq = 0;
+#endif
     if (--numproc == 0)
         xdone();
 
@@ -34,9 +51,6 @@ SYSCALL kill(int pid)
     // and writing back frame contents
     bs_cleanproc(pid);
 
-    // Free the frame with the page directory in it
-    frm_free(PA2FP(pptr->pd));
-
     dev = pptr->pdevs[0];
     if (! isbaddev(dev) )
         close(dev);
@@ -49,11 +63,30 @@ SYSCALL kill(int pid)
     
     send(pptr->pnxtkin, pid);
 
-    freestk(pptr->pbase, pptr->pstklen);
+    schedkill(pid);
+
+    // Waiters for the mutexes it holds get them now
+    mkill(pid);
+
+    // Its message queue goes, and any timed send it was doing
+    mqkill(pid);
+
+    if (pptr->pstate != PRCURR)
+        killstk(pid);
     switch (pptr->pstate) {
 
-    case PRCURR:    pptr->pstate = PRFREE;  /* suicide */
+#ifdef SMP
+    // Suicide. Another processor could reuse the stack while this one
+    // is still on it, so it goes once this one has switched away (see
+    // smpresume)
+    case PRCURR:    pptr->pstate = PRDEAD;
+            cpu()->c_reap = pid;
+            resched();
+#else
+    case PRCURR:    killstk(pid);
+            pptr->pstate = PRFREE;  /* suicide */
             resched();
+#endif
 
     case PRWAIT:    semaph[pptr->psem].semcnt++;
 
@@ -61,6 +94,10 @@ SYSCALL kill(int pid)
             pptr->pstate = PRFREE;
             break;
 
+    case PRWANY:    wanykill(pid);
+            pptr->pstate = PRFREE;
+            break;
+
     case PRSLEEP:
     case PRTRECV:   unsleep(pid);
                         /* fall through */
@@ -69,3 +106,25 @@ SYSCALL kill(int pid)
     restore(ps);
     return(OK);
 }
+
+/*------------------------------------------------------------------------
+ * killstk  --  free the stack and page directory of a dying process
+ *------------------------------------------------------------------------
+ */
+void killstk(int pid)
+{
+    struct  pentry  *pptr = &proctab[pid];
+
+#ifdef VSTACK
+    // Needs the page directory, so before it goes
+    vstk_free(pid);
+#endif
+
+    // Free the page directory and whatever page tables are left
+    if (pptr->pd != kernpd)
+        pd_free(pptr->pd);
+
+#ifndef VSTACK
+    freestk(pptr->pbase, pptr->pstklen);
+#endif
+}
@@ -0,0 +1,195 @@
+/* klog.c - klog, klflush, klinit, klogd */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sem.h>
+#include <klog.h>
+#include <stdio.h>
+
+extern	int	console_dev;
+extern	int	_doprnt(char *, int *, void *, int);
+
+/*
+ * The ring holds the text of the messages back to back. klog() formats
+ * into a buffer on its own stack with interrupts enabled, then only
+ * copies the message in with them disabled, so it never waits and can
+ * be called from pfint() and with interrupts disabled. klogd is woken
+ * with ready(..., RESCHNO): it has the lowest priority there is but the
+ * null process's, so it would not run before the caller anyway.
+ *
+ * With SMP the ring is under LK_LOG. Waking klogd takes LK_SEM and
+ * LK_PROC, which come before the paging locks most messages are logged
+ * under, so then it is left to the next message logged without them.
+ */
+
+#if DUSTYDEBUG
+int	klevel = KL_DEBUG;
+#else
+int	klevel = KL_INFO;
+#endif
+unsigned long	kldrops = 0;
+
+LOCAL	char	klring[KLOGSZ];
+LOCAL	int	klhead = 0;		/* oldest byte in the ring	*/
+LOCAL	int	klcount = 0;		/* bytes in the ring		*/
+LOCAL	int	klsem = SYSERR;		/* klogd waits here for text	*/
+LOCAL	unsigned long	klshown = 0;	/* drops already reported	*/
+LOCAL	int	klwake = FALSE;		/* klogd is to be woken		*/
+
+struct	klmsg	{			/* message being formatted	*/
+	char	*m_next;
+	char	*m_end;
+};
+
+/*------------------------------------------------------------------------
+ *  _klput  --  called by _doprnt: add c to a message, if it has room
+ *------------------------------------------------------------------------
+ */
+LOCAL int _klput(int farg, int c)
+{
+	struct	klmsg	*mp = (struct klmsg *)farg;
+
+	if (mp->m_next < mp->m_end)
+		*mp->m_next++ = c;
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  _klget  --  take up to n bytes out of the ring (interrupts disabled)
+ *------------------------------------------------------------------------
+ */
+LOCAL int _klget(char *buf, int n)
+{
+	int	i;
+
+	for (i=0 ; i<n && klcount>0 ; i++) {
+		buf[i] = klring[klhead];
+		if (++klhead == KLOGSZ)
+			klhead = 0;
+		klcount--;
+	}
+	return(i);
+}
+
+/*------------------------------------------------------------------------
+ *  _kldrops  --  report messages dropped since the last report
+ *------------------------------------------------------------------------
+ */
+LOCAL void _kldrops()
+{
+	unsigned long	n;
+
+	if ((n = kldrops - klshown) == 0)
+		return;
+	klshown = kldrops;
+	kprintf("[klog: %u messages dropped]\n", n);
+}
+
+/*------------------------------------------------------------------------
+ *  klog  --  log a message of the given level without waiting; SYSERR
+ *	      if the ring had no room for it
+ *------------------------------------------------------------------------
+ */
+int klog(int level, char *fmt, ...)
+{
+	STATWORD ps;
+	struct	klmsg	msg;
+	char	buf[KLOGMSG];
+	int	n, i, pos;
+
+	if (level > klevel)
+		return(OK);
+	msg.m_next = buf;
+	msg.m_end = buf + KLOGMSG;
+	_doprnt(fmt, (int *)(&fmt + 1), _klput, (int)&msg);
+	n = msg.m_next - buf;
+
+	lkdisable(ps, LK_LOG);
+	if (n > KLOGSZ - klcount) {
+		kldrops++;
+		restore(ps);
+		return(SYSERR);
+	}
+	pos = klhead + klcount;
+	for (i=0 ; i<n ; i++) {
+		if (pos >= KLOGSZ)
+			pos -= KLOGSZ;
+		klring[pos++] = buf[i];
+	}
+	klcount += n;
+	if (klsem != SYSERR && semaph[klsem].semcnt < 0)
+		klwake = TRUE;
+	restore(ps);
+#ifdef	SMP
+	if (cpuget(c_lkheld) & ~(2*LK_PROC-1))
+		return(OK);		/* klwake stays set (see above)	*/
+#endif
+	if (klwake) {
+		lkdisable(ps, LK_SEM|LK_PROC);
+		klwake = FALSE;
+		isignaln(klsem, 1);
+		restore(ps);
+	}
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  klflush  --  write out whatever is in the ring now, synchronously
+ *------------------------------------------------------------------------
+ */
+int klflush()
+{
+	STATWORD ps;
+	char	c;
+
+	lkdisable(ps, LK_LOG);
+	while (_klget(&c, 1) > 0)
+		kputc(console_dev, c);
+	_kldrops();
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  klinit  --  start klogd; messages logged before are kept until then
+ *------------------------------------------------------------------------
+ */
+int klinit()
+{
+	int	pid;
+
+	if ((klsem = screate(0)) == SYSERR)
+		return(SYSERR);
+	pid = create(klogd, INITSTK, KLOGPRIO, "klogd", 0, 0);
+	if (pid == SYSERR)
+		return(SYSERR);
+	numproc--;		/* it never exits; let xdone() still run	*/
+	resume(pid);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  klogd  --  copy the ring out to the console a chunk at a time
+ *------------------------------------------------------------------------
+ */
+PROCESS klogd()
+{
+	STATWORD ps;
+	char	buf[64];
+	int	n, i;
+
+	for (;;) {
+		lkdisable(ps, LK_SEM|LK_PROC|LK_LOG);
+		while (klcount == 0 && kldrops == klshown)
+			wait(klsem);
+		n = _klget(buf, sizeof(buf));
+		restore(ps);
+
+		for (i=0 ; i<n ; i++)		/* may be preempted	*/
+			kputc(console_dev, buf[i]);
+		if (klcount == 0)
+			_kldrops();
+	}
+}
@@ -15,7 +15,7 @@ int kprintf(char *fmt, int args)
 {
 	STATWORD	ps;
 
-	disable(ps);
+	lkdisable(ps, LK_CONS);
         _doprnt(fmt, &args, (void *)kputc, CONSOLE);
 	restore(ps);
         return OK;
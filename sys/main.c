@@ -8,6 +8,13 @@
 #include <bs.h>
 #include <frame.h>
 #include <sem.h>
+#include <q.h>
+#include <timer.h>
+#include <tty.h>
+#include <com.h>
+#include <klog.h>
+#include <trace.h>
+#include <network.h>
 
 //////////////////////////////////////////////////////////////////////////
 //  basic_test ( given code from initial main.c )
@@ -63,9 +70,9 @@ void vheaptask() {
     int vpno   = 4200;
 
     // Values for frame_t structure
-    int status = 75;
-    int type   = 1;
-    int refcnt = 7200;
+    int frmid  = 75;
+    int bsid   = 1;
+    int bspage = 7200;
 
     // Create a proc structure.. populate some print it out
     kprintf("Allocating pentry structure\n\n");
@@ -137,18 +144,18 @@ void vheaptask() {
         return;
     }
     kprintf("Mem for frame_t structure: 0x%08x\n", frame);
-    frame->status = status;
-    frame->type   = type;
-    frame->refcnt = refcnt;
+    frame->frmid  = frmid;
+    frame->bsid   = bsid;
+    frame->bspage = bspage;
 
-    str = (frame->status == status) ? pass : fail;
-    kprintf("task1: UT7 frame->status: \t%s\n", str);
+    str = (frame->frmid == frmid) ? pass : fail;
+    kprintf("task1: UT7 frame->frmid: \t%s\n", str);
 
-    str = (frame->type == type) ? pass : fail;
-    kprintf("task1: UT8 frame->type: \t%s\n", str);
+    str = (frame->bsid == bsid) ? pass : fail;
+    kprintf("task1: UT8 frame->bsid: \t%s\n", str);
 
-    str = (frame->refcnt == refcnt) ? pass : fail;
-    kprintf("task1: UT9 frame->refcnt: \t%s\n", str);
+    str = (frame->bspage == bspage) ? pass : fail;
+    kprintf("task1: UT9 frame->bspage: \t%s\n", str);
 
     kprintf("\n\n");
 
@@ -706,10 +713,1732 @@ void error_test() {
 
 }
 
+//////////////////////////////////////////////////////////////////////////
+//  vstack_test (demand-paged process stacks, needs VSTACK)
+//////////////////////////////////////////////////////////////////////////
+#ifdef VSTACK
+int vstack_nframes() {
+    int i, n = 0;
+
+    for (i=0; i < NFRAMES; i++)
+        if (frm_status[i] == FRM_USED && frm_type[i] == FRM_STK)
+            n++;
+    return n;
+}
+
+void vstack_idletask() {
+    sleep(5);
+}
+
+int vstack_recurse(int depth) {
+    char buf[512];
+
+    bzero(buf, sizeof(buf));
+    buf[0] = depth;
+    return vstack_recurse(depth + 1) + buf[0];
+}
+
+void vstack_overflowtask() {
+    vstack_recurse(0);
+    kprintf("THIS SHOULD NOT RUN\n");
+}
+
+// Two processes switch back and forth, each checking the pattern it
+// left on its stack. Every VSTACK stack is at the same address, so a
+// switch done on the wrong stack shows up here.
+#define VSTACK_SWITCHES 1000
+int vstack_sem[2], vstack_bad;
+
+void vstack_pingtask(int self) {
+    int pattern[64];
+    int i, j;
+
+    for (j=0; j < 64; j++)
+        pattern[j] = self * 1000 + j;
+    for (i=0; i < VSTACK_SWITCHES; i++) {
+        wait(vstack_sem[self]);
+        for (j=0; j < 64; j++)
+            if (pattern[j] != self * 1000 + j)
+                vstack_bad++;
+        signal(vstack_sem[!self]);
+    }
+}
+
+void vstack_test() {
+    int i, p1, p2, before, after;
+    int nprocs = 20;
+    int ssize  = 4*NBPG;
+
+    kprintf("\nDemand-paged stack test\n");
+
+    // Mostly idle processes should only use the frames they touch
+    before = vstack_nframes();
+    for (i=0; i < nprocs; i++)
+        resume(create(vstack_idletask, ssize, 20, "vstack_idle", 0, NULL));
+    after = vstack_nframes();
+
+    kprintf("%d procs with %d byte stacks: %d stack frames (%d bytes)"
+            " instead of %d bytes of kernel heap\n",
+            nprocs, ssize, after - before, (after - before)*NBPG,
+            nprocs*ssize);
+
+    // Running off the end of a stack should kill only that process
+    p1 = create(vstack_overflowtask, 2*NBPG, 30, "vstack_ovfl", 0, NULL);
+    resume(p1);
+    if (proctab[p1].pstate == PRFREE)
+        kprintf("vstack_test: overflow PASS!\n");
+    else
+        kprintf("vstack_test: overflow FAIL!\n");
+
+    // Context switches between two stack-paged processes
+    vstack_bad = 0;
+    vstack_sem[0] = screate(1);
+    vstack_sem[1] = screate(0);
+    p1 = create(vstack_pingtask, 2*NBPG, 20, "vstack_ping", 1, 0);
+    p2 = create(vstack_pingtask, 2*NBPG, 20, "vstack_pong", 1, 1);
+    resume(p1);
+    resume(p2);
+    while (proctab[p1].pstate != PRFREE || proctab[p2].pstate != PRFREE)
+        sleep10(1);
+    sdelete(vstack_sem[0]);
+    sdelete(vstack_sem[1]);
+    if (vstack_bad == 0)
+        kprintf("vstack_test: %d switches PASS!\n", 2*VSTACK_SWITCHES);
+    else
+        kprintf("vstack_test: %d switches FAIL!\n", 2*VSTACK_SWITCHES);
+
+    sleep(6);
+    if (vstack_nframes() == before)
+        kprintf("vstack_test: frames released PASS!\n");
+    else
+        kprintf("vstack_test: frames released FAIL!\n");
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+//  xmadvise_test (access hints and XM_POPULATE)
+//////////////////////////////////////////////////////////////////////////
+int xmadvise_nresident(int vpno, int npages) {
+    int i, n = 0;
+    pd_t * pd = proctab[currpid].pd;
+    pt_t * pt;
+
+    for (i=vpno; i < vpno + npages; i++) {
+        if (!pd[i / NENTRIES].pt_pres)
+            continue;
+        pt = VPNO2VA(pd[i / NENTRIES].pt_base);
+        if (pt[i & (NENTRIES - 1)].p_pres)
+            n++;
+    }
+    return n;
+}
+
+void xmadvise_test() {
+    int i, rc, n;
+    char *addr = (char*) 0x60000000;
+    bsd_t bsid = 6;
+    int npages = 40;
+    int vpno = VA2VPNO(addr);
+
+    kprintf("\nxmadvise test\n");
+
+    rc = get_bs(bsid, npages);
+    if (rc == SYSERR) {
+    	kprintf("get_bs call failed\n");
+    	return;
+    }
+
+    rc = xmmap(vpno, bsid, npages);
+    if (rc == SYSERR) {
+    	kprintf("xmmap call failed\n");
+    	return;
+    }
+
+    // A sequential stream should only keep a window resident
+    xmadvise(vpno, npages, XM_SEQUENTIAL);
+    for (i=0; i < npages; i++)
+        *(addr + i*NBPG) = 'A' + (i % 26);
+    n = xmadvise_nresident(vpno, npages);
+    kprintf("%d of %d pages resident after sequential writes\n", n, npages);
+    if (n < npages)
+        kprintf("xmadvise_test: SEQUENTIAL PASS!\n");
+    else
+        kprintf("xmadvise_test: SEQUENTIAL FAIL!\n");
+
+    // DONTNEED releases everything, the data must survive
+    xmadvise(vpno, npages, XM_DONTNEED);
+    n = xmadvise_nresident(vpno, npages);
+    for (i=0; i < npages; i++)
+        if (*(addr + i*NBPG) != 'A' + (i % 26))
+            break;
+    if (n == 0 && i == npages)
+        kprintf("xmadvise_test: DONTNEED PASS!\n");
+    else
+        kprintf("xmadvise_test: DONTNEED FAIL! (%d resident, %d ok)\n", n, i);
+
+    // WILLNEED brings the range back in the background
+    xmadvise(vpno, npages, XM_NORMAL);
+    xmadvise(vpno, npages, XM_DONTNEED);
+    xmadvise(vpno, npages, XM_WILLNEED);
+    sleep(1);
+    n = xmadvise_nresident(vpno, npages);
+    if (n == npages)
+        kprintf("xmadvise_test: WILLNEED PASS!\n");
+    else
+        kprintf("xmadvise_test: WILLNEED FAIL! (%d resident)\n", n);
+
+    xmunmap(vpno);
+
+    // XM_POPULATE maps everything up front
+    rc = xmmapf(vpno, bsid, npages, XM_POPULATE);
+    if (rc == SYSERR) {
+    	kprintf("xmmapf call failed\n");
+    	return;
+    }
+    n = xmadvise_nresident(vpno, npages);
+    if (n == npages && *(addr + (npages-1)*NBPG) == 'A' + ((npages-1) % 26))
+        kprintf("xmadvise_test: POPULATE PASS!\n");
+    else
+        kprintf("xmadvise_test: POPULATE FAIL! (%d resident)\n", n);
+
+    xmunmap(vpno);
+    release_bs(bsid);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  xmlock_test (pinned pages survive replacement)
+//////////////////////////////////////////////////////////////////////////
+void xmlock_test() {
+    int i, rc, n;
+    char *hot = (char*) 0x70000000;
+    char *stream = (char*) 0x71000000;
+    bsd_t hotbsid = 5;
+    bsd_t streambsid = 4;
+    int nhot = 4;
+    int nstream = 40;
+
+    kprintf("\nxmlock test\n");
+
+    if (get_bs(hotbsid, nhot) == SYSERR ||
+        get_bs(streambsid, nstream) == SYSERR) {
+    	kprintf("get_bs call failed\n");
+    	return;
+    }
+
+    if (xmmap(VA2VPNO(hot), hotbsid, nhot) == SYSERR ||
+        xmmap(VA2VPNO(stream), streambsid, nstream) == SYSERR) {
+    	kprintf("xmmap call failed\n");
+    	return;
+    }
+
+    // Lock the hot pages, twice should count once
+    rc = xmlock(VA2VPNO(hot), nhot);
+    xmlock(VA2VPNO(hot), nhot);
+    if (rc == OK && proctab[currpid].pnpinned == nhot)
+        kprintf("xmlock_test: lock PASS!\n");
+    else
+        kprintf("xmlock_test: lock FAIL! (%d locked)\n", proctab[currpid].pnpinned);
+
+    // Going over the per-process limit is refused
+    if (xmlock(VA2VPNO(stream), XM_MAXLOCK) == SYSERR)
+        kprintf("xmlock_test: limit PASS!\n");
+    else
+        kprintf("xmlock_test: limit FAIL!\n");
+
+    // Touch more pages than there are frames
+    for (i=0; i < nstream; i++)
+        *(stream + i*NBPG) = 'A' + (i % 26);
+    n = xmadvise_nresident(VA2VPNO(hot), nhot);
+    if (n == nhot)
+        kprintf("xmlock_test: pinned pages resident PASS!\n");
+    else
+        kprintf("xmlock_test: pinned pages resident FAIL! (%d of %d)\n", n, nhot);
+
+    pgdump();
+
+    xmunlock(VA2VPNO(hot), nhot);
+    if (proctab[currpid].pnpinned == 0 && frm_npinned == 0)
+        kprintf("xmlock_test: unlock PASS!\n");
+    else
+        kprintf("xmlock_test: unlock FAIL!\n");
+
+    xmunmap(VA2VPNO(stream));
+    xmunmap(VA2VPNO(hot));
+    release_bs(streambsid);
+    release_bs(hotbsid);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  tsc_read (low 32 bits of the time stamp counter, for benchmarks)
+//////////////////////////////////////////////////////////////////////////
+unsigned long tsc_read() {
+    unsigned long lo, hi;
+
+    asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+    return lo;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  killbench (kill latency of a process with 256 resident pages)
+//////////////////////////////////////////////////////////////////////////
+void killbench_idle() {
+    sleep(5);
+}
+
+void killbench_task(int bsid) {
+    int i;
+    char *addr = (char*) 0x80000000;
+
+    if (get_bs(bsid, MAX_BS_PAGES) == SYSERR ||
+        xmmap(VA2VPNO(addr), bsid, MAX_BS_PAGES) == SYSERR) {
+        kprintf("killbench_task: could not map bs %d\n", bsid);
+        return;
+    }
+
+    // Dirty every page
+    for (i=0; i < MAX_BS_PAGES; i++)
+        *(addr + i*NBPG) = 'A' + (i % 26);
+
+    sleep(100);
+}
+
+void killbench() {
+    int i, pid;
+    int nidle = 10;
+    unsigned long t0, t1;
+    pgstat_t before, resident, after;
+
+    kprintf("\nkill latency benchmark\n");
+
+    // Some other processes so a scan of everybody's page tables
+    // would have something to scan
+    for (i=0; i < nidle; i++)
+        resume(create(killbench_idle, 2000, 20, "killbench_idle", 0, NULL));
+
+    pgstat(&before);
+    pid = create(killbench_task, 2000, 20, "killbench_task", 1, 3);
+    resume(pid);
+    sleep(1);
+    pgstat(&resident);
+
+    t0 = tsc_read();
+    kill(pid);
+    t1 = tsc_read();
+    pgstat(&after);
+
+    kprintf("killed proc with %d resident pages in %u cycles\n",
+            resident.nbs - before.nbs, t1 - t0);
+    if (after.nbs == before.nbs && after.npt == before.npt &&
+        after.npd == before.npd)
+        kprintf("killbench: frames released PASS!\n");
+    else
+        kprintf("killbench: frames released FAIL!\n");
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  frmbench (frame table scans, packed arrays vs one struct per frame)
+//////////////////////////////////////////////////////////////////////////
+
+// What frame_t looked like before the frame table was split
+typedef struct _frmbench_old_t {
+    int frmid, status, type, accessed, refcnt, age, pincnt;
+    struct _frmbench_old_t * fifo_next;
+    int bsid, bspage;
+    struct _frmbench_old_t * bs_next;
+} frmbench_old_t;
+
+void frmbench_run(int n) {
+    int i, r, victim, minage;
+    int nreps = 10;
+    unsigned long t0, told, tnew;
+    frmbench_old_t * old;
+    unsigned char  * status, * type, * age;
+    unsigned short * pincnt;
+
+    old    = (frmbench_old_t *) getmem(n * sizeof(frmbench_old_t));
+    status = (unsigned char *)  getmem(n);
+    type   = (unsigned char *)  getmem(n);
+    age    = (unsigned char *)  getmem(n);
+    pincnt = (unsigned short *) getmem(n * sizeof(unsigned short));
+    if ((int)old == SYSERR || (int)status == SYSERR || (int)type == SYSERR ||
+        (int)age == SYSERR || (int)pincnt == SYSERR) {
+        kprintf("frmbench: getmem failed for %d frames\n", n);
+        return;
+    }
+
+    // Same random table in both layouts, all frames in use
+    srand(n);
+    for (i=0; i < n; i++) {
+        old[i].status = status[i] = FRM_USED;
+        old[i].type   = type[i]   = (rand() % 8) ? FRM_BS : FRM_PT;
+        old[i].age    = age[i]    = rand() & 0xff;
+        old[i].pincnt = pincnt[i] = (rand() % 64) ? 0 : 1;
+    }
+
+    // Looking for a free frame, none to be found
+    t0 = tsc_read();
+    for (r=0; r < nreps; r++)
+        for (i=0; i < n && old[i].status != FRM_FREE; i++)
+            ;
+    told = tsc_read() - t0;
+
+    t0 = tsc_read();
+    for (r=0; r < nreps; r++)
+        for (i=0; i < n && status[i] != FRM_FREE; i++)
+            ;
+    tnew = tsc_read() - t0;
+
+    kprintf("%5d frames  free scan:  %8u cycles old, %8u cycles packed\n",
+            n, told / nreps, tnew / nreps);
+
+    // Picking an AGING victim
+    t0 = tsc_read();
+    for (r=0; r < nreps; r++) {
+        victim = -1; minage = 255;
+        for (i=0; i < n; i++)
+            if (old[i].type == FRM_BS && old[i].pincnt == 0 &&
+                old[i].age < minage) {
+                victim = i;
+                minage = old[i].age;
+            }
+    }
+    told = tsc_read() - t0;
+
+    t0 = tsc_read();
+    for (r=0; r < nreps; r++) {
+        victim = -1; minage = 255;
+        for (i=0; i < n; i++)
+            if (type[i] == FRM_BS && pincnt[i] == 0 && age[i] < minage) {
+                victim = i;
+                minage = age[i];
+            }
+    }
+    tnew = tsc_read() - t0;
+
+    kprintf("%5d frames  aging scan: %8u cycles old, %8u cycles packed"
+            " (victim %d)\n", n, told / nreps, tnew / nreps, victim);
+
+    freemem((struct mblock *)pincnt, n * sizeof(unsigned short));
+    freemem((struct mblock *)age, n);
+    freemem((struct mblock *)type, n);
+    freemem((struct mblock *)status, n);
+    freemem((struct mblock *)old, n * sizeof(frmbench_old_t));
+}
+
+void frmbench() {
+    kprintf("\nframe table scan benchmark (%d bytes per frame before,"
+            " %d hot + %d cold now)\n", sizeof(frmbench_old_t),
+            4*sizeof(char) + 2*sizeof(short) + sizeof(frm_idx_t),
+            sizeof(frame_t));
+
+    // The real table can't grow past 1024 frames (the backing stores
+    // start right after it) so both sizes are measured on copies.
+    frmbench_run(1024);
+    frmbench_run(16384);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  rdybench (ready list cost with lots of ready processes)
+//////////////////////////////////////////////////////////////////////////
+void rdybench_task() {
+    while (1)
+        ;
+}
+
+void rdybench_pingtask() {
+    while (1)
+        suspend(getpid());
+}
+
+void rdybench() {
+    int i, n, pid, prev, sorted;
+    int nprocs = 520;
+    int nreps = 1000;
+    int pids[NPROC];
+    unsigned long t0, t1;
+
+    kprintf("\nready list benchmark\n");
+
+    // All below main's priority so none of them ever runs, spread
+    // over priorities 1-19.
+    for (n=0; n < nprocs; n++) {
+        pid = create(rdybench_task, 1024, 1 + (n % 19), "rdybench", 0, NULL);
+        if (pid == SYSERR)
+            break;
+        pids[n] = pid;
+        resume(pid);
+    }
+    if (n < nprocs)
+        kprintf("only %d processes (NPROC is %d, set it to %d or more"
+                " in Configuration for the full run)\n", n, NPROC, nprocs + 8);
+
+    // Taking the highest priority ready process out and putting it
+    // back puts it at the end of the list: the old sorted insert
+    // walked all of it.
+    pid = pids[18];
+    t0 = tsc_read();
+    for (i=0; i < nreps; i++) {
+        suspend(pid);
+        resume(pid);
+    }
+    t1 = tsc_read();
+    kprintf("%d ready processes: %u cycles per suspend+resume\n",
+            n, (t1 - t0) / nreps);
+
+    // Switching to a higher priority process and back: main goes on
+    // the ready list (above everybody else) each time
+    pid = create(rdybench_pingtask, 1024, INITPRIO + 1, "rdyping", 0, NULL);
+    if (pid != SYSERR) {
+        t0 = tsc_read();
+        for (i=0; i < nreps; i++)
+            resume(pid);
+        t1 = tsc_read();
+        kprintf("%d ready processes: %u cycles per switch there and back\n",
+                n, (t1 - t0) / nreps);
+        kill(pid);
+    }
+
+    // The ready list must still be in priority order
+    sorted = 1;
+    prev = 0;
+    for (i = q[rdyhead].qnext; i != rdytail; i = q[i].qnext) {
+        if (q[i].qkey < prev)
+            sorted = 0;
+        prev = q[i].qkey;
+    }
+    if (sorted)
+        kprintf("rdybench: ready list ordered PASS!\n");
+    else
+        kprintf("rdybench: ready list ordered FAIL!\n");
+
+    for (i=0; i < n; i++)
+        kill(pids[i]);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  tmtest (timing wheel: kernel timers fire on their tick, cancel works)
+//////////////////////////////////////////////////////////////////////////
+#define TMTEST_N 1000
+
+extern unsigned long ctr1000;
+
+unsigned long * tmtest_fired;
+
+void tmtest_func(int i) {
+    tmtest_fired[i] = ctr1000;
+}
+
+void tmtest() {
+    struct tmentry * tm;
+    unsigned long * due;
+    unsigned long t0, t1;
+    int i, nbad, ntimers;
+    int pass = 1;
+
+    kprintf("\ntiming wheel test\n");
+
+    tm           = (struct tmentry *) getmem(TMTEST_N * sizeof(struct tmentry));
+    due          = (unsigned long *)  getmem(TMTEST_N * sizeof(unsigned long));
+    tmtest_fired = (unsigned long *)  getmem(TMTEST_N * sizeof(unsigned long));
+    if (tm == (struct tmentry *)SYSERR || due == (unsigned long *)SYSERR ||
+        tmtest_fired == (unsigned long *)SYSERR) {
+        kprintf("tmtest: out of memory\n");
+        return;
+    }
+
+    // Timeouts up to 20s land in levels 0 to 2 of the wheel. Every
+    // fourth timer is cancelled again.
+    srand(32);
+    for (i=0; i < TMTEST_N; i++) {
+        tmclear(&tm[i]);
+        tmtest_fired[i] = 0;
+        if (tmset(&tm[i], 1 + rand() % 20000, tmtest_func, i) == SYSERR)
+            pass = 0;
+        due[i] = tm[i].tm_expires;
+    }
+    for (i=0; i < TMTEST_N; i += 4)
+        if (tmcancel(&tm[i]) == SYSERR)
+            pass = 0;
+    if (tmcancel(&tm[0]) != SYSERR) // not armed any more
+        pass = 0;
+
+    sleep(21);
+
+    nbad = 0;
+    for (i=0; i < TMTEST_N; i++) {
+        if ((i % 4 == 0) ? tmtest_fired[i] != 0 : tmtest_fired[i] != due[i])
+            nbad++;
+        if (tmarmed(&tm[i]))
+            nbad++;
+    }
+    if (nbad)
+        kprintf("%d timers fired at the wrong tick or not at all\n", nbad);
+    if (pass && nbad == 0)
+        kprintf("tmtest: timers PASS!\n");
+    else
+        kprintf("tmtest: timers FAIL!\n");
+
+    // Arming and cancelling costs the same however many timers are
+    // armed: the delta list walked past all of them.
+    for (ntimers=1; ntimers <= TMTEST_N; ntimers *= 10) {
+        for (i=1; i < ntimers; i++)
+            tmset(&tm[i], 5000 + i, tmtest_func, i);
+        t0 = tsc_read();
+        for (i=0; i < 1000; i++) {
+            tmset(&tm[0], 6000, tmtest_func, 0);
+            tmcancel(&tm[0]);
+        }
+        t1 = tsc_read();
+        kprintf("%d timers armed: %u cycles per tmset+tmcancel\n",
+                ntimers, (t1 - t0) / 1000);
+        for (i=1; i < ntimers; i++)
+            tmcancel(&tm[i]);
+    }
+
+    freemem((struct mblock *)tm, TMTEST_N * sizeof(struct tmentry));
+    freemem((struct mblock *)due, TMTEST_N * sizeof(unsigned long));
+    freemem((struct mblock *)tmtest_fired, TMTEST_N * sizeof(unsigned long));
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  usleeptest (wakeup latency of short sleeps, idle clock interrupts)
+//////////////////////////////////////////////////////////////////////////
+unsigned long usleeptest_now() {
+#ifdef TICKLESS
+    return clknow();
+#else
+    return ctr1000 * 1000;
+#endif
+}
+
+void usleeptest() {
+    static int delays[] = { 100, 250, 1000, 2500, 10000 };
+    unsigned long t0, t1, late;
+    int i, n;
+
+    kprintf("\nusleep test\n");
+#ifndef TICKLESS
+    kprintf("(periodic clock: sleeps are whole ticks, compile with"
+            " TICKLESS for one-shot)\n");
+#endif
+
+    for (i=0; i < sizeof(delays)/sizeof(delays[0]); i++) {
+        t0 = usleeptest_now();
+        for (n=0; n < 20; n++)
+            usleep(delays[i]);
+        t1 = usleeptest_now();
+        late = (t1 - t0) / 20 - delays[i];
+        kprintf("usleep(%d): woke %d us late on average\n",
+                delays[i], (int) late);
+        if ((long) late < 0)
+            kprintf("usleeptest: usleep(%d) returned early FAIL!\n",
+                    delays[i]);
+    }
+
+#ifdef TICKLESS
+    // Nothing armed and only the null process left to run: the clock
+    // should only interrupt to keep the time base (every 50ms).
+    t0 = clkevents;
+    sleep(1);
+    t1 = clkevents;
+    kprintf("%d clock interrupts in 1s asleep (periodic clock: 1000)\n",
+            (int)(t1 - t0));
+    kprintf("ctr1000 %u ms, ctrusec/1000 %u ms\n",
+            ctr1000, ctrusec / 1000);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  schedbench (CPU split under the share based scheduling classes)
+//////////////////////////////////////////////////////////////////////////
+#define SCHEDBENCH_N 100
+
+volatile unsigned long schedbench_cnt[SCHEDBENCH_N];
+
+void schedbench_task(int i) {
+    volatile int j;
+
+    while (1) {
+        for (j=0; j < 1000; j++)
+            ;
+        schedbench_cnt[i]++;
+    }
+}
+
+void schedbench_run(int class, char * name, int nsecs) {
+    int pids[SCHEDBENCH_N];
+    unsigned long cnt[SCHEDBENCH_N];
+    unsigned long total, err, maxerr, sumerr;
+    int i, n, totrate;
+
+    // Priority 1, below main: under PRIOSCHED they only run while main
+    // sleeps and stop as soon as it wakes. Rates 1-5.
+    totrate = 0;
+    for (n=0; n < SCHEDBENCH_N; n++) {
+        pids[n] = create(schedbench_task, 1024, 1, "schedbench", 1, n);
+        if (pids[n] == SYSERR)
+            break;
+        setrate(pids[n], 1 + n % 5);
+        totrate += 1 + n % 5;
+        schedbench_cnt[n] = 0;
+        resume(pids[n]);
+    }
+
+    setschedclass(class);
+    sleep(nsecs);
+    setschedclass(PRIOSCHED);
+
+    total = 0;
+    for (i=0; i < n; i++)
+        total += (cnt[i] = schedbench_cnt[i]);
+    for (i=0; i < n; i++)
+        kill(pids[i]);
+
+    // Error of each process's CPU share against its rate's share of
+    // all rates, in hundredths of a percent (PRIOSCHED ignores rates
+    // and is measured against an equal split).
+    maxerr = sumerr = 0;
+    for (i=0; total > 0 && i < n; i++) {
+        if (class == PRIOSCHED)
+            err = cnt[i] * 10000 / total - 10000 / n;
+        else
+            err = cnt[i] * 10000 / total - (1 + i % 5) * 10000 / totrate;
+        if ((long) err < 0)
+            err = -err;
+        sumerr += err;
+        if (err > maxerr)
+            maxerr = err;
+    }
+    kprintf("%-17s %d procs: %u loops/s, share error max %u.%02u%%"
+            " mean %u.%02u%%\n", name, n, total / nsecs,
+            maxerr / 100, maxerr % 100,
+            (n ? sumerr / n : 0) / 100, (n ? sumerr / n : 0) % 100);
+}
+
+void schedbench() {
+    kprintf("\nscheduling class benchmark\n");
+    if (NPROC < SCHEDBENCH_N + 8)
+        kprintf("(NPROC is %d, set it to %d or more in Configuration"
+                " for all %d processes)\n", NPROC, SCHEDBENCH_N + 8,
+                SCHEDBENCH_N);
+
+    schedbench_run(PRIOSCHED, "PRIOSCHED", 5);
+    schedbench_run(RANDOMSCHED, "RANDOMSCHED", 5);
+    schedbench_run(PROPORTIONALSHARE, "PROPORTIONALSHARE", 5);
+}
+
 /*------------------------------------------------------------------------
  *  main  --  user main program
  *------------------------------------------------------------------------
  */
+//////////////////////////////////////////////////////////////////////////
+//  pdtest (shared kernel page directory, private one on first mapping)
+//////////////////////////////////////////////////////////////////////////
+#ifndef VSTACK
+void pdtest_task() {
+    while (1)
+        suspend(getpid());
+}
+
+void pdtest_maptask(int bsid) {
+    char *addr = (char*) 0x40000000;
+    pgstat_t st;
+
+    if (proctab[currpid].pd != kernpd)
+        kprintf("pdtest: shared directory before xmmap FAIL!\n");
+
+    if (get_bs(bsid, 10) == SYSERR ||
+        xmmap(VA2VPNO(addr), bsid, 10) == SYSERR) {
+        kprintf("pdtest_maptask: could not map bs %d\n", bsid);
+        return;
+    }
+    *addr = 'A';
+    pgstat(&st);
+
+    if (proctab[currpid].pd != kernpd && *addr == 'A' && st.npd == 2)
+        kprintf("pdtest: private directory after xmmap PASS!\n");
+    else
+        kprintf("pdtest: private directory after xmmap FAIL!\n");
+
+    xmunmap(VA2VPNO(addr));
+    release_bs(bsid);
+}
+
+void pdtest() {
+    int i, n, pid;
+    int nprocs = 20;
+    int nreps = 1000;
+    int pids[NPROC];
+    unsigned long t0, t1;
+    pgstat_t before, after;
+
+    kprintf("\npage directory test\n");
+
+    // Creating processes takes no frames
+    pgstat(&before);
+    for (n=0; n < nprocs; n++) {
+        pids[n] = create(pdtest_task, 1024, 1, "pdtest", 0, NULL);
+        if (pids[n] == SYSERR)
+            break;
+    }
+    pgstat(&after);
+    if (after.npd == before.npd)
+        kprintf("pdtest: %d processes, no new directories PASS!\n", n);
+    else
+        kprintf("pdtest: %d processes, %d new directories FAIL!\n",
+                n, after.npd - before.npd);
+    for (i=0; i < n; i++)
+        kill(pids[i]);
+
+    // The first mapping gets a process its own directory, which
+    // goes away with it
+    pgstat(&before);
+    pid = create(pdtest_maptask, 2000, INITPRIO + 1, "pdtest_map", 1, 4);
+    resume(pid);
+    pgstat(&after);
+    if (after.npd == before.npd && after.npt == before.npt)
+        kprintf("pdtest: frames released PASS!\n");
+    else
+        kprintf("pdtest: frames released FAIL!\n");
+
+    // Switching between two processes on the shared directory
+    // doesn't reload CR3
+    pid = create(pdtest_task, 1024, INITPRIO + 1, "pdtest_ping", 0, NULL);
+    if (pid != SYSERR) {
+        t0 = tsc_read();
+        for (i=0; i < nreps; i++)
+            resume(pid);
+        t1 = tsc_read();
+        kprintf("%u cycles per switch there and back\n",
+                (t1 - t0) / nreps);
+        kill(pid);
+    }
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+//  invbench (priority inversion: semaphore vs mutex with inheritance)
+//////////////////////////////////////////////////////////////////////////
+#define INVBENCH_HOLDMS 2    // low priority critical section
+#define INVBENCH_HOGMS  50   // medium priority CPU hog
+
+int (*invbench_lock)(int);
+int (*invbench_unlock)(int);
+
+void invbench_spin(int ms) {
+    unsigned long end = ctr1000 + ms;
+
+    while ((long)(ctr1000 - end) < 0)
+        ;
+}
+
+void invbench_low(int lock) {
+    (*invbench_lock)(lock);
+    invbench_spin(INVBENCH_HOLDMS);
+    (*invbench_unlock)(lock);
+}
+
+void invbench_medium() {
+    invbench_spin(INVBENCH_HOGMS);
+}
+
+void invbench_high(int lock, int parent) {
+    unsigned long t0, t1;
+
+    t0 = tsc_read();
+    (*invbench_lock)(lock);
+    t1 = tsc_read();
+    (*invbench_unlock)(lock);
+    send(parent, t1 - t0);
+}
+
+void invbench_run(int usemutex, char * name) {
+    int i, lock;
+    int nrounds = 10;
+    unsigned long lat, worst = 0, total = 0;
+    unsigned long ms0, msworst = 0;
+
+    if (usemutex) {
+        lock = mcreate();
+        invbench_lock = mlock;
+        invbench_unlock = munlock;
+    } else {
+        lock = screate(1);
+        invbench_lock = wait;
+        invbench_unlock = signal;
+    }
+
+    for (i=0; i < nrounds; i++) {
+        recvclr();
+
+        // The low priority process gets the lock while we sleep, then
+        // the high priority one asks for it with a medium priority
+        // one ready to hog the CPU
+        resume(create(invbench_low, 2000, 10, "invlow", 1, lock));
+        usleep(1000);
+        ms0 = ctr1000;
+        resume(create(invbench_medium, 2000, 20, "invmed", 0, NULL));
+        resume(create(invbench_high, 2000, 30, "invhigh", 2, lock, currpid));
+        lat = receive();
+        if (ctr1000 - ms0 > msworst)
+            msworst = ctr1000 - ms0;
+
+        total += lat;
+        if (lat > worst)
+            worst = lat;
+        usleep(100000); // let the others finish
+    }
+
+    kprintf("%s: worst %u cycles (about %u ms), mean %u cycles\n",
+            name, worst, msworst, total / nrounds);
+
+    if (usemutex)
+        mdelete(lock);
+    else
+        sdelete(lock);
+}
+
+void invbench() {
+    int oldprio;
+
+    kprintf("\npriority inversion benchmark\n");
+    kprintf("low holds the lock %d ms, medium hogs the CPU %d ms\n",
+            INVBENCH_HOLDMS, INVBENCH_HOGMS);
+
+    // Above everybody so we get to start them all
+    oldprio = chprio(currpid, 40);
+    invbench_run(0, "semaphore");
+    invbench_run(1, "mutex");
+    chprio(currpid, oldprio);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  msgbench (message throughput: mailbox vs queue vs batched queue)
+//////////////////////////////////////////////////////////////////////////
+#define MSGBENCH_N     20000
+#define MSGBENCH_DEPTH 64
+#define MSGBENCH_BATCH 16
+
+void msgbench_consumer(int mode, int parent) {
+    int i, n, bad = 0;
+    WORD buf[MSGBENCH_BATCH];
+
+    if (mode != 0)
+        msgqinit(MSGBENCH_DEPTH);
+    send(parent, OK);   // ready
+
+    for (i=0; i < MSGBENCH_N; i += n) {
+        if (mode == 2)
+            n = receiven(buf, MSGBENCH_BATCH);
+        else {
+            buf[0] = receive();
+            n = 1;
+        }
+        if (buf[n-1] != i + n - 1)
+            bad++;
+    }
+    send(parent, bad);
+}
+
+void msgbench_run(int mode, char * name) {
+    int i, n, cpid, bad;
+    WORD buf[MSGBENCH_BATCH];
+    unsigned long t0, t1, ms0, ms;
+
+    recvclr();
+    cpid = create(msgbench_consumer, 2000, getprio(currpid), "msgcons",
+                  2, mode, currpid);
+    resume(cpid);
+    receive();
+
+    t0 = tsc_read();
+    ms0 = ctr1000;
+    for (i=0; i < MSGBENCH_N; ) {
+        switch (mode) {
+        case 0:     // the mailbox: try again until the consumer took it
+            while (send(cpid, i) == SYSERR)
+                sleep(0);
+            i++;
+            break;
+        case 1:
+            sendb(cpid, i++);
+            break;
+        case 2:
+            for (n=0; n < MSGBENCH_BATCH; n++)
+                buf[n] = i + n;
+            n = sendn(cpid, buf, MSGBENCH_BATCH);
+            if (n == 0)
+                sleep(0);
+            i += n;
+            break;
+        }
+    }
+    bad = receive();
+    t1 = tsc_read();
+    ms = ctr1000 - ms0;
+
+    kprintf("%s: %u cycles per message, %u messages/s%s\n", name,
+            (t1 - t0) / MSGBENCH_N, ms ? MSGBENCH_N * 1000 / ms : 0,
+            bad ? " (out of order!)" : "");
+}
+
+void msgbench() {
+    kprintf("\nmessage benchmark, %d messages\n", MSGBENCH_N);
+    msgbench_run(0, "mailbox send/receive");
+    msgbench_run(1, "queue sendb/receive");
+    msgbench_run(2, "queue sendn/receiven");
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  gpqbench (generic priority queues: heap/ring vs the old sorted array)
+//////////////////////////////////////////////////////////////////////////
+
+// What enq/deq did before: keep the array sorted, shift on both
+void gpqbench_old_enq(int * keys, char ** elts, int * count, char * elt,
+                      int key) {
+    int i, j;
+
+    i = *count - 1;
+    while (i >= 0 && key > keys[i])
+        --i;
+    for (j = *count - 1; j > i; --j) {
+        keys[j+1] = keys[j];
+        elts[j+1] = elts[j];
+    }
+    keys[i+1] = key;
+    elts[i+1] = elt;
+    (*count)++;
+}
+
+char * gpqbench_old_deq(int * keys, char ** elts, int * count) {
+    char * elt = elts[0];
+    int i;
+
+    for (i=1; i < *count; ++i) {
+        elts[i-1] = elts[i];
+        keys[i-1] = keys[i];
+    }
+    (*count)--;
+    return elt;
+}
+
+void gpqbench_run(int n, int nkeys) {
+    int i, q, count;
+    int nreps = 2000;
+    int * keys;
+    char ** elts;
+    unsigned long t0, told, tnew;
+
+    keys = (int *) getmem(n * sizeof(int));
+    elts = (char **) getmem(n * sizeof(char *));
+    q = newq(n, QF_NOWAIT);
+    if ((int)keys == SYSERR || (int)elts == SYSERR || q < 0) {
+        kprintf("gpqbench: could not get queues of %d\n", n);
+        return;
+    }
+
+    // Both kept one short of full, then one deq and one enq per rep
+    srand(n);
+    count = 0;
+    for (i=0; i < n - 1; i++) {
+        gpqbench_old_enq(keys, elts, &count, (char *) i, rand() % nkeys);
+        enq(q, (char *) i, rand() % nkeys);
+    }
+
+    t0 = tsc_read();
+    for (i=0; i < nreps; i++) {
+        gpqbench_old_deq(keys, elts, &count);
+        gpqbench_old_enq(keys, elts, &count, (char *) i, rand() % nkeys);
+    }
+    told = tsc_read() - t0;
+
+    t0 = tsc_read();
+    for (i=0; i < nreps; i++) {
+        deq(q);
+        enq(q, (char *) i, rand() % nkeys);
+    }
+    tnew = tsc_read() - t0;
+
+    kprintf("%5d items, %s keys: %8u cycles old, %6u new per deq+enq\n",
+            n, nkeys == 1 ? "equal " : "random", told / nreps,
+            tnew / nreps);
+
+    while (deq(q) != NULL)
+        ;
+    freeq(q);
+    freemem((struct mblock *) keys, n * sizeof(int));
+    freemem((struct mblock *) elts, n * sizeof(char *));
+}
+
+void gpqbench() {
+    int n;
+
+    kprintf("\ngeneric priority queue benchmark\n");
+    for (n=16; n <= 4096; n *= 4) {
+        gpqbench_run(n, 1000);
+        gpqbench_run(n, 1);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  waitanybench (one server, several event sources: waitany vs helpers)
+//////////////////////////////////////////////////////////////////////////
+#define WAITANY_NSRC 4
+#define WAITANY_N    5000
+
+int waitany_pending[WAITANY_NSRC];
+
+void waitany_source(int sem, int n) {
+    while (n-- > 0)
+        signal(sem);
+}
+
+// The old way: one helper per source waits for it, notes where the
+// event came from and passes it on to a single semaphore
+void waitany_helper(int sem, int all, int i) {
+    STATWORD ps;
+
+    for (;;) {
+        wait(sem);
+        disable(ps);
+        waitany_pending[i]++;
+        restore(ps);
+        signal(all);
+    }
+}
+
+void waitany_run(int helpers) {
+    STATWORD ps;
+    int sems[WAITANY_NSRC], got[WAITANY_NSRC], hpid[WAITANY_NSRC];
+    int i, s, r, all = 0, bad = 0;
+    unsigned long t0, t1;
+
+    for (i=0; i < WAITANY_NSRC; i++) {
+        sems[i] = screate(0);
+        got[i] = 0;
+        waitany_pending[i] = 0;
+    }
+    if (helpers) {
+        all = screate(0);
+        for (i=0; i < WAITANY_NSRC; i++) {
+            hpid[i] = create(waitany_helper, 2000, getprio(currpid) + 1,
+                             "wahelp", 3, sems[i], all, i);
+            resume(hpid[i]);
+        }
+    }
+    for (i=0; i < WAITANY_NSRC; i++)
+        resume(create(waitany_source, 2000, getprio(currpid) - 1,
+                      "wasrc", 2, sems[i], WAITANY_N));
+
+    t0 = tsc_read();
+    for (i=0; i < WAITANY_NSRC * WAITANY_N; i++) {
+        if (helpers) {
+            wait(all);
+            disable(ps);
+            for (s=0; s < WAITANY_NSRC && waitany_pending[s] == 0; s++)
+                ;
+            if (s < WAITANY_NSRC)
+                waitany_pending[s]--;
+            restore(ps);
+        } else {
+            r = waitany(sems, WAITANY_NSRC);
+            for (s=0; s < WAITANY_NSRC && sems[s] != r; s++)
+                ;
+        }
+        if (s == WAITANY_NSRC)
+            bad++;
+        else
+            got[s]++;
+    }
+    t1 = tsc_read();
+
+    for (i=0; i < WAITANY_NSRC; i++) {
+        if (got[i] != WAITANY_N || scount(sems[i]) != 0)
+            bad++;
+        if (helpers)
+            kill(hpid[i]);
+        sdelete(sems[i]);
+    }
+    if (helpers)
+        sdelete(all);
+    kprintf("%s: %u cycles per event%s\n",
+            helpers ? "helper processes" : "waitany",
+            (t1 - t0) / (WAITANY_NSRC * WAITANY_N), bad ? " (wrong!)" : "");
+}
+
+void waitanybench() {
+    int sems[2];
+
+    kprintf("\nwaitany benchmark, %d sources of %d events\n",
+            WAITANY_NSRC, WAITANY_N);
+    waitany_run(0);
+    waitany_run(1);
+
+    // sdelete() wakes a waitany() caller with SYSERR and leaves the
+    // other semaphore as it was
+    sems[0] = screate(0);
+    sems[1] = screate(0);
+    resume(create(sdelete, 2000, getprio(currpid) - 1, "wadel", 1,
+                  sems[1]));
+    kprintf("waitany on a deleted semaphore: %s\n",
+            waitany(sems, 2) == SYSERR && scount(sems[0]) == 0 ?
+            "ok" : "wrong!");
+    sdelete(sems[0]);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  serbench (serial output: a putc per byte vs one write)
+//////////////////////////////////////////////////////////////////////////
+#define SERBENCH_N 2048
+
+unsigned long serbench_spins;
+
+// Runs whenever the writer is blocked; what it doesn't get is the
+// CPU time the output took
+void serbench_spin() {
+    for (;;)
+        serbench_spins++;
+}
+
+void serbench_run(int bulk, unsigned long spinsperms,
+                  unsigned long cycperms) {
+    char buf[64];
+    int i, n;
+    unsigned long ms0, ms, busy;
+
+    for (i=0; i < sizeof(buf); i++)
+        buf[i] = (i == sizeof(buf) - 1) ? '\n' : 'a' + i % 26;
+    while (comtab[0].com_count)     // start with it drained
+        usleep(1000);
+
+    serbench_spins = 0;
+    ms0 = ctr1000;
+    for (n=0; n < SERBENCH_N; n += sizeof(buf)) {
+        if (bulk)
+            write(SERIAL0, buf, sizeof(buf));
+        else
+            for (i=0; i < sizeof(buf); i++)
+                putc(SERIAL0, buf[i]);
+    }
+    while (comtab[0].com_count)
+        usleep(1000);
+    ms = ctr1000 - ms0;
+
+    busy = ms - serbench_spins / spinsperms;
+    if (busy > ms)
+        busy = 0;
+    kprintf("%s: %u bytes/s, %u cycles of CPU per byte\n",
+            bulk ? "write()" : "putc() per byte",
+            ms ? SERBENCH_N * 1000 / ms : 0, busy * (cycperms / SERBENCH_N));
+}
+
+void serbench() {
+    int pid;
+    unsigned long t0, spinsperms, cycperms;
+
+    kprintf("\nserial output benchmark, %d bytes to SERIAL0, %s FIFO\n",
+            SERBENCH_N, comtab[0].com_txfifo > 1 ? "16550A" : "no");
+    pid = create(serbench_spin, 2000, getprio(currpid) - 1, "serspin", 0, NULL);
+    resume(pid);
+
+    serbench_spins = 0;             // how fast it spins alone
+    t0 = tsc_read();
+    usleep(100000);
+    cycperms = (tsc_read() - t0) / 100;
+    spinsperms = serbench_spins / 100;
+    if (spinsperms == 0)
+        spinsperms = 1;
+
+    serbench_run(0, spinsperms, cycperms);
+    serbench_run(1, spinsperms, cycperms);
+    kill(pid);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  rxbench (serial receive: interrupts per KB at each rx FIFO trigger)
+//////////////////////////////////////////////////////////////////////////
+#define RXBENCH_N 1024
+
+// SERIAL1 is put in loopback, so what it sends it receives; no tty is
+// attached to it, so the bytes are counted and dropped
+void rxbench() {
+    static int trig[] = { 1, 4, 8, 14 };
+    struct comstats cs;
+    char buf[64];
+    int csr = devtab[SERIAL1].dvcsr;
+    int i, n;
+
+    kprintf("\nserial receive benchmark, %d bytes looped back on SERIAL1\n",
+            RXBENCH_N);
+    if (comtab[1].com_fcr == 0) {
+        kprintf("no 16550A FIFO\n");
+        return;
+    }
+    for (i=0; i < sizeof(buf); i++)
+        buf[i] = 'a' + i % 26;
+    outb(csr + UART_MCR, UART_MCR_LOOP | UART_MCR_OUT2);
+
+    for (i=0; i < sizeof(trig) / sizeof(trig[0]); i++) {
+        control(SERIAL1, COMC_RXTRIG, trig[i], 0);
+        control(SERIAL1, COMC_STATS, (int) &cs, 0);
+        for (n=0; n < RXBENCH_N; n += sizeof(buf))
+            write(SERIAL1, buf, sizeof(buf));
+        while (comtab[1].com_count)
+            usleep(1000);
+        usleep(20000);              // rx FIFO timeout, last bytes
+        control(SERIAL1, COMC_STATS, (int) &cs, 0);
+        kprintf("trigger %2d: %u bytes in, %u interrupts per KB "
+                "(tx and rx), %u overruns\n", trig[i], cs.cs_rxbytes,
+                cs.cs_rxbytes ? cs.cs_ints * 1024 / cs.cs_rxbytes : 0,
+                cs.cs_overruns);
+    }
+
+    control(SERIAL1, COMC_RXTRIG, 8, 0);
+    outb(csr + UART_MCR, UART_MCR_DTR | UART_MCR_RTS | UART_MCR_OUT2);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  klogbench (cost to the caller: kprintf vs klog)
+//////////////////////////////////////////////////////////////////////////
+#define KLOGBENCH_N 32
+
+void klogbench() {
+    unsigned long t0, tk, tl, d0;
+    int i;
+
+    kprintf("\nkernel log benchmark, %d messages each\n", KLOGBENCH_N);
+
+    t0 = tsc_read();
+    for (i=0; i < KLOGBENCH_N; i++)
+        kprintf("_frm_evict(): Evicting frame %d\n", i);
+    tk = (tsc_read() - t0) / KLOGBENCH_N;
+
+    t0 = tsc_read();
+    for (i=0; i < KLOGBENCH_N; i++)
+        klog(KL_INFO, "_frm_evict(): Evicting frame %d\n", i);
+    tl = (tsc_read() - t0) / KLOGBENCH_N;
+    sleep(2);                       // klogd writes them out now
+
+    kprintf("kprintf: %u cycles per message\n", tk);
+    kprintf("klog:    %u cycles per message\n", tl);
+
+    // a burst bigger than the ring: the rest is dropped and counted
+    d0 = kldrops;
+    for (i=0; i < KLOGSZ / 16; i++)
+        klog(KL_INFO, "burst %d\n", i);
+    klog(KL_DEBUG, "not kept unless klevel is KL_DEBUG\n");
+    kprintf("burst of %d: %u dropped\n", KLOGSZ / 16, kldrops - d0);
+    klflush();
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  tracetest (event tracing: cost per tracepoint, dump of a short run)
+//////////////////////////////////////////////////////////////////////////
+#define TRACETEST_N 1000
+
+int tracetest_sem1, tracetest_sem2;
+
+void tracetest_pong() {
+    while (1) {
+        wait(tracetest_sem1);
+        signal(tracetest_sem2);
+    }
+}
+
+void tracetest() {
+    unsigned long t0, toff, ton;
+    int i, pid, sem;
+
+    kprintf("\ntrace test\n");
+
+    if (settrace(0x10000) != SYSERR)
+        kprintf("tracetest: bad mask accepted FAIL!\n");
+
+    // A signal/wait pair on a semaphore that never blocks, with TRC_SEM
+    // off and then on: the difference is what two records cost.
+    sem = screate(0);
+    t0 = tsc_read();
+    for (i=0; i < TRACETEST_N; i++) {
+        signal(sem);
+        wait(sem);
+    }
+    toff = (tsc_read() - t0) / TRACETEST_N;
+    settrace(TRC_SEM);
+    t0 = tsc_read();
+    for (i=0; i < TRACETEST_N; i++) {
+        signal(sem);
+        wait(sem);
+    }
+    ton = (tsc_read() - t0) / TRACETEST_N;
+    settrace(0);
+    sdelete(sem);
+    kprintf("signal+wait: %u cycles untraced, %u traced\n", toff, ton);
+
+    // A short run with everything on: ping-pong with another process
+    // and a sleep, with clock interrupts in between.
+    tracetest_sem1 = screate(0);
+    tracetest_sem2 = screate(0);
+    pid = create(tracetest_pong, 2000, 20, "tracepong", 0, NULL);
+    resume(pid);
+    settrace(TRC_ALL);
+    for (i=0; i < 5; i++) {
+        signal(tracetest_sem1);
+        wait(tracetest_sem2);
+    }
+    sleep10(1);
+    settrace(0);
+    kill(pid);
+    sdelete(tracetest_sem1);
+    sdelete(tracetest_sem2);
+
+    // the console log can be given to tools/tracedec as it is
+    tracedump(TRD_CONSOLE);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  ttytest (buffered tty output: flush points, cost per character)
+//////////////////////////////////////////////////////////////////////////
+#define TTYTEST_N 2048
+
+void ttytest() {
+    struct tty * ptty = (struct tty *) devtab[CONSOLE].dvioblk;
+    unsigned long t0, t1;
+    int i, pass = 1;
+
+    kprintf("\ntty output test\n");
+    while (ptty->tty_ocount || comtab[0].com_count)
+        usleep(1000);
+
+    // held until the newline, then all of it goes
+    write(CONSOLE, "buffered ", 9);
+    if (ptty->tty_ocount != 9 || ptty->tty_oready != 0)
+        pass = 0;
+    write(CONSOLE, "line\n", 5);
+    if (ptty->tty_ocount != 0)
+        pass = 0;
+
+    // TTC_SYNC sends a partial line out at once
+    write(CONSOLE, "sync: ", 6);
+    control(CONSOLE, TTC_SYNC, 1);
+    if (ptty->tty_ocount != 0)
+        pass = 0;
+    write(CONSOLE, "polled\n", 7);
+    control(CONSOLE, TTC_SYNC, 0);
+
+    // 8-bit characters become M-x in the ring
+    write(CONSOLE, "\xe1\n", 2);
+
+    kprintf("ttytest: flush on newline and TTC_SYNC %s\n",
+            pass ? "PASS!" : "FAIL!");
+
+    // putc() a character at a time, lines of 64: the driver is only
+    // entered once per line
+    t0 = tsc_read();
+    for (i=0; i < TTYTEST_N; i++)
+        putc(CONSOLE, (i % 64 == 63) ? '\n' : 'a' + i % 26);
+    t1 = tsc_read();
+    while (ptty->tty_ocount || comtab[0].com_count)
+        usleep(1000);
+    kprintf("putc(CONSOLE): %u cycles per character\n",
+            (t1 - t0) / TTYTEST_N);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  cksumtest (monitor checksum routines: against a plain 16-bit sum,
+//             cycles per full-size TFTP block)
+//////////////////////////////////////////////////////////////////////////
+#define CKSUMTEST_N   2000
+#define CKSUMTEST_LEN 1468      // TFTP_BLKSIZE
+#define CKSUMTEST_RUN 200
+
+extern unsigned short mon_cksum();
+extern unsigned long mon_cksum_add(void *buf, int len, unsigned long sum);
+extern unsigned long mon_cksum_copy(void *dst, void *src, int len,
+                                    unsigned long sum);
+extern unsigned long mon_cksum_mmx(void *buf, int len, unsigned long sum);
+extern int mon_hasmmx();
+
+unsigned char cksumtest_src[2048], cksumtest_dst[2048];
+
+// 16 bits at a time, as mon_udpcksum used to
+unsigned long cksumtest_ref(unsigned char *buf, int len) {
+    unsigned long sum = 0;
+    int i;
+
+    for (i=0; i+1 < len; i += 2)
+        sum += *(unsigned short *) (buf + i);
+    if (len & 1)
+        sum += buf[len-1];
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return sum;
+}
+
+void cksumtest() {
+    unsigned long t0, tref, tadd, tmmx, tsep, tcopy, ref, sum;
+    unsigned char *src, *dst;
+    int i, j, len, half, mmx, bad = 0;
+
+    kprintf("\nchecksum test\n");
+    mmx = mon_hasmmx();
+
+    // random lengths and alignments; every 8th buffer all ones, for
+    // the longest carry chains. 0 and 0xffff are the same sum.
+    srand(48);
+    for (i=0; i < CKSUMTEST_N; i++) {
+        src = cksumtest_src + rand() % 4;
+        dst = cksumtest_dst + rand() % 4;
+        len = rand() % (CKSUMTEST_LEN + 64);
+        for (j=0; j < len; j++)
+            src[j] = (i % 8 == 0) ? 0xff : rand();
+        ref = cksumtest_ref(src, len);
+
+        if (mon_cksum_add(src, len, 0) % 0xffff != ref % 0xffff)
+            bad++;
+        if ((unsigned short) ~mon_cksum(src, len) % 0xffff != ref % 0xffff)
+            bad++;
+        if (mmx && mon_cksum_mmx(src, len, 0) % 0xffff != ref % 0xffff)
+            bad++;
+        half = (rand() % (len / 2 + 1)) * 2;    // even-length first part
+        sum = mon_cksum_add(src, half, 0);
+        sum = mon_cksum_copy(dst + half, src + half, len - half, sum);
+        if (sum % 0xffff != ref % 0xffff ||
+            !blkequ(dst + half, src + half, len - half))
+            bad++;
+    }
+    kprintf("cksumtest: %d buffers, MMX %s: %s\n", CKSUMTEST_N,
+            mmx ? "tested" : "not present", bad ? "FAIL!" : "PASS!");
+
+    // one full-size block, as it comes in on the TFTP receive path
+    for (j=0; j < CKSUMTEST_LEN; j++)
+        cksumtest_src[j] = rand();
+    t0 = tsc_read();
+    for (i=0; i < CKSUMTEST_RUN; i++)
+        cksumtest_ref(cksumtest_src, CKSUMTEST_LEN);
+    tref = (tsc_read() - t0) / CKSUMTEST_RUN;
+    t0 = tsc_read();
+    for (i=0; i < CKSUMTEST_RUN; i++)
+        mon_cksum_add(cksumtest_src, CKSUMTEST_LEN, 0);
+    tadd = (tsc_read() - t0) / CKSUMTEST_RUN;
+    tmmx = 0;
+    if (mmx) {
+        t0 = tsc_read();
+        for (i=0; i < CKSUMTEST_RUN; i++)
+            mon_cksum_mmx(cksumtest_src, CKSUMTEST_LEN, 0);
+        tmmx = (tsc_read() - t0) / CKSUMTEST_RUN;
+    }
+    t0 = tsc_read();
+    for (i=0; i < CKSUMTEST_RUN; i++) {
+        mon_cksum_add(cksumtest_src, CKSUMTEST_LEN, 0);
+        blkcopy(cksumtest_dst, cksumtest_src, CKSUMTEST_LEN);
+    }
+    tsep = (tsc_read() - t0) / CKSUMTEST_RUN;
+    t0 = tsc_read();
+    for (i=0; i < CKSUMTEST_RUN; i++)
+        mon_cksum_copy(cksumtest_dst, cksumtest_src, CKSUMTEST_LEN, 0);
+    tcopy = (tsc_read() - t0) / CKSUMTEST_RUN;
+
+    kprintf("%d octets: 16-bit C %u cycles, adc %u, MMX %u\n",
+            CKSUMTEST_LEN, tref, tadd, tmmx);
+    kprintf("sum then blkcopy %u cycles, mon_cksum_copy %u\n", tsep, tcopy);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  udptest (kernel UDP sockets against tools/udpecho on the host, which
+//           QEMU user networking puts at 10.0.2.2: round trips, windowed
+//           throughput through read/write and through the zero-copy
+//           buffers, and a reply big enough to come back in fragments)
+//////////////////////////////////////////////////////////////////////////
+#define UDPTEST_PEER  "10.0.2.2:7777"
+#define UDPTEST_RTT   200
+#define UDPTEST_SMALL 64
+#define UDPTEST_N     2000
+#define UDPTEST_WIN   8
+#define UDPTEST_BIG   8000
+
+char udptest_out[U_MAXDATA], udptest_in[UDPTEST_BIG];
+
+// UDPTEST_N full datagrams, UDPTEST_WIN of them in flight; returns the
+// number that came back
+int udptest_window(int dev, int zcopy) {
+    struct ep *pep;
+    char *data;
+    int sent, got, n;
+
+    for (sent = got = 0; got < UDPTEST_N; ) {
+        if (sent < UDPTEST_N && sent - got < UDPTEST_WIN) {
+            if (zcopy) {
+                // fill the buffer in place; the driver sends it as is
+                if ((pep = netgetbuf()) == NULL) {
+                    sleep10(1);
+                    continue;
+                }
+                blkcopy(UDP_DATA(pep), udptest_out, U_MAXDATA);
+                control(dev, UDPC_SEND, (int) pep, U_MAXDATA);
+            } else
+                write(dev, udptest_out, U_MAXDATA);
+            sent++;
+            continue;
+        }
+        if (zcopy) {
+            n = control(dev, UDPC_RECV, (int) &pep, (int) &data);
+            if (n > 0)
+                freebuf(pep);
+        } else
+            n = read(dev, udptest_in, U_MAXDATA);
+        if (n == TIMEOUT)
+            break;              // lost some: the window will not refill
+        got++;
+    }
+    return got;
+}
+
+void udptest() {
+    unsigned long t0, ms;
+    int dev, i, n, got, bad = 0, lost = 0;
+
+    kprintf("\nUDP test\n");
+    if (nif.ni_state != NIS_UP) {
+        kprintf("udptest: no network interface\n");
+        return;
+    }
+    if ((dev = open(UDP0, (int) UDPTEST_PEER, 0)) == SYSERR) {
+        kprintf("udptest: cannot open UDP0\n");
+        return;
+    }
+    control(dev, UDPC_TIMEOUT, 1000, 0);
+
+    // round trips; the first one also resolves the gateway
+    for (i=0; i < U_MAXDATA; i++)
+        udptest_out[i] = i * 7;
+    t0 = tsc_read();
+    ms = ctr1000;
+    for (i=0; i < UDPTEST_RTT; i++) {
+        udptest_out[0] = i;
+        write(dev, udptest_out, UDPTEST_SMALL);
+        n = read(dev, udptest_in, sizeof(udptest_in));
+        if (n == TIMEOUT) {
+            lost++;
+            continue;
+        }
+        if (n != UDPTEST_SMALL || !blkequ(udptest_in, udptest_out, n))
+            bad++;
+    }
+    if (lost == UDPTEST_RTT) {
+        kprintf("udptest: no answer from %s (is tools/udpecho running?)\n",
+                UDPTEST_PEER);
+        close(dev);
+        return;
+    }
+    kprintf("udptest: %d round trips of %d octets, %d lost: %s\n",
+            UDPTEST_RTT, UDPTEST_SMALL, lost, bad ? "FAIL!" : "PASS!");
+    kprintf("%u cycles, %u ms per round trip\n",
+            (tsc_read() - t0) / UDPTEST_RTT, (ctr1000 - ms) / UDPTEST_RTT);
+
+    ms = ctr1000;
+    got = udptest_window(dev, 0);
+    ms = ctr1000 - ms + 1;
+    kprintf("read/write: %d of %d datagrams of %d octets, %u KB/s\n",
+            got, UDPTEST_N, U_MAXDATA, got * U_MAXDATA / ms);
+    ms = ctr1000;
+    got = udptest_window(dev, 1);
+    ms = ctr1000 - ms + 1;
+    kprintf("zero-copy:  %d of %d datagrams of %d octets, %u KB/s\n",
+            got, UDPTEST_N, U_MAXDATA, got * U_MAXDATA / ms);
+
+    // "#n" asks udpecho for n octets of i & 0xff back, which arrive as
+    // fragments and are put together by ipreass
+    sprintf(udptest_out, "#%d", UDPTEST_BIG);
+    write(dev, udptest_out, strlen(udptest_out) + 1);
+    n = read(dev, udptest_in, sizeof(udptest_in));
+    for (i=0, bad = (n != UDPTEST_BIG); i < n && !bad; i++)
+        if ((unsigned char) udptest_in[i] != (i & 0xff))
+            bad++;
+    kprintf("reassembly: %d octet reply, %d expected: %s\n",
+            n, UDPTEST_BIG, bad ? "FAIL!" : "PASS!");
+    kprintf("socket drops %d, interface in %u/%u dropped, out %u/%u\n",
+            control(dev, UDPC_DROPS, 0, 0), nif.ni_idrops, nif.ni_ipackets,
+            nif.ni_odrops, nif.ni_opackets);
+    close(dev);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  smpbench (the same CPU-bound work split over 1, 2, 4 and 8 processes;
+//            with SMP they spread over the processors)
+//////////////////////////////////////////////////////////////////////////
+#define SMPBENCH_WORK 1600      // units of 100000 loops per run
+#define SMPBENCH_MAXP 8
+
+void smpbench_task(int units, int sem) {
+    volatile int j;
+
+    while (units-- > 0)
+        for (j=0; j < 100000; j++)
+            ;
+    signal(sem);
+}
+
+// ms for nproc processes to do SMPBENCH_WORK between them, 0 if they
+// can't all be created
+unsigned long smpbench_run(int nproc) {
+    int pids[SMPBENCH_MAXP];
+    unsigned long t0, t;
+    int sem, i;
+
+    sem = screate(0);
+    for (i=0; i < nproc; i++) {
+        pids[i] = create(smpbench_task, 1024, INITPRIO, "smpbench", 2,
+                         SMPBENCH_WORK / nproc, sem);
+        if (pids[i] == SYSERR) {
+            while (--i >= 0)
+                kill(pids[i]);
+            sdelete(sem);
+            return 0;
+        }
+    }
+
+    // main waits below, so the workers have every processor
+    t0 = ctr1000;
+    for (i=0; i < nproc; i++)
+        resume(pids[i]);
+    for (i=0; i < nproc; i++)
+        wait(sem);
+    t = ctr1000 - t0;
+    sdelete(sem);
+    return t;
+}
+
+void smpbench() {
+    unsigned long t, t1;
+    int n;
+#ifdef SMP
+    int i;
+#endif
+
+    kprintf("\nCPU-bound scaling benchmark\n");
+#ifndef SMP
+    kprintf("(one processor; define SMP in Configuration to use them all)\n");
+#endif
+    t1 = 0;
+    for (n=1; n <= SMPBENCH_MAXP; n *= 2) {
+        if ((t = smpbench_run(n)) == 0) {
+            kprintf("%d procs: can't create them (NPROC is %d)\n",
+                    n, NPROC);
+            break;
+        }
+        if (n == 1)
+            t1 = t;
+        kprintf("%d procs: %u ms, speedup %u.%02u\n", n, t,
+                t1 * 100 / t / 100, t1 * 100 / t % 100);
+    }
+#ifdef SMP
+    for (i=0; i < ncpu; i++)
+        if (cpus[i].c_online)
+            kprintf("cpu %d: %u context switches, %u processes stolen\n",
+                    i, cpus[i].c_nswitch, cpus[i].c_nsteal);
+#endif
+}
+
 int main() {
     int i, s;
     int count = 0;
@@ -751,6 +2480,28 @@ int main() {
     kprintf("\t5 - Kill Test (Need NFRAMES=1024 and DUSTYDEBUG=1)\n");
     kprintf("\t6 - Error Test\n");
     kprintf("\t8 - Combo!\n");
+    kprintf("\t9 - Demand-paged Stack Test (Need VSTACK)\n");
+    kprintf("\t10 - xmadvise Test (Need NFRAMES=1024)\n");
+    kprintf("\t11 - xmlock Test (Recommend NFRAMES=22)\n");
+    kprintf("\t12 - Kill Latency Benchmark (Need NFRAMES=1024)\n");
+    kprintf("\t13 - Frame Table Scan Benchmark\n");
+    kprintf("\t14 - Ready List Benchmark (Recommend NPROC=528)\n");
+    kprintf("\t15 - Timing Wheel Test\n");
+    kprintf("\t16 - usleep Test (Recommend TICKLESS)\n");
+    kprintf("\t17 - Scheduling Class Benchmark (Recommend NPROC=108)\n");
+    kprintf("\t18 - CPU Scaling Benchmark (Recommend SMP)\n");
+    kprintf("\t19 - Shared Page Directory Test\n");
+    kprintf("\t20 - Priority Inversion Benchmark\n");
+    kprintf("\t21 - Message Queue Benchmark\n");
+    kprintf("\t22 - Generic Priority Queue Benchmark\n");
+    kprintf("\t23 - waitany Benchmark\n");
+    kprintf("\t24 - Serial Output Benchmark\n");
+    kprintf("\t25 - Serial Receive Benchmark\n");
+    kprintf("\t26 - Kernel Log Benchmark\n");
+    kprintf("\t27 - Trace Test\n");
+    kprintf("\t28 - TTY Output Test\n");
+    kprintf("\t29 - Checksum Test\n");
+    kprintf("\t30 - UDP Test (tools/udpecho on the host)\n");
     kprintf("\nPlease Input:\n");
     while ((i = read(CONSOLE, buf, sizeof(buf))) <1);
     buf[i] = 0;
@@ -801,6 +2552,124 @@ int main() {
         error_test();
         break;
 
+    case 9:
+        // Demand-paged stack test
+#ifdef VSTACK
+        vstack_test();
+#else
+        kprintf("Compile with VSTACK defined to run this test\n");
+#endif
+        break;
+
+    case 10:
+        // xmadvise test
+        xmadvise_test();
+        break;
+
+    case 11:
+        // xmlock test
+        xmlock_test();
+        break;
+
+    case 12:
+        // kill latency benchmark
+        killbench();
+        break;
+
+    case 13:
+        // frame table scan benchmark
+        frmbench();
+        break;
+
+    case 14:
+        // ready list benchmark
+        rdybench();
+        break;
+
+    case 15:
+        // timing wheel test
+        tmtest();
+        break;
+
+    case 16:
+        // usleep test
+        usleeptest();
+        break;
+
+    case 17:
+        // scheduling class benchmark
+        schedbench();
+        break;
+
+    case 18:
+        // CPU-bound work over every processor
+        smpbench();
+        break;
+
+    case 19:
+        // shared page directory test
+#ifndef VSTACK
+        pdtest();
+#else
+        kprintf("With VSTACK every process has its own directory\n");
+#endif
+        break;
+
+    case 20:
+        // priority inversion benchmark
+        invbench();
+        break;
+
+    case 21:
+        // message queue benchmark
+        msgbench();
+        break;
+
+    case 22:
+        // generic priority queue benchmark
+        gpqbench();
+        break;
+
+    case 23:
+        // wait on several semaphores at once
+        waitanybench();
+        break;
+
+    case 24:
+        // serial output: per byte vs bulk
+        serbench();
+        break;
+
+    case 25:
+        // serial input: rx FIFO trigger levels
+        rxbench();
+        break;
+
+    case 26:
+        // kernel log ring vs kprintf
+        klogbench();
+        break;
+
+    case 27:
+        // TSC-stamped event tracing
+        tracetest();
+        break;
+
+    case 28:
+        // tty output ring, flushed on newline / full / TTC_SYNC
+        ttytest();
+        break;
+
+    case 29:
+        // monitor checksums: adc, MMX, fused copy
+        cksumtest();
+        break;
+
+    case 30:
+        // kernel UDP/IP: echo round trips, throughput, reassembly
+        udptest();
+        break;
+
     }
 	return 0;
 }
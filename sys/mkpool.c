@@ -1,4 +1,4 @@
-/* mkpool.c - mkpool */
+/* mkpool.c - mkpool, freepool */
 
 #include <conf.h>
 #include <kernel.h>
@@ -21,7 +21,7 @@ int mkpool(int bufsiz, int numbufs)
 	if ( unmarked(bpmark) )
 		poolinit();
 #endif
-	disable(ps);
+	lkdisable(ps, LK_MEM);
 	if (bufsiz<BPMINB || bufsiz>BPMAXB ||
 	    numbufs<1 || numbufs>BPMAXN ||
 	    nbpools >= NBPOOLS ||
@@ -32,7 +32,7 @@ int mkpool(int bufsiz, int numbufs)
 	poolid = nbpools++;
 	bptab[poolid].bptotal = numbufs;
 	bptab[poolid].bpmaxused = 0;
-	bptab[poolid].bpnext = where;
+	bptab[poolid].bpnext = bptab[poolid].bpbase = where;
 	bptab[poolid].bpsize = bufsiz;
 	bptab[poolid].bpsem = screate(numbufs);
 	bufsiz+=sizeof(int);
@@ -42,3 +42,28 @@ int mkpool(int bufsiz, int numbufs)
 	restore(ps);
 	return(poolid);
 }
+
+/*------------------------------------------------------------------------
+ *  freepool  --  give back the memory of the pool made last; SYSERR if
+ *		  a buffer of it is still out
+ *------------------------------------------------------------------------
+ */
+int freepool(int poolid)
+{
+	STATWORD ps;
+	struct	bpool	*bpptr;
+
+	lkdisable(ps, LK_MEM);
+	bpptr = &bptab[poolid];
+	if (poolid < 0 || poolid != nbpools-1 ||
+	    scount(bpptr->bpsem) != bpptr->bptotal) {
+		restore(ps);
+		return(SYSERR);
+	}
+	sdelete(bpptr->bpsem);
+	freemem((struct mblock *) bpptr->bpbase,
+	    (bpptr->bpsize+sizeof(int)) * bpptr->bptotal);
+	nbpools--;
+	restore(ps);
+	return(OK);
+}
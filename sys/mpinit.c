@@ -0,0 +1,120 @@
+/* mpinit.c - mpinit */
+
+#include <conf.h>
+#include <kernel.h>
+#include <stdio.h>
+#include <mp.h>
+
+/*
+ * mpinit() finds out how many processors the machine has and what
+ * their local APIC ids are. sysinit() calls it before paging is on.
+ * Without SMP nulluser() only says the others are left idle; with SMP
+ * smpstart() (smp.c) starts them. Nothing here writes to the APIC.
+ *
+ * The kernel is loaded at address 0, on top of the BIOS data area, so
+ * the EBDA pointer kept there can't be trusted; the last KB of base
+ * memory and the BIOS ROM lie in the 640K-1M hole and are searched
+ * instead.
+ */
+
+#define	MP_LAPICDEF	0xfee00000	/* local APIC of a default cfg	*/
+#define	MP_MAPPED	(4096 * 4096)	/* the global page tables map	*/
+					/* the first 16MB		*/
+
+int	ncpu = 1;
+int	cpubsp = 0;
+unsigned char	cpuapic[NCPU];
+unsigned long	lapicaddr = 0;
+
+/*------------------------------------------------------------------------
+ *  _mpsum  --  byte sum of len bytes at p (0 for a valid MP structure)
+ *------------------------------------------------------------------------
+ */
+LOCAL int _mpsum(unsigned char *p, int len)
+{
+	int	sum = 0;
+
+	while (len-- > 0)
+		sum += *p++;
+	return(sum & 0xff);
+}
+
+/*------------------------------------------------------------------------
+ *  _mpsearch  --  look for the floating pointer in len bytes at base
+ *------------------------------------------------------------------------
+ */
+LOCAL struct mpfp *_mpsearch(unsigned long base, int len)
+{
+	struct	mpfp	*fp;
+
+	for (fp = (struct mpfp *)base ;
+	    (unsigned long)fp < base + len ; fp++)
+		if (fp->fp_sig == MP_FPSIG && fp->fp_len == 1 &&
+		    _mpsum((unsigned char *)fp, sizeof(struct mpfp)) == 0)
+			return(fp);
+	return(NULL);
+}
+
+/*------------------------------------------------------------------------
+ *  mpinit  --  count the processors listed in the MP configuration;
+ *		SYSERR if the BIOS provides none (one processor assumed)
+ *------------------------------------------------------------------------
+ */
+int mpinit()
+{
+	struct	mpfp	*fp;
+	struct	mpct	*ct;
+	struct	mpcpu	*cpu;
+	unsigned char	*p, *end;
+
+	ncpu = 1;
+	cpubsp = 0;
+	cpuapic[0] = 0;
+	lapicaddr = 0;
+
+	if ((fp = _mpsearch(0x9fc00, 1024)) == NULL &&
+	    (fp = _mpsearch(0xf0000, 0x10000)) == NULL)
+		return(SYSERR);
+
+	if (fp->fp_cfg == 0) {		/* default config: 2 processors	*/
+		if (fp->fp_type == 0)
+			return(SYSERR);
+		ncpu = 2;
+		cpuapic[1] = 1;
+		lapicaddr = MP_LAPICDEF;
+		return(OK);
+	}
+
+	/* the BIOS may leave the table anywhere, even above the memory	*/
+	/* Xinu maps; reading it there would fault			*/
+	if (fp->fp_cfg > MP_MAPPED - sizeof(struct mpct))
+		return(SYSERR);
+	ct = (struct mpct *)fp->fp_cfg;
+	if (ct->ct_sig != MP_CTSIG || ct->ct_len < sizeof(struct mpct) ||
+	    ct->ct_len > MP_MAPPED - fp->fp_cfg ||
+	    _mpsum((unsigned char *)ct, ct->ct_len) != 0)
+		return(SYSERR);
+	lapicaddr = ct->ct_lapic;
+
+	ncpu = 0;
+	p = (unsigned char *)(ct + 1);
+	end = (unsigned char *)ct + ct->ct_len;
+	while (p < end) {
+		if (*p != MP_CPU) {
+			p += 8;
+			continue;
+		}
+		if (p + sizeof(struct mpcpu) > end)
+			break;		/* truncated entry		*/
+		cpu = (struct mpcpu *)p;
+		p += sizeof(struct mpcpu);
+		if (!(cpu->cpu_flags & MP_CPUEN) || ncpu >= NCPU)
+			continue;
+		if (cpu->cpu_flags & MP_CPUBSP)
+			cpubsp = ncpu;
+		cpuapic[ncpu++] = cpu->cpu_apicid;
+	}
+	if (ncpu == 0)			/* a table without processors	*/
+		ncpu = 1;
+	return(OK);
+}
@@ -0,0 +1,350 @@
+/* msgq.c - msgqinit, sendb, sendt, sendn, receiven, recvnb, mqput, mqget, mqclear, mqkill */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sem.h>
+#include <mem.h>
+#include <sleep.h>
+#include <timer.h>
+#include <msgq.h>
+#include <stdio.h>
+
+/*
+ * A process that calls msgqinit() gets a ring of messages in place of
+ * its one word mailbox (see msgq.h). send() still fails when there is
+ * no room, sendb() and sendt() wait for room. Senders wait on pmqsem,
+ * a semaphore used only for its queue: taking a message out of the
+ * ring wakes the first of them, which then tries again.
+ *
+ * sendn() and receiven() move up to n messages with interrupts
+ * disabled once and reschedule at most once.
+ */
+
+LOCAL	struct	tmentry	mqtm[NPROC];	/* sendt() timeout per sender	*/
+
+/*------------------------------------------------------------------------
+ *  _mqtimeout  --  timer callback: the timed send of pid ran out
+ *------------------------------------------------------------------------
+ */
+LOCAL void _mqtimeout(int pid)
+{
+	struct	pentry	*pptr;
+
+	pptr = &proctab[pid];
+	pptr->pwaitret = TIMEOUT;
+	if (pptr->pstate == PRWAIT) {
+		semaph[pptr->psem].semcnt++;
+		dequeue(pid);
+		ready(pid, RESCHNO);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  _mqwake  --  let the receiver know a message has arrived
+ *------------------------------------------------------------------------
+ */
+LOCAL void _mqwake(int pid)
+{
+	struct	pentry	*pptr;
+
+	pptr = &proctab[pid];
+	if (pptr->pstate == PRRECV)	/* if receiver waits, start it	*/
+		ready(pid, RESCHYES);
+	else if (pptr->pstate == PRTRECV) {
+		unsleep(pid);
+		ready(pid, RESCHYES);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  _mqget  --  take the oldest message out of a ring and start the
+ *		first sender waiting for room, if any
+ *------------------------------------------------------------------------
+ */
+LOCAL WORD _mqget(struct pentry *pptr, int resch)
+{
+	struct	sentry	*sptr;
+	WORD	msg;
+
+	msg = pptr->pmq[pptr->pmqhead];
+	if (++pptr->pmqhead == pptr->pmqsize)
+		pptr->pmqhead = 0;
+	if (--pptr->pmqcount == 0)
+		pptr->phasmsg = FALSE;
+
+	sptr = &semaph[pptr->pmqsem];
+	if (sptr->semcnt < 0) {
+		sptr->semcnt++;
+		ready(getfirst(sptr->sqhead), resch);
+	}
+	return(msg);
+}
+
+/*------------------------------------------------------------------------
+ *  _mqsend  --  send msg to pid, waiting up to ticks for room in its
+ *		 ring (for ever if timed is FALSE)
+ *------------------------------------------------------------------------
+ */
+LOCAL int _mqsend(int pid, WORD msg, int timed, unsigned long ticks)
+{
+	STATWORD ps;
+	struct	pentry	*pptr;
+	struct	pentry	*me;
+	struct	sentry	*sptr;
+	int	ret = OK;
+
+	lkdisable(ps, LK_SEM|LK_PROC);
+	me = &proctab[currpid];
+	me->pwaitret = OK;
+	if (timed)
+		tmset(&mqtm[currpid], ticks, _mqtimeout, currpid);
+	for (;;) {
+		if (isbadpid(pid) || (pptr = &proctab[pid])->pstate == PRFREE ||
+		    me->pwaitret != OK) {
+			ret = (me->pwaitret == TIMEOUT) ? TIMEOUT : SYSERR;
+			break;
+		}
+		if (!mqfull(pptr)) {
+			if (pptr->pmq == NULL) {
+				pptr->pmsg = msg;
+				pptr->phasmsg = TRUE;
+			} else
+				mqput(pptr, msg);
+			_mqwake(pid);
+			break;
+		}
+		if (pptr->pmq == NULL || pid == currpid) {	/* can't wait */
+			ret = SYSERR;
+			break;
+		}
+
+		sptr = &semaph[pptr->pmqsem];
+		me->pstate = PRWAIT;
+		me->psem = pptr->pmqsem;
+		sptr->semcnt--;
+		enqueue(currpid, sptr->sqtail);
+		resched();
+	}
+	if (timed)
+		tmcancel(&mqtm[currpid]);
+	restore(ps);
+	return(ret);
+}
+
+/*------------------------------------------------------------------------
+ *  msgqinit  --  give the calling process a queue of depth messages
+ *------------------------------------------------------------------------
+ */
+SYSCALL	msgqinit(int depth)
+{
+	STATWORD ps;
+	struct	pentry	*pptr;
+	WORD	*ring;
+	int	sem;
+
+	lkdisable(ps, LK_MEM|LK_SEM|LK_PROC);
+	pptr = &proctab[currpid];
+	if (depth < 1 || pptr->pmq != NULL) {
+		restore(ps);
+		return(SYSERR);
+	}
+	ring = getmem(depth * sizeof(WORD));
+	if (ring == (WORD *)SYSERR) {
+		restore(ps);
+		return(SYSERR);
+	}
+	if ((sem = screate(0)) == SYSERR) {
+		freemem((struct mblock *)ring, depth * sizeof(WORD));
+		restore(ps);
+		return(SYSERR);
+	}
+	pptr->pmq = ring;
+	pptr->pmqsize = depth;
+	pptr->pmqhead = 0;
+	pptr->pmqcount = 0;
+	pptr->pmqsem = sem;
+	if (pptr->phasmsg) {		/* keep what is in the mailbox	*/
+		ring[0] = pptr->pmsg;
+		pptr->pmqcount = 1;
+	}
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  sendb  --  send a message, waiting for room in the receiver's queue
+ *------------------------------------------------------------------------
+ */
+SYSCALL	sendb(int pid, WORD msg)
+{
+	return(_mqsend(pid, msg, FALSE, 0));
+}
+
+/*------------------------------------------------------------------------
+ *  sendt  --  send a message, waiting at most maxwait milliseconds for
+ *	       room in the receiver's queue; TIMEOUT if there was none
+ *------------------------------------------------------------------------
+ */
+SYSCALL	sendt(int pid, WORD msg, int maxwait)
+{
+	if (maxwait < 0 || maxwait > TM_MAXTICKS / TM_MS(1) || clkruns == 0)
+		return(SYSERR);
+	return(_mqsend(pid, msg, TRUE, TM_MS(maxwait)));
+}
+
+/*------------------------------------------------------------------------
+ *  sendn  --  send up to n messages without waiting; returns how many
+ *	       there was room for
+ *------------------------------------------------------------------------
+ */
+SYSCALL	sendn(int pid, WORD *msgs, int n)
+{
+	STATWORD ps;
+	struct	pentry	*pptr;
+	int	i;
+
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (isbadpid(pid) || (pptr = &proctab[pid])->pstate == PRFREE ||
+	    n < 0) {
+		restore(ps);
+		return(SYSERR);
+	}
+	for (i=0 ; i<n && !mqfull(pptr) ; i++) {
+		if (pptr->pmq == NULL) {
+			pptr->pmsg = msgs[i];
+			pptr->phasmsg = TRUE;
+		} else
+			mqput(pptr, msgs[i]);
+	}
+	if (i > 0)
+		_mqwake(pid);
+	restore(ps);
+	return(i);
+}
+
+/*------------------------------------------------------------------------
+ *  receiven  --  wait for a message, then take up to n of those waiting;
+ *		  returns how many
+ *------------------------------------------------------------------------
+ */
+SYSCALL	receiven(WORD *buf, int n)
+{
+	STATWORD ps;
+	struct	pentry	*pptr;
+	int	i;
+
+	if (n < 1)
+		return(SYSERR);
+	lkdisable(ps, LK_SEM|LK_PROC);
+	pptr = &proctab[currpid];
+	if ( !pptr->phasmsg ) {		/* if no message, wait for one	*/
+		pptr->pstate = PRRECV;
+		resched();
+	}
+	if (pptr->pmq == NULL) {
+		buf[0] = pptr->pmsg;
+		pptr->phasmsg = FALSE;
+		i = 1;
+	} else {
+		for (i=0 ; i<n && pptr->phasmsg ; i++)
+			buf[i] = _mqget(pptr, RESCHNO);
+		resched();		/* for the senders started	*/
+	}
+	restore(ps);
+	return(i);
+}
+
+/*------------------------------------------------------------------------
+ *  recvnb  --  take the oldest message without waiting; TIMEOUT if
+ *		there is none
+ *------------------------------------------------------------------------
+ */
+SYSCALL	recvnb()
+{
+	STATWORD ps;
+	struct	pentry	*pptr;
+	WORD	msg;
+
+	lkdisable(ps, LK_SEM|LK_PROC);
+	pptr = &proctab[currpid];
+	if (!pptr->phasmsg)
+		msg = TIMEOUT;
+	else if (pptr->pmq == NULL) {
+		msg = pptr->pmsg;
+		pptr->phasmsg = FALSE;
+	} else
+		msg = mqget(pptr);
+	restore(ps);
+	return(msg);
+}
+
+/*------------------------------------------------------------------------
+ *  mqput  --  add a message to the ring of pptr, which has room
+ *------------------------------------------------------------------------
+ */
+void mqput(struct pentry *pptr, WORD msg)
+{
+	int	i;
+
+	i = pptr->pmqhead + pptr->pmqcount;
+	if (i >= pptr->pmqsize)
+		i -= pptr->pmqsize;
+	pptr->pmq[i] = msg;
+	pptr->pmqcount++;
+	pptr->phasmsg = TRUE;
+}
+
+/*------------------------------------------------------------------------
+ *  mqget  --  take the oldest message out of the ring of pptr, which
+ *	       has one
+ *------------------------------------------------------------------------
+ */
+WORD mqget(struct pentry *pptr)
+{
+	return(_mqget(pptr, RESCHYES));
+}
+
+/*------------------------------------------------------------------------
+ *  mqclear  --  empty the ring of pptr, which has a message, returning
+ *		 the oldest one
+ *------------------------------------------------------------------------
+ */
+WORD mqclear(struct pentry *pptr)
+{
+	WORD	msg;
+
+	msg = _mqget(pptr, RESCHNO);
+	while (pptr->phasmsg)
+		_mqget(pptr, RESCHNO);
+	resched();
+	return(msg);
+}
+
+/*------------------------------------------------------------------------
+ *  mqkill  --  called by kill(): stop a timed send by pid and free its
+ *		queue; senders waiting for room get SYSERR
+ *------------------------------------------------------------------------
+ */
+void mqkill(int pid)
+{
+	struct	pentry	*pptr;
+	struct	sentry	*sptr;
+	int	wpid;
+
+	tmcancel(&mqtm[pid]);
+	pptr = &proctab[pid];
+	if (pptr->pmq == NULL)
+		return;
+
+	sptr = &semaph[pptr->pmqsem];
+	sptr->sstate = SFREE;
+	while ((wpid = getfirst(sptr->sqhead)) != EMPTY) {
+		proctab[wpid].pwaitret = DELETED;
+		ready(wpid, RESCHNO);
+	}
+	freemem((struct mblock *)pptr->pmq, pptr->pmqsize * sizeof(WORD));
+	pptr->pmq = NULL;
+	pptr->phasmsg = FALSE;
+}
@@ -0,0 +1,247 @@
+/* mutex.c - mcreate, mdelete, mlock, munlock, mprio, mkill */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sem.h>
+#include <stdio.h>
+
+/*
+ * A mutex is an entry in the semaphore table with smutex set. Unlike a
+ * semaphore it has an owner: the process that locked it, which is the
+ * only one that may unlock it. Waiters are kept in priority order and
+ * the highest one gets the mutex next.
+ *
+ * A process's pbprio is the priority it was created with or given by
+ * chprio(); pprio, which the ready list and resched() use, is the
+ * highest of pbprio and the priorities of the processes waiting for
+ * mutexes it holds. When a waiter is boosted and is itself waiting for
+ * a mutex the boost is passed on to that mutex's owner, and so on down
+ * the chain. The mutexes a process holds are linked through snext so
+ * its priority can be worked out again when it gives one up.
+ */
+
+/*------------------------------------------------------------------------
+ *  _mneed  --  priority process pid should run at: its own or that of
+ *		the highest process waiting for a mutex it holds
+ *------------------------------------------------------------------------
+ */
+LOCAL int _mneed(int pid)
+{
+	struct	sentry	*sptr;
+	int	prio;
+	int	mutex;
+
+	prio = proctab[pid].pbprio;
+	for (mutex = proctab[pid].pmutex ; mutex != EMPTY ;
+	    mutex = sptr->snext) {
+		sptr = &semaph[mutex];
+		if (nonempty(sptr->sqhead) && lastkey(sptr->sqtail) > prio)
+			prio = lastkey(sptr->sqtail);
+	}
+	return(prio);
+}
+
+/*------------------------------------------------------------------------
+ *  _mset  --  bring the priority of pid up to date, and that of the
+ *	       owners down the chain of mutexes it is waiting for
+ *------------------------------------------------------------------------
+ */
+LOCAL void _mset(int pid)
+{
+	struct	pentry	*pptr;
+	struct	sentry	*sptr;
+	int	prio;
+	int	n;
+
+	for (n=0 ; n<NPROC && !isbadpid(pid) ; n++) {	/* a cycle is a	*/
+		pptr = &proctab[pid];			/* deadlock	*/
+		prio = _mneed(pid);
+		if (prio == pptr->pprio)
+			return;
+		pptr->pprio = prio;
+		if (pptr->pstate == PRREADY) {	/* in any processor's list */
+			insert(pid, rdyheadof(dequeue(pid)), prio);
+			return;
+		}
+		if (pptr->pstate != PRWAIT ||
+		    !(sptr = &semaph[pptr->psem])->smutex)
+			return;
+		insert(dequeue(pid), sptr->sqhead, prio);
+		pid = sptr->sowner;
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  _mhandoff  --  take mutex away from its owner and give it to the
+ *		   highest waiter, if any, making that one ready
+ *------------------------------------------------------------------------
+ */
+LOCAL void _mhandoff(int mutex)
+{
+	struct	sentry	*sptr;
+	struct	pentry	*pptr;
+	int	*link;
+	int	pid;
+
+	sptr = &semaph[mutex];
+	for (link = &proctab[sptr->sowner].pmutex ; *link != mutex ;
+	    link = &semaph[*link].snext)
+		;
+	*link = sptr->snext;
+	sptr->sowner = BADPID;
+
+	if ((pid = getlast(sptr->sqtail)) == EMPTY)
+		return;
+	pptr = &proctab[pid];
+	sptr->sowner = pid;
+	sptr->snext = pptr->pmutex;
+	pptr->pmutex = mutex;
+	pptr->pprio = _mneed(pid);	/* the waiters left behind	*/
+	ready(pid, RESCHNO);
+}
+
+/*------------------------------------------------------------------------
+ * mcreate  --  create an unlocked mutex, returning its id
+ *------------------------------------------------------------------------
+ */
+SYSCALL mcreate()
+{
+	STATWORD ps;
+	int	mutex;
+	struct	sentry	*sptr;
+
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if ((mutex = screate(0)) == SYSERR) {
+		restore(ps);
+		return(SYSERR);
+	}
+	sptr = &semaph[mutex];
+	sptr->smutex = TRUE;
+	sptr->sowner = BADPID;
+	sptr->snext = EMPTY;
+	restore(ps);
+	return(mutex);
+}
+
+/*------------------------------------------------------------------------
+ * mdelete  --  delete a mutex; its waiters return DELETED from mlock
+ *------------------------------------------------------------------------
+ */
+SYSCALL mdelete(int mutex)
+{
+	STATWORD ps;
+	int	pid;
+	int	owner;
+	struct	sentry	*sptr;
+
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (isbadsem(mutex) || (sptr = &semaph[mutex])->sstate==SFREE ||
+	    !sptr->smutex) {
+		restore(ps);
+		return(SYSERR);
+	}
+	if ((owner = sptr->sowner) != BADPID) {
+		while ((pid = getfirst(sptr->sqhead)) != EMPTY) {
+			proctab[pid].pwaitret = DELETED;
+			ready(pid, RESCHNO);
+		}
+		_mhandoff(mutex);	/* no waiters: just unlinks it	*/
+		_mset(owner);
+	}
+	sptr->sstate = SFREE;
+	sptr->smutex = FALSE;
+	resched();
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ * mlock  --  lock a mutex, waiting for its owner to unlock it if needed
+ *------------------------------------------------------------------------
+ */
+SYSCALL mlock(int mutex)
+{
+	STATWORD ps;
+	struct	sentry	*sptr;
+	struct	pentry	*pptr;
+
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (isbadsem(mutex) || (sptr = &semaph[mutex])->sstate==SFREE ||
+	    !sptr->smutex || sptr->sowner == currpid) {
+		restore(ps);
+		return(SYSERR);
+	}
+	pptr = &proctab[currpid];
+	if (sptr->sowner == BADPID) {
+		sptr->sowner = currpid;
+		sptr->snext = pptr->pmutex;
+		pptr->pmutex = mutex;
+		restore(ps);
+		return(OK);
+	}
+
+	pptr->pstate = PRWAIT;
+	pptr->psem = mutex;
+	insert(currpid, sptr->sqhead, pptr->pprio);
+	pptr->pwaitret = OK;
+	_mset(sptr->sowner);		/* owner inherits our priority	*/
+	resched();
+	restore(ps);
+	return(pptr->pwaitret);
+}
+
+/*------------------------------------------------------------------------
+ * munlock  --  unlock a mutex held by the caller
+ *------------------------------------------------------------------------
+ */
+SYSCALL munlock(int mutex)
+{
+	STATWORD ps;
+	struct	sentry	*sptr;
+
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (isbadsem(mutex) || (sptr = &semaph[mutex])->sstate==SFREE ||
+	    !sptr->smutex || sptr->sowner != currpid) {
+		restore(ps);
+		return(SYSERR);
+	}
+	_mhandoff(mutex);
+	_mset(currpid);			/* drop what it inherited	*/
+	resched();
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  mprio  --  recompute the priority of pid after its pbprio changed
+ *------------------------------------------------------------------------
+ */
+void mprio(int pid)
+{
+	_mset(pid);
+}
+
+/*------------------------------------------------------------------------
+ *  mkill  --  called by kill(): pass on the mutexes pid holds and take
+ *	       it off the queue of a mutex it is waiting for (it is then
+ *	       left PRSUSP so kill() doesn't dequeue it again)
+ *------------------------------------------------------------------------
+ */
+void mkill(int pid)
+{
+	struct	pentry	*pptr;
+	struct	sentry	*sptr;
+
+	pptr = &proctab[pid];
+	while (pptr->pmutex != EMPTY)
+		_mhandoff(pptr->pmutex);
+
+	if (pptr->pstate == PRWAIT &&
+	    (sptr = &semaph[pptr->psem])->smutex) {
+		dequeue(pid);
+		pptr->pstate = PRSUSP;
+		_mset(sptr->sowner);
+	}
+}
@@ -6,6 +6,7 @@
 #include <kernel.h>
 #include <proc.h>
 #include <stdio.h>
+#include <klog.h>
 
 /*static unsigned long	esp, ebp;*/
 
@@ -14,6 +15,7 @@ int panic(char *msg)
 	extern int console_dev;
 	STATWORD ps;    
 	disable(ps);
+	klflush();			/* what was logged comes first	*/
 	kprintf("currpid %d (%s)\n", currpid, proctab[currpid].pname);
 	kprintf("Panic: %s\n", msg);
 /*
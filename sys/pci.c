@@ -358,7 +358,7 @@ int scan_pci_bios(void) {
     unsigned long   vendor, device, index;
     unsigned long   retval, results, error;
     int v;
-    unsigned long vtable[3]={0x8086,0xa727,0x10b7}; 
+    unsigned long vtable[4]={0x8086,0xa727,0x10b7,0x1af4}; 
 /*
     unsigned long vtable[1]={0x10b7};
 */
@@ -366,7 +366,7 @@ int scan_pci_bios(void) {
 #if 0
     for (vendor=0; vendor<PCIBIOS_MAX_VENDOR; vendor++) {
 #else
-    for (v=0; v<3; v++) {
+    for (v=0; v<4; v++) {
 	vendor=vtable[v];
 #endif
 	for (device=0; device<PCIBIOS_MAX_DEVICE; device++) {
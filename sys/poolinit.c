@@ -22,7 +22,7 @@ int poolinit()
 #ifdef	MEMMARK
 	int	status;
 
-	disable(ps);
+	lkdisable(ps, LK_MEM);
 	if ( (status=mark(bpmark)) == OK) {
 		nbpools = 0;
 	}
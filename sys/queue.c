@@ -33,6 +33,7 @@ int dequeue(int item)
 {
 	struct	qent	*mptr;		/* pointer to q entry for item	*/
 
+	rdyremove(item);		/* in case it is a ready proc	*/
 	mptr = &q[item];
 	q[mptr->qprev].qnext = mptr->qnext;
 	q[mptr->qnext].qprev = mptr->qprev;
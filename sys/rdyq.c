@@ -0,0 +1,190 @@
+/* rdyq.c - rdyinit, rdyinsert, rdyremove, rdyheadof, rdycount */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+
+/*
+ * The ready list is still one q list sorted by priority, so lastkey()
+ * and getlast() on rdytail work as before. It is made up of one FIFO
+ * run per priority: a process made ready goes in front of the others
+ * of its priority, and getlast() takes from the tail of the highest
+ * one. For each priority we keep the first process of its run, and a
+ * bitmap of the priorities that have one. Finding where a process
+ * goes is then a bit scan instead of a walk down the list.
+ *
+ * With SMP each processor has a ready list of its own, with its own
+ * bookkeeping; the lists' heads are allocated together, so a head
+ * gives its rdyq without a search. Each also counts its processes, for
+ * smpsteal() to even out the lists, and making a process ready wakes
+ * an idle processor (smpkick).
+ */
+
+#define	NPRIOWORDS	(NPRIO / 32)
+
+#ifdef	SMP
+#define	NRDYQ		NCPU
+#define	RDYQ(head)	(&rdyq[((head) - rdylists) / 2])
+#else
+#define	NRDYQ		1
+#define	RDYQ(head)	(&rdyq[0])
+#endif
+
+struct	rdyq	{
+	int		r_head, r_tail;		/* the q list			*/
+	int		r_first[NPRIO];		/* first pid of each run	*/
+	unsigned long	r_map[NPRIOWORDS];	/* bit set: run nonempty	*/
+	unsigned long	r_summary;		/* bit set: r_map[i] != 0	*/
+	int		r_count;		/* processes on the list	*/
+};
+
+LOCAL	struct	rdyq	rdyq[NRDYQ];
+LOCAL	int	rdyof[NPROC];			/* rdyq a ready process is in	*/
+LOCAL	char	rdyon[NPROC];			/* TRUE iff it is on one	*/
+
+/*------------------------------------------------------------------------
+ *  _bsf  --  index of the lowest bit set in a nonzero word
+ *------------------------------------------------------------------------
+ */
+LOCAL int _bsf(unsigned long x)
+{
+	int	i;
+
+	asm("bsfl %1, %0" : "=r" (i) : "rm" (x));
+	return(i);
+}
+
+/*------------------------------------------------------------------------
+ *  _rdyabove  --  lowest priority >= prio with a nonempty run, or EMPTY
+ *------------------------------------------------------------------------
+ */
+LOCAL int _rdyabove(struct rdyq *r, int prio)
+{
+	int		w;
+	unsigned long	bits;
+
+	w = prio >> 5;
+	bits = r->r_map[w] & (~0UL << (prio & 31));
+	if (bits)
+		return((w << 5) + _bsf(bits));
+
+	if (++w >= NPRIOWORDS)
+		return(EMPTY);
+	bits = r->r_summary & (~0UL << w);
+	if (bits == 0)
+		return(EMPTY);
+	w = _bsf(bits);
+	return((w << 5) + _bsf(r->r_map[w]));
+}
+
+/*------------------------------------------------------------------------
+ *  rdyinit  --  initialize the bookkeeping of the ready list at head
+ *------------------------------------------------------------------------
+ */
+void rdyinit(int head)
+{
+	struct	rdyq	*r;
+	int	i;
+
+#ifdef	SMP
+	if (rdylists == 0)		/* the first list: cpus[0]'s	*/
+		rdylists = head;
+#endif
+	r = RDYQ(head);
+	r->r_head = head;
+	r->r_tail = head + 1;
+	for (i=0 ; i<NPRIO ; i++)
+		r->r_first[i] = EMPTY;
+	for (i=0 ; i<NPRIOWORDS ; i++)
+		r->r_map[i] = 0;
+	r->r_summary = 0;
+	r->r_count = 0;
+}
+
+/*------------------------------------------------------------------------
+ *  rdyinsert  --  insert a process into the ready list at head,
+ *		   0 <= prio < NPRIO
+ *------------------------------------------------------------------------
+ */
+int rdyinsert(int pid, int head, int prio)
+{
+	struct	rdyq	*r;
+	int	next;			/* entry pid goes in front of	*/
+	int	prev;
+	int	above;
+
+	r = RDYQ(head);
+	above = _rdyabove(r, prio);
+	next = (above == EMPTY) ? r->r_tail : r->r_first[above];
+	q[pid].qnext = next;
+	q[pid].qprev = prev = q[next].qprev;
+	q[pid].qkey  = prio;
+	q[prev].qnext = pid;
+	q[next].qprev = pid;
+
+	r->r_first[prio] = pid;
+	r->r_map[prio >> 5] |= 1UL << (prio & 31);
+	r->r_summary |= 1UL << (prio >> 5);
+	rdyof[pid] = r - rdyq;
+	rdyon[pid] = TRUE;
+	r->r_count++;
+	schedadd(pid);			/* share class bookkeeping	*/
+#ifdef	SMP
+	if (prio > 0)			/* not an idle process		*/
+		smpkick();
+#endif
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  rdyremove  --  called by dequeue() before it unlinks an item; keeps
+ *		   the bookkeeping right if the item heads a ready run
+ *------------------------------------------------------------------------
+ */
+void rdyremove(int item)
+{
+	struct	rdyq	*r;
+	int	prio;
+	int	next;
+
+	schedremove(item);
+	if (item >= NPROC || !rdyon[item])
+		return;
+	rdyon[item] = FALSE;
+	r = &rdyq[rdyof[item]];
+	r->r_count--;
+	prio = q[item].qkey;
+	if (r->r_first[prio] != item)
+		return;
+
+	next = q[item].qnext;
+	if (next < NPROC && q[next].qkey == prio) {
+		r->r_first[prio] = next;
+		return;
+	}
+
+	/* that was the last process of this priority */
+	r->r_first[prio] = EMPTY;
+	r->r_map[prio >> 5] &= ~(1UL << (prio & 31));
+	if (r->r_map[prio >> 5] == 0)
+		r->r_summary &= ~(1UL << (prio >> 5));
+}
+
+/*------------------------------------------------------------------------
+ *  rdyheadof  --  head of the ready list a ready process is in
+ *------------------------------------------------------------------------
+ */
+int rdyheadof(int pid)
+{
+	return(rdyq[rdyof[pid]].r_head);
+}
+
+/*------------------------------------------------------------------------
+ *  rdycount  --  number of processes on the ready list at head
+ *------------------------------------------------------------------------
+ */
+int rdycount(int head)
+{
+	return(RDYQ(head)->r_count);
+}
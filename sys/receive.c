@@ -3,6 +3,7 @@
 #include <conf.h>
 #include <kernel.h>
 #include <proc.h>
+#include <msgq.h>
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
@@ -15,14 +16,17 @@ SYSCALL	receive()
 	struct	pentry	*pptr;
 	WORD	msg;
 
-	disable(ps);
+	lkdisable(ps, LK_SEM|LK_PROC);
 	pptr = &proctab[currpid];
 	if ( !pptr->phasmsg ) {		/* if no message, wait for one	*/
 		pptr->pstate = PRRECV;
 		resched();
 	}
-	msg = pptr->pmsg;		/* retrieve message		*/
-	pptr->phasmsg = FALSE;
+	if (pptr->pmq == NULL) {
+		msg = pptr->pmsg;	/* retrieve message		*/
+		pptr->phasmsg = FALSE;
+	} else
+		msg = mqget(pptr);	/* the oldest one in the queue	*/
 	restore(ps);
 	return(msg);
 }
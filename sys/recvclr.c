@@ -3,6 +3,7 @@
 #include <conf.h>
 #include <kernel.h>
 #include <proc.h>
+#include <msgq.h>
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
@@ -14,8 +15,10 @@ SYSCALL	recvclr()
 	STATWORD ps;    
 	WORD	msg;
 
-	disable(ps);
-	if (proctab[currpid].phasmsg) {
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (proctab[currpid].phasmsg && proctab[currpid].pmq != NULL)
+		msg = mqclear(&proctab[currpid]);	/* oldest one	*/
+	else if (proctab[currpid].phasmsg) {
 		proctab[currpid].phasmsg = 0;
 		msg = proctab[currpid].pmsg;
 	} else
@@ -3,8 +3,10 @@
 #include <conf.h>
 #include <kernel.h>
 #include <proc.h>
+#include <msgq.h>
 #include <q.h>
 #include <sleep.h>
+#include <timer.h>
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
@@ -17,18 +19,18 @@ SYSCALL	recvtim(int maxwait)
 	struct	pentry	*pptr;
 	int	msg;
 
-	if (maxwait<0 || clkruns == 0)
+	if (maxwait<0 || maxwait > TM_MAXTICKS / TM_MS(1000) || clkruns == 0)
 		return(SYSERR);
-	disable(ps);
+	lkdisable(ps, LK_SEM|LK_PROC);
 	pptr = &proctab[currpid];
 	if ( !pptr->phasmsg ) {		/* if no message, wait		*/
-	        insertd(currpid, clockq, maxwait*1000);
-		slnempty = TRUE;
-		sltop = (int *)&q[q[clockq].qnext].qkey;
+	        tmsleep(currpid, TM_MS(maxwait*1000));
 	        pptr->pstate = PRTRECV;
 		resched();
 	}
-	if ( pptr->phasmsg ) {
+	if ( pptr->phasmsg && pptr->pmq != NULL ) {
+		msg = mqget(pptr);	/* the oldest one in the queue	*/
+	} else if ( pptr->phasmsg ) {
 		msg = pptr->pmsg;	/* msg. arrived => retrieve it	*/
 		pptr->phasmsg = FALSE;
 	} else {			/* still no message => TIMEOUT	*/
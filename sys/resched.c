@@ -1,11 +1,14 @@
 /* resched.c  -  resched */
 
 #include <conf.h>
+#include <i386.h>
 #include <kernel.h>
 #include <stdio.h>
 #include <proc.h>
 #include <q.h>
+#include <timer.h>
 #include <control_reg.h>
+#include <trace.h>
 
 unsigned long currSP;   /* REAL sp of current process */
 
@@ -22,18 +25,29 @@ int resched()
     STATWORD        PS;
     register struct pentry  *optr;  /* pointer to old process entry */
     register struct pentry  *nptr;  /* pointer to new process entry */
+    unsigned long   pdbr;           /* CR3 for ctxsw, 0 to keep it  */
 
-    disable(PS);
+    lkdisable(PS, LK_PROC);
+#ifdef  TICKLESS
+    clkupdate();            /* ctr1000 etc. only move on one-shots */
+#endif
+#ifdef  SMP
+    if (schedclass == PRIOSCHED)
+        smpsteal();         /* take work another processor has queued */
+#endif
     /* no switch needed if current process priority higher than next*/
+    /* (the share classes draw or compare every time instead)       */
 
-    if ( ( (optr= &proctab[currpid])->pstate == PRCURR) &&
+    optr = &proctab[currpid];
+    if ( schedclass == PRIOSCHED && (optr->pstate == PRCURR) &&
        (lastkey(rdytail)<optr->pprio)) {
         restore(PS);
         return(OK);
     }
     
-#ifdef STKCHK
+#if defined(STKCHK) && !defined(VSTACK)
     /* make sure current stack has room for ctsw */
+    /* (with VSTACK the guard page catches overflow instead) */
     asm("movl   %esp, currSP");
     if (currSP - optr->plimit < 48) {
         kprintf("Bad SP current process, pid=%d (%s), lim=0x%lx, currently 0x%lx\n",
@@ -46,14 +60,21 @@ int resched()
 
     /* force context switch */
 
+    if (schedclass != PRIOSCHED)
+        schedstop(currpid);
     if (optr->pstate == PRCURR) {
         optr->pstate = PRREADY;
         insert(currpid,rdyhead,optr->pprio);
     }
 
     /* remove highest priority process at end of ready list */
+    /* (or the one the share class picks)                   */
 
-    nptr = &proctab[ (currpid = getlast(rdytail)) ];
+    if (schedclass == PRIOSCHED)
+        setcurrpid(getlast(rdytail));
+    else
+        setcurrpid(schedpick());
+    nptr = &proctab[currpid];
     nptr->pstate = PRCURR;      /* mark it currently running    */
 #ifdef notdef
 #ifdef  STKCHK
@@ -78,25 +99,52 @@ int resched()
 #endif  /* STKCHK */
 #endif  /* notdef */
 #ifdef  RTCLOCK
+#ifdef  SMP
+    if (!smpquantum())      /* on the APIC timer once the others run */
+#endif
+#ifdef  TICKLESS
+    clkquantum();           /* preempt QUANTUM ms from now */
+#else
     preempt = QUANTUM;      /* reset preemption counter */
 #endif
+#endif
 #ifdef  DEBUG
     PrintSaved(nptr);
 #endif
 
+    if (nptr == optr) {         /* share class picked the same one */
+        restore(PS);
+        return OK;
+    }
+
     // When performing a context switch between processes we must also
     // switch between memory spaces. This is accomplished by adjusting
     // the PDBR register with every context switch. 
     //
     // 5 - Context switch
     //      - every process has separate page directory
-    //      - before ctxsw() load CR3 with the process' PDBR
-    set_PDBR(VA2VPNO(nptr->pd));
+    //      - ctxsw() loads CR3 with the process' PDBR
+    // Processes without private mappings share kernpd, so switching
+    // between two of them leaves CR3 (and the TLB) alone. CR3 can't be
+    // loaded here: with VSTACK the rest of the switch would then run on
+    // the new process's stack, which sits at the same address.
+    pdbr = 0;
+    if (optr->pd != kernpd || nptr->pd != kernpd)
+        pdbr = VA2VPNO(nptr->pd) << 12;
 #if DUSTYDEBUG
     kprintf("switching to process %d\n", (nptr - proctab));
 #endif
+    TRACE(TRC_SCHED, TE_RESCHED, optr - proctab, currpid, optr->pstate, 0);
 
-    ctxsw(&optr->pesp, optr->pirmask, &nptr->pesp, nptr->pirmask);
+#ifdef  SMP
+    smpswitch(optr, nptr);  /* optr lets go of all but LK_PROC */
+#endif
+
+    ctxsw(&optr->pesp, optr->pirmask, &nptr->pesp, nptr->pirmask, pdbr,
+        &cputss()[0].ts_pdbr);
+#ifdef  SMP
+    smpresume();            /* take them back */
+#endif
 
 #ifdef  DEBUG
     PrintSaved(nptr);
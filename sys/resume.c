@@ -15,7 +15,7 @@ SYSCALL resume(int pid)
 	struct	pentry	*pptr;		/* pointer to proc. tab. entry	*/
 	int	prio;			/* priority to return		*/
 
-	disable(ps);
+	lkdisable(ps, LK_PROC);
 	if (isbadpid(pid) || (pptr= &proctab[pid])->pstate!=PRSUSP) {
 		restore(ps);
 		return(SYSERR);
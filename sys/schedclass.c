@@ -0,0 +1,453 @@
+/* schedclass.c - setschedclass, getschedclass, setrate, tktransfer,
+ *		  schedinit, schedadd, schedremove, schedstop, schedpick,
+ *		  schedkill
+ */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <stdio.h>
+
+/*
+ * Besides strict priority (PRIOSCHED) resched() can run one of two
+ * share based classes, chosen for the whole system with setschedclass().
+ * In both a process's share is its rate (prate, set to its priority by
+ * create() and changed with setrate()); the null process has none and
+ * only runs when nothing else can.
+ *
+ * RANDOMSCHED is lottery scheduling: every resched draws a ticket and
+ * the process holding it runs. A process has prate tickets plus those
+ * lent to it by blocked processes that named it with tktransfer(). The
+ * tickets of the ready processes live in a Fenwick tree indexed by pid,
+ * so changing a count and finding the winner are both O(log NPROC).
+ *
+ * PROPORTIONALSHARE gives each process a virtual time (ppi) that grows
+ * by the cycles it ran divided by its rate; the ready process with the
+ * smallest one runs next. The ready processes are kept in a min-heap on
+ * ppi. While a process is not ready or running its ppi holds only how
+ * far ahead of the system virtual time (psvtime) it was, so processes
+ * that sleep come back level with the others instead of with credit
+ * for the time they were away.
+ *
+ * The ready list itself is unchanged: rdyinsert() and rdyremove() tell
+ * us when a process joins or leaves it. With SMP the tree and the heap
+ * hold the processes of every processor's ready list, so schedpick()
+ * may take one from another processor's; each processor's idle process
+ * is left out like the null process.
+ */
+
+int	schedclass = PRIOSCHED;		/* class resched() runs		*/
+
+LOCAL	int	rdymember[NPROC];	/* TRUE iff pid is in our set	*/
+
+/* lottery */
+LOCAL	int	lottree[NPROC];		/* Fenwick tree, index = pid	*/
+LOCAL	int	lotcnt[NPROC];		/* tickets pid has in the tree	*/
+LOCAL	int	lotlent[NPROC];		/* tickets lent to pid		*/
+LOCAL	int	lotlending[NPROC];	/* TRUE iff pid's are lent out	*/
+LOCAL	int	lottotal;		/* tickets in the tree		*/
+LOCAL	unsigned long	lotseed = 1;	/* drawing state		*/
+
+/* proportional share */
+LOCAL	int	psheap[NPROC];		/* min-heap of pids on ppi	*/
+LOCAL	int	pspos[NPROC];		/* index of pid in psheap	*/
+LOCAL	int	psn;			/* pids in psheap		*/
+LOCAL	int	psaway[NPROC];		/* TRUE iff ppi is a lag	*/
+LOCAL	unsigned long	psvtime;	/* system virtual time		*/
+#ifdef	SMP
+#define	psstart		(cpu()->c_psstart)
+#define	_idle(pid)	smpidle(pid)
+#else
+LOCAL	unsigned long	psstart;	/* tsc when current one started	*/
+#define	_idle(pid)	((pid) == NULLPROC)
+#endif
+
+/*------------------------------------------------------------------------
+ *  _tsc  --  low word of the time stamp counter
+ *------------------------------------------------------------------------
+ */
+LOCAL unsigned long _tsc()
+{
+	unsigned long	lo, hi;
+
+	asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+	return(lo);
+}
+
+/*------------------------------------------------------------------------
+ *  _lotset  --  give pid n tickets in the tree
+ *------------------------------------------------------------------------
+ */
+LOCAL void _lotset(int pid, int n)
+{
+	int	i;
+	int	delta = n - lotcnt[pid];
+
+	if (delta == 0)
+		return;
+	lotcnt[pid] = n;
+	lottotal += delta;
+	for (i=pid ; i<NPROC ; i += i & -i)
+		lottree[i] += delta;
+}
+
+/*------------------------------------------------------------------------
+ *  _lotupdate  --  recount the tickets of pid after a change
+ *------------------------------------------------------------------------
+ */
+LOCAL void _lotupdate(int pid)
+{
+	if (rdymember[pid])
+		_lotset(pid, proctab[pid].prate + lotlent[pid]);
+}
+
+/*------------------------------------------------------------------------
+ *  _lotlend  --  pid blocked: its tickets go to the process it named
+ *------------------------------------------------------------------------
+ */
+LOCAL void _lotlend(int pid)
+{
+	int	to = proctab[pid].pxferto;
+
+	if (lotlending[pid] || isbadpid(to) || proctab[to].pstate == PRFREE)
+		return;
+	lotlending[pid] = TRUE;
+	lotlent[to] += proctab[pid].prate;
+	_lotupdate(to);
+}
+
+/*------------------------------------------------------------------------
+ *  _lotreturn  --  pid can run again: take its tickets back
+ *------------------------------------------------------------------------
+ */
+LOCAL void _lotreturn(int pid)
+{
+	int	to = proctab[pid].pxferto;
+
+	if (!lotlending[pid])
+		return;
+	lotlending[pid] = FALSE;
+	lotlent[to] -= proctab[pid].prate;
+	_lotupdate(to);
+}
+
+/*------------------------------------------------------------------------
+ *  _lotdraw  --  pid holding a random ticket, or EMPTY if none
+ *------------------------------------------------------------------------
+ */
+LOCAL int _lotdraw()
+{
+	int	pos, step, r;
+
+	if (lottotal <= 0)
+		return(EMPTY);
+	lotseed = lotseed * 1103515245 + 12345;
+	r = (lotseed >> 8) % lottotal;
+
+	for (step=1 ; step*2 < NPROC ; step *= 2)
+		;
+	for (pos=0 ; step > 0 ; step >>= 1)
+		if (pos + step < NPROC && lottree[pos + step] <= r) {
+			pos += step;
+			r -= lottree[pos];
+		}
+	return(pos + 1);
+}
+
+/*------------------------------------------------------------------------
+ *  _psless  --  TRUE iff heap entry i should be above heap entry j
+ *------------------------------------------------------------------------
+ */
+#define	_psless(i, j)	((long)((unsigned long)proctab[psheap[i]].ppi - \
+				(unsigned long)proctab[psheap[j]].ppi) < 0)
+
+/*------------------------------------------------------------------------
+ *  _psswap  --  exchange two heap entries
+ *------------------------------------------------------------------------
+ */
+LOCAL void _psswap(int i, int j)
+{
+	int	pid = psheap[i];
+
+	psheap[i] = psheap[j];
+	psheap[j] = pid;
+	pspos[psheap[i]] = i;
+	pspos[psheap[j]] = j;
+}
+
+/*------------------------------------------------------------------------
+ *  _psfix  --  restore heap order around entry i
+ *------------------------------------------------------------------------
+ */
+LOCAL void _psfix(int i)
+{
+	int	c;
+
+	while (i > 0 && _psless(i, (i - 1) / 2)) {
+		_psswap(i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+	while ((c = 2 * i + 1) < psn) {
+		if (c + 1 < psn && _psless(c + 1, c))
+			c++;
+		if (!_psless(c, i))
+			break;
+		_psswap(i, c);
+		i = c;
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  _psback  --  turn pid's ppi from a lag back into a virtual time
+ *------------------------------------------------------------------------
+ */
+LOCAL void _psback(int pid)
+{
+	if (psaway[pid]) {
+		proctab[pid].ppi += psvtime;
+		psaway[pid] = FALSE;
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  _psaway  --  turn pid's ppi into its lead over psvtime (never less
+ *		 than 0: time away doesn't earn credit)
+ *------------------------------------------------------------------------
+ */
+LOCAL void _psaway(int pid)
+{
+	struct	pentry	*pptr = &proctab[pid];
+
+	if (psaway[pid])
+		return;
+	if ((long)(pptr->ppi - psvtime) < 0)
+		pptr->ppi = 0;
+	else
+		pptr->ppi -= psvtime;
+	psaway[pid] = TRUE;
+}
+
+/*------------------------------------------------------------------------
+ *  schedinit  --  empty the class bookkeeping and fill it from the
+ *		   ready lists (setschedclass, LK_PROC)
+ *------------------------------------------------------------------------
+ */
+void schedinit()
+{
+	int	i;
+
+	for (i=0 ; i<NPROC ; i++) {
+		rdymember[i] = FALSE;
+		lottree[i] = lotcnt[i] = lotlent[i] = 0;
+		lotlending[i] = FALSE;
+		psaway[i] = TRUE;
+		proctab[i].ppi = 0;
+	}
+	lottotal = 0;
+	psn = 0;
+	psvtime = 0;
+
+	for (i=0 ; i<NPROC ; i++)
+		if (proctab[i].pstate == PRREADY)
+			schedadd(i);
+		else if (proctab[i].pstate == PRCURR)
+			_psback(i);
+#ifdef	SMP
+	for (i=0 ; i<ncpu ; i++)
+		cpus[i].c_psstart = _tsc();
+#else
+	psstart = _tsc();
+#endif
+}
+
+/*------------------------------------------------------------------------
+ *  schedadd  --  called by rdyinsert(): pid joined the ready list
+ *------------------------------------------------------------------------
+ */
+void schedadd(int pid)
+{
+	if (schedclass == PRIOSCHED || _idle(pid) || rdymember[pid])
+		return;
+	rdymember[pid] = TRUE;
+
+	if (schedclass == RANDOMSCHED) {
+		_lotreturn(pid);
+		_lotupdate(pid);
+	} else {
+		_psback(pid);
+		pspos[pid] = psn;
+		psheap[psn++] = pid;
+		_psfix(psn - 1);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  schedremove  --  called by rdyremove(): pid left the ready list
+ *------------------------------------------------------------------------
+ */
+void schedremove(int pid)
+{
+	int	i;
+
+	if (pid >= NPROC || !rdymember[pid])
+		return;
+	rdymember[pid] = FALSE;
+
+	if (schedclass == RANDOMSCHED) {
+		_lotset(pid, 0);
+	} else {
+		i = pspos[pid];
+		_psswap(i, --psn);
+		if (i < psn)
+			_psfix(i);
+		_psaway(pid);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  schedstop  --  resched() is taking the CPU from pid: charge it and,
+ *		   if it is blocking, lend its tickets or save its lag
+ *------------------------------------------------------------------------
+ */
+void schedstop(int pid)
+{
+	struct	pentry	*pptr = &proctab[pid];
+	unsigned long	now;
+
+	if (_idle(pid))
+		return;
+	if (schedclass == PROPORTIONALSHARE) {
+		now = _tsc();
+		if (pptr->prate > 0)
+			pptr->ppi += (now - psstart) / pptr->prate;
+		psstart = now;
+	}
+	if (pptr->pstate == PRCURR)
+		return;			/* still ready		*/
+	if (schedclass == RANDOMSCHED)
+		_lotlend(pid);
+	else
+		_psaway(pid);
+}
+
+/*------------------------------------------------------------------------
+ *  schedpick  --  take the process to run next off the ready list
+ *------------------------------------------------------------------------
+ */
+int schedpick()
+{
+	int	pid;
+
+	if (schedclass == RANDOMSCHED)
+		pid = _lotdraw();
+	else
+		pid = (psn > 0) ? psheap[0] : EMPTY;
+
+	if (pid == EMPTY)		/* nobody with a share	*/
+		return(getlast(rdytail));
+
+	dequeue(pid);
+	if (schedclass == PROPORTIONALSHARE) {
+		_psback(pid);
+		if ((long)(proctab[pid].ppi - psvtime) > 0)
+			psvtime = proctab[pid].ppi;
+		psstart = _tsc();
+	}
+	return(pid);
+}
+
+/*------------------------------------------------------------------------
+ *  schedkill  --  pid is being killed: settle its loans
+ *------------------------------------------------------------------------
+ */
+void schedkill(int pid)
+{
+	int	i;
+
+	if (schedclass == RANDOMSCHED) {
+		_lotreturn(pid);
+		for (i=0 ; i<NPROC ; i++)
+			if (proctab[i].pxferto == pid)
+				_lotreturn(i);
+	}
+	for (i=0 ; i<NPROC ; i++)
+		if (proctab[i].pxferto == pid)
+			proctab[i].pxferto = BADPID;
+	proctab[pid].pxferto = BADPID;
+	psaway[pid] = TRUE;
+}
+
+/*------------------------------------------------------------------------
+ *  setschedclass  --  choose PRIOSCHED, RANDOMSCHED or PROPORTIONALSHARE
+ *------------------------------------------------------------------------
+ */
+SYSCALL setschedclass(int class)
+{
+	STATWORD ps;
+
+	if (class != PRIOSCHED && class != RANDOMSCHED &&
+	    class != PROPORTIONALSHARE)
+		return(SYSERR);
+	lkdisable(ps, LK_PROC);
+	schedclass = class;
+	schedinit();
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  getschedclass  --  the class resched() runs
+ *------------------------------------------------------------------------
+ */
+SYSCALL getschedclass()
+{
+	return(schedclass);
+}
+
+/*------------------------------------------------------------------------
+ *  setrate  --  set the share (tickets, or rate) of a process
+ *------------------------------------------------------------------------
+ */
+SYSCALL setrate(int pid, int rate)
+{
+	STATWORD ps;
+	struct	pentry	*pptr;
+	int	lending;
+
+	lkdisable(ps, LK_PROC);
+	if (isbadpid(pid) || rate <= 0 ||
+	    (pptr = &proctab[pid])->pstate == PRFREE) {
+		restore(ps);
+		return(SYSERR);
+	}
+	lending = lotlending[pid];
+	_lotreturn(pid);
+	pptr->prate = rate;
+	if (lending)
+		_lotlend(pid);
+	_lotupdate(pid);
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  tktransfer  --  lend the caller's tickets to pid whenever the caller
+ *		    is blocked (RANDOMSCHED); BADPID stops lending
+ *------------------------------------------------------------------------
+ */
+SYSCALL tktransfer(int pid)
+{
+	STATWORD ps;
+
+	lkdisable(ps, LK_PROC);
+	if (pid != BADPID &&
+	    (isbadpid(pid) || pid == currpid || proctab[pid].pstate == PRFREE)) {
+		restore(ps);
+		return(SYSERR);
+	}
+	_lotreturn(currpid);		/* not lent while running	*/
+	proctab[currpid].pxferto = pid;
+	restore(ps);
+	return(OK);
+}
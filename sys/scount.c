@@ -12,7 +12,8 @@ SYSCALL scount(int sem)
 {
 extern	struct	sentry	semaph[];
 
-	if (isbadsem(sem) || semaph[sem].sstate==SFREE)
+	if (isbadsem(sem) || semaph[sem].sstate==SFREE ||
+	    semaph[sem].smutex)
 		return(SYSERR);
 	return(semaph[sem].semcnt);
 }
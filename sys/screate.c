@@ -18,12 +18,13 @@ SYSCALL screate(int count)
 	STATWORD ps;    
 	int	sem;
 
-	disable(ps);
+	lkdisable(ps, LK_SEM);
 	if ( count<0 || (sem=newsem())==SYSERR ) {
 		restore(ps);
 		return(SYSERR);
 	}
 	semaph[sem].semcnt = count;
+	semaph[sem].smutex = FALSE;
 	/* sqhead and sqtail were initialized at system startup */
 	restore(ps);
 	return(sem);
@@ -17,19 +17,21 @@ SYSCALL sdelete(int sem)
 	int	pid;
 	struct	sentry	*sptr;
 
-	disable(ps);
-	if (isbadsem(sem) || semaph[sem].sstate==SFREE) {
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (isbadsem(sem) || semaph[sem].sstate==SFREE ||
+	    semaph[sem].smutex) {
 		restore(ps);
 		return(SYSERR);
 	}
 	sptr = &semaph[sem];
 	sptr->sstate = SFREE;
-	if (nonempty(sptr->sqhead)) {
+	if (nonempty(sptr->sqhead) || sptr->sany != EMPTY) {
 		while( (pid=getfirst(sptr->sqhead)) != EMPTY)
 		  {
 		    proctab[pid].pwaitret = DELETED;
 		    ready(pid,RESCHNO);
 		  }
+		wanydelete(sem);
 		resched();
 	}
 	restore(ps);
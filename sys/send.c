@@ -3,6 +3,7 @@
 #include <conf.h>
 #include <kernel.h>
 #include <proc.h>
+#include <msgq.h>
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
@@ -14,14 +15,17 @@ SYSCALL	send(int pid, WORD msg)
 	STATWORD ps;    
 	struct	pentry	*pptr;
 
-	disable(ps);
+	lkdisable(ps, LK_SEM|LK_PROC);
 	if (isbadpid(pid) || ( (pptr= &proctab[pid])->pstate == PRFREE)
-	   || pptr->phasmsg != 0) {
+	   || mqfull(pptr)) {
 		restore(ps);
 		return(SYSERR);
 	}
-	pptr->pmsg = msg;
-	pptr->phasmsg = TRUE;
+	if (pptr->pmq == NULL) {	/* the one message mailbox	*/
+		pptr->pmsg = msg;
+		pptr->phasmsg = TRUE;
+	} else
+		mqput(pptr, msg);
 	if (pptr->pstate == PRRECV)	/* if receiver waits, start it	*/
 		ready(pid, RESCHYES);
 	else if (pptr->pstate == PRTRECV) {
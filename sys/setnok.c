@@ -14,7 +14,7 @@ SYSCALL	setnok(int nok, int pid)
 	STATWORD ps;    
 	struct	pentry	*pptr;
 
-	disable(ps);
+	lkdisable(ps, LK_PROC);
 	if (isbadpid(pid)) {
 		restore(ps);
 		return(SYSERR);
@@ -5,6 +5,7 @@
 #include <proc.h>
 #include <q.h>
 #include <sem.h>
+#include <trace.h>
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
@@ -16,12 +17,16 @@ SYSCALL signal(int sem)
 	STATWORD ps;    
 	register struct	sentry	*sptr;
 
-	disable(ps);
-	if (isbadsem(sem) || (sptr= &semaph[sem])->sstate==SFREE) {
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (isbadsem(sem) || (sptr= &semaph[sem])->sstate==SFREE ||
+	    sptr->smutex) {
 		restore(ps);
 		return(SYSERR);
 	}
-	if ((sptr->semcnt++) < 0)
+	TRACE(TRC_SEM, TE_SIGNAL, sem, sptr->semcnt, 0, 0);
+	if (sptr->semcnt >= 0 && sptr->sany != EMPTY)
+		wanysignal(sem, RESCHYES);	/* a waitany() gets it	*/
+	else if ((sptr->semcnt++) < 0)
 		ready(getfirst(sptr->sqhead), RESCHYES);
 	restore(ps);
 	return(OK);
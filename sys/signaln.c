@@ -1,4 +1,4 @@
-/* signaln.c - signaln */
+/* signaln.c - signaln, isignaln */
 
 #include <conf.h>
 #include <kernel.h>
@@ -14,18 +14,45 @@
 SYSCALL signaln(int sem, int count)
 {
 	STATWORD ps;    
-	struct	sentry	*sptr;
 
-	disable(ps);
-	if (isbadsem(sem) || semaph[sem].sstate==SFREE || count<=0) {
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (isignaln(sem, count) == SYSERR) {
 		restore(ps);
 		return(SYSERR);
 	}
-	sptr = &semaph[sem];
-	for (; count > 0  ; count--)
-		if ((sptr->semcnt++) < 0)
-			ready(getfirst(sptr->sqhead), RESCHNO);
 	resched();
 	restore(ps);
 	return(OK);
 }
+
+/*------------------------------------------------------------------------
+ *  isignaln -- signaln() for interrupt handlers and drivers: the
+ *		processes are readied but not run; returns how many were
+ *		readied. Called with interrupts disabled; takes LK_SEM
+ *		and LK_PROC itself if the caller does not hold them
+ *------------------------------------------------------------------------
+ */
+int isignaln(int sem, int count)
+{
+	STATWORD ps;
+	struct	sentry	*sptr;
+	int	n;
+
+	lklock(ps, LK_SEM|LK_PROC);
+	if (isbadsem(sem) || semaph[sem].sstate==SFREE ||
+	    semaph[sem].smutex || count<=0) {
+		lkrestore(ps);
+		return(SYSERR);
+	}
+	sptr = &semaph[sem];
+	for (n=0 ; count > 0  ; count--)
+		if (sptr->semcnt >= 0 && sptr->sany != EMPTY) {
+			wanysignal(sem, RESCHNO);
+			n++;
+		} else if ((sptr->semcnt++) < 0) {
+			ready(getfirst(sptr->sqhead), RESCHNO);
+			n++;
+		}
+	lkrestore(ps);
+	return(n);
+}
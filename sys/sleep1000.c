@@ -5,6 +5,7 @@
 #include <proc.h>
 #include <q.h>
 #include <sleep.h>
+#include <timer.h>
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
@@ -15,15 +16,13 @@ SYSCALL sleep1000(int n)
 {
 	STATWORD ps;    
 
-	if (n < 0  || clkruns==0)
+	if (n < 0  || n > TM_MAXTICKS/TM_MS(1) || clkruns==0)
 	         return(SYSERR);
-	disable(ps);
+	lkdisable(ps, LK_PROC);
 	if (n == 0) {		/* sleep1000(0) -> end time slice */
 	        ;
 	} else {
-		insertd(currpid,clockq,n);
-		slnempty = TRUE;
-		sltop = &q[q[clockq].qnext].qkey;
+		tmsleep(currpid, TM_MS(n));
 		proctab[currpid].pstate = PRSLEEP;
 	}
 	resched();
@@ -0,0 +1,826 @@
+/* smp.c - smpinit, smpstart, apmain, lapicinit, lkdisable, lkunlock,
+ *	   smpswitch, smpresume, smpnew, smpquantum, apictick, smpsteal,
+ *	   smpkick, smpipi, smpreqs, smpintr, smpflush, tlbintr, smpidle
+ */
+
+#include <conf.h>
+#include <i386.h>
+#include <kernel.h>
+#include <stdio.h>
+#include <proc.h>
+#include <q.h>
+#include <paging.h>
+#include <timer.h>
+#include <mp.h>
+
+/* apboot.S, intr.S and the interrupt stubs are assembled with or	*/
+/* without SMP and need these						*/
+unsigned long	apstack;		/* SP apboot starts apmain on	*/
+unsigned long	apcr3;			/* page directory for apboot	*/
+void	(*apentry)();			/* apmain			*/
+void	(*smptick)();			/* apictick, once the APIC	*/
+					/*   timers preempt		*/
+void	(*smpreq)();			/* smpintr			*/
+void	(*smptlb)();			/* tlbintr			*/
+#ifdef	SMP
+int	intrif = TRUE;			/* disable() only clears IF	*/
+void	(*smpunlock)(int) = lkunlock;	/* restore() lets locks go	*/
+#else
+int	intrif = FALSE;
+void	(*smpunlock)(int);
+#endif
+
+#ifdef	SMP
+
+/*
+ * With SMP Xinu starts the other processors listed in the MP table
+ * (see mpinit.c). Each is woken by an INIT and two startup IPIs from
+ * the boot processor's local APIC, runs apboot (apboot.S) in the page
+ * the IPI names, and comes to apmain() in protected mode with paging
+ * on. The APICs are reached through the global page table that
+ * init_apic_pt() made before the first page directory. Each processor
+ * then loads a GDT of its own: entry CPUGD is a data segment based at
+ * its struct cpu (%fs, for cpu()), and the two TSS entries are its own
+ * copies of the Xinu and page fault tasks, so that under VSTACK every
+ * processor can take page faults at once.
+ *
+ * The 8259s stay wired to the boot processor only (virtual wire mode
+ * through its LINT0); the other processors have LINT0 and LINT1
+ * masked and only ever see interrupts from their own local APIC.
+ *
+ * Each processor has a struct cpu (mp.h) with its current process, its
+ * ready list and an idle process: the null process on the boot
+ * processor, one made by smpstart() on each of the others. resched()
+ * works on the running processor's list and first takes the best ready
+ * process from another's when that is better than anything it has, or
+ * as good with two more waiting there (smpsteal). Making a process
+ * ready also wakes an idle processor to come and look (smpkick). The
+ * share classes pick from every processor's list at once (schedpick).
+ * Each processor's APIC timer is a one-shot for the running process's
+ * quantum; an idle processor's is stopped.
+ *
+ * Interrupts are no longer enough to keep the kernel data consistent,
+ * and disable() can't use the 8259 mask the processors share: with SMP
+ * it only clears IF. lkdisable() also takes a spin lock per structure
+ * (the LK_ bits in kernel.h): LK_PROC for proctab with the q table,
+ * ready lists, timers and clock, LK_SEM for semaph, LK_BS for bs_tab,
+ * LK_FRM for frm_tab and the page tables, and so on. restore() lets go
+ * of those its lkdisable() took. A processor holds a lock as many
+ * times as it asked, so code called with a lock held may ask again.
+ * Locks are taken lowest bit first; asking for one below a lock already
+ * held lets go of the higher ones and takes them all again in order,
+ * so callers that need several (kill, create) ask for them up front.
+ *
+ * A process that blocks lets go of its locks but keeps its counts:
+ * smpswitch() saves the processor's counts in plkdepth and lets go of
+ * all but LK_PROC, which the switch itself needs; smpresume() takes
+ * them back when the process runs again, as wait() would have to with
+ * a lock of its own. A new process starts with none (smpnew). klog()
+ * is the one caller that can't take what it needs (LK_SEM and LK_PROC
+ * under the paging locks); it leaves klogd to the next message.
+ *
+ * A process running on another processor can't be killed or suspended
+ * from here: it is still on its stack. kill() and suspend() mark it
+ * (psmpreq) and interrupt that processor, which does it (smpreqs). A
+ * process that kills itself stays PRDEAD until its processor has
+ * switched off its stack, which smpresume() then frees (c_reap).
+ *
+ * A processor only caches translations of the page directory it runs
+ * on and loads CR3 when it switches to another, so only removing a
+ * mapping concerns the others: p_invalidate() calls smpflush(), which
+ * interrupts the processors running on that directory and waits until
+ * they have reloaded CR3. A processor spinning for a lock has
+ * interrupts off, so it looks for the request there.
+ */
+
+#define	APSTK		1024		/* words of stack for apmain()	*/
+#define	APTRIES		100		/* ms to wait for a processor	*/
+#define	CALMS		10		/* ms to calibrate APIC timer on*/
+#define	LKPROC		4		/* bit number of LK_PROC	*/
+
+extern	struct	sd	gdt[];
+extern	int	apboot();
+extern	int	apicspur(), apictimer(), apicflush(), apicresched();
+extern	int	ctxsw();
+
+struct	cpu	cpus[NCPU];
+volatile unsigned long	*lapic = NULL;	/* the local APIC, once mapped	*/
+LOCAL	int	apnext;			/* cpu index apboot is starting	*/
+LOCAL	WORD	apstk[APSTK];
+LOCAL	struct	sd	apgdt[NCPU][NGD]; /* GDTs of the other processors*/
+LOCAL	struct	tss	aptss[NCPU][2];	/*   and their tasks		*/
+LOCAL	unsigned long	lapicpms;	/* APIC timer counts per ms	*/
+LOCAL	int	lkready = FALSE;	/* %fs loaded: locks work	*/
+LOCAL	int	stealing = FALSE;	/* smpsteal() moving one (LK_PROC)*/
+
+LOCAL	struct	{
+	volatile int	lk_held;	/* a processor has it		*/
+	int	lk_pad[15];		/* one cache line per lock	*/
+} lktab[NLOCK];
+
+void	apmain();
+
+/*------------------------------------------------------------------------
+ *  _xchg  --  atomically store v in *p and return what was there
+ *------------------------------------------------------------------------
+ */
+LOCAL int _xchg(volatile int *p, int v)
+{
+	asm volatile("xchgl %0,%1" : "+r" (v), "+m" (*p) : : "memory");
+	return(v);
+}
+
+/*------------------------------------------------------------------------
+ *  _sdbase  --  set the base address of a segment descriptor
+ *------------------------------------------------------------------------
+ */
+LOCAL void _sdbase(struct sd *psd, void *p)
+{
+	unsigned long	base = (unsigned long) p;
+
+	psd->sd_lobase = base & 0xffff;
+	psd->sd_midbase = (base >> 16) & 0xff;
+	psd->sd_hibase = base >> 24;
+}
+
+/*------------------------------------------------------------------------
+ *  _cpuseg  --  make *psd the data segment of the struct cpu at cp
+ *------------------------------------------------------------------------
+ */
+LOCAL void _cpuseg(struct sd *psd, struct cpu *cp)
+{
+	_sdbase(psd, cp);
+	psd->sd_lolimit = sizeof(struct cpu) - 1;
+	psd->sd_perm = 2;		/* data, writable		*/
+	psd->sd_iscode = 0;
+	psd->sd_isapp = 1;
+	psd->sd_dpl = 0;
+	psd->sd_present = 1;
+	psd->sd_hilimit = 0;
+	psd->sd_avl = 0;
+	psd->sd_mbz = 0;
+	psd->sd_32b = 1;
+	psd->sd_gran = 0;		/* byte granular limit		*/
+}
+
+/*------------------------------------------------------------------------
+ *  _cpuload  --  point this processor's %fs at its struct cpu
+ *------------------------------------------------------------------------
+ */
+LOCAL void _cpuload()
+{
+	asm volatile("movw %w0,%%fs" : : "r" (CPUSEL));
+}
+
+/*------------------------------------------------------------------------
+ *  _cpugdt  --  give an application processor a GDT and tasks of its
+ *		 own, copied from the boot processor's, and load them
+ *------------------------------------------------------------------------
+ */
+LOCAL void _cpugdt(struct cpu *cp)
+{
+	struct	sd	*g = apgdt[cp->c_id];
+	unsigned short	gdtr[3];
+
+	blkcopy(g, gdt, NGD * sizeof(struct sd));
+	blkcopy(cp->c_tss, i386_tasks, 2 * sizeof(struct tss));
+	_sdbase(&g[5], &cp->c_tss[0]);
+	g[5].sd_perm = 1;		/* an available TSS, not busy	*/
+	_sdbase(&g[6], &cp->c_tss[1]);
+	g[6].sd_perm = 1;
+	_cpuseg(&g[CPUGD], cp);
+
+	gdtr[0] = NGD * sizeof(struct sd) - 1;
+	gdtr[1] = (unsigned long) g & 0xffff;
+	gdtr[2] = (unsigned long) g >> 16;
+	asm volatile("lgdt (%0)" : : "r" (gdtr) : "memory");
+	asm volatile("ltr %w0" : : "r" (0x28));
+	_cpuload();
+}
+
+/*------------------------------------------------------------------------
+ *  smpinit  --  set up the struct cpus, boot processor's %fs (sysinit,
+ *		 after mpinit)
+ *------------------------------------------------------------------------
+ */
+void smpinit()
+{
+	struct	cpu	*cp;
+	int	i, j;
+
+	for (i=0 ; i<NCPU ; i++) {
+		cp = &cpus[i];
+		cp->c_self = cp;
+		cp->c_id = i;
+		cp->c_currpid = NULLPROC;
+		cp->c_lkheld = 0;
+		for (j=0 ; j<NLOCK ; j++)
+			cp->c_lkdepth[j] = 0;
+		cp->c_idlepid = NULLPROC;
+		cp->c_reap = EMPTY;
+		cp->c_tss = (i == cpubsp) ? i386_tasks : aptss[i];
+		cp->c_online = FALSE;
+		cp->c_flush = FALSE;
+		cp->c_kicked = FALSE;
+		cp->c_nsteal = cp->c_nswitch = 0;
+	}
+	cpus[cpubsp].c_online = TRUE;
+	_cpuseg(&gdt[CPUGD], &cpus[cpubsp]);
+	_cpuload();
+	lkready = TRUE;
+}
+
+/*------------------------------------------------------------------------
+ *  _tlbdrop  --  reload CR3, as smpflush() asked of this processor
+ *------------------------------------------------------------------------
+ */
+LOCAL void _tlbdrop()
+{
+	asm volatile("movl %%cr3,%%eax; movl %%eax,%%cr3" : : : "eax", "memory");
+	cpu()->c_flush = FALSE;
+}
+
+/*------------------------------------------------------------------------
+ *  _lkget  --  take the locks in locks, lowest first
+ *------------------------------------------------------------------------
+ */
+LOCAL void _lkget(struct cpu *cp, int locks)
+{
+	int	i;
+
+	for (i=0 ; i<NLOCK ; i++) {
+		if ((locks & (1 << i)) == 0)
+			continue;
+		while (_xchg(&lktab[i].lk_held, TRUE))
+			while (lktab[i].lk_held)
+				if (cp->c_flush)   /* the holder may wait on us	*/
+					_tlbdrop();
+				else
+					asm volatile("pause");
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  _lkput  --  let go of the locks in locks
+ *------------------------------------------------------------------------
+ */
+LOCAL void _lkput(int locks)
+{
+	int	i;
+
+	asm volatile("" : : : "memory");
+	for (i=0 ; i<NLOCK ; i++)
+		if (locks & (1 << i))
+			lktab[i].lk_held = FALSE;
+}
+
+/*------------------------------------------------------------------------
+ *  lkdisable  --  disable interrupts and take the locks in locks (LK_
+ *		   bits), once more for those this processor holds
+ *------------------------------------------------------------------------
+ */
+void lkdisable(STATWORD ps, int locks)
+{
+	struct	cpu	*cp;
+	int	want, above, i;
+
+	disable(ps);
+	if (!lkready || locks == 0)
+		return;
+	cp = cpu();
+	want = locks & ~cp->c_lkheld;
+	if (want != 0) {
+		/* held locks above the lowest one wanted go and come back */
+		above = cp->c_lkheld & ~((want & -want) - 1);
+		_lkput(above);
+		_lkget(cp, want | above);
+		cp->c_lkheld |= want;
+	}
+	for (i=0 ; i<NLOCK ; i++)
+		if (locks & (1 << i))
+			cp->c_lkdepth[i]++;
+	ps[1] = locks;
+}
+
+/*------------------------------------------------------------------------
+ *  lkunlock  --  undo one lkdisable() of each lock in locks (restore,
+ *		  through smpunlock)
+ *------------------------------------------------------------------------
+ */
+void lkunlock(int locks)
+{
+	struct	cpu	*cp = cpu();
+	int	i;
+
+	for (i=0 ; i<NLOCK ; i++)
+		if ((locks & (1 << i)) && --cp->c_lkdepth[i] == 0) {
+			cp->c_lkheld &= ~(1 << i);
+			_lkput(1 << i);
+		}
+}
+
+/*------------------------------------------------------------------------
+ *  smpswitch  --  optr is being switched out for nptr: save its locks
+ *		   and keep only LK_PROC for the switch (resched)
+ *------------------------------------------------------------------------
+ */
+void smpswitch(struct pentry *optr, struct pentry *nptr)
+{
+	struct	cpu	*cp = cpu();
+	int	i;
+
+	for (i=0 ; i<NLOCK ; i++) {
+		optr->plkdepth[i] = cp->c_lkdepth[i];
+		cp->c_lkdepth[i] = 0;
+	}
+	_lkput(cp->c_lkheld & ~LK_PROC);
+	cp->c_lkheld = LK_PROC;
+	cp->c_lkdepth[LKPROC] = 1;
+	nptr->pcpu = cp->c_id;
+	cp->c_nswitch++;
+}
+
+/*------------------------------------------------------------------------
+ *  _smpreap  --  free the stack of a process that killed itself, now
+ *		  that its processor is off it
+ *------------------------------------------------------------------------
+ */
+LOCAL void _smpreap(int pid)
+{
+	STATWORD ps;
+
+	lkdisable(ps, LK_MEM|LK_PROC|LK_BS|LK_FRM);
+	killstk(pid);
+	proctab[pid].pstate = PRFREE;
+	restore(ps);
+}
+
+/*------------------------------------------------------------------------
+ *  smpresume  --  the current process is back from ctxsw(): reap the
+ *		   one switched away from if it died, and take back the
+ *		   locks this one held (resched, smpnew)
+ *------------------------------------------------------------------------
+ */
+void smpresume()
+{
+	struct	cpu	*cp = cpu();
+	struct	pentry	*pptr;
+	int	i, locks;
+
+	lkunlock(LK_PROC);		/* what smpswitch() kept	*/
+	if (cp->c_reap != EMPTY) {
+		_smpreap(cp->c_reap);
+		cp->c_reap = EMPTY;
+	}
+	pptr = &proctab[cp->c_currpid];
+	locks = 0;
+	for (i=0 ; i<NLOCK ; i++)
+		if (pptr->plkdepth[i] > 0)
+			locks |= 1 << i;
+	_lkget(cp, locks);
+	cp->c_lkheld = locks;
+	for (i=0 ; i<NLOCK ; i++)
+		cp->c_lkdepth[i] = pptr->plkdepth[i];
+}
+
+/*------------------------------------------------------------------------
+ *  smpnew  --  where a new process first returns to from ctxsw(): it
+ *		holds no locks yet; returns in turn to the process's code
+ *		(see create)
+ *------------------------------------------------------------------------
+ */
+void smpnew()
+{
+	smpresume();
+	asm volatile("sti");
+}
+
+/*------------------------------------------------------------------------
+ *  _lapicw  --  write a local APIC register and wait for it to take
+ *------------------------------------------------------------------------
+ */
+LOCAL void _lapicw(int reg, unsigned long val)
+{
+	lapic[reg / 4] = val;
+	(void) lapic[LAPIC_ID / 4];
+}
+
+/*------------------------------------------------------------------------
+ *  _lapicipi  --  send an interprocessor interrupt to local APIC id
+ *------------------------------------------------------------------------
+ */
+LOCAL void _lapicipi(int apicid, unsigned long cmd)
+{
+	_lapicw(LAPIC_ICRHI, (unsigned long)apicid << 24);
+	_lapicw(LAPIC_ICRLO, cmd);
+	while (lapic[LAPIC_ICRLO / 4] & ICR_PENDING)
+		/* empty */;
+}
+
+/*------------------------------------------------------------------------
+ *  lapicinit  --  enable this processor's local APIC; the boot
+ *		   processor keeps taking the 8259's interrupts
+ *------------------------------------------------------------------------
+ */
+void lapicinit(int bsp)
+{
+	_lapicw(LAPIC_SVR, LAPIC_ENABLE | IVEC_SPUR);
+	_lapicw(LAPIC_TIMER, LAPIC_MASKED);
+	if (bsp) {
+		_lapicw(LAPIC_LINT0, LAPIC_EXTINT);
+		_lapicw(LAPIC_LINT1, LAPIC_NMI);
+	} else {
+		_lapicw(LAPIC_LINT0, LAPIC_MASKED);
+		_lapicw(LAPIC_LINT1, LAPIC_MASKED);
+	}
+	_lapicw(LAPIC_ERROR, LAPIC_MASKED);
+	_lapicw(LAPIC_ESR, 0);		/* clear errors (back to back)	*/
+	_lapicw(LAPIC_ESR, 0);
+	_lapicw(LAPIC_EOI, 0);
+	_lapicw(LAPIC_TPR, 0);
+}
+
+/*------------------------------------------------------------------------
+ *  _lapiccal  --  count the APIC timer against the 8254 (clkspin); all
+ *		   processors share the bus clock it runs from
+ *------------------------------------------------------------------------
+ */
+LOCAL void _lapiccal()
+{
+	_lapicw(LAPIC_TDCR, LAPIC_DIV16);
+	_lapicw(LAPIC_TIMER, LAPIC_MASKED);
+	_lapicw(LAPIC_TICR, 0xffffffff);
+	clkspin(CALMS);
+	lapicpms = (0xffffffff - lapic[LAPIC_TCCR / 4]) / CALMS;
+	_lapicw(LAPIC_TICR, 0);
+}
+
+/*------------------------------------------------------------------------
+ *  _lapictimer  --  make this processor's APIC timer a one-shot, not
+ *		     yet counting (see smpquantum)
+ *------------------------------------------------------------------------
+ */
+LOCAL void _lapictimer()
+{
+	_lapicw(LAPIC_TDCR, LAPIC_DIV16);
+	_lapicw(LAPIC_TIMER, IVEC_TIMER);
+	_lapicw(LAPIC_TICR, 0);
+}
+
+/*------------------------------------------------------------------------
+ *  smpquantum  --  start the current process's quantum on this
+ *		    processor's APIC timer, or stop it for the idle
+ *		    process; FALSE while the 8254 still preempts
+ *		    (resched, LK_PROC)
+ *------------------------------------------------------------------------
+ */
+int smpquantum()
+{
+	if (smptick == NULL)
+		return(FALSE);
+	if (currpid == cpuget(c_idlepid))
+		_lapicw(LAPIC_TICR, 0);
+	else
+		_lapicw(LAPIC_TICR, lapicpms * QUANTUM);
+	return(TRUE);
+}
+
+/*------------------------------------------------------------------------
+ *  apictick  --  the quantum is up: reschedule, and start another if
+ *		  the same process goes on (apictimer)
+ *------------------------------------------------------------------------
+ */
+void apictick()
+{
+	STATWORD ps;
+	unsigned long	nswitch;
+
+	_lapicw(LAPIC_EOI, 0);
+	lkdisable(ps, LK_PROC);
+	nswitch = cpuget(c_nswitch);
+	resched();
+	if (cpuget(c_nswitch) == nswitch)
+		smpquantum();
+	restore(ps);
+}
+
+/*------------------------------------------------------------------------
+ *  smpsteal  --  take the best ready process from another processor if
+ *		  it beats anything here, or ties with two more waiting
+ *		  there than here (resched, LK_PROC)
+ *------------------------------------------------------------------------
+ */
+void smpsteal()
+{
+	struct	cpu	*cp, *from;
+	struct	pentry	*pptr;
+	int	best, most, key, n, i;
+
+	cp = cpu();
+	best = lastkey(cp->c_rdytail);
+	most = rdycount(cp->c_rdyhead) + 1;
+	pptr = &proctab[cp->c_currpid];
+	if (pptr->pstate == PRCURR && cp->c_currpid != cp->c_idlepid) {
+		most++;
+		if (pptr->pprio > best)
+			best = pptr->pprio;
+	}
+	from = NULL;
+	for (i=0 ; i<ncpu ; i++) {
+		if (&cpus[i] == cp || !cpus[i].c_online)
+			continue;
+		key = lastkey(cpus[i].c_rdytail);
+		if (key <= 0)			/* never an idle process */
+			continue;
+		n = rdycount(cpus[i].c_rdyhead);
+		if (key > best || (key == best && n > most)) {
+			best = key;
+			most = n;
+			from = &cpus[i];
+		}
+	}
+	if (from != NULL) {
+		stealing = TRUE;	/* this processor runs it: no kick */
+		insert(getlast(from->c_rdytail), cp->c_rdyhead, best);
+		stealing = FALSE;
+		cp->c_nsteal++;
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  smpkick  --  a process was made ready: have an idle processor come
+ *		 and look, this one last (rdyinsert, LK_PROC)
+ *------------------------------------------------------------------------
+ */
+void smpkick()
+{
+	struct	cpu	*cp;
+	int	i, me;
+
+	if (smptick == NULL || stealing) /* APs not scheduling yet	*/
+		return;
+	me = cpuget(c_id);
+	for (i=1 ; i<=ncpu ; i++) {
+		cp = &cpus[(me + i) % ncpu];
+		if (cp->c_online && !cp->c_kicked &&
+		    cp->c_currpid == cp->c_idlepid) {
+			cp->c_kicked = TRUE;
+			_lapicipi(cpuapic[cp->c_id], IVEC_REQ);
+			return;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  smpipi  --  have processor cpuid look at the requests (smpreqs)
+ *------------------------------------------------------------------------
+ */
+void smpipi(int cpuid)
+{
+	if (lapic != NULL && cpus[cpuid].c_online)
+		_lapicipi(cpuapic[cpuid], IVEC_REQ);
+}
+
+/*------------------------------------------------------------------------
+ *  _smpreq  --  take what another processor asked of pid: PRQ_ bits,
+ *		 or 0 if nothing or pid has moved on to another processor
+ *------------------------------------------------------------------------
+ */
+LOCAL int _smpreq(int pid)
+{
+	STATWORD ps;
+	struct	pentry	*pptr = &proctab[pid];
+	int	req;
+
+	lkdisable(ps, LK_PROC);
+	req = pptr->psmpreq;
+	if (req != 0 && pptr->pstate == PRCURR && pid != currpid) {
+		smpipi(pptr->pcpu);	/* it moved on; follow it	*/
+		req = 0;
+	} else
+		pptr->psmpreq = 0;
+	restore(ps);
+	return(req);
+}
+
+/*------------------------------------------------------------------------
+ *  smpreqs  --  kill or suspend the processes that kill() and suspend()
+ *		 marked while they ran here (no locks held)
+ *------------------------------------------------------------------------
+ */
+void smpreqs()
+{
+	int	pid, req, self;
+
+	self = currpid;
+	for (pid=1 ; pid<NPROC ; pid++) {
+		if (pid == self || (req = _smpreq(pid)) == 0)
+			continue;
+		if (req & PRQ_KILL)
+			kill(pid);
+		else
+			suspend(pid);
+	}
+	if ((req = _smpreq(self)) != 0) {	/* last: it may not return */
+		if (req & PRQ_KILL)
+			kill(self);
+		else
+			suspend(self);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  smpintr  --  IVEC_REQ from another processor: requests, or work for
+ *		 this one if it is idle (apicresched)
+ *------------------------------------------------------------------------
+ */
+void smpintr()
+{
+	STATWORD ps;
+
+	_lapicw(LAPIC_EOI, 0);
+	smpreqs();
+	lkdisable(ps, LK_PROC);
+	cpu()->c_kicked = FALSE;
+	if (currpid == cpuget(c_idlepid))
+		resched();
+	restore(ps);
+}
+
+/*------------------------------------------------------------------------
+ *  smpflush  --  have the other processors running on page directory
+ *		  pd drop their TLBs, and wait until they have
+ *		  (p_invalidate, LK_FRM)
+ *------------------------------------------------------------------------
+ */
+void smpflush(void *pd)
+{
+	struct	cpu	*cp, *me;
+	int	i;
+
+	if (smptick == NULL)		/* nobody else running yet	*/
+		return;
+	me = cpu();
+	for (i=0 ; i<ncpu ; i++) {
+		cp = &cpus[i];
+		if (cp == me || !cp->c_online ||
+		    (void *) proctab[cp->c_currpid].pd != pd)
+			continue;
+		cp->c_flush = TRUE;
+		_lapicipi(cpuapic[i], IVEC_FLUSH);
+	}
+	for (i=0 ; i<ncpu ; i++)
+		while (cpus[i].c_flush)
+			if (me->c_flush)	/* another one is waiting	*/
+				_tlbdrop();
+			else
+				asm volatile("pause");
+}
+
+/*------------------------------------------------------------------------
+ *  tlbintr  --  IVEC_FLUSH from another processor (apicflush); takes
+ *		 no lock, the sender may be holding any
+ *------------------------------------------------------------------------
+ */
+void tlbintr()
+{
+	_lapicw(LAPIC_EOI, 0);
+	_tlbdrop();
+}
+
+/*------------------------------------------------------------------------
+ *  smpidle  --  is pid a processor's idle process
+ *------------------------------------------------------------------------
+ */
+int smpidle(int pid)
+{
+	int	i;
+
+	for (i=0 ; i<ncpu ; i++)
+		if (cpus[i].c_idlepid == pid)
+			return(TRUE);
+	return(FALSE);
+}
+
+/*------------------------------------------------------------------------
+ *  _idle  --  an application processor's null process; smpintr()
+ *	       reschedules it when there is work
+ *------------------------------------------------------------------------
+ */
+LOCAL PROCESS _idle()
+{
+	cpu()->c_online = TRUE;
+	while (TRUE)
+		asm("hlt");
+	return(OK);			/* not reached			*/
+}
+
+/*------------------------------------------------------------------------
+ *  smpstart  --  start the other processors, one at a time; returns
+ *		  how many processors are running (nulluser)
+ *------------------------------------------------------------------------
+ */
+int smpstart()
+{
+	STATWORD ps;
+	unsigned long	page;
+	int	i, j, nrun, pid;
+
+	if (ncpu < 2 || apicpt == NULL)
+		return(1);
+	page = (unsigned long) apboot;
+	if ((page & (NBPG-1)) != 0 || page >= 0x100000) {
+		kprintf("apboot at 0x%lx is not a page below 1MB\n", page);
+		return(1);
+	}
+
+	lapic = (volatile unsigned long *) lapicaddr;
+	smpreq = smpintr;
+	smptlb = tlbintr;
+	set_evec(IVEC_SPUR, (long) apicspur);
+	set_evec(IVEC_FLUSH, (long) apicflush);
+	set_evec(IVEC_TIMER, (long) apictimer);
+	set_evec(IVEC_REQ, (long) apicresched);
+	lapicinit(TRUE);
+	_lapiccal();
+	_lapictimer();
+	apcr3 = (unsigned long) kernpd;
+	apentry = apmain;
+
+	nrun = 1;
+	for (i=0 ; i<ncpu ; i++) {
+		if (i == cpubsp)
+			continue;
+		pid = create((int *) _idle, NULLSTK, 1, "prnull", 0, 0);
+		if (pid == SYSERR)
+			break;
+		proctab[pid].pprio = proctab[pid].pbprio = 0;
+		numproc--;		/* like the null process	*/
+		cpus[i].c_idlepid = pid;
+
+		apnext = i;
+		apstack = (unsigned long) &apstk[APSTK-1];
+		_lapicipi(cpuapic[i], ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+		clkspin(10);
+		_lapicipi(cpuapic[i], ICR_INIT | ICR_LEVEL);
+		for (j=0 ; j<2 && !cpus[i].c_online ; j++) {
+			_lapicipi(cpuapic[i], ICR_STARTUP | (page >> 12));
+			clkspin(1);
+		}
+		for (j=0 ; j<APTRIES && !cpus[i].c_online ; j++)
+			clkspin(1);
+		if (!cpus[i].c_online) {
+			/* it may still be using apstk; start no more */
+			kprintf("processor %d (APIC id %d) did not start\n",
+				i, cpuapic[i]);
+			cpus[i].c_idlepid = NULLPROC;
+			break;
+		}
+		nrun++;
+	}
+
+	/* From here on the APIC timers preempt, the boot processor's	*/
+	/* too, instead of the 8254 (see clkint and clkevent)		*/
+	lkdisable(ps, LK_PROC);
+	smptick = apictick;
+	smpquantum();
+	restore(ps);
+	return(nrun);
+}
+
+/*------------------------------------------------------------------------
+ *  apmain  --  an application processor, in protected mode on apstk;
+ *		becomes its idle process
+ *------------------------------------------------------------------------
+ */
+void apmain()
+{
+	STATWORD ps;
+	struct	cpu	*cp;
+	struct	pentry	*nptr;
+	unsigned long	pdbr;
+	int	junksp;
+
+	cp = &cpus[apnext];
+	_cpugdt(cp);
+#ifdef	VSTACK
+	init_pftask(kernpd);
+#endif
+	lapicinit(FALSE);
+	_lapictimer();
+
+	/* switch to the idle process as resched() would, holding	*/
+	/* LK_PROC once for smpnew() to let go of			*/
+	lkdisable(ps, LK_PROC);
+	setcurrpid(cp->c_idlepid);
+	nptr = &proctab[cp->c_idlepid];
+	nptr->pstate = PRCURR;
+	nptr->pcpu = cp->c_id;
+	pdbr = 0;
+	if (nptr->pd != kernpd)
+		pdbr = VA2VPNO(nptr->pd) << 12;
+	ctxsw(&junksp, ps, &nptr->pesp, nptr->pirmask, pdbr,
+	      &cp->c_tss[0].ts_pdbr);
+}
+
+#endif
@@ -18,8 +18,9 @@ SYSCALL sreset(int sem, int count)
 	int	pid;
 	int	slist;
 
-	disable(ps);
-	if (isbadsem(sem) || count<0 || semaph[sem].sstate==SFREE) {
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (isbadsem(sem) || count<0 || semaph[sem].sstate==SFREE ||
+	    semaph[sem].smutex) {
 		restore(ps);
 		return(SYSERR);
 	}
@@ -27,6 +28,8 @@ SYSCALL sreset(int sem, int count)
 	slist = sptr->sqhead;
 	while ((pid=getfirst(slist)) != EMPTY)
 		ready(pid,RESCHNO);
+	while (sptr->sany != EMPTY)
+		wanysignal(sem, RESCHNO);
 	sptr->semcnt = count;
 	resched();
 	restore(ps);
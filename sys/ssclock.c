@@ -25,9 +25,8 @@ int strtclk()
 {
 	STATWORD ps;    
 	int makeup;
-	int next;
 
-	disable(ps);
+	lkdisable(ps, LK_SEM|LK_PROC);
 	if ( defclk<=0 || --defclk>0 ) {
 		restore(ps);
 		return;
@@ -35,17 +34,8 @@ int strtclk()
 	makeup = clkdiff;
 	preempt -= makeup;
 	clkdiff = 0;
-	if ( slnempty ) {
-		for (next=firstid(clockq) ; 
-		    next < NPROC && q[next].qkey < makeup ;
-		    next=q[next].qnext) {
-			makeup -= q[next].qkey;
-			q[next].qkey = 0;
-		}
-		if (next < NPROC)
-			q[next].qkey -= makeup;
-		wakeup();
-	}
+	if ( slnempty )
+		wakeup();	/* runs the wheel up to ctr1000 */
 	if ( preempt <= 0 )
 	        resched();
 	restore(ps);
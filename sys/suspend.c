@@ -16,12 +16,22 @@ SYSCALL	suspend(int pid)
 	struct	pentry	*pptr;		/* pointer to proc. tab. entry	*/
 	int	prio;			/* priority returned		*/
 
-	disable(ps);
+	lkdisable(ps, LK_PROC);
 	if (isbadpid(pid) || pid==NULLPROC ||
 	 ((pptr= &proctab[pid])->pstate!=PRCURR && pptr->pstate!=PRREADY)) {
 		restore(ps);
 		return(SYSERR);
 	}
+#ifdef	SMP
+	if (smpidle(pid)) {
+		restore(ps);
+		return(SYSERR);
+	}
+	if (pptr->pstate == PRCURR && pid != currpid) {
+		pptr->psmpreq |= PRQ_SUSP;	/* see smpreqs		*/
+		smpipi(pptr->pcpu);
+	} else
+#endif
 	if (pptr->pstate == PRREADY) {
 		pptr->pstate = PRSUSP;
 		dequeue(pid);
@@ -0,0 +1,359 @@
+/* timer.c - tminit, tmclear, tmset, tmcancel, tmadvance, tmnext, tmsleep, tmunsleep */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <sleep.h>
+#include <stdio.h>
+#include <timer.h>
+
+/*
+ * Sleeping processes and kernel timers share one timing wheel (see
+ * timer.h). Arming a timer puts it at the head of the slot it expires
+ * in and cancelling it unlinks it, both without looking at any other
+ * timer. Each clock tick runs the level 0 slot for that tick; every
+ * TM_L0SIZE ticks one slot of the level above is emptied and its
+ * timers are put back at the level they now belong to.
+ *
+ * tmnow is the next tick the wheel has to process. While no timer is
+ * armed clkint() doesn't call wakeup() at all, so tmnow is brought up
+ * to date when the first one is armed.
+ *
+ * A bitmap per level records which slots are nonempty. tmadvance()
+ * uses it to skip straight to the next tick that has something to do
+ * (with TICKLESS the wheel can be many thousands of ticks behind), and
+ * tmnext() uses it to tell the clock when to interrupt next.
+ */
+
+#define	TM_L0MASK	(TM_L0SIZE - 1)
+#define	TM_LNMASK	(TM_LNSIZE - 1)
+#define	TM_LNSHIFT(l)	(TM_L0BITS + (l) * TM_LNBITS)
+
+#ifdef	TICKLESS
+#define	tmclock()	clknow()	/* ticks are microseconds	*/
+#else
+#define	tmclock()	ctr1000		/* ticks are clock ticks	*/
+#endif
+
+extern	unsigned long	ctr1000;
+
+LOCAL	struct	tmentry	*tml0[TM_L0SIZE];		/* level 0	*/
+LOCAL	struct	tmentry	*tmln[TM_NLEVELS-1][TM_LNSIZE];	/* levels 1-4	*/
+LOCAL	unsigned long	tmmap0[TM_L0SIZE/32];		/* bit set:	*/
+LOCAL	unsigned long	tmmapn[TM_NLEVELS-1][TM_LNSIZE/32]; /* slot used */
+LOCAL	unsigned long	tmnow;			/* next tick to process	*/
+LOCAL	struct	tmentry	proctm[NPROC];		/* sleep timer per pid	*/
+
+/*------------------------------------------------------------------------
+ *  _bsf  --  index of the lowest bit set in a nonzero word
+ *------------------------------------------------------------------------
+ */
+LOCAL int _bsf(unsigned long x)
+{
+	int	i;
+
+	asm("bsfl %1, %0" : "=r" (i) : "rm" (x));
+	return(i);
+}
+
+/*------------------------------------------------------------------------
+ *  _tmscan  --  distance from slot i to the next used slot of a level
+ *		 (going round past the last slot), or -1 if none is used
+ *------------------------------------------------------------------------
+ */
+LOCAL int _tmscan(unsigned long *map, int nslots, int i)
+{
+	int		w, n;
+	int		nwords = nslots >> 5;
+	unsigned long	bits;
+
+	w = i >> 5;
+	bits = map[w] & (~0UL << (i & 31));
+	for (n=0 ; n <= nwords ; n++) {
+		if (bits)
+			return((((w << 5) + _bsf(bits)) - i) & (nslots - 1));
+		if (++w == nwords)
+			w = 0;
+		bits = map[w];
+	}
+	return(-1);
+}
+
+/*------------------------------------------------------------------------
+ *  _tmslotmap  --  find the bitmap word and bit of a slot head
+ *------------------------------------------------------------------------
+ */
+LOCAL unsigned long *_tmslotmap(struct tmentry **slot, unsigned long *bit)
+{
+	int	i, l;
+
+	if (slot >= &tml0[0] && slot < &tml0[TM_L0SIZE]) {
+		i = slot - &tml0[0];
+		*bit = 1UL << (i & 31);
+		return(&tmmap0[i >> 5]);
+	}
+	if (slot >= &tmln[0][0] && slot < &tmln[TM_NLEVELS-1][0]) {
+		i = slot - &tmln[0][0];
+		l = i / TM_LNSIZE;
+		i &= TM_LNMASK;
+		*bit = 1UL << (i & 31);
+		return(&tmmapn[l][i >> 5]);
+	}
+	return(NULL);			/* not a slot: t is mid-list	*/
+}
+
+/*------------------------------------------------------------------------
+ *  _tmlink  --  put an idle timer in the slot for its expiry tick
+ *------------------------------------------------------------------------
+ */
+LOCAL void _tmlink(struct tmentry *t)
+{
+	unsigned long	delta, bit;
+	struct	tmentry	**slot;
+	int	l;
+
+	delta = t->tm_expires - tmnow;
+	if ((long)delta < 0)			/* already due		*/
+		slot = &tml0[tmnow & TM_L0MASK];
+	else if (delta < TM_L0SIZE)
+		slot = &tml0[t->tm_expires & TM_L0MASK];
+	else {
+		for (l=0 ; l < TM_NLEVELS-2 &&
+		    delta >= 1UL << TM_LNSHIFT(l+1) ; l++)
+			;
+		slot = &tmln[l][(t->tm_expires >> TM_LNSHIFT(l)) & TM_LNMASK];
+	}
+
+	if ((t->tm_next = *slot) != NULL)
+		t->tm_next->tm_pprev = &t->tm_next;
+	else
+		*_tmslotmap(slot, &bit) |= bit;
+	*slot = t;
+	t->tm_pprev = slot;
+}
+
+/*------------------------------------------------------------------------
+ *  _tmunlink  --  take an armed timer out of its slot
+ *------------------------------------------------------------------------
+ */
+LOCAL void _tmunlink(struct tmentry *t)
+{
+	unsigned long	*map, bit;
+
+	if ((*t->tm_pprev = t->tm_next) != NULL)
+		t->tm_next->tm_pprev = t->tm_pprev;
+	else if ((map = _tmslotmap(t->tm_pprev, &bit)) != NULL)
+		*map &= ~bit;		/* that emptied the slot	*/
+	t->tm_next = NULL;
+	t->tm_pprev = NULL;
+}
+
+/*------------------------------------------------------------------------
+ *  _tmcascade  --  move the timers of one upper level slot down
+ *------------------------------------------------------------------------
+ */
+LOCAL int _tmcascade(int l, int i)
+{
+	struct	tmentry	*t;
+
+	while ((t = tmln[l][i]) != NULL) {
+		_tmunlink(t);
+		_tmlink(t);
+	}
+	return(i);
+}
+
+/*------------------------------------------------------------------------
+ *  _tmready  --  sleep timer callback: the sleep of process pid is over
+ *------------------------------------------------------------------------
+ */
+LOCAL void _tmready(int pid)
+{
+	ready(pid, RESCHNO);
+}
+
+/*------------------------------------------------------------------------
+ *  tminit  --  initialize the timing wheel (called from clkinit)
+ *------------------------------------------------------------------------
+ */
+void tminit()
+{
+	int	i, l;
+
+	for (i=0 ; i<TM_L0SIZE ; i++)
+		tml0[i] = NULL;
+	for (i=0 ; i<TM_L0SIZE/32 ; i++)
+		tmmap0[i] = 0;
+	for (l=0 ; l<TM_NLEVELS-1 ; l++) {
+		for (i=0 ; i<TM_LNSIZE ; i++)
+			tmln[l][i] = NULL;
+		for (i=0 ; i<TM_LNSIZE/32 ; i++)
+			tmmapn[l][i] = 0;
+	}
+	for (i=0 ; i<NPROC ; i++)
+		tmclear(&proctm[i]);
+	tmnow = tmclock() + 1;
+	slnempty = 0;
+}
+
+/*------------------------------------------------------------------------
+ *  tmclear  --  initialize a timer as idle before its first tmset
+ *------------------------------------------------------------------------
+ */
+void tmclear(struct tmentry *t)
+{
+	t->tm_next = NULL;
+	t->tm_pprev = NULL;
+}
+
+/*------------------------------------------------------------------------
+ *  tmset  --  arm timer t to call func(arg) ticks clock ticks from now
+ *	       (0 means on the next tick); rearms it if already armed
+ *------------------------------------------------------------------------
+ */
+int tmset(struct tmentry *t, unsigned long ticks, void (*func)(int), int arg)
+{
+	STATWORD ps;
+	unsigned long	now;
+
+	if (t == NULL || func == NULL || ticks > TM_MAXTICKS)
+		return(SYSERR);
+	lkdisable(ps, LK_PROC);
+	if (tmarmed(t)) {
+		_tmunlink(t);
+		slnempty--;
+	}
+	now = tmclock();
+	if (slnempty == 0)
+		tmnow = now + 1;
+	t->tm_expires = now + ticks;
+	t->tm_func = func;
+	t->tm_arg = arg;
+	_tmlink(t);
+	slnempty++;
+#ifdef	TICKLESS
+	clkarm();			/* in case t is the next due	*/
+#endif
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  tmcancel  --  disarm timer t; SYSERR if it was not armed
+ *------------------------------------------------------------------------
+ */
+int tmcancel(struct tmentry *t)
+{
+	STATWORD ps;
+
+	lkdisable(ps, LK_PROC);
+	if (t == NULL || !tmarmed(t)) {
+		restore(ps);
+		return(SYSERR);
+	}
+	_tmunlink(t);
+	slnempty--;
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  _tmahead  --  ticks from tmnow to the next one the wheel has to
+ *		  process: a used level 0 slot or an upper level slot
+ *		  that is due to be cascaded. TM_MAXTICKS if none.
+ *------------------------------------------------------------------------
+ */
+LOCAL unsigned long _tmahead()
+{
+	unsigned long	best, d, b0, span;
+	int	l, j;
+
+	best = TM_MAXTICKS;
+	if ((j = _tmscan(tmmap0, TM_L0SIZE, tmnow & TM_L0MASK)) >= 0)
+		best = j;
+
+	/* slot j of level l is cascaded at the j'th multiple of its	*/
+	/* span counting from the first one at or after tmnow		*/
+	for (l=0 ; l<TM_NLEVELS-1 ; l++) {
+		span = 1UL << TM_LNSHIFT(l);
+		b0 = (tmnow + span - 1) & ~(span - 1);
+		j = _tmscan(tmmapn[l], TM_LNSIZE, (b0 >> TM_LNSHIFT(l)) & TM_LNMASK);
+		if (j < 0 || (unsigned long)j > TM_MAXTICKS >> TM_LNSHIFT(l))
+			continue;
+		d = (b0 - tmnow) + ((unsigned long)j << TM_LNSHIFT(l));
+		if (d < best)
+			best = d;
+	}
+	return(best);
+}
+
+/*------------------------------------------------------------------------
+ *  tmadvance  --  run the wheel up to the current tick and call the
+ *		   timers that expired; returns how many did.
+ *		   Called from the clock interrupt with interrupts disabled.
+ *------------------------------------------------------------------------
+ */
+int tmadvance()
+{
+	struct	tmentry	*t;
+	unsigned long	now, d;
+	int	i, l;
+	int	fired = 0;
+
+	now = tmclock();
+	while ((long)(now - tmnow) >= 0) {
+		if ((d = _tmahead()) > now - tmnow) {
+			tmnow = now + 1;	/* nothing more due yet	*/
+			break;
+		}
+		tmnow += d;
+		i = tmnow & TM_L0MASK;
+		if (i == 0)
+			for (l=0 ; l<TM_NLEVELS-1 ; l++)
+				if (_tmcascade(l,
+				    (tmnow >> TM_LNSHIFT(l)) & TM_LNMASK) != 0)
+					break;
+		tmnow++;
+		while ((t = tml0[i]) != NULL) {
+			_tmunlink(t);
+			slnempty--;
+			(*t->tm_func)(t->tm_arg);
+			fired++;
+		}
+	}
+	return(fired);
+}
+
+/*------------------------------------------------------------------------
+ *  tmnext  --  tick at which tmadvance() next has work to do (a timer
+ *		expires or an upper level slot cascades); only meaningful
+ *		while a timer is armed
+ *------------------------------------------------------------------------
+ */
+unsigned long tmnext()
+{
+	return(tmnow + _tmahead());
+}
+
+/*------------------------------------------------------------------------
+ *  tmsleep  --  arm the sleep timer of process pid; the caller puts it
+ *		 in PRSLEEP or PRTRECV and reschedules
+ *------------------------------------------------------------------------
+ */
+int tmsleep(int pid, unsigned long ticks)
+{
+	if (isbadpid(pid))
+		return(SYSERR);
+	return(tmset(&proctm[pid], ticks, _tmready, pid));
+}
+
+/*------------------------------------------------------------------------
+ *  tmunsleep  --  disarm the sleep timer of process pid
+ *------------------------------------------------------------------------
+ */
+int tmunsleep(int pid)
+{
+	if (isbadpid(pid))
+		return(SYSERR);
+	return(tmcancel(&proctm[pid]));
+}
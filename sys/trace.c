@@ -0,0 +1,137 @@
+/* trace.c - trace, settrace, tracedump */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <i386.h>
+#include <sleep.h>
+#include <trace.h>
+#include <timer.h>
+#include <stdio.h>
+
+/*
+ * The ring is written with interrupts disabled for the few stores of a
+ * record, so tracepoints can sit in interrupt handlers and in code that
+ * already runs disabled. Once full it keeps the newest NTRACE records;
+ * tr_seq tells the decoder how many were lost before the oldest one.
+ */
+
+int	tracemask = 0;
+void	(*trintr)() = NULL;
+
+LOCAL	struct	trent	trbuf[NTRACE];
+LOCAL	unsigned long	trseq = 0;	/* records made since boot	*/
+LOCAL	unsigned long	trkhz = 0;	/* TSC ticks per ms, 0 unknown	*/
+
+/*------------------------------------------------------------------------
+ *  _trclock  --  clkint's tracepoint, called while TRC_INTR is on
+ *------------------------------------------------------------------------
+ */
+LOCAL void _trclock()
+{
+	trace(TE_INTR, IRQBASE, 0, 0, 0);
+}
+
+/*------------------------------------------------------------------------
+ *  _trcal  --  measure the TSC against PIT counter 2 (see clktsc); it
+ *		doesn't need clock interrupts, so settrace() can be
+ *		called with interrupts disabled
+ *------------------------------------------------------------------------
+ */
+LOCAL void _trcal()
+{
+	if (trkhz == 0)
+		trkhz = clktsc();
+}
+
+/*------------------------------------------------------------------------
+ *  trace  --  record an event; called through TRACE()
+ *------------------------------------------------------------------------
+ */
+void trace(int event, long a0, long a1, long a2, long a3)
+{
+	STATWORD ps;
+	struct	trent	*tp;
+
+	lkdisable(ps, LK_LOG);
+	tp = &trbuf[trseq & (NTRACE - 1)];
+	asm volatile ("rdtsc" : "=a" (tp->tr_tsclo), "=d" (tp->tr_tschi));
+	tp->tr_seq = trseq++;
+	tp->tr_event = event;
+	tp->tr_pid = currpid;
+	tp->tr_arg[0] = a0;
+	tp->tr_arg[1] = a1;
+	tp->tr_arg[2] = a2;
+	tp->tr_arg[3] = a3;
+	restore(ps);
+}
+
+/*------------------------------------------------------------------------
+ *  settrace  --  trace the categories in mask (TRC_*) from now on;
+ *		  returns those traced before
+ *------------------------------------------------------------------------
+ */
+int settrace(int mask)
+{
+	STATWORD ps;
+	int	old;
+
+	if (mask & ~TRC_ALL)
+		return(SYSERR);
+	if (mask != 0)
+		_trcal();
+	lkdisable(ps, LK_LOG);
+	old = tracemask;
+	tracemask = mask;
+	trintr = (mask & TRC_INTR) ? _trclock : NULL;
+	restore(ps);
+	return(old);
+}
+
+/*------------------------------------------------------------------------
+ *  tracedump  --  send the ring, oldest record first, to the debug port
+ *		   (TRD_DEBUGCON) or the console (TRD_CONSOLE); tracing
+ *		   is off while it runs
+ *------------------------------------------------------------------------
+ */
+int tracedump(int how)
+{
+	struct	trhdr	hdr;
+	struct	trent	*tp;
+	unsigned char	*p;
+	unsigned long	seq, *w;
+	int	mask, i;
+
+	if (how != TRD_DEBUGCON && how != TRD_CONSOLE)
+		return(SYSERR);
+	mask = settrace(0);
+
+	hdr.th_magic = TR_MAGIC;
+	hdr.th_size = sizeof(struct trent);
+	hdr.th_count = (trseq < NTRACE) ? trseq : NTRACE;
+	hdr.th_khz = trkhz;
+	if (how == TRD_DEBUGCON)
+		for (p = (unsigned char *)&hdr, i=0 ; i<sizeof(hdr) ; i++)
+			outb(TR_DBGPORT, *p++);
+	else
+		kprintf("TRC %08x %08x %08x %08x\n", hdr.th_magic,
+		    hdr.th_size, hdr.th_count, hdr.th_khz);
+
+	for (seq = trseq - hdr.th_count ; seq != trseq ; seq++) {
+		tp = &trbuf[seq & (NTRACE - 1)];
+		if (how == TRD_DEBUGCON) {
+			p = (unsigned char *)tp;
+			for (i=0 ; i<sizeof(struct trent) ; i++)
+				outb(TR_DBGPORT, *p++);
+			continue;
+		}
+		kprintf("TR");
+		for (w = (unsigned long *)tp, i=0 ;
+		    i<sizeof(struct trent)/sizeof(long) ; i++)
+			kprintf(" %08x", *w++);
+		kprintf("\n");
+	}
+
+	settrace(mask);
+	return(OK);
+}
@@ -5,6 +5,7 @@
 #include <proc.h>
 #include <q.h>
 #include <sleep.h>
+#include <timer.h>
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
@@ -15,26 +16,15 @@ SYSCALL	unsleep(int pid)
 {
 	STATWORD ps;    
 	struct	pentry	*pptr;
-	struct	qent	*qptr;
-	int	remain;
-	int	next;
 
-        disable(ps);
+        lkdisable(ps, LK_PROC);
 	if (isbadpid(pid) ||
 	    ( (pptr = &proctab[pid])->pstate != PRSLEEP &&
 	     pptr->pstate != PRTRECV) ) {
 		restore(ps);
 		return(SYSERR);
 	}
-	qptr = &q[pid];
-	remain = qptr->qkey;
-	if ( (next=qptr->qnext) < NPROC)
-		q[next].qkey += remain;
-	dequeue(pid);
-	if ( (next=q[clockq].qnext) < NPROC)
-		sltop = (int *) & q[next].qkey;
-	else
-		slnempty = FALSE;
+	tmunsleep(pid);
         restore(ps);
 	return(OK);
 }
@@ -0,0 +1,31 @@
+/* usleep.c - usleep */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sleep.h>
+#include <timer.h>
+#include <stdio.h>
+
+/*------------------------------------------------------------------------
+ * usleep  --  delay the caller for a time specified in microseconds;
+ *	       rounded up to whole clock ticks unless TICKLESS
+ *------------------------------------------------------------------------
+ */
+SYSCALL	usleep(int n)
+{
+	STATWORD ps;    
+	if (n < 0  || clkruns==0)
+	         return(SYSERR);
+	lkdisable(ps, LK_PROC);
+	if (n == 0) {		/* usleep(0) -> end time slice */
+	        ;
+	} else {
+		tmsleep(currpid, TM_US(n));
+		proctab[currpid].pstate = PRSLEEP;
+	}
+	resched();
+        restore(ps);
+	return(OK);
+}
@@ -5,6 +5,7 @@
 #include <proc.h>
 #include <q.h>
 #include <sem.h>
+#include <trace.h>
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
@@ -17,12 +18,14 @@ SYSCALL	wait(int sem)
 	struct	sentry	*sptr;
 	struct	pentry	*pptr;
 
-	disable(ps);
-	if (isbadsem(sem) || (sptr= &semaph[sem])->sstate==SFREE) {
+	lkdisable(ps, LK_SEM|LK_PROC);
+	if (isbadsem(sem) || (sptr= &semaph[sem])->sstate==SFREE ||
+	    sptr->smutex) {
 		restore(ps);
 		return(SYSERR);
 	}
 	
+	TRACE(TRC_SEM, TE_WAIT, sem, sptr->semcnt, 0, 0);
 	if (--(sptr->semcnt) < 0) {
 		(pptr = &proctab[currpid])->pstate = PRWAIT;
 		pptr->psem = sem;
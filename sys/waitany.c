@@ -0,0 +1,162 @@
+/* waitany.c - waitany, waitall, wanysignal, wanydelete, wanykill */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sem.h>
+#include <stdio.h>
+
+/*
+ * A process can only be on one q list, so a process blocked in
+ * waitany() is not put on the queues of its semaphores. Instead each
+ * semaphore has a list of the waitany() callers waiting for it, kept
+ * in arrival order. An entry is a (pid, i) pair meaning pwsem[i] of
+ * pid, encoded as pid * NWANY + i; pwlink[i] holds the next one.
+ *
+ * The count of a semaphore only goes below zero for processes on its
+ * queue. A waitany() caller only blocks when none of its semaphores
+ * has a count above zero, and signal() gives a semaphore to the first
+ * waitany() caller when its queue is empty. That caller is then taken
+ * off the lists of all its semaphores.
+ */
+
+#define	wanypid(l)	((l) / NWANY)
+#define	wanyslot(l)	((l) % NWANY)
+
+/*------------------------------------------------------------------------
+ *  _wanyunlink  --  take waitany() caller pid off all its lists
+ *------------------------------------------------------------------------
+ */
+LOCAL void _wanyunlink(int pid)
+{
+	struct	pentry	*pptr;
+	int	i;
+	int	*link;
+	int	me;
+
+	pptr = &proctab[pid];
+	for (i=0 ; i<pptr->pwn ; i++) {
+		me = pid * NWANY + i;
+		for (link = &semaph[pptr->pwsem[i]].sany ; *link != me ;
+		    link = &proctab[wanypid(*link)].pwlink[wanyslot(*link)])
+			;
+		*link = pptr->pwlink[i];
+	}
+	pptr->pwn = 0;
+}
+
+/*------------------------------------------------------------------------
+ * waitany  --  wait until one of n semaphores can be taken and take it;
+ *		returns the semaphore taken
+ *------------------------------------------------------------------------
+ */
+SYSCALL	waitany(int *sems, int n)
+{
+	STATWORD ps;
+	struct	pentry	*pptr;
+	struct	sentry	*sptr;
+	int	i;
+	int	*link;
+
+	if (n < 1 || n > NWANY)
+		return(SYSERR);
+	lkdisable(ps, LK_SEM|LK_PROC);
+	for (i=0 ; i<n ; i++)
+		if (isbadsem(sems[i]) || semaph[sems[i]].sstate==SFREE ||
+		    semaph[sems[i]].smutex) {
+			restore(ps);
+			return(SYSERR);
+		}
+	for (i=0 ; i<n ; i++)
+		if (semaph[sems[i]].semcnt > 0) {
+			semaph[sems[i]].semcnt--;
+			restore(ps);
+			return(sems[i]);
+		}
+
+	/* none can be taken: go on the end of each one's list */
+	pptr = &proctab[currpid];
+	for (i=0 ; i<n ; i++) {
+		sptr = &semaph[sems[i]];
+		for (link = &sptr->sany ; *link != EMPTY ;
+		    link = &proctab[wanypid(*link)].pwlink[wanyslot(*link)])
+			;
+		*link = currpid * NWANY + i;
+		pptr->pwsem[i] = sems[i];
+		pptr->pwlink[i] = EMPTY;
+	}
+	pptr->pwn = n;
+	pptr->pstate = PRWANY;
+	resched();
+	restore(ps);
+	return(pptr->pwaitret == DELETED ? SYSERR : pptr->pwaitret);
+}
+
+/*------------------------------------------------------------------------
+ * waitall  --  wait on each of n semaphores. They are taken in order of
+ *		semaphore id, so two waitall() callers can't deadlock
+ *		each other holding part of the same set.
+ *------------------------------------------------------------------------
+ */
+SYSCALL	waitall(int *sems, int n)
+{
+	int	order[NWANY];
+	int	i, j, s;
+
+	if (n < 1 || n > NWANY)
+		return(SYSERR);
+	for (i=0 ; i<n ; i++) {		/* insertion sort a copy	*/
+		s = sems[i];
+		for (j=i ; j>0 && order[j-1] > s ; j--)
+			order[j] = order[j-1];
+		order[j] = s;
+	}
+	for (i=0 ; i<n ; i++)
+		if (wait(order[i]) != OK) {
+			while (--i >= 0)	/* give back what was taken	*/
+				signal(order[i]);
+			return(SYSERR);
+		}
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  wanysignal  --  give sem to the first waitany() caller waiting on it
+ *------------------------------------------------------------------------
+ */
+void wanysignal(int sem, int resch)
+{
+	int	pid;
+
+	pid = wanypid(semaph[sem].sany);
+	_wanyunlink(pid);
+	proctab[pid].pwaitret = sem;
+	ready(pid, resch);
+}
+
+/*------------------------------------------------------------------------
+ *  wanydelete  --  called by sdelete(): the waitany() callers waiting on
+ *		    sem return SYSERR
+ *------------------------------------------------------------------------
+ */
+void wanydelete(int sem)
+{
+	int	pid;
+
+	while (semaph[sem].sany != EMPTY) {
+		pid = wanypid(semaph[sem].sany);
+		_wanyunlink(pid);
+		proctab[pid].pwaitret = DELETED;
+		ready(pid, RESCHNO);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  wanykill  --  called by kill() for a process in waitany()
+ *------------------------------------------------------------------------
+ */
+void wanykill(int pid)
+{
+	_wanyunlink(pid);
+}
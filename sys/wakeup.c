@@ -5,6 +5,7 @@
 #include <proc.h>
 #include <q.h>
 #include <sleep.h>
+#include <timer.h>
 
 /*------------------------------------------------------------------------
  * wakeup  --  called by clock interrupt dispatcher to awaken processes
@@ -12,10 +13,11 @@
  */
 INTPROC	wakeup()
 {
-        while (nonempty(clockq) && firstkey(clockq) <= 0)
-                ready(getfirst(clockq),RESCHNO);
-	if ((slnempty = nonempty(clockq)))
-		sltop = & q[q[clockq].qnext].qkey;
-	resched();
+	STATWORD ps;
+
+	lklock(ps, LK_SEM|LK_PROC);
+	if (tmadvance() > 0)
+		resched();
+	lkrestore(ps);
         return(OK);
 }
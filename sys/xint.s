@@ -333,3 +333,115 @@ _Xint47:pushl	%ebp
 	pushal
 	pushl	$47
 	jmp	Xtrap 
+
+	.globl  _Xint48
+_Xint48:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$48
+	jmp	Xtrap 
+
+	.globl  _Xint49
+_Xint49:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$49
+	jmp	Xtrap 
+
+	.globl  _Xint50
+_Xint50:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$50
+	jmp	Xtrap 
+
+	.globl  _Xint51
+_Xint51:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$51
+	jmp	Xtrap 
+
+	.globl  _Xint52
+_Xint52:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$52
+	jmp	Xtrap 
+
+	.globl  _Xint53
+_Xint53:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$53
+	jmp	Xtrap 
+
+	.globl  _Xint54
+_Xint54:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$54
+	jmp	Xtrap 
+
+	.globl  _Xint55
+_Xint55:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$55
+	jmp	Xtrap 
+
+	.globl  _Xint56
+_Xint56:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$56
+	jmp	Xtrap 
+
+	.globl  _Xint57
+_Xint57:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$57
+	jmp	Xtrap 
+
+	.globl  _Xint58
+_Xint58:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$58
+	jmp	Xtrap 
+
+	.globl  _Xint59
+_Xint59:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$59
+	jmp	Xtrap 
+
+	.globl  _Xint60
+_Xint60:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$60
+	jmp	Xtrap 
+
+	.globl  _Xint61
+_Xint61:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$61
+	jmp	Xtrap 
+
+	.globl  _Xint62
+_Xint62:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$62
+	jmp	Xtrap 
+
+	.globl  _Xint63
+_Xint63:pushl	%ebp
+	movl	%esp,%ebp
+	pushal
+	pushl	$63
+	jmp	Xtrap 
@@ -0,0 +1,193 @@
+/* tracedec.c - decode a Xinu trace dump (see h/trace.h) into a timeline
+ *
+ *	tracedec [file]
+ *
+ * The input is either what tracedump(TRD_DEBUGCON) wrote to QEMU's
+ * debug port (-debugcon file:trace.bin) or a console log holding the
+ * "TRC"/"TR" lines of tracedump(TRD_CONSOLE); other lines are skipped.
+ * The magic number and event codes come from the kernel's trace.h. Its
+ * structures are spelled with the target's 32-bit longs, so records
+ * are read here as arrays of stdint words instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../h/trace.h"
+
+#define	TR_WORDS	8		/* 32-bit words in a struct trent */
+
+struct	rec	{
+	uint64_t	tsc;
+	uint32_t	seq;
+	int		event;
+	int		pid;
+	uint32_t	arg[4];
+};
+
+static char *evname[] = {
+	"?", "pfint", "frm_alloc", "frm_free", "read_bs", "write_bs",
+	"resched", "wait", "signal", "intr"
+};
+#define	NEVENT	(sizeof(evname) / sizeof(evname[0]))
+
+static char *frmtype[] = { "PD", "PT", "BS", "STK" };
+
+static struct rec	*recs;
+static int		nrec, maxrec;
+static uint32_t		khz;
+
+static void addrec(uint32_t *w)
+{
+	struct rec	*r;
+
+	if (nrec == maxrec) {
+		maxrec = maxrec ? 2 * maxrec : 1024;
+		if ((recs = realloc(recs, maxrec * sizeof(*r))) == NULL) {
+			perror("tracedec");
+			exit(1);
+		}
+	}
+	r = &recs[nrec++];
+	r->tsc = ((uint64_t)w[1] << 32) | w[0];
+	r->seq = w[2];
+	r->event = w[3] & 0xffff;
+	r->pid = (int16_t)(w[3] >> 16);
+	memcpy(r->arg, &w[4], sizeof(r->arg));
+}
+
+/* the binary dump: header of 4 words, then the records */
+static int readbin(FILE *fp)
+{
+	uint32_t	hdr[4], w[TR_WORDS];
+
+	if (fread(hdr, sizeof(hdr), 1, fp) != 1 || hdr[0] != TR_MAGIC)
+		return -1;
+	if (hdr[1] != sizeof(w)) {
+		fprintf(stderr, "tracedec: records of %u bytes, expected %u\n",
+		    hdr[1], (unsigned)sizeof(w));
+		return -1;
+	}
+	khz = hdr[3];
+	while (fread(w, sizeof(w), 1, fp) == 1)
+		addrec(w);
+	return 0;
+}
+
+/* a console log: "TRC magic size count khz" and "TR w0 .. w7" lines */
+static int readtext(FILE *fp)
+{
+	char		line[256];
+	uint32_t	w[TR_WORDS];
+	unsigned int	h[4];
+	char		*p;
+	int		i, seen = 0;
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if ((p = strstr(line, "TRC ")) != NULL) {
+			if (sscanf(p + 4, "%x %x %x %x", &h[0], &h[1], &h[2],
+			    &h[3]) == 4 && h[0] == TR_MAGIC) {
+				khz = h[3];
+				nrec = 0;	/* the last dump counts	*/
+				seen = 1;
+			}
+			continue;
+		}
+		if (!seen || (p = strstr(line, "TR ")) == NULL)
+			continue;
+		p += 3;
+		for (i=0 ; i<TR_WORDS ; i++)
+			w[i] = strtoul(p, &p, 16);
+		addrec(w);
+	}
+	return seen ? 0 : -1;
+}
+
+static void printargs(struct rec *r)
+{
+	uint32_t	*a = r->arg;
+
+	switch (r->event) {
+	case TE_PFINT:
+		printf("addr 0x%08x", a[0]);
+		break;
+	case TE_FRMALLOC:
+		printf("frame %u", a[0]);
+		break;
+	case TE_FRMFREE:
+		printf("frame %u %s%s", a[0], a[1] < 4 ? frmtype[a[1]] : "?",
+		    a[2] ? " dirty" : "");
+		break;
+	case TE_READBS:
+	case TE_WRITEBS:
+		printf("bs %u page %u", a[0], a[1]);
+		break;
+	case TE_RESCHED:
+		printf("%u -> %u", a[0], a[1]);
+		break;
+	case TE_WAIT:
+	case TE_SIGNAL:
+		printf("sem %u count %d", a[0], (int)a[1]);
+		break;
+	case TE_INTR:
+		printf("vector 0x%x", a[0]);
+		if (a[0] != 0x20)		/* not the clock	*/
+			printf(" iir 0x%x", a[1]);
+		break;
+	default:
+		printf("%x %x %x %x", a[0], a[1], a[2], a[3]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	FILE		*fp;
+	int		counts[NEVENT];
+	uint64_t	dt;
+	int		i, c;
+
+	if (argc > 2) {
+		fprintf(stderr, "usage: tracedec [file]\n");
+		return 1;
+	}
+	fp = stdin;
+	if (argc == 2 && (fp = fopen(argv[1], "rb")) == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	c = getc(fp);
+	ungetc(c, fp);
+	if ((c == 'X' ? readbin(fp) : readtext(fp)) < 0) {
+		fprintf(stderr, "tracedec: no trace dump found\n");
+		return 1;
+	}
+	if (nrec == 0)
+		return 0;
+
+	if (recs[0].seq != 0)
+		printf("# %u earlier records were overwritten\n", recs[0].seq);
+	printf("# %d records, %s\n", nrec, khz ? "time in us" :
+	    "TSC ticks (no clock rate)");
+	memset(counts, 0, sizeof(counts));
+	for (i=0 ; i<nrec ; i++) {
+		dt = recs[i].tsc - recs[0].tsc;
+		if (khz)
+			printf("%12.3f", (double)dt * 1000.0 / khz);
+		else
+			printf("%12llu", (unsigned long long)dt);
+		c = (recs[i].event < NEVENT) ? recs[i].event : 0;
+		counts[c]++;
+		printf("  pid %3d  %-9s  ", recs[i].pid, evname[c]);
+		printargs(&recs[i]);
+		printf("\n");
+	}
+
+	printf("#");
+	for (i=1 ; i<NEVENT ; i++)
+		if (counts[i])
+			printf(" %s %d", evname[i], counts[i]);
+	printf("\n");
+	return 0;
+}
@@ -0,0 +1,69 @@
+/* udpecho.c - the host end of the kernel's UDP test (udptest in main.c)
+ *
+ *	udpecho [port]
+ *
+ * Sends every datagram back where it came from, except that one holding
+ * "#n" gets n octets of i & 0xff in reply, big enough that it reaches
+ * the guest in fragments. With QEMU user networking the guest sees this
+ * host as 10.0.2.2; the port defaults to 7777.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#define	DEFPORT		7777
+#define	MAXDG		65507		/* largest UDP payload		*/
+
+static unsigned char	buf[MAXDG];
+
+int main(int argc, char **argv)
+{
+	struct	sockaddr_in	sin, from;
+	socklen_t	fromlen;
+	int		s, port, n, i;
+
+	if (argc > 2) {
+		fprintf(stderr, "usage: udpecho [port]\n");
+		return 1;
+	}
+	port = argc == 2 ? atoi(argv[1]) : DEFPORT;
+	if (port <= 0 || port > 0xffff) {
+		fprintf(stderr, "udpecho: bad port %s\n", argv[1]);
+		return 1;
+	}
+	if ((s = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+		perror("socket");
+		return 1;
+	}
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_ANY);
+	sin.sin_port = htons(port);
+	if (bind(s, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
+		perror("bind");
+		return 1;
+	}
+
+	for (;;) {
+		fromlen = sizeof(from);
+		n = recvfrom(s, buf, sizeof(buf) - 1, 0,
+		    (struct sockaddr *)&from, &fromlen);
+		if (n < 0) {
+			perror("recvfrom");
+			return 1;
+		}
+		if (n > 1 && buf[0] == '#') {
+			buf[n] = '\0';
+			n = atoi((char *)buf + 1);
+			if (n < 0 || n > MAXDG)
+				continue;
+			for (i=0 ; i<n ; i++)
+				buf[i] = i & 0xff;
+		}
+		sendto(s, buf, n, 0, (struct sockaddr *)&from, fromlen);
+	}
+}
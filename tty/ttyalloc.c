@@ -15,7 +15,7 @@ ttyalloc()
 	STATWORD	ps;
 	int		i;
 
-	disable(ps);
+	lkdisable(ps, LK_DEV);
 	for (i=0; i<Ntty; ++i)
 		if (ttytab[i].tty_state == TTYS_FREE) {
 			ttytab[i].tty_state = TTYS_ALLOC;
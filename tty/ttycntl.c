@@ -26,11 +26,12 @@ char		*arg1, *arg2;
 				ptty->tty_oflags |= TOF_SYNC;
 			else
 				ptty->tty_oflags &= ~TOF_SYNC;
+			ttyostart(ptty, TRUE);	/* flush what is buffered */
 			return OK;
 	case TTC_GIF:	return ptty->tty_iflags;
 	case TTC_GOF:	return ptty->tty_oflags;
 	case TTC_NEXTC:
-			disable(PS);
+			lkdisable(PS, LK_DEV);
 			wait(ptty->tty_isema);
 			ch = ptty->tty_in[ptty->tty_istart];
 			signal(ptty->tty_isema);
@@ -1,9 +1,10 @@
-/* ttyiin.c - ttyiin */
+/* ttyiin.c - ttyiin, ttyiinn */
 
 #include <conf.h>
 #include <kernel.h>
 #include <tty.h>
 
+static int inchar(struct tty *ptty, unsigned char ch);
 static int iputchar(struct tty *ptty, unsigned char ch);
 static int echo(struct tty *ptty, unsigned char ch);
 static int delchar(struct tty *ptty);
@@ -19,41 +20,76 @@ struct devsw	*pdev;
 unsigned char	ch;
 {
 	struct tty	*ptty = (struct tty *)pdev->dvioblk;
+
+	if (inchar(ptty, ch))
+		if (scount(ptty->tty_isema) <= 0)
+			signal(ptty->tty_isema);
+	if (ptty->tty_ocount)		/* echo */
+		ttyostart(ptty, TRUE);
+        return(OK);
+}
+
+/*------------------------------------------------------------------------
+ * ttyiinn - handle n characters of interrupt-level input for a tty,
+ *	     waking the reader at most once
+ *------------------------------------------------------------------------
+ */
+int ttyiinn(pdev, buf, n)
+struct devsw	*pdev;
+unsigned char	*buf;
+int		n;
+{
+	struct tty	*ptty = (struct tty *)pdev->dvioblk;
+	int		wake = FALSE;
+
+	for (; n > 0 ; n--)
+		wake |= inchar(ptty, *buf++);
+	if (wake && scount(ptty->tty_isema) <= 0)
+		signal(ptty->tty_isema);
+	if (ptty->tty_ocount)		/* echo */
+		ttyostart(ptty, TRUE);
+        return(OK);
+}
+
+/*------------------------------------------------------------------------
+ * inchar - apply the line discipline to one input character; returns
+ *	    TRUE if a reader waiting for input should be woken
+ *------------------------------------------------------------------------
+ */
+static int inchar(struct tty *ptty, unsigned char ch)
+{
 	struct tchars	*ptc;
 	static unsigned char	lastc;
 
 	if (ch == '\n' && lastc == '\r')
-		return(OK);
+		return(FALSE);
 	lastc = ch;
 	if (ch == '\r')
 		ch = '\n';
 	if (ptty->tty_iflags & TIF_RAW) {
 		iputchar(ptty, ch);
-		return(OK);
+		return(FALSE);
 	}
 	ptc = &ptty->tty_tchars;
 	if (ch == ptc->tc_erase) {
 		delchar(ptty);
-		return(OK);
+		return(FALSE);
 	} else if (ch == ptc->tc_werase) {
 		delword(ptty);
-		return(OK);
+		return(FALSE);
 	} else if (ch == ptc->tc_reprint) {
 		reprint(ptty);
-		return(OK);
+		return(FALSE);
 	} else if (ch == ptc->tc_intr) {
 		send(ptty->tty_cpid, INTRMSG);
-		return(OK);
+		return(FALSE);
 	} else if (ch == ptc->tc_eof) {
 		ptty->tty_iflags |= TIF_EOF;
 	}
 	iputchar(ptty, ch);
-	if ((ptty->tty_iflags & (TIF_CBREAK|TIF_RAW)) ||
+	return((ptty->tty_iflags & (TIF_CBREAK|TIF_RAW)) ||
 	    ch == ptty->tty_tchars.tc_eol ||
-	    ch == ptty->tty_tchars.tc_eof)
-		if (scount(ptty->tty_isema) <= 0)
-			signal(ptty->tty_isema);
-        return(OK);
+	    ch == ptty->tty_tchars.tc_eof);
 }
 
 /*------------------------------------------------------------------------
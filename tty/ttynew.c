@@ -30,6 +30,7 @@ ttynew()
 	ptty->tty_oflags = 0;
 	ptty->tty_ostart = 0;
 	ptty->tty_ocount = 0;
+	ptty->tty_oready = 0;
 	return ptty;
 }
 
@@ -3,17 +3,38 @@
 #include <conf.h>
 #include <kernel.h>
 #include <tty.h>
-#include <stdio.h>
 
 /*------------------------------------------------------------------------
- * ttyoin - handle transmit interrupt on tty
+ * ttyoin - handle transmit completion on a tty: the hardware has room
+ *	    for up to n characters; copy that much of the ready output
+ *	    into buf and return how many were copied
  *------------------------------------------------------------------------
  */
 int
-ttyoin(ptty, ch)
-struct tty	*ptty;
-unsigned char	ch;
+ttyoin(pdev, buf, n)
+struct devsw	*pdev;
+unsigned char	*buf;
+int		n;
 {
-	kprintf("ttyoin\n");
-        return(OK);
+	struct tty	*ptty = (struct tty *)pdev->dvioblk;
+	int		count, run;
+
+	if (ptty == 0)
+		return 0;
+	if (n > ptty->tty_oready)
+		n = ptty->tty_oready;
+	for (count = 0; count < n; count += run) {
+		run = OBLEN - ptty->tty_ostart;
+		if (run > n - count)
+			run = n - count;
+		blkcopy(buf + count, &ptty->tty_out[ptty->tty_ostart], run);
+		ptty->tty_ostart += run;
+		if (ptty->tty_ostart >= OBLEN)
+			ptty->tty_ostart = 0;
+	}
+	ptty->tty_ocount -= count;
+	ptty->tty_oready -= count;
+	if (count > 0)
+		isignaln(ptty->tty_osema, count);
+	return count;
 }
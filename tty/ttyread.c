@@ -27,7 +27,9 @@ int		len;
 	if (ptty->tty_iflags & TIF_NOBLOCK)
 		if (scount(ptty->tty_isema) <= 0)
 			return SYSERR;
-	disable(ps);
+	lkdisable(ps, LK_DEV);
+	if (ptty->tty_ocount)		/* a prompt without a newline */
+		ttyostart(ptty, TRUE);
 	wait(ptty->tty_isema);
 	count = 0;
 	while (count < len && ptty->tty_icount) {
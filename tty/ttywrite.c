@@ -1,11 +1,22 @@
-/* ttywrite.c - ttywrite */
+/* ttywrite.c - ttywrite, ttyostart */
 
 #include <conf.h>
 #include <kernel.h>
+#include <sem.h>
 #include <tty.h>
+#include <com.h>
+#include <stdio.h>
+
+static void oputc(struct tty *ptty, unsigned char ch);
 
 /*------------------------------------------------------------------------
  * ttywrite - write a buffer to a tty
+ *
+ * Cooked output is translated into the tty's output ring, which holds
+ * it until a newline, a full ring or TOF_SYNC makes it ready; the
+ * hardware then takes the ready part through ttyoin() (see ttyostart).
+ * tty_osema counts the free space in the ring; it is taken a character
+ * at a time only when the ring is full.
  *------------------------------------------------------------------------
  */
 int
@@ -14,34 +25,95 @@ struct devsw	*pdev;
 unsigned char	*buf;
 int		len;
 {
-	struct devsw	*phw;
+	STATWORD	ps;
 	struct tty	*ptty = (struct tty *)pdev->dvioblk;
-	int		i;
+	unsigned char	ch;
+	int		i, n;
 
 	if (ptty == 0)
 		return SYSERR;
-	phw = ptty->tty_phw;
-	if (phw == 0)
-		return SYSERR;
-	if (phw->dvputc == 0)
+	if (ptty->tty_phw == 0)
 		return SYSERR;
+	lkdisable(ps, LK_DEV);
 	for (i=0; i<len; ++i) {
-		if (ptty->tty_oflags & TOF_RAW) {
-			if (phw->dvputc(phw, buf[i]) != OK)
-				break;
-		}
-		/* else, do cooked output */
-		if ( buf[i] > 127) {
-			(phw->dvputc)(phw, 'M');
-			(phw->dvputc)(phw, '-');
-			(phw->dvputc)(phw, buf[i] & 0x7f);
-			continue;
+		ch = buf[i];
+		n = (ch > 127 && !(ptty->tty_oflags & TOF_RAW)) ? 3 : 1;
+		if (scount(ptty->tty_osema) < n) {	/* full */
+			ttyostart(ptty, TRUE);
+			for (; n > 0; n--)
+				wait(ptty->tty_osema);
+		} else
+			semaph[ptty->tty_osema].semcnt -= n;
+		if (ch > 127 && !(ptty->tty_oflags & TOF_RAW)) {
+			oputc(ptty, 'M');
+			oputc(ptty, '-');
+			ch &= 0x7f;
 		}
-#ifdef notdef
-		if (buf[i] == '\n')
-			(phw->dvputc)(phw, '\r');
-#endif
-		(phw->dvputc)(phw, buf[i]);
+		oputc(ptty, ch);
+		if (ch == '\n')
+			ptty->tty_oready = ptty->tty_ocount;
 	}
+	if ((ptty->tty_oflags & TOF_SYNC) || ptty->tty_oready)
+		ttyostart(ptty, ptty->tty_oflags & TOF_SYNC);
+	restore(ps);
 	return i;
 }
+
+/*------------------------------------------------------------------------
+ * ttyostart - start sending the ready part of a tty's output ring (all
+ *	       of it if all is set): under TOF_SYNC write it out now, a
+ *	       contiguous run at a time, else have the hardware take it
+ *	       through ttyoin()
+ *------------------------------------------------------------------------
+ */
+int
+ttyostart(ptty, all)
+struct tty	*ptty;
+int		all;
+{
+	STATWORD	ps;
+	struct devsw	*phw = ptty->tty_phw;
+	int		run;
+	int		woke = FALSE;
+
+	lkdisable(ps, LK_DEV);
+	if (all)
+		ptty->tty_oready = ptty->tty_ocount;
+	if ((ptty->tty_oflags & TOF_SYNC) == 0) {
+		(phw->dvcntl)(phw, COMC_OSTART, 0);
+		restore(ps);
+		return OK;
+	}
+	while (ptty->tty_oready) {
+		run = OBLEN - ptty->tty_ostart;
+		if (run > ptty->tty_oready)
+			run = ptty->tty_oready;
+		(phw->dvwrite)(phw, &ptty->tty_out[ptty->tty_ostart], run);
+		ptty->tty_ostart += run;
+		if (ptty->tty_ostart >= OBLEN)
+			ptty->tty_ostart = 0;
+		ptty->tty_ocount -= run;
+		ptty->tty_oready -= run;
+		if (isignaln(ptty->tty_osema, run) > 0)
+			woke = TRUE;
+	}
+	if (woke)		/* once, not per run		*/
+		resched();
+	restore(ps);
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * oputc - append a character to a tty's output ring, which has room
+ *------------------------------------------------------------------------
+ */
+static void oputc(struct tty *ptty, unsigned char ch)
+{
+	int	pos;
+
+	pos = ptty->tty_ostart + ptty->tty_ocount;
+	if (pos >= OBLEN)
+		pos -= OBLEN;
+	ptty->tty_out[pos] = ch;
+	ptty->tty_ocount++;
+}